@@ -16,295 +16,95 @@
 
 
 #include "QUESS.h"
+#include <unistd.h>
+#include <signal.h>
 //#define VERBOSE
 
 
 
 /**
-  * Name:               void show_usage() {
+  * Name:               nameWorkingFiles(char* inputTempFileName, char* outputTempFileName, char* datasetName, char* outputFileName, char* spoolFileName, DatasetWriter& outputFile, bool stream)
   *
-  * Description :       Shows usage
-  *
-  * Input :
-  *
-  * Process Synopsis :
-  *
-  * Notes :             
-  *
-  */
-void show_usage()
-{
-  cerr << "Usage: ./QUESS <option(s)>\n"
-       << "Required:\n"
-       << "\t-i,--input-file <filename>\t\tSpecify the target fastx file\n"
-       << "\t-g,--genome-length <genome length>\tSpecify the approximate length of the genome\n\n"
-       << "Optional:\n"
-       << "\t-h,--help\t\t\t\tShows Help\n"
-       << "\t-n,--number-of-seeds\t\t\tSpecify number of seeds 1-8 (default 8)\n"
-       << "\t-w,--weight <weight>\t\t\tSpecify weight of seeds 10-26 (default to determined by program)\n\n"
-       << "Example Usage:\n"
-       << "./QUESS -g 2000000 -i file.fastq"
-       << endl;
-}
-
-
-/**
-  * Name:               bool legal_int(char *str) {
-  *
-  * Description :       determine intger
+  * Description :       Names the working files after the dataset
   *
   * Input :
   *       Parameters:
-  *           char*     str               input char array
+  *           char*     inputTempFileName   destination
+  *           char*     outputTempFileName  destination
+  *           char*     datasetName         original file; "-" for standard input
+  *           char*     outputFileName      output file; derived from datasetName if empty
+  *           char*     spoolFileName       destination
+  *           DatasetWriter& outputFile     output file (for the extension of its compression)
+  *           bool      stream              the dataset can be read only once (stdin, FIFO)
   *
-  *       Return:
-  *           bool                        true if integer    
-  * Process Synopsis :
-  *
-  * Notes :             
-  *
-  */
-
-
-bool legal_int(char *str) {
-    while (*str)
-        if (!isdigit(*str++))
-            return false;
-    return true;
-}
-
-/**
-  * Name:               int main(int argc, char* argv[])
-  *
-  * Description :       Main function of program
-  *
-  * Input :
+  * Output/Expected Changes :
   *       Parameters:
-  *           int       argc                Number of arguments passed to program 
-  *           char*     argv[]              An array containing the aforementioned arguments
-  *
+  *           char*     inputTempFileName   original_temp_copy.ext
+  *           char*     outputTempFileName  original_temp_corrected.ext
+  *           char*     outputFileName      original_QUESS_corrected.ext if it was empty
+  *           char*     spoolFileName       original_temp_records.ext for a stream, empty otherwise
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
   *
   * Process Synopsis :
-  *                     [1]  Creates the working temp files using input arguments
-  *                     [2]  Compute seeds and bucket size (number of reads simultaneously read)
-  *                     [3]  For each seed:
-  *                     [4]         Insert the sMers of the input fastx file
-  *                     [5]         Rehash the aforementioned sMers into only values with high frequency
-  *                     [6]         Insert the sGaps of the input fastx file
-  *                     [7]         Determine the sGaps with the highest amount of support/delete ambigious sMers
-  *                     [8]         Correct the temp fastx file based on the correct sGaps
-  *                     [9]  Delete the working files and finalize results
+  *                     [1]  Use string functions to create the names
   *
-  * Notes :             
+  * Notes :             Used by createWorkingFiles and, to find the working files of an interrupted run, by --resume.
   *
   */
 
-int main(int argc, char* argv[])
+void nameWorkingFiles(char* inputTempFileName, char* outputTempFileName, char* datasetName, char* outputFileName, char* spoolFileName, DatasetWriter& outputFile, bool stream)
 {
-
-  time_t iteration_time_start, iteration_time_end, total_time_start, total_time_end;
-  time(&total_time_start);
-  int weight = 0, numberOfSeeds = 0;
-  uint64_t genomeLength=0;
-  char *inputFileName = new char [1000];
-  bool setFile=false;
-  if (argc < 3) {
-      show_usage();
-      return 1;
-  }
-  for (int i = 1; i < argc; ++i) {
-      string arg = argv[i];
-      if ((arg == "-h") || (arg == "--help")) {
-          show_usage();
-          return 0;
-      } 
-      else {
-        if ((arg == "-g") || (arg == "--genome-size")){
-          if (i+1 <argc && legal_int(argv[i+1])){
-              genomeLength=strtoull(argv[i+1], NULL, 10);
-          }
-          else{
-            cerr << "--genome-size requires a integer argument! Run ./QUESS --help for all options!"<<endl; 
-            exit(1);
-          }
-        }
-        if ((arg == "-i") || (arg == "--input-file")){
-          if (i+1 <argc){
-            inputFileName=argv[i+1];
-    	    setFile=true;
-          }
-          else{
-            cerr << "--input-file requires a filename! Run ./QUESS --help for all options!"<<endl; 
-            exit(1);
-          }
-        }
-        if ((arg == "-w") || (arg == "--weight")){
-          if (i+1 <argc && legal_int(argv[i+1]) && strtoull(argv[i+1], NULL, 10)>=10 && strtoull(argv[i+1], NULL, 10)<=26 ){
-            weight=strtoull(argv[i+1], NULL, 10);
-          }
-          else{
-            cerr << "--weight requires an integer between 10 to 26! Run ./QUESS --help for all options!"<<endl; 
-            exit(1);
-          }
-        }
-        if ((arg == "-n") || (arg == "--number-of-seeds")){
-          if (i+1 <argc && legal_int(argv[i+1]) && strtoull(argv[i+1], NULL, 10)>=1 && strtoull(argv[i+1], NULL, 10)<=8 ){
-            numberOfSeeds=strtoull(argv[i+1], NULL, 10);
-          }
-          else{
-            cerr << "--number-of-seeds requires an integer between 1 to 8! Run ./QUESS --help for all options!"<<endl; 
-            exit(1);
-          }
-        }
-      }
-    }
-    // correcting parameters; ABOVE T means >= T, BELOW means < T
-    // Tc and Te will be computed later; Tdiff is given here
-  int Tc = 8;       // Frequent s_mers or s_gaps: count >= Tc; default = 8 (will be recomputed later)
-  int Te = Tc / 2;        // Erroneous s_mers or s_gaps: count < Te:  Te < Tc; default = 4 (will be Te = Tc/2)
-  int Tdiff = 2;     // Maximum s_gap difference allowed for replacing an s_gap with another; default = 2
-	
-	
-    uint64_t peakMemory=0,currentMemory=0;
-  // ============== SEEDS =================
-    int64_t numberOfReads = 0;
-    int64_t readLength = 0, totalReadLength = 0;    // readLength = (int64_t) (totalReadLength / numberOfReads)
-    
-    if (numberOfSeeds == 0)
-      numberOfSeeds = 8;
-    if (genomeLength==0){
-      cerr << "--genome-length is required! Run ./QUESS --help for all options!"<<endl;  
-      exit(1);
-    }
-    if (setFile==false){
-      cerr << "--input-file is required! Run ./QUESS --help for all options!"<<endl;
-      exit(1);
-    }
-    // ============ FILES ====================
-    // make a copy of input: input.ext -> input_copy_w_k.ext (w = weight, k = number of seeds)
-    // create output: input.ext -> input_corrected_w_k.ext
-    // argv[3] = original dataset (FASTX)
-    // inputTempFile = only the reads from datasetName
-    // outputTempFile = only reads but corrected; moved into inputTempFile after each iteration
-    // outputFile = corrected dataset (FASTX); created at the end with headers and scores from original dataset and corrected reads from outputTempFile
-
-    char* inputTempFileName = new char[10000];
-    char* outputTempFileName = new char[10000];
-    char* outputFileName = new char[10000];
-    ifstream inputTempFile;
-    fstream outputTempFile;
-    ofstream outputFile;
-
-    createWorkingFiles(inputTempFileName, outputTempFileName, inputFileName, outputFileName, outputFile,numberOfReads, totalReadLength,peakMemory,currentMemory);
-    cout <<inputFileName<<endl;
-    if (totalReadLength>1000000000 && weight==0)
-        weight=20; 
-    if (totalReadLength<=1000000000 && weight==0)
-        weight=16;
-    char** seeds = new char*[numberOfSeeds]; // seed will hold the actual seed provided by the function getSeed
-    for (int64_t i = 0; i < numberOfSeeds; ++i)
+    char inputTempFileNameExtension[10000];
+    char* baseName = datasetName;       // the working files are named after the dataset
+    char stdinName[100];
+    if (strcmp(datasetName, "-") == 0)  // standard input: QUESS_stdin_<pid>.fastx in the current directory
     {
-        seeds[i] = new char[1000];
-      getSeed(seeds[i],weight, numberOfSeeds, i, peakMemory, currentMemory);
-    }
-    
-    cout << "============ SEEDS ============\n";
-    cout << "weight = " << weight << endl;
-    cout << "numberOfSeeds = " << numberOfSeeds << endl;
-    cout << "seeds:" << endl;
-    for (int64_t i = 0; i < numberOfSeeds; ++i)
-        cout << seeds[i] << endl;
-
-    //===== useful precomputed arrays =======
-    uint64_t* diff16Bits = new uint64_t[1 << 16];
-    for (uint64_t i = 0; i < (1 << 16); ++i)
-        diff16Bits[i] = HashTable::computeDiff16Bits(i);
-    
-    currentMemory+=3*10000*sizeof(char)+(1 << 16)*sizeof(uint64_t)+5*sizeof(uint64_t)+4*sizeof(int)+numberOfSeeds*1000*sizeof(char)+430*sizeof(uint64_t)+sizeof(ifstream)+sizeof(ofstream)+sizeof(fstream)+4*sizeof(time_t);
-    if (currentMemory > peakMemory)
-    {   
-        peakMemory = currentMemory;
-#ifdef VERBOSE
-        cout << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
-#endif
+        sprintf(stdinName, "QUESS_stdin_%d.fastx", (int)getpid());
+        baseName = stdinName;
     }
-
-    // 2 * "bucketSize" = the number of reads loaded at a time
-    uint64_t bucketSize = uint64_t(genomeLength * 10 / MAX_READ_LENGTH);
-
-    //======== START CORRECTING =================
-    readLength = (int64_t)(totalReadLength / numberOfReads);
-    computeTc(readLength, numberOfReads, genomeLength, weight, 0.005, Tc);
-    HashTable H((uint64_t)(genomeLength*2));          // starting hash size
-    uint64_t size=genomeLength*2;
-
-    currentMemory+=size*sizeof(uint64_t);
-    if (currentMemory > peakMemory)
-    {   
-        peakMemory = currentMemory;
-#ifdef VERBOSE
-        cout << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
-#endif
+    uint64_t nameLength = 0;
+    isCompressedName(baseName, nameLength);      // reads.fastq.gz is named as reads.fastq; the working files are not compressed
+    char* lastDot = (char*)memrchr(baseName, '.', nameLength);
+    uint64_t prefixLength = lastDot ? (uint64_t)(lastDot - baseName) : nameLength;
+    memcpy(inputTempFileName, baseName, prefixLength);
+    inputTempFileName[prefixLength] = '\0';
+    memcpy(inputTempFileNameExtension, baseName + prefixLength, nameLength - prefixLength);
+    inputTempFileNameExtension[nameLength - prefixLength] = '\0';
+    strcpy(outputTempFileName, inputTempFileName);
+    strcpy(spoolFileName, "");
+    if (stream)    // a pipe can be read only once; its headers and scores are kept for createOutputFile
+    {
+        strcpy(spoolFileName, inputTempFileName);
+        strcat(spoolFileName, "_temp_records");
+        strcat(spoolFileName, inputTempFileNameExtension);
     }
-
-    cout << "\n=============== QUESS V 1.0.1 ==============\n";
-    
-    for (int64_t seedNumber = 0; seedNumber < numberOfSeeds; ++seedNumber)
+    if (outputFileName[0] == '\0')  // not given with --output-file
     {
-
-        cout << "\n=============== SEED " << seedNumber <<  " ==============\n";
-        time(&iteration_time_start);
-
-        Seed currentSeed = Seed(seeds[seedNumber]);
-
-        inputTempFile.open(inputTempFileName);      // in: uncorrected reads
-        if (!inputTempFile.is_open()) {   cerr << "Cannot open input temp file: " << inputTempFileName << endl; exit(1); }
-        outputTempFile.open(outputTempFileName, ios::out);  // out: corrected reads
-        if (!outputTempFile.is_open()) {   cerr << "Cannot open output temp file: " << outputTempFileName << endl; exit(1); }
-        Te = max(2,(seedNumber<=3) ? Tc/4 : Tc/2); 
-        Tdiff = (seedNumber <= 3) ? 4 : 2; 
-        
-        insertSMers(seedNumber, currentSeed, H, inputTempFile, bucketSize, peakMemory,currentMemory);
-        size=H.getSize(); 
-        rehashFrequentSMers(H, Tc,peakMemory,currentMemory);
-        insertSGaps(currentSeed, H, inputTempFile, Te, bucketSize, (int)seedNumber, peakMemory,currentMemory);
-        removeAmbiguousSMers(H, Tc, Te, (int)seedNumber, peakMemory,currentMemory);
-
-        correct(seedNumber, currentSeed, H, inputTempFile, outputTempFile, Tdiff, diff16Bits, bucketSize,peakMemory,currentMemory);
-
-        cout << "\n==== PARAMETERS ====\n";
-        cout << "genomeLength = " << genomeLength << endl;
-        cout << "number of reads = " << numberOfReads << endl;
-        cout << "read length (weighted avg.) = " << readLength << endl;
-        cout << "seed weight = " << weight << endl;
-        cout << "Peak Memory Usage = " << peakMemory/1048576 << " MB"<<endl;       
-        cout << "Current Memory Usage = " << currentMemory/1048576 << " MB"<<endl;     
-        cout << "Tc    = " << Tc << endl;
-        cout << "Te    = " << Te << endl;
-        cout << "Tdiff = " << Tdiff << endl;
-        cout << "====================\n" << endl;
-        inputTempFile.close();
-        outputTempFile.close();
-        H.clear(peakMemory,currentMemory);
-        swapFiles(inputTempFileName, outputTempFileName, seedNumber, numberOfSeeds);
-        
-        time(&iteration_time_end);
-        cout << "\n============ DONE SEED " << seedNumber << " (" << difftime(iteration_time_end, iteration_time_start) << "s) ===========\n" << endl;
+        strcpy(outputFileName, inputTempFileName);
+        strcat(outputFileName,"_QUESS_corrected");
+        strcat(outputFileName, inputTempFileNameExtension);
+        strcat(outputFileName, outputFile.extension());
     }
 
-    // ======== create the "outputFile" ===========
-    // headers and scores from "datasetName" with corrected reads from "outputTempFile"
+    strcat(inputTempFileName,"_temp_copy");
+    strcat(inputTempFileName, inputTempFileNameExtension);
 
-    createOutputFile(inputFileName, outputTempFileName, outputTempFile, outputFileName, outputFile);
-    time(&total_time_end);
-    cout << "\n=================== END (" << difftime(total_time_end, total_time_start) << "s) ======================" << endl;
-    cout << "==================================================" << endl;
-    return 0;
-}
+    strcat(outputTempFileName,"_temp_corrected");
+    strcat(outputTempFileName, inputTempFileNameExtension);
 
+    quessLog << "original dataset: " << datasetName << endl;
+    quessLog << "temp uncorrected file: " << inputTempFileName << endl;
+    quessLog << "temp corrected file:   " << outputTempFileName << endl;
+    if (spoolFileName[0] != '\0')
+        quessLog << "temp records file:     " << spoolFileName << endl;
+    quessLog << "corrected file:   " << outputFileName << endl;
+}
 
 /**
-  * Name:               createWorkingFiles(char* inputTempFileName, char* outputTempFileName, char* datasetName, char* outputFileName,  std::ofstream& outputFile, int64_t& numberOfReads, int64_t& totalReadLength,uint64_t &peakMemory, uint64_t &currentMemory)
+  * Name:               createWorkingFiles(char* inputTempFileName, char* outputTempFileName, char* datasetName, char* outputFileName, char* spoolFileName, char* qualityFileName, DatasetWriter& outputFile, int64_t& numberOfReads, int64_t& totalReadLength,uint64_t &peakMemory, uint64_t &currentMemory)
   *
   * Description :       Creates the working files for the runtime of the program
   *
@@ -312,9 +112,11 @@ int main(int argc, char* argv[])
   *       Parameters:
   *           char*     inputTempFileName   filename of copy of original reads              
   *           char*     outputTempFileName  filename of correct reads of input file
-  *           char*     datasetName         original file
-  *           char*     outputFileName      output file
-  *           std::ofstream& outputFile     pointer to output file
+  *           char*     datasetName         original file; "-" for standard input
+  *           char*     outputFileName      output file; derived from datasetName if empty
+  *           char*     spoolFileName       headers and scores of the dataset if it is a pipe (empty otherwise)
+  *           char*     qualityFileName     destination for the name of the file of binned scores; NULL = not kept
+  *           DatasetWriter& outputFile     pointer to output file
   *           int64_t&  numberOfReads       number of reads in original file
   *           int64_t&  totalReadLength     total number of base pairs of original file
   *           uint64_t  &peakMemory         Peak memory of program
@@ -322,7 +124,8 @@ int main(int argc, char* argv[])
   *
   * Output/Expected Changes :
   *       Parameters:
-  *           std::ofstream& outputFile     Output file will be pointed to do write in later
+  *           DatasetWriter& outputFile     Output file will be pointed to do write in later
+  *           char*     qualityFileName     <inputTempFileName>_qual; empty for FASTA (no scores)
   *           uint64_t  &peakMemory         peakMemory is recorded and estimated for testing
   *           uint64_t  &currentMemory      currentMemory is recorded and estimated for testing
   *       Memory:
@@ -331,9 +134,16 @@ int main(int argc, char* argv[])
   *           None
   *
   * Process Synopsis :
-  *                     [1]  Use string functions to create files
-  *                     [2]  Copy the original dataset into the copy of the dataset with only relevant information
+  *                     [1]  Name the working files (nameWorkingFiles)
+  *                     [2]  For a dataset that can be read only once (stdin, FIFO), the records without their bases
+  *                             (parseRecords) go to spoolFileName; its working files are removed if the program ends
+  *                             before createOutputFile (removeAtAbnormalExit)
+  *                     [3]  Copy the original dataset into the copy of the dataset with only relevant information
   *                             Discard Quality and comments and only keep the identity of the reads
+  *                             With qualityFileName, the scores are binned to 2 bits (packQualities) in a file of their own
+  *                     [4]  The dataset is read in windows of PARSE_WINDOW_SIZE bytes; each window is split into
+  *                             byte ranges, resynchronized on record starts and parsed in parallel (parseWindow);
+  *                             incomplete records at the end of a window are carried over
   *
   * Notes :             
   *                     original.ext: e.g. "ext" = "fastx"                 - datasetName
@@ -343,46 +153,19 @@ int main(int argc, char* argv[])
   *                     fasta files alternate between comment and identitiy
   *                     fastq files alternate between comment, identity, comment, and quality.
   *                     fasta files are identified by '@', fastq are identified by '>'
+  *                     fasta reads may span several lines; they are concatenated
   *
   */
 
-void createWorkingFiles(char* inputTempFileName, char* outputTempFileName, char* datasetName, char* outputFileName,  std::ofstream& outputFile, int64_t& numberOfReads, int64_t& totalReadLength,uint64_t &peakMemory, uint64_t &currentMemory)
+void createWorkingFiles(char* inputTempFileName, char* outputTempFileName, char* datasetName, char* outputFileName, char* spoolFileName, char* qualityFileName, DatasetWriter& outputFile, int64_t& numberOfReads, int64_t& totalReadLength,uint64_t &peakMemory, uint64_t &currentMemory)
 {
-    char *inputTempFileNameExtension = new char[10000];
-    currentMemory+=10000*sizeof(char);
-    if (currentMemory > peakMemory)
-    {   
-        peakMemory = currentMemory;
-#ifdef VERBOSE
-        cout << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
-#endif
-    }
-    char* lastDot = strrchr(datasetName,'.');
-    if (lastDot)
-        {   memcpy(inputTempFileName, datasetName, lastDot - datasetName);
-            memcpy(outputTempFileName, datasetName, lastDot - datasetName);
-            memcpy(outputFileName, datasetName, lastDot - datasetName);
-            memcpy(inputTempFileNameExtension, lastDot, strlen(datasetName) - (lastDot - datasetName));
-        }
-        else
-            {   strcpy(inputTempFileName, datasetName);
-                strcpy(outputTempFileName, datasetName);
-                strcpy(outputFileName, datasetName);
-                strcpy(inputTempFileNameExtension, "");
-            }
-            strcat(inputTempFileName,"_temp_copy");
-            strcat(inputTempFileName, inputTempFileNameExtension);
-
-            strcat(outputTempFileName,"_temp_corrected");
-            strcat(outputTempFileName, inputTempFileNameExtension);
-
-            strcat(outputFileName,"_QUESS_corrected");
-            strcat(outputFileName, inputTempFileNameExtension);
+    DatasetReader datasetFile;
+    datasetFile.open(datasetName);
+    if (!datasetFile.is_open()) throw QuessError("Cannot open input dataset file: " + string(datasetName));
+    if (datasetFile.compression() != 'p')
+        quessLog << "compressed dataset: " << ((datasetFile.compression() == 'b') ? "BGZF (parallel decompression)" : "gzip") << endl;
 
-            cout << "original dataset: " << datasetName << endl;
-            cout << "temp uncorrected file: " << inputTempFileName << endl;
-            cout << "temp corrected file:   " << outputTempFileName << endl;
-            cout << "corrected file:   " << outputFileName << endl;
+    nameWorkingFiles(inputTempFileName, outputTempFileName, datasetName, outputFileName, spoolFileName, outputFile, datasetFile.is_stream());
 
     // datasetName = original dataset (FASTX)
     // inputTempFile = only the reads from datasetName
@@ -391,47 +174,373 @@ void createWorkingFiles(char* inputTempFileName, char* outputTempFileName, char*
 
     // ======= copy ony the reads from "datasetFile" to "inputTempFile" =========
 
-            std::ifstream datasetFile;
-            datasetFile.open(datasetName);
-            if (!datasetFile.is_open()) {   cerr << "Cannot open input dataset file: " << datasetName << endl; exit(1); }
-
-            std::ofstream copyReads;
+            BlockWriter copyReads;
             copyReads.open(inputTempFileName);
-            if (!copyReads.is_open()) {   cerr << "Cannot open input temp file: " << inputTempFileName << endl; exit(1); }
+            if (!copyReads.is_open()) throw QuessError("Cannot open input temp file: " + string(inputTempFileName));
+
+            BlockWriter spoolFile;
+            if (spoolFileName[0] != '\0')
+            {
+                spoolFile.open(spoolFileName);
+                if (!spoolFile.is_open()) throw QuessError("Cannot open temp records file: " + string(spoolFileName));
+            }
+
+            BlockWriter qualityFile;     // opened once the dataset is known to be FASTQ
+            if (qualityFileName != NULL)
+                sprintf(qualityFileName, "%s_qual", inputTempFileName);
+            if (spoolFile.is_open())     // a pipe cannot be read again: its working files are of no use after an error
+            {
+                removeAtAbnormalExit(spoolFileName);
+                removeAtAbnormalExit(inputTempFileName);
+                removeAtAbnormalExit(outputTempFileName);
+                if (qualityFileName != NULL)
+                    removeAtAbnormalExit(qualityFileName);
+            }
 
-            char* tempRead = new char[MAX_READ_LENGTH];
-            char fastx;
-            currentMemory+=MAX_READ_LENGTH*sizeof(char);
+    // the dataset is read in windows; each window is split into numberOfChunks byte ranges, each starting at a record,
+    // that are parsed in parallel; the reads of each range go to their own part of parsedReads and are written in order
+    // a record not complete at the end of a window is carried over to the beginning of the next window
+            int64_t numberOfChunks = 4 * omp_get_max_threads();
+            char* window = new char[PARSE_WINDOW_SIZE];
+            ParsedChunks chunks;
+            chunks.reads = new char[PARSE_WINDOW_SIZE + numberOfChunks];
+            chunks.start = new uint64_t[numberOfChunks + 1];
+            chunks.stop = new uint64_t[numberOfChunks];
+            chunks.readsLength = new uint64_t[numberOfChunks];
+            chunks.qualitiesLength = new uint64_t[numberOfChunks];
+            chunks.counts = new FastxCounts[numberOfChunks];
+            FastxCounts counts = {0, 0, 0, 0};
+            char* parsedQualities = (qualityFileName != NULL) ? new char[PARSE_WINDOW_SIZE + numberOfChunks] : NULL;
+            uint64_t qualityMemory = (qualityFileName != NULL) ? (PARSE_WINDOW_SIZE + numberOfChunks) * sizeof(char) : 0;
+            chunks.recordsLength = new uint64_t[numberOfChunks];
+            chunks.records = spoolFile.is_open() ? new char[2 * (PARSE_WINDOW_SIZE + numberOfChunks)] : NULL;     // at most twice the bytes (parseRecords)
+            uint64_t recordMemory = numberOfChunks * sizeof(uint64_t) + (spoolFile.is_open() ? 2 * (PARSE_WINDOW_SIZE + numberOfChunks) * sizeof(char) : 0);
+            currentMemory+=2*PARSE_WINDOW_SIZE*sizeof(char)+numberOfChunks*(sizeof(char)+5*sizeof(uint64_t)+sizeof(FastxCounts))+qualityMemory+recordMemory+datasetFile.memoryUsage();
             if (currentMemory > peakMemory)
             {   
                 peakMemory = currentMemory;
 #ifdef VERBOSE
-                cout << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
+                quessLog << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
 #endif
             }
-    while (datasetFile.getline(tempRead, MAX_READ_LENGTH))      // read header
+    uint64_t windowLength = 0;
+    char fastx = 0;
+    bool lastWindow = false;
+    string error;       // thrown once the buffers are freed
+    while (!lastWindow)
     {
-        fastx = tempRead[0];
-        datasetFile.getline(tempRead, MAX_READ_LENGTH); // read read
-        ++numberOfReads;
-        totalReadLength += strlen(tempRead);
-        copyReads << tempRead << '\n';
-        if (fastx == '@')     // FASTQ
+        uint64_t bytesRead = datasetFile.read(window + windowLength, PARSE_WINDOW_SIZE - windowLength);
+        windowLength += bytesRead;
+        lastWindow = (windowLength < PARSE_WINDOW_SIZE);
+        if (fastx == 0)
         {
-            datasetFile.getline(tempRead, MAX_READ_LENGTH); // skip read score header (FASTQ)
-            datasetFile.getline(tempRead, MAX_READ_LENGTH); // skip read scores (FASTQ)
-        }
-        else
-            if (fastx != '>')
+            fastx = (windowLength > 0) ? window[0] : '>';
+            if ((fastx != '@') && (fastx != '>'))
             {
-                cerr << "input data is not a correct FASTA or FASTQ file" << endl;
-                exit(1);
+                error = "input data is not a correct FASTA or FASTQ file";
+                break;
             }
+            if ((qualityFileName != NULL) && (fastx == '@'))
+            {
+                qualityFile.open(qualityFileName);
+                if (!qualityFile.is_open()) {   error = "Cannot open quality temp file: " + string(qualityFileName); break; }
+            }
+            else if (qualityFileName != NULL)
+            {
+                quessLog << "FASTA dataset: no quality scores to keep" << endl;
+                qualityFileName[0] = '\0';
+            }
+        }
+        chunks.qualities = qualityFile.is_open() ? parsedQualities : NULL;
+        int64_t chunksDone = 0;
+        uint64_t consumed = parseWindow(window, windowLength, lastWindow, fastx, numberOfChunks, chunks, chunksDone);
+
+        // write the reads in order, up to the first record that continues in the next window
+        for (int64_t k = 0; k < chunksDone; ++k)
+        {
+            copyReads.write(chunks.reads + chunks.start[k] + k, chunks.readsLength[k]);
+            if (qualityFile.is_open())
+                qualityFile.write(chunks.qualities + chunks.start[k] + k, chunks.qualitiesLength[k]);
+            if (spoolFile.is_open())
+                spoolFile.write(chunks.records + 2 * (chunks.start[k] + k), chunks.recordsLength[k]);
+            counts.numberOfReads += chunks.counts[k].numberOfReads;
+            counts.totalReadLength += chunks.counts[k].totalReadLength;
+            counts.truncatedReads += chunks.counts[k].truncatedReads;
+            counts.badRecords += chunks.counts[k].badRecords;
+        }
+        if ((consumed == 0) && (windowLength == PARSE_WINDOW_SIZE))
+        {
+            error = "record longer than " + to_string(PARSE_WINDOW_SIZE) + " bytes in " + datasetName;
+            break;
+        }
+        memmove(window, window + consumed, windowLength - consumed);
+        windowLength -= consumed;
     }
+    if ((counts.badRecords > 0) && error.empty())
+        error = "input data is not a correct FASTA or FASTQ file";
+    delete [] window;
+    delete [] chunks.reads;
+    delete [] chunks.start;
+    delete [] chunks.stop;
+    delete [] chunks.readsLength;
+    delete [] chunks.qualitiesLength;
+    delete [] chunks.counts;
+    delete [] parsedQualities;
+    delete [] chunks.recordsLength;
+    delete [] chunks.records;
+    currentMemory-=2*PARSE_WINDOW_SIZE*sizeof(char)+numberOfChunks*(sizeof(char)+5*sizeof(uint64_t)+sizeof(FastxCounts))+qualityMemory+recordMemory+datasetFile.memoryUsage();
     datasetFile.close();
     copyReads.close();
-    cout << "numberOfReads = " << numberOfReads << endl;
-    cout << "totalReadLength = " << totalReadLength << endl;
+    spoolFile.close();
+    qualityFile.close();
+    if (!error.empty())
+        throw QuessError(error);
+    if (counts.truncatedReads > 0)
+        quessLog << "reads longer than " << MAX_READ_LENGTH - 1 << " (corrected only up to that length): " << counts.truncatedReads << endl;
+    numberOfReads += counts.numberOfReads;
+    totalReadLength += counts.totalReadLength;
+    quessLog << "numberOfReads = " << numberOfReads << endl;
+    quessLog << "totalReadLength = " << totalReadLength << endl;
+}
+
+/**
+  * Name:               extractShard(char* datasetName, char* shardFileName, char* outputFileName, DatasetWriter& outputFile, int64_t shard, int64_t numberOfShards)
+  *
+  * Description :       Copies one of numberOfShards consecutive ranges of records of the dataset to a shard file
+  *
+  * Input :
+  *       Parameters:
+  *           char*     datasetName         original file (not a pipe: it is read twice)
+  *           char*     shardFileName       destination for the name of the shard file
+  *           char*     outputFileName      output file; derived from datasetName and the shard if empty
+  *           DatasetWriter& outputFile     output file (for the extension of its compression)
+  *           int64_t   shard               1 .. numberOfShards
+  *           int64_t   numberOfShards      number of shards
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           char*     shardFileName       <prefix>_temp_shard<i>of<n>.<ext> (uncompressed)
+  *           char*     outputFileName      <prefix>_QUESS_corrected_shard<i>of<n>.<ext> if it was empty
+  *       Memory:
+  *           None
+  *       Return:
+  *           int64_t                       number of records in the shard
+  *
+  * Process Synopsis :
+  *                     [1]  Count the records of the dataset
+  *                     [2]  Shard i gets records (i-1)*N/n .. i*N/n - 1; copy their lines to the shard file
+  *
+  * Notes :             The shard file is then corrected as a dataset; the corrected shards, concatenated
+  *                     in the order of i, are the corrected dataset. Empty lines are not copied.
+  *
+  */
+
+int64_t extractShard(char* datasetName, char* shardFileName, char* outputFileName, DatasetWriter& outputFile, int64_t shard, int64_t numberOfShards)
+{
+    DatasetReader datasetFile;
+    datasetFile.open(datasetName);
+    if (!datasetFile.is_open()) throw QuessError("Cannot open input dataset file: " + string(datasetName));
+    if (datasetFile.is_stream()) throw QuessError("Shards are read from a file, not a pipe: " + string(datasetName));
+
+    uint64_t nameLength = 0;
+    isCompressedName(datasetName, nameLength);
+    char* lastDot = (char*)memrchr(datasetName, '.', nameLength);
+    uint64_t prefixLength = lastDot ? (uint64_t)(lastDot - datasetName) : nameLength;
+    string prefix(datasetName, prefixLength), extension(datasetName + prefixLength, nameLength - prefixLength);
+    char shardName[100];
+    sprintf(shardName, "shard%0*dof%d", (int)to_string(numberOfShards).size(), (int)shard, (int)numberOfShards);
+    strcpy(shardFileName, (prefix + "_temp_" + shardName + extension).c_str());
+    if (outputFileName[0] == '\0')
+        strcpy(outputFileName, (prefix + "_QUESS_corrected_" + shardName + extension + outputFile.extension()).c_str());
+
+    // records are counted as createOutputFile reads them: FASTQ 4 lines, FASTA from one '>' line to the next
+    char* line = new char[MAX_LINE_LENGTH];
+    char fastx = 0;
+    int64_t numberOfRecords = 0, numberOfLines = 0;
+    while (datasetFile.getline(line, MAX_LINE_LENGTH))
+    {
+        if ((line[0] == '\0') || (line[0] == '\r'))
+            continue;
+        if (fastx == 0)
+            fastx = line[0];
+        if ((fastx == '@') ? (numberOfLines % 4 == 0) : (line[0] == '>'))
+            ++numberOfRecords;
+        ++numberOfLines;
+    }
+    datasetFile.close();
+    if ((fastx != '@') && (fastx != '>'))
+    {
+        delete [] line;
+        throw QuessError("input data is not a correct FASTA or FASTQ file");
+    }
+    int64_t firstRecord = (shard - 1) * numberOfRecords / numberOfShards, lastRecord = shard * numberOfRecords / numberOfShards;
+
+    BlockWriter shardFile;
+    shardFile.open(shardFileName);
+    if (!shardFile.is_open()) {   delete [] line; throw QuessError("Cannot open shard file: " + string(shardFileName)); }
+    datasetFile.open(datasetName);
+    int64_t record = -1;
+    numberOfLines = 0;
+    while (datasetFile.getline(line, MAX_LINE_LENGTH))
+    {
+        if ((line[0] == '\0') || (line[0] == '\r'))
+            continue;
+        if ((fastx == '@') ? (numberOfLines % 4 == 0) : (line[0] == '>'))
+            ++record;
+        ++numberOfLines;
+        if (record >= lastRecord)
+            break;
+        if (record >= firstRecord)
+            shardFile.writeLine(line);
+    }
+    datasetFile.close();
+    shardFile.close();
+    delete [] line;
+    quessLog << "shard " << shard << " of " << numberOfShards << ": records " << firstRecord << " - " << lastRecord - 1 << " of " << numberOfRecords << endl;
+    quessLog << "shard file: " << shardFileName << endl;
+    return lastRecord - firstRecord;
+}
+
+/**
+  * Name:               getMemoryLimit()
+  *
+  * Description :       Memory limit of the cgroup of the process (e.g., the limit of a container or a batch job)
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           uint64_t                      limit in bytes; 0 if there is none
+  *
+  * Process Synopsis :
+  *                     [1]  cgroup v2: /sys/fs/cgroup/memory.max ("max" = no limit)
+  *                     [2]  cgroup v1: /sys/fs/cgroup/memory/memory.limit_in_bytes (huge value = no limit)
+  *
+  * Notes :             
+  *
+  */
+
+uint64_t getMemoryLimit()
+{
+    const char* limitFileNames[2] = {"/sys/fs/cgroup/memory.max", "/sys/fs/cgroup/memory/memory.limit_in_bytes"};
+    for (int i = 0; i < 2; ++i)
+    {
+        ifstream limitFile(limitFileNames[i]);
+        string limit;
+        if (!(limitFile >> limit))
+            continue;
+        if ((limit[0] < '0') || (limit[0] > '9'))     // "max"
+            return 0;
+        uint64_t bytes = strtoull(limit.c_str(), NULL, 10);
+        return (bytes >= (1ULL << 60)) ? 0 : bytes;
+    }
+    return 0;
+}
+
+/**
+  * Name:               planMemory(uint64_t budget, uint64_t genomeLength, uint64_t bucketSize, bool buildModels, MemoryPlan& plan)
+  *
+  * Description :       Plans the bucket size, the counting table, the sMer partitions and the sGap locks within a memory budget
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t  budget              bytes
+  *           uint64_t  genomeLength        approximate length of the genome (expected number of frequent sMers)
+  *           uint64_t  bucketSize          bucket size without a budget
+  *           bool      buildModels         false: models from a correction index; only the buckets are planned
+  *           MemoryPlan& plan              destination
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           MemoryPlan& plan              the planned sizes; plan.required = estimated bytes needed at least
+  *       Memory:
+  *           None
+  *       Return:
+  *           bool                          false if the budget is smaller than plan.required
+  *
+  * Process Synopsis :
+  *                     [1]  Fixed memory: PLAN_RESERVED_MEMORY and the I/O buffers of PLAN_OPEN_FILES files
+  *                     [2]  Buckets: at most 1/8 of the rest (and what the model leaves), at least PLAN_MIN_BUCKET_SIZE reads
+  *                     [3]  Model of a seed (frequent sMers, sGaps, locks) must fit in the rest
+  *                     [4]  Counting table: the rest less the list of frequent sMers (insertFrequentSMers);
+  *                          if the usual table (2 * genomeLength) does not fit, the sMers are counted in partitions
+  *                     [5]  If the model does not fit with the default I/O buffers, fewer and then smaller buffers
+  *                          are used (planIOBuffers); if it does not fit with the smallest ones, it is built in
+  *                          partitions spilled to disk (buildPartitionedModel): then only the merged model
+  *                          (2 Elements per position, smaller than the whole model) must fit besides the buckets
+  *
+  * Notes :             The sizes of the model are estimates (about genomeLength frequent sMers); insertFrequentSMers
+  *                     adds partitions if the counting table is still too small. plan.required is computed with
+  *                     the smallest I/O buffers.
+  *
+  */
+
+// the largest I/O buffers of the open files within ioBudget: fewer blocks first, then smaller ones
+static void planIOBuffers(uint64_t ioBudget, MemoryPlan& plan)
+{
+    plan.numberOfIOBuffers = NUMBER_OF_IO_BUFFERS;
+    plan.ioBufferSize = IO_BUFFER_SIZE;
+    while ((PLAN_OPEN_FILES * plan.numberOfIOBuffers * plan.ioBufferSize > ioBudget) && (plan.numberOfIOBuffers > MIN_NUMBER_OF_IO_BUFFERS))
+        --plan.numberOfIOBuffers;
+    while ((PLAN_OPEN_FILES * plan.numberOfIOBuffers * plan.ioBufferSize > ioBudget) && (plan.ioBufferSize > MIN_IO_BUFFER_SIZE))
+        plan.ioBufferSize /= 2;
+}
+
+bool planMemory(uint64_t budget, uint64_t genomeLength, uint64_t bucketSize, bool buildModels, MemoryPlan& plan)
+{
+    uint64_t bytesPerRead = 4*MAX_READ_LENGTH*sizeof(char) + 2*sizeof(uint64_t) + sizeof(uint8_t);  // 2 buckets, bases, read
+    uint64_t smallestIOMemory = PLAN_OPEN_FILES*MIN_NUMBER_OF_IO_BUFFERS*MIN_IO_BUFFER_SIZE;
+    uint64_t frequentSMers = genomeLength;
+    uint64_t modelMemory = 0, listMemory = 0, wholeModelMemory = 0;
+    plan.budget = budget;
+    plan.numberOfLocks = omp_get_max_threads() * PLAN_LOCKS_PER_THREAD;
+    plan.partitionedModel = false;
+    if (buildModels)
+    {
+        modelMemory = (uint64_t)(1.7 * frequentSMers) * (sizeof(Element) + sizeof(Element*))   // table, sGapTable
+                    + frequentSMers * PLAN_SGAP_BYTES + plan.numberOfLocks * sizeof(omp_lock_t);
+        listMemory = frequentSMers * sizeof(uint64_t);
+        modelMemory = max(modelMemory, listMemory + max((uint64_t)(1.7 * frequentSMers), (uint64_t) PLAN_MIN_TABLE_SIZE) * sizeof(Element));
+    }
+    plan.required = PLAN_RESERVED_MEMORY + smallestIOMemory + PLAN_MIN_BUCKET_SIZE * bytesPerRead + modelMemory;
+    uint64_t mergedModelMemory = max((uint64_t)(1.7 * frequentSMers), (uint64_t) PLAN_MIN_TABLE_SIZE) * 2 * sizeof(Element);
+    if (buildModels && (budget < plan.required) && (mergedModelMemory < modelMemory))   // model built in partitions (buildPartitionedModel)
+    {
+        plan.partitionedModel = true;
+        wholeModelMemory = modelMemory;
+        modelMemory = mergedModelMemory;
+        listMemory = 0;
+        plan.required = PLAN_RESERVED_MEMORY + smallestIOMemory + PLAN_MIN_BUCKET_SIZE * bytesPerRead + modelMemory;
+    }
+    if (budget < plan.required)
+        return false;
+
+    planIOBuffers(budget - (plan.required - smallestIOMemory), plan);
+    uint64_t fixedMemory = PLAN_RESERVED_MEMORY + PLAN_OPEN_FILES * plan.numberOfIOBuffers * plan.ioBufferSize;
+    uint64_t available = budget - fixedMemory;
+    plan.bucketSize = min(bucketSize, min(available / 8, available - modelMemory) / bytesPerRead);
+    plan.bucketSize = max(plan.bucketSize, (uint64_t) PLAN_MIN_BUCKET_SIZE);
+    available -= plan.bucketSize * bytesPerRead;
+    if (!buildModels)
+    {
+        plan.tableSize = plan.tableLimit = 0;
+        plan.numberOfPartitions = 1;
+        return true;
+    }
+    plan.tableLimit = (available - listMemory) / sizeof(Element);
+    uint64_t tableSize = 2 * genomeLength;                           // the table of the constructor without a budget
+    uint64_t largestStart = max((uint64_t)(0.8 * plan.tableLimit), (uint64_t) PLAN_MIN_TABLE_SIZE);  // room for rounding up to a prime
+    plan.numberOfPartitions = (tableSize + largestStart - 1) / largestStart;
+    if (plan.partitionedModel)      // the model of a partition (with its sGap arrays) must fit as well
+        plan.numberOfPartitions = max(plan.numberOfPartitions, max((uint64_t) 2, (wholeModelMemory + available - 1) / available));
+    plan.tableSize = tableSize / plan.numberOfPartitions;
+    return true;
 }
 
 /**
@@ -487,7 +596,45 @@ void computeTc(int64_t readLength, int64_t numberOfReads, int64_t genomeLength,
 	//Tc/=3;
 }
 /**
-  * Name:               insertSMers(int64_t seedNumber, Seed& currentSeed, HashTable& H, std::ifstream& inputTempFile, int64_t bucketSize, uint64_t &peakMemory, uint64_t &currentMemory)
+  * Name:               getModelRead(BlockReader& inputTempFile, char* read, const uint64_t* modelReads, int64_t& readNumber)
+  *
+  * Description :       Reads the next read the models are built from
+  *
+  * Input :
+  *       Parameters:
+  *           BlockReader& inputTempFile    The reads (one per line)
+  *           char*     read                destination; MAX_READ_LENGTH chars
+  *           const uint64_t* modelReads    bit i set: read i is used (selectModelReads); NULL = all reads
+  *           int64_t&  readNumber          number of the next read of inputTempFile (0 after rewind)
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           char*     read                the read
+  *           int64_t&  readNumber          advanced past the read (and the reads skipped)
+  *       Memory:
+  *           None
+  *       Return:
+  *           bool                          false at end of file
+  *
+  * Process Synopsis :
+  *
+  * Notes :             Used by the counting passes (insertSMers, insertSGaps); correct reads all the reads.
+  *
+  */
+
+static bool getModelRead(BlockReader& inputTempFile, char* read, const uint64_t* modelReads, int64_t& readNumber)
+{
+    while (inputTempFile.getline(read, MAX_READ_LENGTH))
+    {
+        int64_t i = readNumber++;
+        if ((modelReads == NULL) || ((modelReads[i >> 6] >> (i & 63)) & 1))
+            return true;
+    }
+    return false;
+}
+
+/**
+  * Name:               insertSMers(int64_t seedNumber, Seed& currentSeed, HashTable& H, BlockReader& inputTempFile, int64_t bucketSize, const uint64_t* modelReads, uint64_t &peakMemory, uint64_t &currentMemory)
   *
   * Description :       Overhead function to insert sMers of the read
   *
@@ -496,8 +643,9 @@ void computeTc(int64_t readLength, int64_t numberOfReads, int64_t genomeLength,
   *           int64_t   seedNumber          The current iteration
   *           Seed&     currentSeed         Current identity of the spaced seed
   *           HashTable& H                  The hashTable
-  *           std::ifstream& inputTempFile  The pointer to the copy of the input file
+  *           BlockReader& inputTempFile  The pointer to the copy of the input file
   *           int64_t   bucketSize          The number of reads being processed in parallel using openMP
+  *           const uint64_t* modelReads    bit i set: read i is counted (selectModelReads); NULL = all reads
   *           uint64_t  &peakMemory         Peak memory of program
   *           uint64_t  &currentMemory      Current memory of program       
 
@@ -510,25 +658,26 @@ void computeTc(int64_t readLength, int64_t numberOfReads, int64_t genomeLength,
   *       Memory:
   *           None
   *       Return:
-  *           None
+  *           bool                          false if the table would grow beyond its size limit (the table is cleared)
   *
   * Process Synopsis :
   *                     [1]  Creates 2-D arrays that will will contain bucket*read_length chars.
   *                     [2]  Insert each read in parallel using openMP
-  *                     [3]  If load exceeds 0.85, resets the hashTable
+  *                     [3]  If load exceeds 0.85, resets the hashTable with double size (if allowed; otherwise stops)
   *                     [4]  Deallocate memory of the 2-D arrays
   *
   * Notes :             
   *
   */
 
-void insertSMers(int64_t seedNumber, Seed& currentSeed, HashTable& H, std::ifstream& inputTempFile, int64_t bucketSize, uint64_t &peakMemory, uint64_t &currentMemory)
+bool insertSMers(int64_t seedNumber, Seed& currentSeed, HashTable& H, BlockReader& inputTempFile, int64_t bucketSize, const uint64_t* modelReads, uint64_t &peakMemory, uint64_t &currentMemory)
 {
     time_t t_start, t_end;
-    cout << "\n\n============ INSERT S-MERS ============\n";
+    quessLog << "\n\n============ INSERT S-MERS ============\n";
     time(&t_start);
     
     // recreate hash table H with max size already used
+    H.setKeyMask(currentSeed.getKeyMask(), peakMemory, currentMemory);    // (compact counting) table for the sMers of this seed
     if (seedNumber != 0)
         H.recreateOfMaxSize(peakMemory,currentMemory);
 
@@ -548,11 +697,12 @@ void insertSMers(int64_t seedNumber, Seed& currentSeed, HashTable& H, std::ifstr
     {   
         peakMemory = currentMemory;
 #ifdef VERBOSE
-        cout << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
+        quessLog << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
 #endif
     }
 
     // insert all sMers of all reads
+    bool tableFits = true;                  // false if the table would have to grow beyond its size limit
     bool hashTableNotFull = false;          // whether hashTable is 85 % full or not
     bool endOfFile = false;
     bool done = false;
@@ -563,19 +713,19 @@ void insertSMers(int64_t seedNumber, Seed& currentSeed, HashTable& H, std::ifstr
         {   
             peakMemory = currentMemory;
 #ifdef VERBOSE
-            cout << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
+            quessLog << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
 #endif
         }
         hashTableNotFull = true;
 
-        inputTempFile.clear();              // file from beginning
-        inputTempFile.seekg(0, ios::beg);
+        inputTempFile.rewind();             // file from beginning
+        int64_t readNumber = 0;
         
         // load first bucket
         getBucketNumber++;
         currBucketSize = 0;
         while ((currBucketSize < bucketSize) && (!endOfFile))
-            if (inputTempFile.getline(currBucket[currBucketSize], MAX_READ_LENGTH))
+            if (getModelRead(inputTempFile, currBucket[currBucketSize], modelReads, readNumber))
                 ++currBucketSize;
             else
                 endOfFile = true;
@@ -596,7 +746,7 @@ void insertSMers(int64_t seedNumber, Seed& currentSeed, HashTable& H, std::ifstr
                         if (!endOfFile)
                         {
                             while ((nextBucketSize < bucketSize) && (!endOfFile))
-                                if (inputTempFile.getline(nextBucket[nextBucketSize], MAX_READ_LENGTH))
+                                if (getModelRead(inputTempFile, nextBucket[nextBucketSize], modelReads, readNumber))
                                     ++nextBucketSize;
                                 else
                                     endOfFile = true;
@@ -612,7 +762,7 @@ void insertSMers(int64_t seedNumber, Seed& currentSeed, HashTable& H, std::ifstr
                     if (hashTableNotFull)
                     {
                         if (i % 50000000 == 0 && i!=0)
-                            cout << "Read " << i << endl;
+                            quessLog << "Read " << i << endl;
                         hashTableNotFull = currentRead.insertSMersOfRead(H, currentSeed);  // hashTableNotFull becomes false if 80% full
                     }
                     currentRead.clear();
@@ -638,6 +788,11 @@ void insertSMers(int64_t seedNumber, Seed& currentSeed, HashTable& H, std::ifstr
          getBucketNumber=0;
          processBucketNumber=0;
          H.clear(peakMemory,currentMemory);
+         if (!H.canDoubleSize())   // over the memory budget; the caller counts fewer sMers at a time
+         {
+             tableFits = false;
+             break;
+         }
          H.recreateOfDoubleSize(peakMemory,currentMemory);
      }
     }
@@ -650,7 +805,8 @@ void insertSMers(int64_t seedNumber, Seed& currentSeed, HashTable& H, std::ifstr
     delete [] nextBucket;
     currentMemory-=2*bucketSize*MAX_READ_LENGTH*sizeof(char);
     time(&t_end);
-    cout << "============ DONE inserting sMers (" << difftime(t_end,t_start) << "s) ===========\n" << endl;
+    quessLog << "============ DONE inserting sMers (" << difftime(t_end,t_start) << "s) ===========\n" << endl;
+    return tableFits;
 }
 
 /**
@@ -685,16 +841,176 @@ void insertSMers(int64_t seedNumber, Seed& currentSeed, HashTable& H, std::ifstr
 
 void rehashFrequentSMers(HashTable& H, int Tc, uint64_t &peakMemory,uint64_t &currentMemory)
 {
-    cout << "\n============ REHASH FREQUENT S-MERS ============\n";
+    quessLog << "\n============ REHASH FREQUENT S-MERS ============\n";
     time_t t_start, t_end;
     time(&t_start);
     H.rehashFrequentSMers(Tc,peakMemory,currentMemory);
     time(&t_end);
-    cout << "============ DONE rehashing frequent sMers (" << difftime(t_end,t_start) << "s) ===========\n" << endl;
+    quessLog << "============ DONE rehashing frequent sMers (" << difftime(t_end,t_start) << "s) ===========\n" << endl;
+}
+
+/**
+  * Name:               insertFrequentSMers(int64_t seedNumber, Seed& currentSeed, HashTable& H, BlockReader& inputTempFile, int64_t bucketSize, const uint64_t* modelReads, int Tc, uint64_t& numberOfPartitions, uint64_t &peakMemory, uint64_t &currentMemory)
+  *
+  * Description :       insertSMers and rehashFrequentSMers within the size limit of the table, counting the sMers
+  *                     one partition at a time
+  *
+  * Input :
+  *       Parameters:
+  *           int64_t   seedNumber          The current iteration
+  *           Seed&     currentSeed         Current identity of the spaced seed
+  *           HashTable& H                  The hashTable (with a size limit, setSizeLimit)
+  *           BlockReader& inputTempFile    The pointer to the copy of the input file
+  *           int64_t   bucketSize          The number of reads being processed in parallel using openMP
+  *           const uint64_t* modelReads    reads counted (selectModelReads); NULL = all reads
+  *           int       Tc                  The count threshold to ascertain whether a specific sMer should be kept
+  *           uint64_t& numberOfPartitions  number of partitions of the sMers (from planMemory)
+  *           uint64_t  &peakMemory         Peak memory of program
+  *           uint64_t  &currentMemory      Current memory of program
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           HashTable& H                  the frequent sMers, as after rehashFrequentSMers
+  *           uint64_t& numberOfPartitions  doubled as long as a partition does not fit in the table
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  For each partition: count its sMers (insertSMers), collect the frequent ones, clear the table
+  *                     [2]  If the table of a partition would exceed its size limit: double the number of partitions, restart
+  *                     [3]  Table of the frequent sMers of all partitions
+  *
+  * Notes :             The reads are read once per partition. The frequent sMers are the same as without partitions.
+  *
+  */
+
+void insertFrequentSMers(int64_t seedNumber, Seed& currentSeed, HashTable& H, BlockReader& inputTempFile, int64_t bucketSize, const uint64_t* modelReads, int Tc, uint64_t& numberOfPartitions, uint64_t &peakMemory, uint64_t &currentMemory)
+{
+    vector<uint64_t> frequentSMers;
+    bool tableAllocated = (seedNumber == 0);       // the first seed starts with the table of the constructor
+    bool fits = false;
+    while (!fits)
+    {
+        fits = true;
+        frequentSMers.clear();
+        for (uint64_t partition = 0; (partition < numberOfPartitions) && fits; ++partition)
+        {
+            if (numberOfPartitions > 1)
+                quessLog << "sMer partition " << partition + 1 << " of " << numberOfPartitions << endl;
+            H.setPartition(partition, numberOfPartitions);
+            if (!tableAllocated)
+                H.recreateOfMaxSize(peakMemory,currentMemory);
+            fits = insertSMers(0, currentSeed, H, inputTempFile, bucketSize, modelReads, peakMemory, currentMemory);  // 0: table allocated here
+            tableAllocated = false;
+            if (fits)
+            {
+                H.collectFrequentSMers(Tc, frequentSMers);
+                H.clear(peakMemory,currentMemory);
+            }
+        }
+        if (!fits)
+        {
+            numberOfPartitions *= 2;
+            quessLog << "Table over the memory budget; counting the sMers in " << numberOfPartitions << " partitions" << endl;
+        }
+    }
+    H.setPartition(0, 1);
+    currentMemory+=frequentSMers.size()*sizeof(uint64_t);
+    if (currentMemory > peakMemory)
+        peakMemory = currentMemory;
+    H.createFromSMers(frequentSMers, peakMemory, currentMemory);
+    currentMemory-=frequentSMers.size()*sizeof(uint64_t);
+}
+
+/**
+  * Name:               buildPartitionedModel(int64_t seedNumber, Seed& currentSeed, HashTable& H, BlockReader& inputTempFile, int64_t bucketSize, const uint64_t* modelReads, int Tc, int Te, uint64_t& numberOfPartitions, const char* modelFileName, uint64_t &peakMemory, uint64_t &currentMemory)
+  *
+  * Description :       Builds the model of a seed one partition of the sMers at a time, spilling the model of each
+  *                     partition to disk, and merges them for the correction
+  *
+  * Input :
+  *       Parameters:
+  *           int64_t   seedNumber          The current iteration
+  *           Seed&     currentSeed         Current identity of the spaced seed
+  *           HashTable& H                  The hashTable (possibly with a size limit, setSizeLimit)
+  *           BlockReader& inputTempFile    The pointer to the copy of the input file
+  *           int64_t   bucketSize          The number of reads being processed in parallel using openMP
+  *           const uint64_t* modelReads    reads the model is built from (selectModelReads); NULL = all reads
+  *           int       Tc                  The count threshold to ascertain whether a specific sMer should be kept
+  *           int       Te                  The count threshold for how acceptable deviants from the strongest sGap are
+  *           uint64_t& numberOfPartitions  number of partitions of the sMers
+  *           const char* modelFileName     model file (removed at the end)
+  *           uint64_t  &peakMemory         Peak memory of program
+  *           uint64_t  &currentMemory      Current memory of program
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           HashTable& H                  read-only model of the seed (createFromModel), as after removeAmbiguousSMers
+  *           uint64_t& numberOfPartitions  doubled as long as the counting table of a partition does not fit
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  For each partition: insertSMers (only the sMers of the partition), rehashFrequentSMers,
+  *                          insertSGaps, removeAmbiguousSMers; append the model to the model file (writeModel); clear
+  *                     [2]  If the table of a partition would exceed its size limit: double the number of partitions, restart
+  *                     [3]  Read the model file into one table (createFromModel)
+  *
+  * Notes :             The reads are read twice per partition; only the model of one partition (with its sGap arrays)
+  *                     and, at the end, the compact model of the seed are in memory. The corrections are the same
+  *                     as without partitions.
+  *
+  */
+
+void buildPartitionedModel(int64_t seedNumber, Seed& currentSeed, HashTable& H, BlockReader& inputTempFile, int64_t bucketSize, const uint64_t* modelReads, int Tc, int Te, uint64_t& numberOfPartitions, const char* modelFileName, uint64_t &peakMemory, uint64_t &currentMemory)
+{
+    bool tableAllocated = (seedNumber == 0);       // the first seed starts with the table of the constructor
+    uint64_t numberOfPairs = 0;
+    bool fits = false;
+    while (!fits)
+    {
+        ofstream modelFile(modelFileName, ios::out | ios::binary | ios::trunc);
+        if (!modelFile.is_open()) throw QuessError("Cannot create model file: " + string(modelFileName));
+        fits = true;
+        numberOfPairs = 0;
+        for (uint64_t partition = 0; (partition < numberOfPartitions) && fits; ++partition)
+        {
+            quessLog << "\n============ MODEL PARTITION " << partition + 1 << " OF " << numberOfPartitions << " ============\n";
+            H.setPartition(partition, numberOfPartitions);
+            if (!tableAllocated)
+                H.recreateOfMaxSize(peakMemory,currentMemory);
+            fits = insertSMers(0, currentSeed, H, inputTempFile, bucketSize, modelReads, peakMemory, currentMemory);  // 0: table allocated here
+            tableAllocated = false;
+            if (!fits)
+                break;
+            rehashFrequentSMers(H, Tc, peakMemory, currentMemory);
+            insertSGaps(currentSeed, H, inputTempFile, Te, bucketSize, (int)seedNumber, modelReads, peakMemory, currentMemory);
+            removeAmbiguousSMers(H, Tc, Te, (int)seedNumber, peakMemory, currentMemory);
+            numberOfPairs += H.writeModel(modelFile);
+            H.clear(peakMemory, currentMemory);
+        }
+        modelFile.close();
+        if (!modelFile) throw QuessError("Cannot write model file: " + string(modelFileName));
+        if (!fits)
+        {
+            numberOfPartitions *= 2;
+            quessLog << "Table over the memory budget; building the model in " << numberOfPartitions << " partitions" << endl;
+        }
+    }
+    H.setPartition(0, 1);
+    ifstream modelFile(modelFileName, ios::in | ios::binary);
+    if (!modelFile.is_open()) throw QuessError("Cannot open model file: " + string(modelFileName));
+    H.createFromModel(modelFile, numberOfPairs, peakMemory, currentMemory);
+    modelFile.close();
+    remove(modelFileName);
 }
 
 /**
-  * Name:               insertSGaps(Seed& currentSeed, HashTable& H, std::ifstream& inputTempFile, int Te, int64_t bucketSize, int Ta, uint64_t &peakMemory,uint64_t &currentMemory)
+  * Name:               insertSGaps(Seed& currentSeed, HashTable& H, BlockReader& inputTempFile, int Te, int64_t bucketSize, int seedNumber, const uint64_t* modelReads, uint64_t &peakMemory,uint64_t &currentMemory)
   *
   * Description :       Overhead function to insert sGaps of the read
   *
@@ -702,10 +1018,11 @@ void rehashFrequentSMers(HashTable& H, int Tc, uint64_t &peakMemory,uint64_t &cu
   *       Parameters:
   *           Seed&     currentSeed         Current identity of the spaced seed
   *           HashTable& H                  The hashTable
-  *           std::ifstream& inputTempFile  The pointer to the copy of the input file
+  *           BlockReader& inputTempFile  The pointer to the copy of the input file
   *           int       Te                  The count threshold for how acceptable deviants from the strongest sGap are
   *           int64_t   bucketSize          The number of reads being processed in parallel using openMP
   *           int       seedNumber          current iteration of program
+  *           const uint64_t* modelReads    bit i set: read i is counted (selectModelReads); NULL = all reads
   *           uint64_t  &peakMemory         Peak memory of program
   *           uint64_t  &currentMemory      Current memory of program       
 
@@ -731,9 +1048,9 @@ void rehashFrequentSMers(HashTable& H, int Tc, uint64_t &peakMemory,uint64_t &cu
   *
   */
 
-void insertSGaps(Seed& currentSeed, HashTable& H, std::ifstream& inputTempFile, int Te, int64_t bucketSize, int seedNumber, uint64_t &peakMemory, uint64_t &currentMemory)
+void insertSGaps(Seed& currentSeed, HashTable& H, BlockReader& inputTempFile, int Te, int64_t bucketSize, int seedNumber, const uint64_t* modelReads, uint64_t &peakMemory, uint64_t &currentMemory)
 {
-    cout << "\n============ INSERT S-GAPS ============\n";
+    quessLog << "\n============ INSERT S-GAPS ============\n";
     time_t t_start, t_end;
     time(&t_start);
     
@@ -744,10 +1061,10 @@ void insertSGaps(Seed& currentSeed, HashTable& H, std::ifstream& inputTempFile,
         {   
             peakMemory = currentMemory;
 #ifdef VERBOSE
-            cout << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
+            quessLog << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
 #endif
         }
-    uint64_t numberOfLocks = H.getSize();   
+    uint64_t numberOfLocks = H.getNumberOfLocks();   
     omp_lock_t* lockArray = new omp_lock_t [numberOfLocks];
     for (uint64_t i = 0; i < numberOfLocks; ++i)
         omp_init_lock(&(lockArray[i]));
@@ -765,19 +1082,19 @@ void insertSGaps(Seed& currentSeed, HashTable& H, std::ifstream& inputTempFile,
     {   
         peakMemory = currentMemory;
 #ifdef VERBOSE
-        cout << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
+        quessLog << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
 #endif
     }
 
     bool endOfFile = false;
     bool done = false;
-    inputTempFile.clear();              // file from beginning
-    inputTempFile.seekg(0, ios::beg);
+    inputTempFile.rewind();             // file from beginning
+    int64_t readNumber = 0;
     currBucketSize = 0;
     // insert all sGaps of all reads
     
     while ((currBucketSize < bucketSize) && (!endOfFile))
-        if (inputTempFile.getline(currBucket[currBucketSize], MAX_READ_LENGTH))
+        if (getModelRead(inputTempFile, currBucket[currBucketSize], modelReads, readNumber))
             ++currBucketSize;
         else
             endOfFile = true;
@@ -793,7 +1110,7 @@ void insertSGaps(Seed& currentSeed, HashTable& H, std::ifstream& inputTempFile,
             {   
                 peakMemory = currentMemory;
 #ifdef VERBOSE
-                cout << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
+                quessLog << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
 #endif
             }
             if (endOfFile)
@@ -808,7 +1125,7 @@ void insertSGaps(Seed& currentSeed, HashTable& H, std::ifstream& inputTempFile,
                     if (!endOfFile)
                     {
                         while ((nextBucketSize < bucketSize) && (!endOfFile))
-                            if (inputTempFile.getline(nextBucket[nextBucketSize], MAX_READ_LENGTH))
+                            if (getModelRead(inputTempFile, nextBucket[nextBucketSize], modelReads, readNumber))
                                 ++nextBucketSize;
                             else
                                 endOfFile = true;
@@ -821,7 +1138,7 @@ void insertSGaps(Seed& currentSeed, HashTable& H, std::ifstream& inputTempFile,
             {
                 currentRead = Read(currBucket[i]);
                 if (i % 50000000 == 0 && i!=0)
-                   cout << "read " << i << endl;
+                   quessLog << "read " << i << endl;
                currentRead.insertSGapsOfRead(H, currentSeed, Te, seedNumber, lockArray);
                currentRead.clear();
             } // ### end omp for schedule (dynamic)
@@ -849,7 +1166,172 @@ void insertSGaps(Seed& currentSeed, HashTable& H, std::ifstream& inputTempFile,
     delete [] currBucket;
     delete [] nextBucket;
     time(&t_end);
-    cout << "============ DONE inserting sGaps (" << difftime(t_end,t_start) << "s) ===========\n" << endl;
+    quessLog << "============ DONE inserting sGaps (" << difftime(t_end,t_start) << "s) ===========\n" << endl;
+}
+
+/**
+  * Name:               insertSMersSharded(Seed& currentSeed, HashTable& H, ShardedCounter& shards, BlockReader& inputTempFile, int64_t bucketSize, const uint64_t* modelReads, int Tc, uint64_t &peakMemory, uint64_t &currentMemory)
+  *
+  * Description :       Counts the sMers of the reads in the shards of the threads owning them and creates the table
+  *                     of the frequent sMers (as insertSMers and rehashFrequentSMers)
+  *
+  * Input :
+  *       Parameters:
+  *           Seed&     currentSeed         current seed
+  *           HashTable& H                  the hashTable (cleared here)
+  *           ShardedCounter& shards        shards of the threads
+  *           BlockReader& inputTempFile    The file containing all of the reads
+  *           int64_t   bucketSize          The number of reads processed at a time
+  *           const uint64_t* modelReads    bit i set: read i is counted (selectModelReads); NULL = all reads
+  *           int       Tc                  The count threshold to ascertain whether a specific sMer should be kept
+  *           uint64_t  &peakMemory         Peak memory of program
+  *           uint64_t  &currentMemory      Current memory of program
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           uint64_t  &peakMemory         peakMemory is recorded and estimated for testing
+  *           uint64_t  &currentMemory      currentMemory is recorded and estimated for testing
+  *       Memory:
+  *           Element*  sMerTable           the frequent sMers, as after rehashFrequentSMers
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  Empty counting tables of the shards
+  *                     [2]  For each bucket of reads: the threads pass the sMers to their owners (ShardedCounter::countSMers)
+  *                     [3]  Collect the sMers of count >= Tc of all shards; free the shards; createFromSMers
+  *
+  * Notes :             One pass over the reads: a full shard grows in place. The memory budget (partitions)
+  *                     and the compact table do not apply.
+  *
+  */
+
+void insertSMersSharded(Seed& currentSeed, HashTable& H, ShardedCounter& shards, BlockReader& inputTempFile, int64_t bucketSize, const uint64_t* modelReads, int Tc, uint64_t &peakMemory, uint64_t &currentMemory)
+{
+    time_t t_start, t_end;
+    quessLog << "\n\n============ INSERT S-MERS (" << shards.getNumberOfShards() << " SHARDS) ============\n";
+    time(&t_start);
+    H.clear(peakMemory, currentMemory);         // the table is created from the shards
+    shards.createTables(peakMemory, currentMemory);
+    char** bucket = new char* [bucketSize];
+    for (int64_t i = 0; i < bucketSize; ++i)
+        bucket[i] = new char [MAX_READ_LENGTH];
+    currentMemory+=bucketSize*MAX_READ_LENGTH*sizeof(char);
+
+    inputTempFile.rewind();
+    int64_t readNumber = 0;
+    bool endOfFile = false;
+    while (!endOfFile)
+    {
+        int64_t currBucketSize = 0;
+        while ((currBucketSize < bucketSize) && (!endOfFile))
+            if (getModelRead(inputTempFile, bucket[currBucketSize], modelReads, readNumber))
+                ++currBucketSize;
+            else
+                endOfFile = true;
+        uint64_t before = shards.memoryUsage();
+        shards.countSMers(currentSeed, bucket, currBucketSize);
+        currentMemory += shards.memoryUsage() - before;        // shards grown
+        if (currentMemory > peakMemory)
+            peakMemory = currentMemory;
+    }
+    for (int64_t i = 0; i < bucketSize; ++i)
+        delete [] bucket[i];
+    delete [] bucket;
+    currentMemory-=bucketSize*MAX_READ_LENGTH*sizeof(char);
+    time(&t_end);
+    quessLog << "============ DONE inserting sMers (" << difftime(t_end,t_start) << "s) ===========\n" << endl;
+
+    quessLog << "\n============ REHASH FREQUENT S-MERS ============\n";
+    time(&t_start);
+    vector<uint64_t> frequentSMers;
+    shards.collectFrequentSMers(Tc, frequentSMers);
+    shards.freeTables(peakMemory, currentMemory);
+    currentMemory+=frequentSMers.size()*sizeof(uint64_t);
+    if (currentMemory > peakMemory)
+        peakMemory = currentMemory;
+    H.createFromSMers(frequentSMers, peakMemory, currentMemory);
+    currentMemory-=frequentSMers.size()*sizeof(uint64_t);
+    time(&t_end);
+    quessLog << "============ DONE rehashing frequent sMers (" << difftime(t_end,t_start) << "s) ===========\n" << endl;
+}
+
+/**
+  * Name:               insertSGapsSharded(Seed& currentSeed, HashTable& H, ShardedCounter& shards, BlockReader& inputTempFile, int Te, int64_t bucketSize, int seedNumber, const uint64_t* modelReads, uint64_t &peakMemory, uint64_t &currentMemory)
+  *
+  * Description :       Inserts the sGaps of the reads, each by the thread owning its sMer (as insertSGaps, without locks)
+  *
+  * Input :
+  *       Parameters:
+  *           Seed&     currentSeed         current seed
+  *           HashTable& H                  the hashTable of the frequent sMers
+  *           ShardedCounter& shards        shards of the threads
+  *           BlockReader& inputTempFile    The file containing all of the reads
+  *           int       Te                  The count threshold for how acceptable deviants from the strongest sGap are
+  *           int64_t   bucketSize          The number of reads processed at a time
+  *           int       seedNumber          current iteration of program
+  *           const uint64_t* modelReads    bit i set: read i is counted (selectModelReads); NULL = all reads
+  *           uint64_t  &peakMemory         Peak memory of program
+  *           uint64_t  &currentMemory      Current memory of program
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           Element** sGapTable           sGap table created with sGaps inserted
+  *           uint64_t  &peakMemory         peakMemory is recorded and estimated for testing
+  *           uint64_t  &currentMemory      currentMemory is recorded and estimated for testing
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  Creates sGapTable of same size as sMerTable
+  *                     [2]  For each bucket of reads: the threads pass the (sMer, sGap) pairs to the owners of the sMers,
+  *                          which insert them (ShardedCounter::insertSGaps)
+  *
+  * Notes :             No omp_lock_t: the sMers of a shard, hence their positions, are changed by one thread only.
+  *
+  */
+
+void insertSGapsSharded(Seed& currentSeed, HashTable& H, ShardedCounter& shards, BlockReader& inputTempFile, int Te, int64_t bucketSize, int seedNumber, const uint64_t* modelReads, uint64_t &peakMemory, uint64_t &currentMemory)
+{
+    quessLog << "\n============ INSERT S-GAPS (" << shards.getNumberOfShards() << " SHARDS) ============\n";
+    time_t t_start, t_end;
+    time(&t_start);
+    H.createSGapTable(peakMemory,currentMemory);
+    currentMemory+=0.84*(8-seedNumber)*H.getSize()*sizeof(uint64_t);
+    currentMemory+=H.getSize()*sizeof(uint64_t);
+    char** bucket = new char* [bucketSize];
+    for (int64_t i = 0; i < bucketSize; ++i)
+        bucket[i] = new char [MAX_READ_LENGTH];
+    currentMemory+=bucketSize*MAX_READ_LENGTH*sizeof(char);
+    if (currentMemory > peakMemory)
+    {
+        peakMemory = currentMemory;
+#ifdef VERBOSE
+        quessLog << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
+#endif
+    }
+
+    inputTempFile.rewind();
+    int64_t readNumber = 0;
+    bool endOfFile = false;
+    while (!endOfFile)
+    {
+        int64_t currBucketSize = 0;
+        while ((currBucketSize < bucketSize) && (!endOfFile))
+            if (getModelRead(inputTempFile, bucket[currBucketSize], modelReads, readNumber))
+                ++currBucketSize;
+            else
+                endOfFile = true;
+        shards.insertSGaps(currentSeed, bucket, currBucketSize, H, Te, seedNumber);
+    }
+    for (int64_t i = 0; i < bucketSize; ++i)
+        delete [] bucket[i];
+    delete [] bucket;
+    currentMemory-=bucketSize*MAX_READ_LENGTH*sizeof(char);
+    time(&t_end);
+    quessLog << "============ DONE inserting sGaps (" << difftime(t_end,t_start) << "s) ===========\n" << endl;
 }
 
 /**
@@ -886,17 +1368,17 @@ void insertSGaps(Seed& currentSeed, HashTable& H, std::ifstream& inputTempFile,
 
 void removeAmbiguousSMers(HashTable& H, int Tc, int Te, int seedNumber, uint64_t &peakMemory,uint64_t &currentMemory)
 {
-    cout << "\n============ REMOVE AMBIGUOUS S-MERS ============\n\n";
+    quessLog << "\n============ REMOVE AMBIGUOUS S-MERS ============\n\n";
     time_t t_start, t_end;
     time(&t_start);
     // remove ambiguous sMers to speed up correction
     H.removeAmbigSMers(Tc, Te, seedNumber, peakMemory,currentMemory);
     time(&t_end);
-    cout << "============ DONE removing ambiguous sMers (" << difftime(t_end,t_start) << "s) ===========\n" << endl;
+    quessLog << "============ DONE removing ambiguous sMers (" << difftime(t_end,t_start) << "s) ===========\n" << endl;
 }
 
 /**
-  * Name:               correct(int64_t seedNumber, Seed& currentSeed, HashTable& H, std::ifstream& inputTempFile, std::fstream& outputTempFile,  int Tdiff, uint64_t* diff16Bits, int64_t bucketSize,uint64_t &peakMemory,uint64_t &currentMemory)
+  * Name:               correct(int64_t seedNumber, Seed& currentSeed, HashTable& H, BlockReader& inputTempFile, BlockWriter& outputTempFile,  int Tdiff, int64_t bucketSize, CorrectionStats& stats, uint64_t* solidReads, BlockReader* qualityFile, int qualitySkip, uint64_t &peakMemory,uint64_t &currentMemory)
   *
   * Description :       Overhead function to correct the reads of the fastx file
   *
@@ -905,11 +1387,14 @@ void removeAmbiguousSMers(HashTable& H, int Tc, int Te, int seedNumber, uint64_t
   *           int64_t   seedNumber          Current iteration
   *           Seed&     currentSeed         Current identity of the spaced seed
   *           HashTable& H                  The hashTable
-  *           std::ifstream& inputTempFile  The pointer to the copy of the input file
-  *           std::fstream& outputTempFile  The pointer to the temp output file
+  *           BlockReader& inputTempFile  The pointer to the copy of the input file
+  *           BlockWriter& outputTempFile  The pointer to the temp output file
   *           uint64_t  Tdiff               The allowance of how many bits can be different to have the uncorrected sGap be corrected
-  *           uint64_t* diff16Bits          Precomputed array to determine the difference between the sGaps
   *           int64_t   bucketSize          The number of reads being processed in parallel using openMP
+  *           CorrectionStats& stats        destination
+  *           uint64_t* solidReads          bit i set: read i was solid with an earlier seed (skipped); NULL = none skipped
+  *           BlockReader* qualityFile      binned quality scores of the reads (createWorkingFiles); NULL = none
+  *           int       qualitySkip         windows whose sGap positions are all in this bin or above are not looked up
   *           uint64_t  &peakMemory         Peak memory of program
   *           uint64_t  &currentMemory      Current memory of program       
 
@@ -917,7 +1402,9 @@ void removeAmbiguousSMers(HashTable& H, int Tc, int Te, int seedNumber, uint64_t
   * Output/Expected Changes :
   *       Parameters:
   *           Element** sGapTable           sGap table created with sGaps inserted
-  *           std::fstream& outputTempFile  Correct variants will be written in the temp output file
+  *           BlockWriter& outputTempFile  Correct variants will be written in the temp output file
+  *           CorrectionStats& stats        yield of the seed (positions and reads corrected, reads still suspect, reads skipped)
+  *           uint64_t* solidReads          bits of the reads found solid (no suspect position left) with this seed are set
   *           uint64_t  &peakMemory         peakMemory is recorded and estimated for testing
   *           uint64_t  &currentMemory      currentMemory is recorded and estimated for testing
   *       Memory:
@@ -931,13 +1418,17 @@ void removeAmbiguousSMers(HashTable& H, int Tc, int Te, int seedNumber, uint64_t
   *                     [3]  Outputs the correct variant of the sGap into the read sGap and prints into the temp file
   *                     [4]  Deallocate memory of the 2-D arrays
   *
-  * Notes :             
+  * Notes :             The counters are per thread, added at the end of each bucket. stats.correctedPositions counts
+  *                     only the corrections written (seeds 0 and 1 write a read only if it is perfectly corrected).
+  *                     A solid read (--skip-solid) is copied to the output as it is, without encoding or lookups.
+  *                     With qualityFile (--quality-skip), the scores of each bucket are read with its reads; the sGaps
+  *                     of high quality positions are assumed correct (getLowQualityPositions, correctBinaryReadFast).
   *
   */
 
-void correct(int64_t seedNumber, Seed& currentSeed, HashTable& H, std::ifstream& inputTempFile, std::fstream& outputTempFile,  int Tdiff, uint64_t* diff16Bits, int64_t bucketSize,uint64_t &peakMemory,uint64_t &currentMemory)
+void correct(int64_t seedNumber, Seed& currentSeed, HashTable& H, BlockReader& inputTempFile, BlockWriter& outputTempFile,  int Tdiff, int64_t bucketSize, CorrectionStats& stats, uint64_t* solidReads, BlockReader* qualityFile, int qualitySkip, uint64_t &peakMemory,uint64_t &currentMemory)
 {
-    cout << "\n============ CORRECT ============\n";
+    quessLog << "\n============ CORRECT ============\n";
     time_t t_start, t_end;
     time(&t_start);
 
@@ -952,27 +1443,42 @@ void correct(int64_t seedNumber, Seed& currentSeed, HashTable& H, std::ifstream&
     char** outputBucket = new char* [bucketSize];
     for (int64_t i = 0; i < bucketSize; ++i)
         outputBucket[i] = new char [MAX_READ_LENGTH];
+    uint8_t* currQualities = NULL;      // (MAX_READ_LENGTH + 3) / 4 bytes per read of the bucket
+    uint8_t* nextQualities = NULL;
+    uint64_t qualityMemory = 0;
+    if (qualityFile != NULL)
+    {
+        currQualities = new uint8_t[bucketSize * ((MAX_READ_LENGTH + 3) / 4)];
+        nextQualities = new uint8_t[bucketSize * ((MAX_READ_LENGTH + 3) / 4)];
+        qualityMemory = 2 * bucketSize * ((MAX_READ_LENGTH + 3) / 4) * sizeof(uint8_t);
+        qualityFile->rewind();
+    }
 
-    currentMemory+=3*bucketSize*MAX_READ_LENGTH*sizeof(char);
+    currentMemory+=3*bucketSize*MAX_READ_LENGTH*sizeof(char)+qualityMemory;
     if (currentMemory > peakMemory)
     {   
         peakMemory = currentMemory;
 #ifdef VERBOSE
-        cout << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
+        quessLog << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
 #endif
     }
     // correct all reads
     bool endOfFile = false;
     bool done = false;
-    inputTempFile.clear();              // file from beginning
-    inputTempFile.seekg(0, ios::beg);
+    inputTempFile.rewind();             // file from beginning
     
     // load first bucket
     currBucketSize = 0;
     uint64_t corr=0;
+    stats.correctedPositions = stats.correctedReads = stats.suspectReads = stats.skippedReads = 0;
+    int64_t firstRead = 0;              // number of the first read of the current bucket
     while ((currBucketSize < bucketSize) && (!endOfFile))
         if (inputTempFile.getline(currBucket[currBucketSize], MAX_READ_LENGTH))
+        {
+            if (qualityFile != NULL)
+                qualityFile->read((char*)currQualities + currBucketSize * ((MAX_READ_LENGTH + 3) / 4), (strlen(currBucket[currBucketSize]) + 3) / 4);
             ++currBucketSize;
+        }
         else
             endOfFile = true;
 
@@ -985,7 +1491,7 @@ void correct(int64_t seedNumber, Seed& currentSeed, HashTable& H, std::ifstream&
             {   
                 peakMemory = currentMemory;
 #ifdef VERBOSE
-            cout << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
+            quessLog << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
 #endif
         }
         if (endOfFile)
@@ -993,6 +1499,7 @@ void correct(int64_t seedNumber, Seed& currentSeed, HashTable& H, std::ifstream&
 #pragma omp parallel
         {
             Read currentRead;
+            uint64_t threadCorr = 0, threadCorrectedPositions = 0, threadCorrectedReads = 0, threadSuspectReads = 0, threadSkippedReads = 0;
             // load next bucket (one thread; others need not wait; they process current bucket)
 #pragma omp single nowait
             {
@@ -1001,37 +1508,76 @@ void correct(int64_t seedNumber, Seed& currentSeed, HashTable& H, std::ifstream&
                 {
                     while ((nextBucketSize < bucketSize) && (!endOfFile))
                         if (inputTempFile.getline(nextBucket[nextBucketSize], MAX_READ_LENGTH))
+                        {
+                            if (qualityFile != NULL)
+                                qualityFile->read((char*)nextQualities + nextBucketSize * ((MAX_READ_LENGTH + 3) / 4), (strlen(nextBucket[nextBucketSize]) + 3) / 4);
                             ++nextBucketSize;
+                        }
                         else
                             endOfFile = true;
                     }
             } // ### end omp single no wait
+            uint64_t lowQuality[QUALITY_WORDS];
             // process current bucket
 #pragma omp for schedule(dynamic)
             for (int64_t i = 0 ; i < currBucketSize; ++i)
             {
+                uint64_t readNumber = firstRead + i;
+                if ((solidReads != NULL) && ((solidReads[readNumber >> 6] >> (readNumber & 63)) & 1))   // solid with an earlier seed
+                {
+                    strcpy(outputBucket[i], currBucket[i]);
+                    ++threadSkippedReads;
+                    continue;
+                }
                 currentRead = Read(currBucket[i]);
-                int64_t errPositions = currentRead.correctBinaryReadFast(H, currentSeed, Tdiff, diff16Bits,corr);
+                uint64_t readCorr = 0;
+                if (qualityFile != NULL)
+                    getLowQualityPositions(currQualities + i * ((MAX_READ_LENGTH + 3) / 4), currentRead.getLength(), qualitySkip, lowQuality);
+                int64_t errPositions = currentRead.correctBinaryReadFast(H, currentSeed, Tdiff, readCorr, (qualityFile != NULL) ? lowQuality : NULL);
+                threadCorr += readCorr;
+                if (errPositions > 0)
+                    ++threadSuspectReads;
+                if ((errPositions == 0) && (solidReads != NULL))    // all sMers solid, all sGaps correct
+                {
+#pragma omp atomic
+                    solidReads[readNumber >> 6] |= (uint64_t)1 << (readNumber & 63);
+                }
                 if (errPositions > -1)  // errPositions == -1 means read was not corrected
                     if  ((seedNumber >= 2) || errPositions == 0)   // for the first two seeds implement corrections only when "perfectly" corrected
+                    {
                         currentRead.correctCharRead();             // i.e., no positions with score != 0
+                        threadCorrectedPositions += readCorr;
+                        threadCorrectedReads += (readCorr > 0);
+                    }
                     currentRead.outputRead(outputBucket[i]);
                     currentRead.clear();
             } // ### end omp for schedule (dynamic)
+#pragma omp atomic
+            corr += threadCorr;
+#pragma omp atomic
+            stats.correctedPositions += threadCorrectedPositions;
+#pragma omp atomic
+            stats.correctedReads += threadCorrectedReads;
+#pragma omp atomic
+            stats.suspectReads += threadSuspectReads;
+#pragma omp atomic
+            stats.skippedReads += threadSkippedReads;
             // output corrected bucket to file
 #pragma omp single nowait
             {
                 for (int64_t i = 0 ; i < currBucketSize; ++i)
-                    outputTempFile << outputBucket[i] << '\n';
+                    outputTempFile.writeLine(outputBucket[i]);
             }
         } // ### end omp parallel
         
         // copy next bucket into current bucket
+        firstRead += currBucketSize;
         if (nextBucketSize > 0)  // hash table not full; continue processing buckets by moving next bucket into current
         {
             currBucketSize = nextBucketSize;
             for (int64_t j = 0; j < currBucketSize; ++j)
                 strcpy(currBucket[j], nextBucket[j]);
+            swap(currQualities, nextQualities);
         }
         currentMemory-=bucketSize*(2*sizeof(uint64_t)+MAX_READ_LENGTH*sizeof(char)+sizeof(uint8_t));
     }
@@ -1041,14 +1587,19 @@ void correct(int64_t seedNumber, Seed& currentSeed, HashTable& H, std::ifstream&
         delete [] nextBucket[i];
         delete [] outputBucket[i];
     }
+    delete [] currQualities;
+    delete [] nextQualities;
 
-    currentMemory-=3*bucketSize*MAX_READ_LENGTH*sizeof(char);
+    currentMemory-=3*bucketSize*MAX_READ_LENGTH*sizeof(char)+qualityMemory;
     delete [] currBucket;
     delete [] nextBucket;
     delete [] outputBucket;
     time(&t_end);
-    cout << "Number of Corrected Positions this iteration: " << corr << endl;
-    cout << "============ DONE correcting (" << difftime(t_end,t_start) << "s) ===========\n" << endl;
+    quessLog << "Number of Corrected Positions this iteration: " << corr << endl;
+    quessLog << "Corrections written: " << stats.correctedPositions << " in " << stats.correctedReads << " reads; reads with suspect positions: " << stats.suspectReads << endl;
+    if (solidReads != NULL)
+        quessLog << "Solid reads skipped: " << stats.skippedReads << endl;
+    quessLog << "============ DONE correcting (" << difftime(t_end,t_start) << "s) ===========\n" << endl;
 }
 
 /**
@@ -1085,7 +1636,7 @@ void swapFiles(char* inputTempFileName, char* outputTempFileName, int64_t seedNu
     char * copy_command = new char [10000];
     strcpy(copy_command, "rm ");
     strcat(copy_command, inputTempFileName);
-    cout << "delete copy of input " << copy_command << endl;
+    quessLog << "delete copy of input " << copy_command << endl;
     system(copy_command);
 
     // move corrected file in place of input copy to correct again; except at the end
@@ -1095,29 +1646,29 @@ void swapFiles(char* inputTempFileName, char* outputTempFileName, int64_t seedNu
         strcat(copy_command, outputTempFileName);
         strcat(copy_command, " ");
         strcat(copy_command, inputTempFileName);
-        cout << "copy_command: " << copy_command << endl;
+        quessLog << "copy_command: " << copy_command << endl;
         system(copy_command);
     }
 }
 
 /**
-  * Name:               createOutputFile(char* datasetName, char *outputTempFileName, std::fstream &outputTempFile, char *outputFileName, std::ofstream &outputFile)
+  * Name:               createOutputFile(char* datasetName, char *outputTempFileName, char *outputFileName, DatasetWriter &outputFile, bool recordFile)
   *
   * Description :       creates the final output file and copies all of the corrections into this one with all the comments included
   *
   * Input :
   *       Parameters:
-  *           char*     datasetName         original file
+  *           char*     datasetName         original file, or its records file (dataset read from a pipe)
   *           char*     outputTempFileName  latest output temp file name
-  *           std::fstream &outputTempFile  pointer to latest output temp file
   *           char*     outputFileName      final output filename
-  *           std::fstream &outputFile      pointer to final output file
+  *           DatasetWriter &outputFile     pointer to final output file
+  *           bool      recordFile          datasetName is a records file (parseRecords): read lines are written by writeRecordLine
   *
   * Output/Expected Changes :
   *       Parameters:
   *           None
   *       Memory:
-  *           std::fstream &outputFile      final output file created
+  *           DatasetWriter &outputFile     final output file created
   *       Return:
   *           None
   *
@@ -1130,35 +1681,57 @@ void swapFiles(char* inputTempFileName, char* outputTempFileName, int64_t seedNu
   *
   */
 
-void createOutputFile(char* datasetName, char *outputTempFileName, std::fstream &outputTempFile, char *outputFileName, std::ofstream &outputFile)
+void createOutputFile(char* datasetName, char *outputTempFileName, char *outputFileName, DatasetWriter &outputFile, bool recordFile)
 {
-    std::ifstream datasetFile;
+    DatasetReader datasetFile;
     datasetFile.open(datasetName);      // open original dataset
-    if (!datasetFile.is_open()) {   cerr << "Cannot open input dataset file: " << datasetName << endl; exit(1); }
+    if (!datasetFile.is_open()) throw QuessError("Cannot open input dataset file: " + string(datasetName));
     
-    outputTempFile.open(outputTempFileName, ios::in);
-    if (!outputTempFile.is_open()) {   cerr << "Cannot open output file: " << outputTempFileName << endl; exit(1); }
+    BlockReader outputTempFile;         // latest corrected reads
+    outputTempFile.open(outputTempFileName);
+    if (!outputTempFile.is_open()) throw QuessError("Cannot open output file: " + string(outputTempFileName));
     
-    outputFile.open(outputFileName, ios::out);
-    if (!outputFile.is_open()) {   cerr << "Cannot open output file: " << outputFileName << endl; exit(1); }
+    outputFile.open(outputFileName);
+    if (!outputFile.is_open()) throw QuessError("Cannot open output file: " + string(outputFileName));
     
-    char* datasetLine = new char[MAX_READ_LENGTH];
+    char* datasetLine = new char[MAX_LINE_LENGTH];
     char* correctedReadLine = new char[MAX_READ_LENGTH];
     char fastx;
-    while (datasetFile.getline(datasetLine, MAX_READ_LENGTH))         // read header from dataset
+    bool lineRead = datasetFile.getline(datasetLine, MAX_LINE_LENGTH);
+    while (lineRead)
     {
-        outputFile << datasetLine << '\n';                            // put read header in outputFile
+        if ((datasetLine[0] == '\0') || (datasetLine[0] == '\r'))  // empty line between records
+        {
+            lineRead = datasetFile.getline(datasetLine, MAX_LINE_LENGTH);
+            continue;
+        }
+        outputFile.writeLine(datasetLine);                            // put read header in outputFile
         fastx = datasetLine[0];
         outputTempFile.getline(correctedReadLine, MAX_READ_LENGTH);   // read corrected read from outputTempFile
-        outputFile << correctedReadLine << '\n';                      // put corrected read in outputFile
-        datasetFile.getline(datasetLine, MAX_READ_LENGTH);            // skip uncorrected read from dataset
+        uint64_t correctedLength = strlen(correctedReadLine), used = 0;
 
         if (fastx == '@')     // FASTQ
         {
-            datasetFile.getline(datasetLine, MAX_READ_LENGTH);        // read score header from dataset
-            outputFile << datasetLine << '\n';                        // put score header in outputFile
-            datasetFile.getline(datasetLine, MAX_READ_LENGTH);        // read score from dataset
-            outputFile << datasetLine << '\n';                        // put score in outputFile
+            datasetFile.getline(datasetLine, MAX_LINE_LENGTH);        // uncorrected read from dataset
+            if (recordFile)
+                writeRecordLine(outputFile, datasetLine, correctedReadLine, correctedLength, used);
+            else
+                writeCorrectedLine(outputFile, datasetLine, correctedReadLine, correctedLength, used);
+            datasetFile.getline(datasetLine, MAX_LINE_LENGTH);        // read score header from dataset
+            outputFile.writeLine(datasetLine);                        // put score header in outputFile
+            datasetFile.getline(datasetLine, MAX_LINE_LENGTH);        // read score from dataset
+            outputFile.writeLine(datasetLine);                        // put score in outputFile
+            lineRead = datasetFile.getline(datasetLine, MAX_LINE_LENGTH);
+        }
+        else                  // FASTA; the read may span several lines, their lengths are kept
+        {
+            while ((lineRead = datasetFile.getline(datasetLine, MAX_LINE_LENGTH)) && (datasetLine[0] != '>'))
+            {
+                if (recordFile)
+                    writeRecordLine(outputFile, datasetLine, correctedReadLine, correctedLength, used);
+                else
+                    writeCorrectedLine(outputFile, datasetLine, correctedReadLine, correctedLength, used);
+            }
         }
     }
     datasetFile.close();
@@ -1169,13 +1742,156 @@ void createOutputFile(char* datasetName, char *outputTempFileName, std::fstream
     char * copy_command = new char [10000];
     strcpy(copy_command, "rm ");
     strcat(copy_command, outputTempFileName);
-    cout << "delete copy of input " << copy_command << endl;
+    quessLog << "delete copy of input " << copy_command << endl;
     system(copy_command);
     delete [] datasetLine;
     delete [] correctedReadLine;
     
 }
 
+/**
+  * Name:               writeCorrectedLine(DatasetWriter& outputFile, char* datasetLine, char* correctedRead, uint64_t correctedLength, uint64_t& used)
+  *
+  * Description :       Writes a read line of the original dataset with its bases replaced by the corrected ones
+  *
+  * Input :
+  *       Parameters:
+  *           DatasetWriter& outputFile     output file
+  *           char*     datasetLine         read line of the original dataset
+  *           char*     correctedRead       corrected read
+  *           uint64_t  correctedLength     length of the corrected read
+  *           uint64_t& used                number of corrected bases already written
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           uint64_t& used                increased by the number of corrected bases written
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  Overwrite the line with the next corrected bases
+  *                     [2]  Bases past the corrected read (truncated long reads) and a final '\r' are kept
+  *
+  * Notes :
+  *
+  */
+
+void writeCorrectedLine(DatasetWriter& outputFile, char* datasetLine, char* correctedRead, uint64_t correctedLength, uint64_t& used)
+{
+    uint64_t lineLength = strlen(datasetLine);
+    if ((lineLength > 0) && (datasetLine[lineLength - 1] == '\r'))
+        --lineLength;
+    uint64_t copy = min(lineLength, correctedLength - used);
+    memcpy(datasetLine, correctedRead + used, copy);
+    used += copy;
+    outputFile.writeLine(datasetLine);
+}
+
+/**
+  * Name:               writeRecordLine(DatasetWriter& outputFile, char* recordLine, char* correctedRead, uint64_t correctedLength, uint64_t& used)
+  *
+  * Description :       Writes a read line of a dataset read from a pipe, from its line in the records file
+  *
+  * Input :
+  *       Parameters:
+  *           DatasetWriter& outputFile     output file
+  *           char*     recordLine          number of bases of the line kept in the reads, then ':' and the other bytes (if any)
+  *           char*     correctedRead       corrected read
+  *           uint64_t  correctedLength     length of the corrected read
+  *           uint64_t& used                number of corrected bases already written
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           uint64_t& used                increased by the number of corrected bases written
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  Write the next corrected bases, then the bytes of the line that were not kept in the reads
+  *
+  * Notes :             The records file is written by parseRecords (copyRecordLine).
+  *
+  */
+
+void writeRecordLine(DatasetWriter& outputFile, char* recordLine, char* correctedRead, uint64_t correctedLength, uint64_t& used)
+{
+    char* rest = recordLine;
+    uint64_t copy = min((uint64_t)strtoull(recordLine, &rest, 10), correctedLength - used);
+    outputFile.write(correctedRead + used, copy);
+    used += copy;
+    if (*rest == ':')
+        ++rest;
+    outputFile.writeLine(rest);
+}
+
+/**
+  * Name:               removeAtAbnormalExit(const char* fileName)
+  *
+  * Description :       Removes a working file if the program exits (exit(1), SIGINT, SIGTERM, SIGHUP) before it is done with it
+  *
+  * Input :
+  *       Parameters:
+  *           const char* fileName          working file; NULL = the files registered are no longer removed
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  The names are kept in static buffers (up to ABNORMAL_EXIT_FILES); the handlers are
+  *                          installed on the first call
+  *
+  * Notes :             Used for the working files of a dataset read from a pipe, which cannot be used again
+  *                     (no --resume from a pipe). Files already removed are ignored.
+  *
+  */
+
+#define ABNORMAL_EXIT_FILES 4
+static char abnormalExitFileNames[ABNORMAL_EXIT_FILES][10000];
+static int numberOfAbnormalExitFiles = 0;
+
+static void removeAbnormalExitFiles()
+{
+    for (int i = 0; i < numberOfAbnormalExitFiles; ++i)
+        unlink(abnormalExitFileNames[i]);
+}
+
+static void removeAbnormalExitFilesOnSignal(int signalNumber)
+{
+    removeAbnormalExitFiles();
+    signal(signalNumber, SIG_DFL);
+    raise(signalNumber);
+}
+
+void removeAtAbnormalExit(const char* fileName)
+{
+    static bool installed = false;
+    if (fileName == NULL)
+    {
+        numberOfAbnormalExitFiles = 0;
+        return;
+    }
+    if (numberOfAbnormalExitFiles == ABNORMAL_EXIT_FILES)
+        return;
+    strncpy(abnormalExitFileNames[numberOfAbnormalExitFiles], fileName, sizeof(abnormalExitFileNames[0]) - 1);
+    ++numberOfAbnormalExitFiles;
+    if (installed)
+        return;
+    installed = true;
+    atexit(removeAbnormalExitFiles);
+    signal(SIGINT, removeAbnormalExitFilesOnSignal);
+    signal(SIGTERM, removeAbnormalExitFilesOnSignal);
+    signal(SIGHUP, removeAbnormalExitFilesOnSignal);
+}
+
 /**
   * Name:               printIntInBinary(uint8_t n)
   *
@@ -1204,11 +1920,11 @@ void printIntInBinary(uint8_t n)
     int i = 0;
     for (i=7; i>=0; --i) {
         if ((((uint8_t)1<<i) & n) != 0)
-            cout << "1";
+            quessLog << "1";
         else
-            cout << "0";
+            quessLog << "0";
         if (i == 0)
-            cout << " ";
+            quessLog << " ";
     }
 
 }
@@ -13,6 +13,21 @@
 #define DEBUG1 0
 #endif
 
+#ifndef USE_IO_URING            // io_uring backend for file access (falls back to pread/pwrite at run time if unavailable)
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define USE_IO_URING 1
+#endif
+#endif
+#endif
+#ifndef USE_IO_URING
+#define USE_IO_URING 0
+#endif
+
+#ifndef USE_ZSTD                // zstd output (make USE_ZSTD=1)
+#define USE_ZSTD 0
+#endif
+
 #include <iostream>
 #include <fstream>
 #include <sys/time.h>
@@ -23,9 +38,15 @@
 #include <assert.h>
 #include <omp.h>
 #include <string.h>
+#include <vector>
+#include "dna2bit.h"
+#include "libquess.h"
 
 using namespace std;
 
+extern ostream quessLog;
+    // progress messages of the library (standard output by default; setLogger, setVerbose in libquess.h)
+
 
 
 // =============================
@@ -49,6 +70,13 @@ typedef struct
 }
 Element;
 
+class StaticTable;
+class LookupCache;
+class CompactTable;
+template <typename Key> class NarrowTable;
+class BucketTable;
+class Seed;
+
 class HashTable  // class for hash table
 {
 private:
@@ -58,17 +86,57 @@ private:
     static const uint64_t REMOVED = ((uint64_t)1<<56) - 2; // element removed from table: 00000000 11111111 11111111 ... 11111110
     Element* sMerTable;                 // sMers; .count = count, .value = sMer
     Element** sGapTable;                // array of sGaps for each sMer
+    Element* sGapValues;                // table read from an index: the correct sGap of each sMer (NULL otherwise)
+    bool ownsSGapValues;                // sMerTable and sGapValues allocated by createFromModel (freed by clear)
+    StaticTable* staticTable;           // replaces sMerTable and sGapTable after buildStaticTable (NULL otherwise)
+    BucketTable* bucketTable;           // replaces sMerTable and sGapTable after buildBucketTable (NULL otherwise)
+    uint64_t partition, numberOfPartitions;     // insertSMer counts only the sMers of this partition (setPartition)
+    uint64_t sizeLimit;                 // largest size of the counting table (memory budget); 0 = no limit
+    uint64_t numberOfLocks;             // locks used by insertSGap (lock of position i: i % numberOfLocks); 0 = one per position
+    CompactTable* compactTable;         // replaces sMerTable while sMers are counted (setCompactCounting; NULL otherwise)
+    NarrowTable<uint32_t>* narrowTable; // replaces sMerTable while sMers of at most 32 bits are counted (NULL otherwise)
+    bool compactCounting;               // count the sMers in a CompactTable when the remainders fit
+    uint64_t keyMask;                   // bits of the sMers counted (setKeyMask)
+
+    void allocateCountingTable(uint64_t& peakMemory, uint64_t& currentMemory);
+        // empty counting table of size "size": a NarrowTable if the sMers have at most 32 bits, a CompactTable if
+        // compactCounting and the sMers fit, otherwise Elements
 
 public:
     HashTable(uint64_t minRequiredSize);
         // new hash table of prime size > minRequiredSize
 
+    HashTable(Element* sMerTable, Element* sGapValues, uint64_t size);
+        // read-only table over the arrays of a correction index (mapped in memory); used only for correction
+
     uint64_t getNewSize(uint64_t minSize);
         // find the smallest prime in the table larger than size
     
     uint64_t getSize();
         // return the current size of the hash table
 
+    void setPartition(uint64_t partition, uint64_t numberOfPartitions);
+        // insertSMer ignores the sMers not in partition (0 .. numberOfPartitions - 1); (0, 1) = all sMers
+
+    void setSizeLimit(uint64_t sizeLimit);
+        // recreateOfDoubleSize is refused (canDoubleSize() false) beyond sizeLimit; 0 = no limit
+
+    bool canDoubleSize();
+        // true if the table may be recreated with double size
+
+    void setNumberOfLocks(uint64_t numberOfLocks);
+        // number of locks shared by the positions in insertSGap; 0 = one per position
+
+    uint64_t getNumberOfLocks();
+        // number of locks insertSGap expects in lockArray
+
+    void setCompactCounting(bool compactCounting);
+        // count the sMers in a CompactTable (about 5.3 bytes per position instead of 8) when they fit
+
+    void setKeyMask(uint64_t keyMask, uint64_t& peakMemory, uint64_t& currentMemory);
+        // bits of the sMers of the seed (seed.getKeyMask()), before they are counted; an empty counting
+        // table is reallocated for them (NarrowTable, CompactTable or Elements)
+
     bool insertSMer(uint64_t sMer);
         // insert sMer with count = 1 or increment count if already in table
         // return true if table not 50% full and false otherwise
@@ -88,11 +156,18 @@ public:
     
     void rehashFrequentSMers(uint64_t Tc,uint64_t& peakMemory, uint64_t& currentMemory);
         // rehash to keep only frequent smers (count >= Tc)
+
+    void collectFrequentSMers(uint64_t Tc, vector<uint64_t>& frequentSMers);
+        // append the sMers with count >= Tc to frequentSMers
+
+    void createFromSMers(vector<uint64_t>& sMers, uint64_t& peakMemory, uint64_t& currentMemory);
+        // (table cleared) new table with sMers, as rehashFrequentSMers leaves it; maxSize is kept
     
     void createSGapTable(uint64_t& peakMemory, uint64_t& currentMemory);
         // create the sGapTable array
     
     void insertSGap(uint64_t sMer, uint64_t sGap, uint64_t Te, int seedNumber, omp_lock_t* lockArray);
+        // lockArray NULL: no lock (the caller is the only thread inserting the sGaps of sMer; ShardedCounter)
         // insert sGap for sMer; here sMer.count = number of sGaps !!!; sMers with more than one sGap with count >= Te are deemed ambiguous and removed
     
     void removeAmbigSMers(uint64_t Tc, uint64_t Te , int seedNumber, uint64_t& peakMemory, uint64_t& currentMemory);
@@ -100,7 +175,7 @@ public:
         // remove ambiguous ones and rearrange the sGap arrays to contain only the correct sGap
         // the count of the single sGap contains the score = correctSGap.count / maxErrSGap.count (no more than 255)
     
-    int64_t getCorrectSGap(uint64_t sMer, uint64_t sGap, uint64_t& correctSGap, uint64_t Tdiff, uint64_t* diff16Bits);
+    int64_t getCorrectSGap(uint64_t sMer, uint64_t sGap, uint64_t& correctSGap, uint64_t Tdiff);
         // given current sMer and sGap, get the correctSGap; return score > 0 if it exists:
         // (1) sMer is in table
         // (2) sGap is different from correctSGap but the difference is < Tdiff (not too different)
@@ -108,17 +183,34 @@ public:
         // return 0 if sMer is in table but correctSGap = currentSGap
         // return -1 if sMer not in table or sGap is too different
 
-    static uint64_t getDiff(uint64_t x, uint64_t y, uint64_t* diff16Bits);
-        // compute the number of different 2-bit blocks of x and y
-        // diff16Bits (precomputed) gives the number of non-zero 2-bit blocks
-        // needed only inside HashTable
-
-    static uint64_t computeDiff16Bits(uint16_t x);
-        // compute the number of non-zero 2-bit blocks in a uint16_t integer x
-
     void clear(uint64_t& peakMemory, uint64_t& currentMemory);
         // delete the hash table to prepare it for next iteration (different seed)
 
+    HashTable* detach();
+        // move the tables into a new HashTable (kept after the seed); this one is left empty as after clear
+
+    void buildStaticTable(uint64_t sMerMask, uint64_t& peakMemory, uint64_t& currentMemory);
+        // replace the table (after removeAmbigSMers) by a StaticTable of its non-ambiguous sMers; only
+        // getCorrectSGap (and clear) may be used afterwards; sMerMask = sMer bits (seed.getSMerMaskRC())
+
+    void buildBucketTable(uint64_t& peakMemory, uint64_t& currentMemory);
+        // replace the table (after removeAmbigSMers) by a BucketTable of its non-ambiguous sMers; only getCorrectSGap,
+        // getCorrectEntry (and clear) may be used afterwards
+
+    bool getCorrectEntry(uint64_t sMer, uint64_t& sGap, uint64_t& score);
+        // correct sGap and score of a non-ambiguous sMer (after removeAmbigSMers); false if there is none
+
+    uint64_t writeIndex(ofstream& file);
+        // append the sMers (rehashed to a table of about 1.7 times their number) and the correct sGap of each
+        // position (Element[returned size] each) to a correction index (after removeAmbigSMers)
+
+    uint64_t writeModel(ofstream& file);
+        // append the sMers of the table with their correct sGap (Element pairs, only occupied positions) to a
+        // model file (after removeAmbigSMers); return the number of pairs written
+
+    void createFromModel(ifstream& file, uint64_t numberOfPairs, uint64_t& peakMemory, uint64_t& currentMemory);
+        // (table cleared) read-only table, as from an index, of numberOfPairs pairs written by writeModel; maxSize is kept
+
     void recreateOfMaxSize(uint64_t& peakMemory, uint64_t& currentMemory);
     // clear and reallocate hash table of size = maxSize (saved from previous work)
     
@@ -127,33 +219,357 @@ public:
     
 };
 
+// ==============================================================
+// ============== StaticTable class =============================
+// ============== (definitions in staticTable.cpp) ==============
+
+// read-only model of a seed for the correction: a minimal perfect hash function (BBHash) maps each
+// non-ambiguous sMer to its entry = sMer | correct sGap (disjoint bits, seeds being palindromes of
+// length <= 26) | score << 56; the sMer bits of the entry tell sMers not in the table apart
+// level l has STATIC_GAMMA * (keys colliding in all previous levels) bits; a key is placed in the first level
+// where it does not collide; keys left after STATIC_MAX_LEVELS levels are kept in a sorted array
+
+#define STATIC_GAMMA 2.0
+#define STATIC_MAX_LEVELS 32
+#define STATIC_RANK_BLOCK 512           // bits per precomputed rank
+
+class StaticTable  // minimal perfect hash table of the sMers of a seed
+{
+private:
+    uint64_t numberOfKeys;
+    uint64_t sMerMask;                                  // sMer bits of an entry; the others are the sGap
+    int numberOfLevels;
+    uint64_t levelStart[STATIC_MAX_LEVELS];             // first bit of each level in "bits"
+    uint64_t levelSize[STATIC_MAX_LEVELS];              // bits of each level (multiple of 64)
+    uint64_t* bits;                                     // levels, one after the other
+    uint64_t* ranks;                                    // ranks[b] = set bits before bit b * STATIC_RANK_BLOCK
+    uint64_t* entries;                                  // entries[rank of the bit of a key]
+    uint64_t* fallback;                                 // entries of the keys not placed, sorted by sMer
+    uint64_t numberOfFallback;
+
+    static uint64_t hashPosition(uint64_t sMer, int level, uint64_t size);
+    bool find(uint64_t sMer, uint64_t& entry);
+
+public:
+    StaticTable(uint64_t* entries, uint64_t numberOfKeys, uint64_t sMerMask);
+        // build from entries (sMer | sGap | score << 56), in parallel
+    ~StaticTable();
+
+    uint64_t memoryUsage();
+        // bytes used
+
+    int64_t getCorrectSGap(uint64_t sMer, uint64_t sGap, uint64_t& correctSGap, uint64_t Tdiff);
+        // same as HashTable::getCorrectSGap (-3 for any sMer not in the table)
+
+    bool getCorrectEntry(uint64_t sMer, uint64_t& sGap, uint64_t& score);
+        // correct sGap and score of sMer; false if sMer is not in the table
+};
+
+
+// ==============================================================
+// ============== BucketTable class =============================
+// ============== (definitions in bucketTable.cpp) ==============
+
+// read-only model of a seed for the correction: a bucket is one cache line of BUCKET_SLOTS (sMer, entry)
+// pairs (entry = correct sGap | score << 56); an sMer is in its home bucket or, if that was full, in its
+// alternate bucket (a second hash; bucketized cuckoo hashing), else in a small stash; a lookup compares the
+// sMers of a bucket at once (AVX2 when available) and reads the alternate bucket only if the home one is full
+
+#define BUCKET_SLOTS 4                  // 16-byte pairs: one 64-byte cache line
+#define BUCKET_LOAD 0.9                 // sMers / slots
+#define BUCKET_MAX_KICKS 500            // moves of an insertion before its sMer goes to the stash
+#define BUCKET_MAX_STASH 64             // larger stash: rebuilt with more buckets
+
+struct BucketSlot  // an sMer and its entry
+{
+    uint64_t key;
+    uint64_t entry;
+};
+
+struct alignas(64) Bucket  // BUCKET_SLOTS sMers with their entries
+{
+    BucketSlot slots[BUCKET_SLOTS];
+};
+
+class BucketTable  // bucketized cuckoo hash table of the sMers of a seed
+{
+private:
+    uint64_t numberOfKeys, numberOfBuckets;
+    Bucket* buckets;
+    vector<BucketSlot> stash;           // sMers placed in neither bucket, sorted
+    bool useAVX2;                       // the processor has AVX2
+
+    uint64_t homeBucket(uint64_t sMer);
+    uint64_t alternateBucket(uint64_t sMer);
+    bool build(uint64_t* keys, uint64_t* entries);
+    bool find(uint64_t sMer, uint64_t& entry);
+
+public:
+    BucketTable(uint64_t* keys, uint64_t* entries, uint64_t numberOfKeys);
+        // build from the non-ambiguous sMers keys[i] and their entries[i] (correct sGap | score << 56)
+    ~BucketTable();
+
+    uint64_t memoryUsage();
+        // bytes used
+
+    int64_t getCorrectSGap(uint64_t sMer, uint64_t sGap, uint64_t& correctSGap, uint64_t Tdiff);
+        // same as HashTable::getCorrectSGap, but -3 for an ambiguous sMer (treated alike by the correction)
+
+    bool getCorrectEntry(uint64_t sMer, uint64_t& sGap, uint64_t& score);
+        // same as HashTable::getCorrectEntry
+};
+
+
+// ==============================================================
+// ============== CompactTable class ============================
+// ============== (definitions in compactTable.cpp) =============
+
+// counting table of the sMers of a seed (insertSMers), a quotient table: the hash h of an sMer (a bijection
+// of its bits) is split into its home slot h % size and the remainder h / size; a slot holds the count
+// (8 bits), the distance from the home slot (linear probing) and the remainder, and three 42-bit slots
+// are packed in 16 bytes; h, hence the sMer, is recovered from the position and the slot
+
+#define COMPACT_SLOT_BITS 42
+#define COMPACT_MAX_REMAINDER_BITS 24           // leaves at least 10 bits for the displacement
+
+class CompactTable  // quotient counting table of the sMers of a seed
+{
+private:
+    uint64_t size, numberOfElements;
+    uint64_t numberOfGroups;                            // groups of three slots
+    uint128_t* groups;
+    MaskRuns keyRuns;                                   // runs of the sMer bits
+    uint64_t keyBits, bitsMask;                         // bits of a hash
+    uint64_t remainderBits, maxDisplacement;
+    uint64_t inverse;                                   // inverse of the hash multiplier
+
+    uint64_t hash(uint64_t sMer);
+    uint64_t unhash(uint64_t h);
+
+public:
+    static bool fits(uint64_t keyMask, uint64_t size);
+        // true if the remainders of the sMers of keyMask fit a table of size slots
+
+    CompactTable(uint64_t keyMask, uint64_t size);
+    ~CompactTable();
+
+    uint64_t memoryUsage();
+        // bytes used
+
+    bool insert(uint64_t sMer);
+        // as HashTable::insertSMer (thread safe); false if the table is full
+
+    void getEntry(uint64_t place, uint64_t& sMer, uint64_t& count);
+        // sMer and count of position place (count 0: empty)
+};
+
+
+// ==============================================================
+// ============== NarrowTable class =============================
+// ============== (definitions in narrowTable.cpp) ==============
+
+// counting table of the sMers of a seed of at most 8 * sizeof(Key) bits (weight <= 16 for uint32_t): the
+// gathered sMer bits in an array of Key and the counts in a separate array of bytes (linear probing)
+
+template <typename Key>
+class NarrowTable  // counting table of narrow sMers
+{
+private:
+    uint64_t size, numberOfElements;
+    MaskRuns keyRuns;                                   // runs of the sMer bits
+    Key* keys;
+    uint8_t* counts;                                    // 0: empty position
+    uint64_t* written;                                  // bit i: the key of position i is written
+
+public:
+    static bool fits(uint64_t keyMask);
+        // true if the sMers of keyMask fit a Key
+
+    NarrowTable(uint64_t keyMask, uint64_t size);
+    ~NarrowTable();
+
+    uint64_t memoryUsage();
+        // bytes used
+
+    bool insert(uint64_t sMer);
+        // as HashTable::insertSMer (thread safe); false if the table is full
+
+    void getEntry(uint64_t place, uint64_t& sMer, uint64_t& count);
+        // sMer and count of position place (count 0: empty)
+};
+
+
+// ==============================================================
+// ============== ShardedCounter class ==========================
+// ============== (definitions in shardedCounter.cpp) ===========
+
+// sMers split into shards, each owned by one thread (only the owner changes the counts or sGaps of its sMers);
+// the threads pass the sMers of their reads to the owners in batches, through a single-producer
+// single-consumer queue for each (producer, shard); the reads are taken in chunks, which every owner
+// consumes in order, so the sGaps reach the model in the order of the reads for any number of threads
+
+#define SHARD_BATCH_WORDS 512                   // words of a batch (sMers, or sMer/sGap pairs)
+#define SHARD_QUEUE_BATCHES 4                   // batches of a queue
+#define SHARD_CHUNK_READS 1024                  // reads of a chunk; chunk c is routed by thread c % threads
+
+struct ShardQueue  // single-producer single-consumer ring of batches
+{
+    uint64_t* words;                            // SHARD_QUEUE_BATCHES batches of SHARD_BATCH_WORDS
+    uint64_t lengths[SHARD_QUEUE_BATCHES];      // words of each published batch
+    bool ends[SHARD_QUEUE_BATCHES];             // the batch is the last of its chunk (possibly empty)
+    uint64_t filled;                            // words of the batch being filled (producer only)
+    alignas(64) uint64_t head;                  // batches consumed (written by the consumer)
+    alignas(64) uint64_t tail;                  // batches published (written by the producer)
+};
+
+class ShardedCounter  // thread-owned shards of the sMers of a seed
+{
+private:
+    int numberOfShards;
+    ShardQueue* queues;                         // queues[producer * numberOfShards + shard]
+    Element** tables;                           // counting table of each shard (count 0 = empty)
+    uint64_t* sizes;                            // kept from seed to seed (as maxSize)
+    uint64_t* elements;
+    HashTable* H;                               // insertSGaps: model receiving the sGaps; NULL when counting
+    uint64_t Te;
+    int seedNumber;
+    uint64_t numberOfChunks;                    // chunks of the bucket being routed
+    uint64_t* nextChunks;                       // chunk each shard consumes next (by its owner)
+
+    int ownerOf(uint64_t sMer);
+    void insert(int shard, uint64_t sMer);
+    void consume(int shard, const uint64_t* words, uint64_t length);
+    uint64_t drain(int thread, int numberOfThreads);
+    void publish(int thread, int numberOfThreads, ShardQueue& q, bool end);
+    void route(Seed& seed, char** bucket, int64_t bucketSize);
+
+public:
+    ShardedCounter(int numberOfShards, uint64_t totalSize);
+        // numberOfShards threads; counting tables of totalSize positions together
+    ~ShardedCounter();
+
+    int getNumberOfShards();
+
+    uint64_t memoryUsage();
+        // bytes used by the queues and the counting tables
+
+    void createTables(uint64_t& peakMemory, uint64_t& currentMemory);
+        // empty counting tables, before the sMers of a seed are counted
+    void freeTables(uint64_t& peakMemory, uint64_t& currentMemory);
+
+    void countSMers(Seed& seed, char** bucket, int64_t bucketSize);
+        // count the sMers of the reads of bucket (the tables grow as needed)
+
+    void collectFrequentSMers(uint64_t Tc, vector<uint64_t>& frequentSMers);
+        // append the sMers with count >= Tc of all shards to frequentSMers
+
+    void insertSGaps(Seed& seed, char** bucket, int64_t bucketSize, HashTable& H, uint64_t Te, int seedNumber);
+        // HashTable::insertSGap of the sGaps of the reads of bucket, by the owners of the sMers (no locks)
+};
+
+
+// ==============================================================
+// ============== LookupCache class =============================
+// ============== (definitions in lookupCache.cpp) ==============
+
+// QUESS_mpi: the model of a seed is split among the MPI ranks; the correct sGaps of the sMers of the reads
+// being corrected are fetched from their ranks into a LookupCache; an sMer not yet fetched is a miss:
+// it is recorded and the read is corrected again once it has been fetched
+
+#define CACHE_ABSENT ((uint64_t)-1)     // entry of an sMer that is not in the model
+
+class LookupCache  // correct sGaps of sMers owned by other ranks
+{
+private:
+    uint64_t size, numberOfElements;                    // size = power of 2
+    uint64_t* keys;                                     // sMer + 1; 0 = empty
+    uint64_t* entries;                                  // sGap | score << 56, or CACHE_ABSENT
+    vector<uint64_t>* misses;                           // misses of each thread
+    int numberOfThreads;
+
+    bool findPos(uint64_t sMer, uint64_t& place);
+    void grow();
+
+public:
+    LookupCache();
+    ~LookupCache();
+
+    void clear();
+        // remove all sMers (and misses)
+
+    bool contains(uint64_t sMer);
+
+    void insert(uint64_t sMer, uint64_t entry);
+        // add sMer with entry = sGap | score << 56 or CACHE_ABSENT (one thread at a time)
+
+    uint64_t getNumberOfMisses();
+        // misses so far of the calling thread
+
+    void takeMisses(vector<uint64_t>& sMers);
+        // append the misses of all threads to sMers and forget them
+
+    int64_t getCorrectSGap(uint64_t sMer, uint64_t sGap, uint64_t& correctSGap, uint64_t Tdiff);
+        // same as HashTable::getCorrectSGap; -3 (and a miss) for an sMer not fetched
+};
+
+
 // ========================================================
 // ====================== Seed class ======================
 // =============== (definitions in seed.cpp) ==============
 
+// seeds of length <= MAX_NARROW_SEED_LENGTH: 64-bit windows, the sMers and sGaps are the window bits under the masks
+// longer (wide) seeds: 128-bit windows, the bits under the masks are gathered into the sMers and sGaps (56 bits, Element)
+
+#define MAX_NARROW_SEED_LENGTH 26
+#define MAX_SEED_LENGTH 53                  // MAX_SEED_WEIGHT + MAX_SEED_GAP_POSITIONS - 2 (a 128-bit window holds
+                                            // up to 62 positions; the sGap bits are the limit)
+#define MAX_SEED_WEIGHT 27                  // sMers below the EMPTY and REMOVED values of HashTable (56-bit Element;
+                                            // the keys are not widened for wide seeds)
+#define MAX_SEED_GAP_POSITIONS 28           // length + 2 - weight positions of an sGap (56 bits)
+
 class Seed  // class for multiple spQUESSd seeds
 {
 private:
     uint64_t weight, length;     // weight = # 1's
     char* charSeed;         // the seeds
-    uint64_t sMerMask, sGapMask, sMerMaskRC, sGapMaskRC;
+    uint128_t sMerMask, sGapMask, sMerMaskRC, sGapMaskRC;     // aligned to the left (RC: right) of a 128-bit window
+    MaskRuns sMerRuns, sGapRuns;                                // runs of sMerMaskRC, sGapMaskRC (wide seeds)
 public:
     Seed(char* seed);
     uint64_t getLength();
     uint64_t getWeight();
+    bool isWide();
+        // true if the seed needs 128-bit windows (length > MAX_NARROW_SEED_LENGTH)
     uint64_t getSMerMask();
     uint64_t getSGapMask();
     uint64_t getSMerMaskRC();
     uint64_t getSGapMaskRC();
+        // masks of a narrow seed in a 64-bit window
+    template <class Window>
+    void getMasks(Window& sMerMask, Window& sGapMask, Window& sMerMaskRC, Window& sGapMaskRC);
+        // masks in a window of type Window (uint64_t: narrow seeds only; uint128_t)
+    const MaskRuns& getSMerRuns();
+    const MaskRuns& getSGapRuns();
+    uint64_t getKeyMask();
+        // bits of the sMers inserted in a HashTable (getSMerMaskRC(); dense 2 * weight bits for wide seeds)
     void printSeedInfo();
 };
 
+bool isValidSeed(const char* seed, const char*& problem);
+    // true if seed (0/1, palindrome) can be used; otherwise problem says why (definition in seeds.cpp)
+
 
 // ========================================================
 // ====================== Read class ======================
 // =============== (definitions in read.cpp) ==============
 
 #define MAX_READ_LENGTH 302 
+#define MAX_LINE_LENGTH 100000      // headers and score lines of the original dataset
+#define QUALITY_WORDS ((MAX_READ_LENGTH + 63) / 64)     // words of a bit set of the positions of a read
+
+void setLookupReuse(bool enabled);
+    // enable/disable (full passes) the reuse of the lookups of unchanged windows in the later passes of
+    // correctBinaryReadFast; the corrections are the same (for checks)
 
 class Read  // class for DNA Sequencing reads
 {
@@ -161,6 +577,16 @@ private:
     uint64_t length, numberOfNs;            // length = # characters, numberOfNs = # chars not in {A,C,G,T}
     char charRead[MAX_READ_LENGTH];         // read characters
     uint8_t *binRead;                       // read in binary (last incomplete block aligned left)
+
+    // the functions below with windows of type Window (uint64_t, or uint128_t for wide seeds)
+    template <class Window>
+    bool insertSMersOfWindows(HashTable& H, Seed& seed);
+    template <class Window>
+    void insertSGapsOfWindows(HashTable& H, Seed& seed, uint64_t Te, int seedNumber, omp_lock_t* lockArray);
+    template <class Table, class Window>
+    int64_t correctWindows(Table& H, Seed& seed, uint64_t Tdiff, uint64_t &corr, const uint64_t* lowQuality);
+    template <class Window>
+    uint64_t getSMersOfWindows(Seed& seed, uint64_t* sMers, uint64_t* sGaps);
     
 public:
     Read();
@@ -179,11 +605,16 @@ public:
     void insertSGapsOfRead(HashTable& H, Seed& seed, uint64_t Te, int seedNumber, omp_lock_t* lockArray);
         // insert all sGaps of the read into hash table
     
-    int64_t correctBinaryReadFast(HashTable& H, Seed& seed, uint64_t Tdiff, uint64_t* diff16Bits, uint64_t &corr);
-        // correct binary read
+    template <class Table>
+    int64_t correctBinaryReadFast(Table& H, Seed& seed, uint64_t Tdiff, uint64_t &corr, const uint64_t* lowQuality = NULL);
+        // correct binary read (Table = HashTable or LookupCache)
+        // lowQuality (QUALITY_WORDS, getLowQualityPositions): only windows with a low quality sGap position are looked up
         // return -1 if read could not be corrected (> 50% N's or seed too long)
         // return the number of erroneous positions suspected
 
+    uint64_t getSMersOfRead(Seed& seed, uint64_t* sMers, uint64_t* sGaps);
+        // store min(sMer, sMerRC) of each position (and its sGap if sGaps != NULL); return the number of positions
+
     void correctCharRead();
         // move corrections from binRead to charRead
 
@@ -196,33 +627,521 @@ public:
 };
 
 
+// ==============================================================
+// ============== BlockReader and BlockWriter classes ===========
+// ============== (definitions in asyncIO.cpp) ==================
+
+// files are read/written sequentially in blocks of IO_BUFFER_SIZE bytes;
+// NUMBER_OF_IO_BUFFERS blocks are in flight at a time (io_uring) or read/written with pread/pwrite (fallback);
+// with a memory budget (planMemory) smaller and fewer blocks may be used (setIOBuffers)
+
+#define IO_BUFFER_SIZE (8 << 20)            // default (and largest) block size
+#define NUMBER_OF_IO_BUFFERS 4              // default (and largest) number of blocks
+#define MIN_IO_BUFFER_SIZE (256 << 10)
+#define MIN_NUMBER_OF_IO_BUFFERS 2          // one block consumed while the next one is read
+
+struct IORing;
+
+void setAsyncIO(bool enabled);
+    // enable/disable io_uring for the files opened afterwards
+
+void setIOBuffers(uint64_t numberOfBuffers, uint64_t bufferSize);
+    // number and size of the blocks of the files opened afterwards (within the MIN_ and default values)
+uint64_t getNumberOfIOBuffers();
+uint64_t getIOBufferSize();
+
+class BlockReader  // sequential reader of (temp) files
+{
+private:
+    int fd;
+    uint64_t fileSize;                                  // streams: unknown (-1) until their end is read
+    bool stream;                                        // pipe, FIFO or terminal: read() in order, no io_uring
+    IORing* ring;                                       // NULL when pread is used
+    uint64_t numberOfBuffers;                           // blocks (getNumberOfIOBuffers at open)
+    uint64_t bufferSize;                                // bytes of a block (getIOBufferSize at open)
+    char* buffers[NUMBER_OF_IO_BUFFERS];                // block b is in buffers[b % numberOfBuffers]
+    uint64_t bufferLength[NUMBER_OF_IO_BUFFERS];        // bytes read in each buffer
+    uint64_t bufferOffset[NUMBER_OF_IO_BUFFERS];        // file offset of each buffer
+    bool bufferPending[NUMBER_OF_IO_BUFFERS];           // read in flight
+    int64_t currentBlock;                               // block being consumed (-1 before the first one)
+    uint64_t currentPos;                                // position in the current block
+
+    void requestBlock(uint64_t block);
+    void waitBlock(uint64_t block);
+    bool nextBlock();
+
+public:
+    BlockReader();
+    ~BlockReader();
+
+    bool open(const char* fileName);
+        // open file ("-" = standard input) and start reading its first blocks; false if it cannot be opened
+
+    bool is_open();
+
+    bool is_stream();
+        // true for pipes, FIFOs and terminals (they can be read only once)
+
+    void rewind();
+        // restart reading from the beginning of the file (not for streams)
+
+    bool getline(char* line, uint64_t maxLength);
+        // read the next line (without '\n'); lines longer than maxLength - 1 are truncated
+        // return false at end of file
+
+    uint64_t read(char* data, uint64_t maxLength);
+        // read the next (at most) maxLength bytes; return the number of bytes read (0 at end of file)
+
+    void close();
+};
+
+class BlockWriter  // sequential writer of (temp and output) files
+{
+private:
+    int fd;
+    bool stream;                                        // pipe, FIFO or terminal: write() in order, no io_uring
+    IORing* ring;                                       // NULL when pwrite is used
+    uint64_t numberOfBuffers;                           // blocks (getNumberOfIOBuffers at open)
+    uint64_t bufferSize;                                // bytes of a block (getIOBufferSize at open)
+    char* buffers[NUMBER_OF_IO_BUFFERS];
+    uint64_t bufferLength[NUMBER_OF_IO_BUFFERS];        // bytes in each buffer
+    uint64_t bufferOffset[NUMBER_OF_IO_BUFFERS];        // file offset of each buffer being written
+    bool bufferPending[NUMBER_OF_IO_BUFFERS];           // write in flight
+    uint64_t currentBuffer;                             // buffer being filled
+    uint64_t fileOffset;                                // file offset of the current buffer
+
+    void waitBuffer(uint64_t b);
+    void flush();
+
+public:
+    BlockWriter();
+    ~BlockWriter();
+
+    bool open(const char* fileName);
+        // create (truncate) file ("-" = standard output); false if it cannot be created
+
+    bool is_open();
+
+    void write(const char* data, uint64_t length);
+        // append length bytes
+
+    void writeLine(const char* line);
+        // append line followed by '\n'
+
+    void close();
+        // write remaining data and close the file
+};
+
+
+// ==============================================================
+// ============== DatasetReader and DatasetWriter classes ========
+// ============== (definitions in gzip.cpp) =====================
+
+// the original dataset may be plain, gzip or BGZF (detected from its first bytes, not its name);
+// BGZF blocks are inflated in parallel, up to BGZF_BATCH_BLOCKS blocks at a time;
+// a plain gzip stream is inflated by a second thread into NUMBER_OF_GZIP_BUFFERS buffers ahead of the reader
+
+#define BGZF_MAX_BLOCK_SIZE (1 << 16)
+#define BGZF_BATCH_BLOCKS 512
+#define GZIP_BUFFER_SIZE (8 << 20)
+#define NUMBER_OF_GZIP_BUFFERS 4
+
+struct GzipPipeline;
+
+class DatasetReader  // sequential reader of the original dataset
+{
+private:
+    BlockReader file;                                   // the (compressed) file
+    char format;                                        // 'p' plain, 'g' gzip, 'b' BGZF; 0 if no file is open
+    char* compressed;                                   // BGZF: compressed bytes of the current batch
+    uint64_t compressedLength;
+    bool endOfFile;                                     // BGZF: all compressed bytes read
+    char* buffer;                                       // plain/BGZF: data; gzip: input of the inflating thread
+    uint64_t bufferSize;                                // plain/gzip: bytes of buffer (getIOBufferSize at open)
+    char* data;                                         // bytes being consumed
+    uint64_t dataLength, dataPos;
+    GzipPipeline* pipeline;                             // gzip: inflating thread and its buffers
+
+    bool fill();
+
+public:
+    DatasetReader();
+    ~DatasetReader();
+
+    bool open(const char* fileName);
+        // open dataset and detect its compression; false if it cannot be opened
+
+    bool is_open();
+
+    bool is_stream();
+        // true if the dataset is a pipe, FIFO or standard input (it can be read only once)
+
+    char compression();
+        // 'p' plain, 'g' gzip, 'b' BGZF
+
+    uint64_t memoryUsage();
+        // bytes of buffers used for the open dataset
+
+    bool getline(char* line, uint64_t maxLength);
+        // read the next line (without '\n'); lines longer than maxLength - 1 are truncated
+        // return false at end of the dataset
+
+    uint64_t read(char* destination, uint64_t maxLength);
+        // read the next (at most) maxLength bytes; return the number of bytes read (0 at end of the dataset)
+
+    void close();
+};
+
+// the corrected dataset may be written compressed; the data is gathered in batches of COMPRESS_BATCH_SIZE bytes
+// whose blocks (BGZF_OUTPUT_BLOCK_SIZE bytes for BGZF, COMPRESS_BLOCK_SIZE for gzip/zstd) are compressed in parallel
+
+#define BGZF_OUTPUT_BLOCK_SIZE 0xff00
+#define COMPRESS_BLOCK_SIZE (1 << 20)
+#define COMPRESS_BATCH_SIZE (32 << 20)
+
+class DatasetWriter  // sequential writer of the corrected dataset
+{
+private:
+    BlockWriter file;
+    char format;                                        // 'p' plain, 'g' gzip, 'b' BGZF, 'z' zstd
+    char* batch;                                        // data not yet compressed
+    uint64_t batchLength;
+    char* compressed;                                   // compressed blocks of the batch
+
+    uint64_t blockSize();
+    uint64_t blockBound();
+    void compressBatch();
+
+public:
+    DatasetWriter();
+    ~DatasetWriter();
+
+    bool setCompression(const char* name);
+        // "bgzf", "gzip", "zstd" or "none", for the files opened afterwards; false if unknown
+
+    const char* extension();
+        // "", ".gz" or ".zst"
+
+    bool open(const char* fileName);
+        // create (truncate) file; false if it cannot be created
+
+    bool is_open();
+
+    void write(const char* data, uint64_t length);
+        // append length bytes
+
+    void writeLine(const char* line);
+        // append line followed by '\n'
+
+    void close();
+        // compress and write remaining data and close the file
+};
+
+bool isCompressedName(const char* fileName, uint64_t& nameLength);
+    // true if fileName ends with ".gz", ".bgz" or ".bgzf"; nameLength = length without that extension
+
+// ==============================================================
+// ============== FASTQ/FASTA parsing ===========================
+// ============== (definitions in fastx.cpp) ====================
+
+// the original dataset is parsed in windows of PARSE_WINDOW_SIZE bytes;
+// each window is split into byte ranges that are resynchronized on record starts and parsed in parallel
+
+#define PARSE_WINDOW_SIZE (64 << 20)
+
+// FASTQ quality scores are kept (--quality-skip) in 2-bit bins, 4 positions per byte (first position in the
+// highest bits), (length + 3) / 4 bytes per read, in the order of the reads; bin = min(3, (score - QUALITY_OFFSET) / QUALITY_BIN_WIDTH)
+#define QUALITY_OFFSET 33
+#define QUALITY_BIN_WIDTH 10
+
+typedef struct
+{
+    int64_t numberOfReads, totalReadLength;
+    int64_t truncatedReads;         // reads longer than MAX_READ_LENGTH - 1
+    int64_t badRecords;             // records not in FASTA/FASTQ format
+}
+FastxCounts;
+
+uint64_t findRecordStart(const char* data, uint64_t length, uint64_t pos, char fastx);
+    // first record starting at or after pos ('@' header followed, two lines below, by '+' for FASTQ; '>' line for FASTA)
+    // return length if none found in data
+
+uint64_t parseRecords(const char* data, uint64_t begin, uint64_t end, uint64_t length, bool lastWindow, char fastx, char* out, uint64_t& outLength, char* qualityOut, uint64_t& qualityOutLength, char* recordOut, uint64_t& recordOutLength, FastxCounts& counts);
+    // copy the reads of the records starting in [begin, end) to out (one per line); FASTA reads may span several lines
+    // FASTQ: the binned quality scores of the reads go to qualityOut (if not NULL)
+    // recordOut (if not NULL): the records with each read line replaced by the number of its bases kept in out
+    // and, after ':', its remaining bytes (see createOutputFile)
+
+typedef struct
+{
+    uint64_t* start;                // numberOfChunks + 1 range boundaries
+    uint64_t* stop;                 // end of the complete records of each range
+    char* reads;                    // windowLength + numberOfChunks bytes
+    char* qualities;                // windowLength + numberOfChunks bytes; NULL = scores not kept
+    char* records;                  // 2 * (windowLength + numberOfChunks) bytes; NULL = records not kept
+    uint64_t* readsLength;
+    uint64_t* qualitiesLength;
+    uint64_t* recordsLength;
+    FastxCounts* counts;
+}
+ParsedChunks;
+
+uint64_t parseWindow(const char* window, uint64_t windowLength, bool lastWindow, char fastx, int64_t numberOfChunks, ParsedChunks& chunks, int64_t& chunksDone);
+    // parse the window in numberOfChunks ranges in parallel; ranges 0 .. chunksDone - 1 hold complete records
+    // (range k at reads + start[k] + k, qualities + start[k] + k, records + 2 * (start[k] + k)); return the bytes consumed
+    // return end, or the start of the first record not complete in data (to be carried to the next window)
+
+void packQualities(const char* scores, uint64_t numberOfScores, uint64_t length, uint8_t* out);
+    // bin the quality scores of a read of the given length into out ((length + 3) / 4 bytes); missing scores are bin 0
+
+void getLowQualityPositions(const uint8_t* qualities, uint64_t length, int minBin, uint64_t* positions);
+    // bit p of positions (QUALITY_WORDS words) set: the score of position p is in a bin below minBin
+
+
+// ==============================================================
+// ============== CorrectionIndex class =========================
+// ============== (definitions in index.cpp) ====================
+
+// the model of every seed (hash table after removeAmbigSMers) saved in a file that is mapped in memory
+// to correct further reads without building the model again; layout (native byte order):
+//      IndexHeader | for each seed: sMerTable (Element[tableSize]) | sGaps (Element[tableSize])
+// the arrays start at multiples of INDEX_ALIGNMENT; the header is written last (an incomplete file is rejected)
+
+#define INDEX_MAGIC "QUESSIDX"
+#define INDEX_VERSION 1             // change when the layout, Element or the hashing (findPos, hashTableSizes) changes
+#define INDEX_MAX_SEEDS 8
+#define INDEX_SEED_LENGTH 128
+#define INDEX_ALIGNMENT 4096
+#define INDEX_BYTE_ORDER 0x0102030405060708ULL
+
+typedef struct
+{
+    char seed[INDEX_SEED_LENGTH];
+    uint64_t tableSize;             // number of Elements of each array
+    uint64_t sMerOffset;            // file offset of sMerTable
+    uint64_t sGapOffset;            // file offset of the sGaps (.count = score)
+}
+IndexSeedEntry;
+
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t elementSize;           // sizeof(Element)
+    uint64_t byteOrder;             // INDEX_BYTE_ORDER as written
+    uint64_t genomeLength;
+    int32_t weight, numberOfSeeds, Tc, seedsWritten;
+    IndexSeedEntry seeds[INDEX_MAX_SEEDS];
+}
+IndexHeader;
+
+class CorrectionIndex  // writer and (memory-mapped) reader of a correction index
+{
+private:
+    IndexHeader header;
+    ofstream file;                  // index being written
+    char* map;                      // index being read (mapped); NULL if none
+    uint64_t mapLength;
+
+public:
+    CorrectionIndex();
+    ~CorrectionIndex();
+
+    bool create(const char* fileName, uint64_t genomeLength, int weight, int numberOfSeeds, int Tc);
+        // start writing an index; false if the file cannot be created
+
+    void addSeed(HashTable& H, const char* seed);
+        // append the model of the next seed (H after removeAmbigSMers)
+
+    bool finish();
+        // write the header and close the file; false on write error
+
+    void open(const char* fileName);
+        // map an index and check its header; QuessError if it cannot be used
+
+    uint64_t getGenomeLength();
+    int getWeight();
+    int getNumberOfSeeds();
+    int getTc();
+    const char* getSeed(int seedNumber);
+
+    HashTable* getTable(int seedNumber);
+        // new read-only table over the mapped arrays of a seed (valid until close)
+
+    void close();
+        // unmap the index
+};
+
+
+// ==============================================================
+// ============== checkpoint ====================================
+// ============== (definitions in checkpoint.cpp) ===============
+
+// after each seed but the last, a manifest <reads working file>.checkpoint records the seeds done, the
+// parameters and the size and CRC-32 of the working file of the reads; with --resume a run continues after
+// the last seed done if the dataset, the options and the working file are unchanged
+// format: one "key value" line each (text), written to a temporary file and renamed
+
+#define CHECKPOINT_VERSION 1
+#define CHECKPOINT_NAME_LENGTH 10000
+
+typedef struct
+{
+    char datasetName[CHECKPOINT_NAME_LENGTH];
+    uint64_t datasetSize;
+    int64_t datasetTime;                    // modification time
+    uint64_t genomeLength;
+    int32_t weight, numberOfSeeds, seedsDone;
+    int32_t Tc, Te, Tdiff;                  // of the last seed done
+    int64_t numberOfReads, totalReadLength;
+    char readsFileName[CHECKPOINT_NAME_LENGTH];     // working file of the reads corrected by seeds 0 .. seedsDone - 1
+    uint64_t readsSize;
+    uint32_t readsChecksum;                 // CRC-32
+}
+Checkpoint;
+
+bool fileChecksum(const char* fileName, uint64_t& fileSize, uint32_t& checksum);
+    // size and CRC-32 of a file; false if it cannot be read
+bool writeCheckpoint(const char* checkpointFileName, Checkpoint& checkpoint);
+    // fill in the size and time of the dataset and the size and checksum of the reads, write the manifest
+bool readCheckpoint(const char* checkpointFileName, Checkpoint& checkpoint);
+    // read a manifest; false if missing or not readable
+const char* verifyCheckpoint(Checkpoint& checkpoint);
+    // NULL if the dataset and the working file of the reads are as recorded; otherwise what has changed
+
+
+// ==============================================================
+// ============== digital normalization =========================
+// ============== (definitions in normalize.cpp) ================
+
+// with --normalize <C> the models are built from a subset of the reads with a coverage of about C
+// (digital normalization): a read is kept for the models only if the median estimated count of its
+// k-mers in the reads kept so far is below C; the counts are estimated with a count-min sketch
+// (NORMALIZE_SKETCH_DEPTH rows of 8-bit saturating counters); every read is still corrected
+
+#define NORMALIZE_K 20                      // k-mer length (2 bits per base)
+#define NORMALIZE_SKETCH_DEPTH 4            // rows (hash functions) of the sketch
+#define NORMALIZE_SKETCH_FACTOR 4           // counters per row >= NORMALIZE_SKETCH_FACTOR * genomeLength (power of 2)
+
+class CountMinSketch  // estimated counts of k-mers (never below the true count)
+{
+private:
+    uint64_t width;                         // counters per row (power of 2)
+    uint64_t widthBits;                     // log2(width)
+    uint8_t* counters;                      // NORMALIZE_SKETCH_DEPTH rows of width counters, saturating at 255
+
+    uint64_t position(uint64_t key, uint64_t row);
+
+public:
+    CountMinSketch(uint64_t minWidth);
+    ~CountMinSketch();
+
+    uint64_t getCount(uint64_t key);
+        // smallest counter of key over the rows
+
+    void add(uint64_t key);
+        // increment the counters of key (conservative update: only those equal to the smallest)
+
+    uint64_t memoryUsage();
+};
+
+int64_t selectModelReads(BlockReader& inputTempFile, uint64_t genomeLength, int coverage, uint64_t* modelReads, int64_t& modelReadLength, uint64_t& peakMemory, uint64_t& currentMemory);
+    // set bit i of modelReads if read i is kept for the models (coverage-capped subset, in a single pass)
+    // return the number of reads kept; modelReadLength = their total length
+
+
+//===============================================
+//============ memory budget ==================
+
+// with a memory budget (--max-memory or the cgroup limit) the I/O buffers, the bucket size, the size of
+// the counting table, the number of sMer partitions and the number of sGap locks are planned before the
+// first seed; a model too large for the budget is built one partition at a time and spilled to disk
+
+#define PLAN_RESERVED_MEMORY (32 << 20)     // stacks, libraries, small arrays
+#define PLAN_SGAP_BYTES 48                  // sGap arrays of a frequent sMer (heap blocks)
+#define PLAN_MIN_BUCKET_SIZE 1000           // reads
+#define PLAN_LOCKS_PER_THREAD 4096          // locks shared by the positions in insertSGap
+#define PLAN_MIN_TABLE_SIZE 1769627         // smallest size of a HashTable (hashTableSizes[0])
+#define PLAN_OPEN_FILES 3                   // files open during a seed: input temp, output temp, quality scores
+
+struct MemoryPlan
+{
+    uint64_t budget;                        // bytes
+    uint64_t required;                      // bytes needed at least (estimated)
+    uint64_t numberOfIOBuffers;             // blocks of each open file (setIOBuffers)
+    uint64_t ioBufferSize;                  // bytes of a block
+    uint64_t bucketSize;                    // reads loaded at a time
+    uint64_t tableSize;                     // starting size of the counting table
+    uint64_t tableLimit;                    // largest size of the counting table
+    uint64_t numberOfPartitions;            // sMers counted in this many passes
+    uint64_t numberOfLocks;                 // locks of insertSGap
+    bool partitionedModel;                  // model of a seed too large: built in partitions (buildPartitionedModel)
+};
+
+uint64_t getMemoryLimit();
+    // memory limit of the cgroup of the process (cgroup v2 memory.max or v1 memory.limit_in_bytes); 0 if none
+bool planMemory(uint64_t budget, uint64_t genomeLength, uint64_t bucketSize, bool buildModels, MemoryPlan& plan);
+    // plan the sizes within budget; false if the budget is too small (plan.required = bytes needed)
+
+
 //===============================================
 //============ main functions =================
 
+// yield of the correction with one seed; with an adaptive schedule (--converge) the remaining seeds are
+// skipped once a seed corrects too few positions (not before ADAPTIVE_MIN_SEEDS seeds: the first seeds
+// write only perfectly corrected reads and use a larger Tdiff)
+
+#define ADAPTIVE_MIN_SEEDS 4
+
+typedef struct
+{
+    uint64_t correctedPositions;            // corrections written to the reads
+    uint64_t correctedReads;                // reads with corrections written
+    uint64_t suspectReads;                  // reads left with positions not confirmed by the model
+    uint64_t skippedReads;                  // reads solid with an earlier seed, copied unchanged (--skip-solid)
+}
+CorrectionStats;
+
 
-void show_usage();
-    //shows usage
-bool legal_int(char *);
-    // tests for legal int
-void createWorkingFiles(char* inputTempFileName, char* outputTempFileName, char* datasetName, char* outputFileName,  std::ofstream& outputFile, int64_t& numberOfReads, int64_t& totalReadLength,uint64_t& peakMemory, uint64_t& currentMemory);
+void nameWorkingFiles(char* inputTempFileName, char* outputTempFileName, char* datasetName, char* outputFileName, char* spoolFileName, DatasetWriter& outputFile, bool stream);
+    // names of the working files (and of the output file if empty) after the dataset
+void createWorkingFiles(char* inputTempFileName, char* outputTempFileName, char* datasetName, char* outputFileName, char* spoolFileName, char* qualityFileName, DatasetWriter& outputFile, int64_t& numberOfReads, int64_t& totalReadLength,uint64_t& peakMemory, uint64_t& currentMemory);
     // create file names
     // copy the reads only from "datasetName" to "inputTempFile"
+    // qualityFileName (not NULL): named <inputTempFile>_qual and filled with the binned FASTQ scores ("" for FASTA)
+int64_t extractShard(char* datasetName, char* shardFileName, char* outputFileName, DatasetWriter& outputFile, int64_t shard, int64_t numberOfShards);
+    // copy the records of shard "shard" (of "numberOfShards") of "datasetName" to "shardFileName"
 void computeTc(int64_t readLength, int64_t numberOfReads, int64_t genomeLength, int64_t weight, long double error, int &Tc);
     // compute Tc
-void insertSMers(int64_t seedNumber, Seed& currentSeed, HashTable& H, std::ifstream& inputTempFile, int64_t bucketSize,uint64_t& peakMemory, uint64_t& currentMemory);
-    // insert all sMers of all reads in "inputFile"
+bool insertSMers(int64_t seedNumber, Seed& currentSeed, HashTable& H, BlockReader& inputTempFile, int64_t bucketSize, const uint64_t* modelReads, uint64_t& peakMemory, uint64_t& currentMemory);
+    // insert all sMers of all reads in "inputFile" (of the reads in modelReads if not NULL);
+    // false (table cleared) if the table would exceed its size limit
 void rehashFrequentSMers(HashTable &H, int Tc,uint64_t& peakMemory, uint64_t& currentMemory);
     // rehash to keep only frequent smers (count >= Tc)
-void insertSGaps(Seed& currentSeed, HashTable& H, std::ifstream& inputTempFile, int Te, int64_t bucketSize,int seedNumber,uint64_t& peakMemory, uint64_t& currentMemory);
-    // insert all SGaps of all reads in"inputTempFile"
+void insertFrequentSMers(int64_t seedNumber, Seed& currentSeed, HashTable& H, BlockReader& inputTempFile, int64_t bucketSize, const uint64_t* modelReads, int Tc, uint64_t& numberOfPartitions, uint64_t& peakMemory, uint64_t& currentMemory);
+    // insertSMers and rehashFrequentSMers within the size limit of H, one partition of the sMers at a time
+void buildPartitionedModel(int64_t seedNumber, Seed& currentSeed, HashTable& H, BlockReader& inputTempFile, int64_t bucketSize, const uint64_t* modelReads, int Tc, int Te, uint64_t& numberOfPartitions, const char* modelFileName, uint64_t& peakMemory, uint64_t& currentMemory);
+    // model of a seed built one partition of the sMers at a time (spilled to modelFileName) and merged for the correction
+void insertSGaps(Seed& currentSeed, HashTable& H, BlockReader& inputTempFile, int Te, int64_t bucketSize,int seedNumber, const uint64_t* modelReads, uint64_t& peakMemory, uint64_t& currentMemory);
+    // insert all SGaps of all reads in"inputTempFile" (of the reads in modelReads if not NULL)
+void insertSMersSharded(Seed& currentSeed, HashTable& H, ShardedCounter& shards, BlockReader& inputTempFile, int64_t bucketSize, const uint64_t* modelReads, int Tc, uint64_t& peakMemory, uint64_t& currentMemory);
+    // insertSMers and rehashFrequentSMers with the sMers counted by the threads owning them
+void insertSGapsSharded(Seed& currentSeed, HashTable& H, ShardedCounter& shards, BlockReader& inputTempFile, int Te, int64_t bucketSize, int seedNumber, const uint64_t* modelReads, uint64_t& peakMemory, uint64_t& currentMemory);
+    // insertSGaps with the sGaps inserted by the threads owning their sMers (no locks)
 void removeAmbiguousSMers(HashTable& H, int Tc, int Te, int seedNumber, uint64_t& peakMemory, uint64_t& currentMemory);
     // remove ambiguous sMers from H
-void correct(int64_t seedNumber, Seed& currentSeed, HashTable& H, std::ifstream& inputTempFile, std::fstream& outputTempFile, int Tdiff, uint64_t* diff16Bits, int64_t bucketSize,uint64_t& peakMemory, uint64_t& currentMemory);
+void correct(int64_t seedNumber, Seed& currentSeed, HashTable& H, BlockReader& inputTempFile, BlockWriter& outputTempFile, int Tdiff, int64_t bucketSize, CorrectionStats& stats, uint64_t* solidReads, BlockReader* qualityFile, int qualitySkip, uint64_t& peakMemory, uint64_t& currentMemory);
     // correct all reads in "inputTempFile" and put them in "outputTempFile"
 void swapFiles(char* inputTempFileName, char* outputTempFileName, int64_t seedNumber, int64_t numberOfSeeds);
     // delete "inputTempFileName" and replQUESS it with "outputTempFileName"; except for the last iteration
-void createOutputFile(char* datasetName, char *outputTempFileName, std::fstream &outputTempFile, char *outputFileName, std::ofstream &outputFile);
-    // create "outputFile" with headers and scores from "datasetName" and corrected reads from "outputTempFile"
+void createOutputFile(char* datasetName, char *outputTempFileName, char *outputFileName, DatasetWriter &outputFile, bool recordFile);
+    // create "outputFile" with headers and scores from "datasetName" (or its records file) and corrected reads from "outputTempFile"
+void writeCorrectedLine(DatasetWriter& outputFile, char* datasetLine, char* correctedRead, uint64_t correctedLength, uint64_t& used);
+    // write the next line of a read: corrected characters replace those of datasetLine, the rest of datasetLine is kept
+void writeRecordLine(DatasetWriter& outputFile, char* recordLine, char* correctedRead, uint64_t correctedLength, uint64_t& used);
+    // write the next line of a read from its line in a records file: the next corrected characters, then the bytes after ':'
+void removeAtAbnormalExit(const char* fileName);
+    // remove fileName if the program exits or is killed before removeAtAbnormalExit(NULL) (which forgets all the files)
 
 void printIntInBinary(uint8_t n);
 #endif /* defined(____QUESS__) */
@@ -0,0 +1,1009 @@
+/**
+  * File:     QUESS_mpi.cpp
+  *
+  * Author1:  Lucian Ilie (ilie@uwo.ca)
+  * Author2:  Stephen Lu (slu93@uwo.ca)
+  *
+  *   QUality Error correction using Spaced Seeds
+  *
+  *   This file contains QUESS_mpi, the distributed version of
+  *   QUESS (make QUESS_mpi). The reads are split among the MPI
+  *   ranks and each rank owns the sMers whose hash is its rank
+  *   number: the sMers and sGaps of the reads are sent to their
+  *   owners with batched all-to-all exchanges, so each rank holds
+  *   only its part of sMerTable and sGapTable. For the correction
+  *   the correct sGaps of the sMers of a bucket are fetched from
+  *   their owners into a LookupCache, in rounds, until every
+  *   lookup of correctBinaryReadFast has been answered.
+  *
+  *   Usage: mpirun -np <ranks> ./QUESS_mpi -i <input_file> -g <genome_size>
+  *
+  */
+
+#include "QUESS.h"
+#include <mpi.h>
+#include <unistd.h>
+#include <time.h>
+#include <algorithm>
+
+#define MPI_BUCKET_SIZE 65536               // reads of a rank exchanged at a time
+#define MPI_MESSAGE_SIZE (8 << 20)          // bytes of the messages carrying reads
+
+static int myRank = 0, numberOfRanks = 1;
+
+
+/**
+  * Name:               ownerOf(uint64_t sMer)
+  *
+  * Description :       Rank owning sMer
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t  sMer                sMer (min of direct and reverse complement)
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           int                           rank
+  *
+  * Process Synopsis :
+  *
+  * Notes :             The hash differs from the one of HashTable so that each part of the table is still uniform.
+  *
+  */
+
+static inline int ownerOf(uint64_t sMer)
+{
+    uint64_t h = sMer * 0xff51afd7ed558ccdULL;
+    h ^= h >> 29;
+    return (int)(((unsigned __int128)h * (uint64_t)numberOfRanks) >> 64);
+}
+
+/**
+  * Name:               exchange(vector<uint64_t>* send, vector<uint64_t>& received, vector<int>& receivedCounts)
+  *
+  * Description :       All-to-all exchange of 64-bit values
+  *
+  * Input :
+  *       Parameters:
+  *           vector<uint64_t>* send        send[r] = values for rank r
+  *           vector<uint64_t>& received    destination
+  *           vector<int>& receivedCounts   destination
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           vector<uint64_t>& received    values received, those of rank 0 first
+  *           vector<int>& receivedCounts   number of values received from each rank
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  MPI_Alltoall of the counts, MPI_Alltoallv of the values
+  *
+  * Notes :             Called by all ranks.
+  *
+  */
+
+static void exchange(vector<uint64_t>* send, vector<uint64_t>& received, vector<int>& receivedCounts)
+{
+    vector<int> sendCounts(numberOfRanks), sendOffsets(numberOfRanks), receivedOffsets(numberOfRanks);
+    receivedCounts.assign(numberOfRanks, 0);
+    uint64_t totalSend = 0;
+    for (int r = 0; r < numberOfRanks; ++r)
+    {
+        sendCounts[r] = send[r].size();
+        sendOffsets[r] = totalSend;
+        totalSend += send[r].size();
+    }
+    MPI_Alltoall(sendCounts.data(), 1, MPI_INT, receivedCounts.data(), 1, MPI_INT, MPI_COMM_WORLD);
+    uint64_t totalReceived = 0;
+    for (int r = 0; r < numberOfRanks; ++r)
+    {
+        receivedOffsets[r] = totalReceived;
+        totalReceived += receivedCounts[r];
+    }
+    vector<uint64_t> sendBuffer(totalSend + 1);
+    for (int r = 0; r < numberOfRanks; ++r)
+        copy(send[r].begin(), send[r].end(), sendBuffer.begin() + sendOffsets[r]);
+    received.resize(totalReceived + 1);
+    MPI_Alltoallv(sendBuffer.data(), sendCounts.data(), sendOffsets.data(), MPI_UINT64_T,
+                  received.data(), receivedCounts.data(), receivedOffsets.data(), MPI_UINT64_T, MPI_COMM_WORLD);
+    received.resize(totalReceived);
+}
+
+/**
+  * Name:               anyRank(bool value)
+  *
+  * Description :       Logical or of value over all ranks
+  *
+  * Input :
+  *       Parameters:
+  *           bool      value               value of this rank
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           bool                          true if value is true on some rank
+  *
+  * Process Synopsis :
+  *
+  * Notes :             Called by all ranks.
+  *
+  */
+
+static bool anyRank(bool value)
+{
+    int local = value ? 1 : 0, global = 0;
+    MPI_Allreduce(&local, &global, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    return (global != 0);
+}
+
+/**
+  * Name:               loadBucket(BlockReader& file, char** bucket, int64_t bucketSize)
+  *
+  * Description :       Reads the next reads of a temp file
+  *
+  * Input :
+  *       Parameters:
+  *           BlockReader& file             temp file of reads
+  *           char**    bucket              destination (bucketSize reads of MAX_READ_LENGTH chars)
+  *           int64_t   bucketSize          maximum number of reads
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           char**    bucket              the reads
+  *       Memory:
+  *           None
+  *       Return:
+  *           int64_t                       number of reads (0 at end of file)
+  *
+  * Process Synopsis :
+  *
+  * Notes :
+  *
+  */
+
+static int64_t loadBucket(BlockReader& file, char** bucket, int64_t bucketSize)
+{
+    int64_t size = 0;
+    while ((size < bucketSize) && file.getline(bucket[size], MAX_READ_LENGTH))
+        ++size;
+    return size;
+}
+
+/**
+  * Name:               sMersByOwner(Seed& seed, char** bucket, int64_t bucketSize, bool withSGaps, vector<uint64_t>* send)
+  *
+  * Description :       sMers (and sGaps) of the reads of a bucket, grouped by the rank owning them
+  *
+  * Input :
+  *       Parameters:
+  *           Seed&     seed                current seed
+  *           char**    bucket              reads
+  *           int64_t   bucketSize          number of reads
+  *           bool      withSGaps           send (sMer, sGap) pairs instead of sMers
+  *           vector<uint64_t>* send        destination, one vector per rank
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           vector<uint64_t>* send        sMers (pairs) of the reads for each rank, in the order of the reads
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  The threads take contiguous ranges of reads (static schedule)
+  *                     [2]  Their vectors are appended in thread order, which keeps the order of the reads
+  *
+  * Notes :
+  *
+  */
+
+static void sMersByOwner(Seed& seed, char** bucket, int64_t bucketSize, bool withSGaps, vector<uint64_t>* send)
+{
+    int numberOfThreads = omp_get_max_threads();
+    vector<uint64_t>* threadSend = new vector<uint64_t>[numberOfThreads * numberOfRanks];
+#pragma omp parallel
+    {
+        vector<uint64_t>* mySend = threadSend + omp_get_thread_num() * numberOfRanks;
+        uint64_t* sMers = new uint64_t[MAX_READ_LENGTH];
+        uint64_t* sGaps = new uint64_t[MAX_READ_LENGTH];
+        Read currentRead;
+#pragma omp for schedule(static)
+        for (int64_t i = 0; i < bucketSize; ++i)
+        {
+            currentRead = Read(bucket[i]);
+            uint64_t count = currentRead.getSMersOfRead(seed, sMers, withSGaps ? sGaps : NULL);
+            currentRead.clear();
+            for (uint64_t k = 0; k < count; ++k)
+            {
+                vector<uint64_t>& destination = mySend[ownerOf(sMers[k])];
+                destination.push_back(sMers[k]);
+                if (withSGaps)
+                    destination.push_back(sGaps[k]);
+            }
+        }
+        delete [] sMers;
+        delete [] sGaps;
+    }
+    for (int r = 0; r < numberOfRanks; ++r)
+    {
+        send[r].clear();
+        for (int t = 0; t < numberOfThreads; ++t)
+            send[r].insert(send[r].end(), threadSend[t * numberOfRanks + r].begin(), threadSend[t * numberOfRanks + r].end());
+    }
+    delete [] threadSend;
+}
+
+/**
+  * Name:               distributeReads(char* inputTempFileName, char* rankInputName, int64_t numberOfReads, int64_t bucketSize)
+  *
+  * Description :       Splits the reads among the ranks
+  *
+  * Input :
+  *       Parameters:
+  *           char*     inputTempFileName   reads of the dataset (rank 0)
+  *           char*     rankInputName       temp file of the reads of this rank
+  *           int64_t   numberOfReads       total number of reads
+  *           int64_t   bucketSize          reads of a rank exchanged at a time
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           int64_t                       number of reads of this rank
+  *
+  * Process Synopsis :
+  *                     [1]  Rank 0 reads inputTempFile in blocks of bucketSize reads; block b goes to rank b % numberOfRanks
+  *                     [2]  The reads are sent in messages of MPI_MESSAGE_SIZE bytes; an empty message ends them
+  *                     [3]  inputTempFile is removed
+  *
+  * Notes :             Called by all ranks. In the k-th exchange every rank sends the sMers of its k-th bucket,
+  *                     which is block k*numberOfRanks + rank, so the owners receive them in the order of the
+  *                     reads and insert the sGaps as the serial program does.
+  *
+  */
+
+static int64_t distributeReads(char* inputTempFileName, char* rankInputName, int64_t numberOfReads, int64_t bucketSize)
+{
+    int64_t myReads = 0;
+    BlockWriter rankInput;
+    rankInput.open(rankInputName);
+    if (!rankInput.is_open()) {   cerr << "Cannot open input temp file: " << rankInputName << endl; MPI_Abort(MPI_COMM_WORLD, 1); }
+    char* message = new char[MPI_MESSAGE_SIZE + MAX_READ_LENGTH + 1];
+    if (myRank == 0)
+    {
+        BlockReader inputTempFile;
+        inputTempFile.open(inputTempFileName);
+        if (!inputTempFile.is_open()) {   cerr << "Cannot open input temp file: " << inputTempFileName << endl; MPI_Abort(MPI_COMM_WORLD, 1); }
+        char* read = new char[MAX_READ_LENGTH];
+        int64_t* messageLength = new int64_t[numberOfRanks]();
+        char** messages = new char*[numberOfRanks];
+        for (int r = 1; r < numberOfRanks; ++r)
+            messages[r] = new char[MPI_MESSAGE_SIZE + MAX_READ_LENGTH + 1];
+        for (int64_t i = 0; (i < numberOfReads) && inputTempFile.getline(read, MAX_READ_LENGTH); ++i)
+        {
+            int r = (int)((i / bucketSize) % numberOfRanks);
+            if (r == 0)
+            {
+                rankInput.writeLine(read);
+                ++myReads;
+                continue;
+            }
+            uint64_t length = strlen(read);
+            memcpy(messages[r] + messageLength[r], read, length);
+            messages[r][messageLength[r] + length] = '\n';
+            messageLength[r] += length + 1;
+            if (messageLength[r] >= MPI_MESSAGE_SIZE)
+            {
+                MPI_Send(messages[r], messageLength[r], MPI_CHAR, r, 1, MPI_COMM_WORLD);
+                messageLength[r] = 0;
+            }
+        }
+        for (int r = 1; r < numberOfRanks; ++r)
+        {
+            if (messageLength[r] > 0)
+                MPI_Send(messages[r], messageLength[r], MPI_CHAR, r, 1, MPI_COMM_WORLD);
+            MPI_Send(messages[r], 0, MPI_CHAR, r, 1, MPI_COMM_WORLD);
+            delete [] messages[r];
+        }
+        delete [] messages;
+        delete [] messageLength;
+        delete [] read;
+        inputTempFile.close();
+        remove(inputTempFileName);
+    }
+    else
+    {
+        int messageLength = 1;
+        while (messageLength > 0)
+        {
+            MPI_Status status;
+            MPI_Recv(message, MPI_MESSAGE_SIZE + MAX_READ_LENGTH + 1, MPI_CHAR, 0, 1, MPI_COMM_WORLD, &status);
+            MPI_Get_count(&status, MPI_CHAR, &messageLength);
+            rankInput.write(message, messageLength);
+            for (int i = 0; i < messageLength; ++i)
+                if (message[i] == '\n')
+                    ++myReads;
+        }
+    }
+    delete [] message;
+    rankInput.close();
+    return myReads;
+}
+
+/**
+  * Name:               insertSMersMPI(int64_t seedNumber, Seed& currentSeed, HashTable& H, BlockReader& inputTempFile, int64_t bucketSize, uint64_t &peakMemory, uint64_t &currentMemory)
+  *
+  * Description :       Inserts the sMers of the reads of all ranks in the tables of their owners
+  *
+  * Input :
+  *       Parameters:
+  *           int64_t   seedNumber          Current iteration
+  *           Seed&     currentSeed         Current identity of the spaced seed
+  *           HashTable& H                  the part of the hash table owned by this rank
+  *           BlockReader& inputTempFile    reads of this rank
+  *           int64_t   bucketSize          reads of a rank exchanged at a time
+  *           uint64_t  &peakMemory         Peak memory of program
+  *           uint64_t  &currentMemory      Current memory of program
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           HashTable& H                  sMers owned by this rank with their counts
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  For each bucket: sMers sent to their owners, which insert them
+  *                     [2]  If the table of some rank is full, all ranks restart: the full tables with double size
+  *
+  * Notes :             Called by all ranks. The received sMers are inserted by one thread
+  *                     (insertSMer inserts new sMers only in the master thread).
+  *
+  */
+
+static void insertSMersMPI(int64_t seedNumber, Seed& currentSeed, HashTable& H, BlockReader& inputTempFile, int64_t bucketSize, uint64_t &peakMemory, uint64_t &currentMemory)
+{
+    time_t t_start, t_end;
+    cout << "\n\n============ INSERT S-MERS ============\n";
+    time(&t_start);
+    if (seedNumber != 0)
+        H.recreateOfMaxSize(peakMemory,currentMemory);
+    char** bucket = new char* [bucketSize];
+    for (int64_t i = 0; i < bucketSize; ++i)
+        bucket[i] = new char [MAX_READ_LENGTH];
+    vector<uint64_t>* send = new vector<uint64_t>[numberOfRanks];
+    vector<uint64_t> received;
+    vector<int> receivedCounts;
+
+    bool restart = true;
+    while (restart)
+    {
+        restart = false;
+        bool full = false, anyFull = false;
+        inputTempFile.rewind();
+        while (true)
+        {
+            int64_t size = loadBucket(inputTempFile, bucket, bucketSize);
+            if (!anyRank(size > 0))
+                break;
+            sMersByOwner(currentSeed, bucket, size, false, send);
+            exchange(send, received, receivedCounts);
+            for (uint64_t k = 0; (k < received.size()) && !full; ++k)
+                full = !H.insertSMer(received[k]);      // table too full; need to restart
+            anyFull = anyRank(full);
+            if (anyFull)
+                break;
+        }
+        if (anyFull)    // restart processing reads from the beginning of the files
+        {
+            restart = true;
+            H.clear(peakMemory,currentMemory);
+            if (full)
+                H.recreateOfDoubleSize(peakMemory,currentMemory);
+            else
+                H.recreateOfMaxSize(peakMemory,currentMemory);
+        }
+    }
+    for (int64_t i = 0; i < bucketSize; ++i)
+        delete [] bucket[i];
+    delete [] bucket;
+    delete [] send;
+    time(&t_end);
+    cout << "============ DONE inserting sMers (" << difftime(t_end,t_start) << "s) ===========\n" << endl;
+}
+
+/**
+  * Name:               insertSGapsMPI(Seed& currentSeed, HashTable& H, BlockReader& inputTempFile, int Te, int64_t bucketSize, int seedNumber, uint64_t &peakMemory, uint64_t &currentMemory)
+  *
+  * Description :       Inserts the sGaps of the reads of all ranks in the tables of the owners of their sMers
+  *
+  * Input :
+  *       Parameters:
+  *           Seed&     currentSeed         Current identity of the spaced seed
+  *           HashTable& H                  the part of the hash table owned by this rank
+  *           BlockReader& inputTempFile    reads of this rank
+  *           int       Te                  The count threshold for how acceptable deviants from the strongest sGap are
+  *           int64_t   bucketSize          reads of a rank exchanged at a time
+  *           int       seedNumber          Current iteration
+  *           uint64_t  &peakMemory         Peak memory of program
+  *           uint64_t  &currentMemory      Current memory of program
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           HashTable& H                  sGaps of the sMers owned by this rank
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  For each bucket: (sMer, sGap) pairs sent to the owners of the sMers, which insert them in parallel
+  *
+  * Notes :             Called by all ranks.
+  *
+  */
+
+static void insertSGapsMPI(Seed& currentSeed, HashTable& H, BlockReader& inputTempFile, int Te, int64_t bucketSize, int seedNumber, uint64_t &peakMemory, uint64_t &currentMemory)
+{
+    cout << "\n============ INSERT S-GAPS ============\n";
+    time_t t_start, t_end;
+    time(&t_start);
+    H.createSGapTable(peakMemory,currentMemory);
+    currentMemory+=0.84*(8-seedNumber)*H.getSize()*sizeof(uint64_t);     // sGap lists, freed by removeAmbigSMers (as insertSGaps)
+    currentMemory+=H.getSize()*sizeof(uint64_t);
+    peakMemory = max(peakMemory, currentMemory);
+    uint64_t numberOfLocks = H.getNumberOfLocks();
+    omp_lock_t* lockArray = new omp_lock_t [numberOfLocks];
+    for (uint64_t i = 0; i < numberOfLocks; ++i)
+        omp_init_lock(&(lockArray[i]));
+    char** bucket = new char* [bucketSize];
+    for (int64_t i = 0; i < bucketSize; ++i)
+        bucket[i] = new char [MAX_READ_LENGTH];
+    vector<uint64_t>* send = new vector<uint64_t>[numberOfRanks];
+    vector<uint64_t> received;
+    vector<int> receivedCounts;
+
+    inputTempFile.rewind();
+    while (true)
+    {
+        int64_t size = loadBucket(inputTempFile, bucket, bucketSize);
+        if (!anyRank(size > 0))
+            break;
+        sMersByOwner(currentSeed, bucket, size, true, send);
+        exchange(send, received, receivedCounts);
+        int64_t numberOfPairs = received.size() / 2;
+#pragma omp parallel for schedule(static)
+        for (int64_t k = 0; k < numberOfPairs; ++k)
+            H.insertSGap(received[2 * k], received[2 * k + 1], Te, seedNumber, lockArray);
+    }
+    for (uint64_t i = 0; i < numberOfLocks; ++i)
+        omp_destroy_lock(&(lockArray[i]));
+    delete [] lockArray;
+    for (int64_t i = 0; i < bucketSize; ++i)
+        delete [] bucket[i];
+    delete [] bucket;
+    delete [] send;
+    time(&t_end);
+    cout << "============ DONE inserting sGaps (" << difftime(t_end,t_start) << "s) ===========\n" << endl;
+}
+
+/**
+  * Name:               fetchEntries(HashTable& H, vector<uint64_t>& wanted, LookupCache& cache)
+  *
+  * Description :       Fetches the correct sGaps of sMers from their owners into the cache
+  *
+  * Input :
+  *       Parameters:
+  *           HashTable& H                  the part of the hash table owned by this rank (answers the other ranks)
+  *           vector<uint64_t>& wanted      sMers needed by this rank (duplicates allowed)
+  *           LookupCache& cache            cache of this rank
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           LookupCache& cache            the wanted sMers, with their entries or CACHE_ABSENT
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  Requests (sMers not yet in the cache) to the owners
+  *                     [2]  Each rank answers the requests it received, in their order
+  *                     [3]  Answers back to the requesting ranks; added to the cache
+  *
+  * Notes :             Called by all ranks (with an empty "wanted" if nothing is needed).
+  *
+  */
+
+static void fetchEntries(HashTable& H, vector<uint64_t>& wanted, LookupCache& cache)
+{
+    sort(wanted.begin(), wanted.end());
+    wanted.erase(unique(wanted.begin(), wanted.end()), wanted.end());
+    vector<uint64_t>* requests = new vector<uint64_t>[numberOfRanks];
+    vector<uint64_t>* answers = new vector<uint64_t>[numberOfRanks];
+    for (uint64_t k = 0; k < wanted.size(); ++k)
+        if (!cache.contains(wanted[k]))
+            requests[ownerOf(wanted[k])].push_back(wanted[k]);
+    vector<uint64_t> received, receivedAnswers;
+    vector<int> receivedCounts, answerCounts;
+    exchange(requests, received, receivedCounts);
+
+    vector<uint64_t> entries(received.size());
+#pragma omp parallel for schedule(static)
+    for (int64_t k = 0; k < (int64_t)received.size(); ++k)
+    {
+        uint64_t sGap = 0, score = 0;
+        entries[k] = H.getCorrectEntry(received[k], sGap, score) ? (sGap | (score << 56)) : CACHE_ABSENT;
+    }
+    uint64_t offset = 0;
+    for (int r = 0; r < numberOfRanks; ++r)
+    {
+        answers[r].assign(entries.begin() + offset, entries.begin() + offset + receivedCounts[r]);
+        offset += receivedCounts[r];
+    }
+    exchange(answers, receivedAnswers, answerCounts);
+    offset = 0;
+    for (int r = 0; r < numberOfRanks; ++r)
+        for (uint64_t k = 0; k < requests[r].size(); ++k)
+            cache.insert(requests[r][k], receivedAnswers[offset++]);
+    delete [] requests;
+    delete [] answers;
+}
+
+/**
+  * Name:               correctMPI(int64_t seedNumber, Seed& currentSeed, HashTable& H, BlockReader& inputTempFile, BlockWriter& outputTempFile, int Tdiff, int64_t bucketSize)
+  *
+  * Description :       Corrects the reads of this rank with the tables of all ranks
+  *
+  * Input :
+  *       Parameters:
+  *           int64_t   seedNumber          Current iteration
+  *           Seed&     currentSeed         Current identity of the spaced seed
+  *           HashTable& H                  the part of the hash table owned by this rank
+  *           BlockReader& inputTempFile    reads of this rank
+  *           BlockWriter& outputTempFile   corrected reads of this rank
+  *           int       Tdiff               The allowance of how many bits can be different to have the uncorrected sGap be corrected
+  *           int64_t   bucketSize          reads of a rank corrected at a time
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           BlockWriter& outputTempFile   corrected reads, same order
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  For each bucket: fetch the entries of all sMers of the reads
+  *                     [2]  Correct the reads as correct() does, with the cache; a read whose correction
+  *                          looked up an sMer not fetched (changed by an earlier correction) is corrected
+  *                          again, from its original, after these sMers are fetched
+  *                     [3]  Until no read of any rank is left
+  *
+  * Notes :             Called by all ranks. The result is that of correct() with the whole table.
+  *
+  */
+
+static void correctMPI(int64_t seedNumber, Seed& currentSeed, HashTable& H, BlockReader& inputTempFile, BlockWriter& outputTempFile, int Tdiff, int64_t bucketSize)
+{
+    cout << "\n============ CORRECT ============\n";
+    time_t t_start, t_end;
+    time(&t_start);
+    char** bucket = new char* [bucketSize];
+    char** outputBucket = new char* [bucketSize];
+    for (int64_t i = 0; i < bucketSize; ++i)
+    {
+        bucket[i] = new char [MAX_READ_LENGTH];
+        outputBucket[i] = new char [MAX_READ_LENGTH];
+    }
+    vector<uint64_t>* sMers = new vector<uint64_t>[numberOfRanks];
+    LookupCache cache;
+    vector<uint64_t> wanted;
+    vector<int64_t> pending, stillPending;
+    uint64_t corr = 0;
+    int64_t rounds = 0;
+
+    inputTempFile.rewind();
+    while (true)
+    {
+        int64_t size = loadBucket(inputTempFile, bucket, bucketSize);
+        if (!anyRank(size > 0))
+            break;
+        cache.clear();
+        sMersByOwner(currentSeed, bucket, size, false, sMers);     // all sMers of the reads as they are
+        wanted.clear();
+        for (int r = 0; r < numberOfRanks; ++r)
+            wanted.insert(wanted.end(), sMers[r].begin(), sMers[r].end());
+        pending.resize(size);
+        for (int64_t i = 0; i < size; ++i)
+            pending[i] = i;
+        bool anyPending = true;
+        while (anyPending)
+        {
+            fetchEntries(H, wanted, cache);
+            ++rounds;
+            int64_t numberOfPending = pending.size();
+            vector<char> retry(numberOfPending, 0);
+#pragma omp parallel reduction(+:corr)
+            {
+                Read currentRead;
+#pragma omp for schedule(dynamic)
+                for (int64_t k = 0; k < numberOfPending; ++k)
+                {
+                    int64_t i = pending[k];
+                    uint64_t missesBefore = cache.getNumberOfMisses(), readCorr = 0;
+                    currentRead = Read(bucket[i]);
+                    int64_t errPositions = currentRead.correctBinaryReadFast(cache, currentSeed, Tdiff, readCorr);
+                    if (cache.getNumberOfMisses() > missesBefore)   // some sMer not fetched yet; correct again later
+                        retry[k] = 1;
+                    else
+                    {
+                        if (errPositions > -1)  // errPositions == -1 means read was not corrected
+                            if  ((seedNumber >= 2) || errPositions == 0)   // for the first two seeds implement corrections only when "perfectly" corrected
+                                currentRead.correctCharRead();
+                        currentRead.outputRead(outputBucket[i]);
+                        corr += readCorr;
+                    }
+                    currentRead.clear();
+                }
+            }
+            stillPending.clear();
+            for (int64_t k = 0; k < numberOfPending; ++k)
+                if (retry[k])
+                    stillPending.push_back(pending[k]);
+            pending.swap(stillPending);
+            wanted.clear();
+            cache.takeMisses(wanted);
+            anyPending = anyRank(pending.size() > 0);
+        }
+        for (int64_t i = 0; i < size; ++i)
+            outputTempFile.writeLine(outputBucket[i]);
+    }
+    for (int64_t i = 0; i < bucketSize; ++i)
+    {
+        delete [] bucket[i];
+        delete [] outputBucket[i];
+    }
+    delete [] bucket;
+    delete [] outputBucket;
+    delete [] sMers;
+    uint64_t totalCorr = 0;
+    MPI_Reduce(&corr, &totalCorr, 1, MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+    time(&t_end);
+    cout << "Number of Corrected Positions this iteration: " << totalCorr << " (lookup rounds of rank 0: " << rounds << ")" << endl;
+    cout << "============ DONE correcting (" << difftime(t_end,t_start) << "s) ===========\n" << endl;
+}
+
+/**
+  * Name:               gatherCorrectedReads(char* rankOutputName, char* outputTempFileName, int64_t numberOfReads, int64_t bucketSize)
+  *
+  * Description :       Collects the corrected reads of all ranks, in order, in the output temp file of rank 0
+  *
+  * Input :
+  *       Parameters:
+  *           char*     rankOutputName      corrected reads of this rank (removed)
+  *           char*     outputTempFileName  corrected reads of all ranks (rank 0)
+  *           int64_t   numberOfReads       total number of reads
+  *           int64_t   bucketSize          reads of a block of distributeReads
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  Ranks > 0 send each of their blocks in messages of MPI_MESSAGE_SIZE bytes, an empty one
+  *                          ending the block
+  *                     [2]  Rank 0 writes block b from its own file or from rank b % numberOfRanks
+  *
+  * Notes :             Called by all ranks.
+  *
+  */
+
+static void gatherCorrectedReads(char* rankOutputName, char* outputTempFileName, int64_t numberOfReads, int64_t bucketSize)
+{
+    char* message = new char[MPI_MESSAGE_SIZE + MAX_READ_LENGTH + 1];
+    char* read = new char[MAX_READ_LENGTH];
+    BlockReader rankOutput;
+    rankOutput.open(rankOutputName);
+    if (!rankOutput.is_open()) {   cerr << "Cannot open output temp file: " << rankOutputName << endl; MPI_Abort(MPI_COMM_WORLD, 1); }
+    int64_t numberOfBlocks = (numberOfReads + bucketSize - 1) / bucketSize;
+    if (myRank == 0)
+    {
+        BlockWriter outputTempFile;
+        outputTempFile.open(outputTempFileName);
+        if (!outputTempFile.is_open()) {   cerr << "Cannot open output temp file: " << outputTempFileName << endl; MPI_Abort(MPI_COMM_WORLD, 1); }
+        for (int64_t b = 0; b < numberOfBlocks; ++b)
+        {
+            int r = (int)(b % numberOfRanks);
+            if (r == 0)
+            {
+                for (int64_t i = 0; (i < bucketSize) && rankOutput.getline(read, MAX_READ_LENGTH); ++i)
+                    outputTempFile.writeLine(read);
+                continue;
+            }
+            int messageLength = 1;
+            while (messageLength > 0)
+            {
+                MPI_Status status;
+                MPI_Recv(message, MPI_MESSAGE_SIZE + MAX_READ_LENGTH + 1, MPI_CHAR, r, 2, MPI_COMM_WORLD, &status);
+                MPI_Get_count(&status, MPI_CHAR, &messageLength);
+                outputTempFile.write(message, messageLength);
+            }
+        }
+        outputTempFile.close();
+    }
+    else
+    {
+        for (int64_t b = myRank; b < numberOfBlocks; b += numberOfRanks)
+        {
+            int64_t messageLength = 0;
+            for (int64_t i = 0; (i < bucketSize) && rankOutput.getline(read, MAX_READ_LENGTH); ++i)
+            {
+                uint64_t length = strlen(read);
+                memcpy(message + messageLength, read, length);
+                message[messageLength + length] = '\n';
+                messageLength += length + 1;
+                if (messageLength >= MPI_MESSAGE_SIZE)
+                {
+                    MPI_Send(message, messageLength, MPI_CHAR, 0, 2, MPI_COMM_WORLD);
+                    messageLength = 0;
+                }
+            }
+            if (messageLength > 0)
+                MPI_Send(message, messageLength, MPI_CHAR, 0, 2, MPI_COMM_WORLD);
+            MPI_Send(message, 0, MPI_CHAR, 0, 2, MPI_COMM_WORLD);
+        }
+    }
+    rankOutput.close();
+    remove(rankOutputName);
+    delete [] read;
+    delete [] message;
+}
+
+/**
+  * Name:               void show_usage() {
+  *
+  * Description :       Shows usage
+  *
+  * Input :
+  *
+  * Process Synopsis :
+  *
+  * Notes :
+  *
+  */
+
+static void show_usage()
+{
+    cerr << "Usage: mpirun -np <ranks> ./QUESS_mpi <option(s)>\n"
+         << "Required:\n"
+         << "\t-i,--input-file <filename>\t\tSpecify the target fastx file\n"
+         << "\t-g,--genome-length <genome length>\tSpecify the approximate length of the genome\n\n"
+         << "Optional:\n"
+         << "\t-h,--help\t\t\t\tShows Help\n"
+         << "\t-n,--number-of-seeds\t\t\tSpecify number of seeds 1-8 (default 8)\n"
+         << "\t-w,--weight <weight>\t\t\tSpecify weight of seeds 10-26 (default to determined by program)\n"
+         << "\t-o,--output-file <file>\t\t\tCorrected file (default <input_prefix>_QUESS_corrected.<ext>)\n\n"
+         << "Example Usage:\n"
+         << "mpirun -np 4 ./QUESS_mpi -g 2000000 -i file.fastq"
+         << endl;
+}
+
+/**
+  * Name:               int main(int argc, char* argv[])
+  *
+  * Description :       Main function of QUESS_mpi
+  *
+  * Input :
+  *       Parameters:
+  *           int       argc                Number of arguments passed to program
+  *           char*     argv[]              An array containing the aforementioned arguments
+  *
+  *
+  * Process Synopsis :
+  *                     [1]  Parse the arguments
+  *                     [2]  Rank 0 creates the working files; the reads are split among the ranks
+  *                     [3]  For each seed: insert sMers and sGaps in the tables of their owners, rehash and
+  *                          remove ambiguous sMers in each part, correct the reads of each rank
+  *                     [4]  Rank 0 gathers the corrected reads and writes the corrected dataset
+  *
+  * Notes :             Messages are printed by rank 0 only.
+  *
+  */
+
+int main(int argc, char* argv[])
+{
+    int provided = 0;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+    MPI_Comm_rank(MPI_COMM_WORLD, &myRank);
+    MPI_Comm_size(MPI_COMM_WORLD, &numberOfRanks);
+    ofstream quiet("/dev/null");
+    streambuf* coutBuffer = cout.rdbuf();       // restored before quiet is destroyed (cout is flushed at exit)
+    if (myRank != 0)
+        cout.rdbuf(quiet.rdbuf());
+
+    time_t total_time_start, total_time_end;
+    time(&total_time_start);
+    int weight = 0, numberOfSeeds = 8;
+    uint64_t genomeLength = 0;
+    char* datasetName = new char[10000];
+    char* inputTempFileName = new char[10000];
+    char* outputTempFileName = new char[10000];
+    char* outputFileName = new char[10000];
+    char* spoolFileName = new char[10000];
+    char* rankInputName = new char[10000];
+    char* rankOutputName = new char[10000];
+    datasetName[0] = inputTempFileName[0] = outputTempFileName[0] = outputFileName[0] = spoolFileName[0] = '\0';
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if ((arg == "-h") || (arg == "--help"))
+        {
+            if (myRank == 0)
+                show_usage();
+            cout.rdbuf(coutBuffer);
+            MPI_Finalize();
+            return 0;
+        }
+        if (i + 1 >= argc)
+            continue;
+        if ((arg == "-g") || (arg == "--genome-length") || (arg == "--genome-size"))
+            genomeLength = strtoull(argv[i+1], NULL, 10);
+        if ((arg == "-i") || (arg == "--input-file"))
+            strcpy(datasetName, argv[i+1]);
+        if ((arg == "-o") || (arg == "--output-file"))
+            strcpy(outputFileName, argv[i+1]);
+        if ((arg == "-w") || (arg == "--weight"))
+            weight = atoi(argv[i+1]);
+        if ((arg == "-n") || (arg == "--number-of-seeds"))
+            numberOfSeeds = atoi(argv[i+1]);
+    }
+    if ((genomeLength == 0) || (datasetName[0] == '\0') || (strcmp(datasetName, "-") == 0)
+        || ((weight != 0) && ((weight < 10) || (weight > 26))) || (numberOfSeeds < 1) || (numberOfSeeds > 8))
+    {
+        if (myRank == 0)
+            show_usage();
+        cout.rdbuf(coutBuffer);
+        MPI_Finalize();
+        return 1;
+    }
+    uint64_t peakMemory = 7*10000*sizeof(char), currentMemory = peakMemory;
+
+    // ============ FILES ====================
+    int64_t numberOfReads = 0, totalReadLength = 0;
+    DatasetWriter outputFile;
+    if (myRank == 0)
+    {
+        cout << "QUESS_mpi: " << numberOfRanks << " ranks" << endl;
+        try {
+            createWorkingFiles(inputTempFileName, outputTempFileName, datasetName, outputFileName, spoolFileName, NULL, outputFile, numberOfReads, totalReadLength, peakMemory, currentMemory);
+        }
+        catch (const QuessError& error) {   cerr << error.what() << endl; MPI_Abort(MPI_COMM_WORLD, 1); }
+    }
+    MPI_Bcast(inputTempFileName, 10000, MPI_CHAR, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&numberOfReads, 1, MPI_INT64_T, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&totalReadLength, 1, MPI_INT64_T, 0, MPI_COMM_WORLD);
+    if (numberOfReads == 0)
+    {
+        if (myRank == 0)
+            cerr << "No reads in " << datasetName << endl;
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    sprintf(rankInputName, "%s.rank%d", inputTempFileName, myRank);
+    sprintf(rankOutputName, "%s.rank%d.corrected", inputTempFileName, myRank);
+    int64_t bucketSize = max((int64_t)1, min((int64_t)(genomeLength * 10 / MAX_READ_LENGTH), (int64_t)MPI_BUCKET_SIZE));
+    int64_t myReads = distributeReads(inputTempFileName, rankInputName, numberOfReads, bucketSize);
+    cout << "reads of rank 0: " << myReads << endl;
+
+    // ============ SEEDS ====================
+    if (totalReadLength>1000000000 && weight==0)
+        weight=20;
+    if (totalReadLength<=1000000000 && weight==0)
+        weight=16;
+    char** seeds = new char*[numberOfSeeds];
+    for (int64_t i = 0; i < numberOfSeeds; ++i)
+    {
+        seeds[i] = new char[1000];
+        try {
+            getSeed(seeds[i],weight, numberOfSeeds, i, peakMemory, currentMemory);
+        }
+        catch (const QuessError& error) {   cerr << error.what() << endl; MPI_Abort(MPI_COMM_WORLD, 1); }
+    }
+    cout << "============ SEEDS ============\n";
+    cout << "weight = " << weight << endl;
+    cout << "numberOfSeeds = " << numberOfSeeds << endl;
+    for (int64_t i = 0; i < numberOfSeeds; ++i)
+        cout << seeds[i] << endl;
+
+    int64_t readLength = (int64_t)(totalReadLength / numberOfReads);
+    int Tc = 8;
+    computeTc(readLength, numberOfReads, genomeLength, weight, 0.005, Tc);
+    HashTable H((uint64_t)(genomeLength * 2 / numberOfRanks));     // this rank's part of the starting hash size
+    currentMemory += H.getSize() * sizeof(uint64_t);                // rounded up to a size of hashTableSizes
+    peakMemory = max(peakMemory, currentMemory);
+
+    //======== START CORRECTING =================
+    for (int64_t seedNumber = 0; seedNumber < numberOfSeeds; ++seedNumber)
+    {
+        time_t iteration_time_start, iteration_time_end;
+        cout << "\n=============== SEED " << seedNumber <<  " ==============\n";
+        time(&iteration_time_start);
+        Seed currentSeed = Seed(seeds[seedNumber]);
+        BlockReader inputTempFile;
+        BlockWriter outputTempFile;
+        inputTempFile.open(rankInputName);
+        if (!inputTempFile.is_open()) {   cerr << "Cannot open input temp file: " << rankInputName << endl; MPI_Abort(MPI_COMM_WORLD, 1); }
+        outputTempFile.open(rankOutputName);
+        if (!outputTempFile.is_open()) {   cerr << "Cannot open output temp file: " << rankOutputName << endl; MPI_Abort(MPI_COMM_WORLD, 1); }
+        int Te = max(2,(seedNumber<=3) ? Tc/4 : Tc/2);
+        int Tdiff = (seedNumber <= 3) ? 4 : 2;
+
+        insertSMersMPI(seedNumber, currentSeed, H, inputTempFile, bucketSize, peakMemory, currentMemory);
+        rehashFrequentSMers(H, Tc, peakMemory, currentMemory);
+        insertSGapsMPI(currentSeed, H, inputTempFile, Te, bucketSize, (int)seedNumber, peakMemory, currentMemory);
+        removeAmbiguousSMers(H, Tc, Te, (int)seedNumber, peakMemory, currentMemory);
+        correctMPI(seedNumber, currentSeed, H, inputTempFile, outputTempFile, Tdiff, bucketSize);
+
+        inputTempFile.close();
+        outputTempFile.close();
+        H.clear(peakMemory, currentMemory);
+        swapFiles(rankInputName, rankOutputName, seedNumber, numberOfSeeds);
+        uint64_t maxPeakMemory = 0;
+        MPI_Reduce(&peakMemory, &maxPeakMemory, 1, MPI_UINT64_T, MPI_MAX, 0, MPI_COMM_WORLD);
+        cout << "Tc = " << Tc << ", Te = " << Te << ", Tdiff = " << Tdiff << endl;
+        cout << "Peak Memory Usage (largest rank) = " << maxPeakMemory/1048576 << " MB" << endl;
+        time(&iteration_time_end);
+        cout << "\n============ DONE SEED " << seedNumber << " (" << difftime(iteration_time_end, iteration_time_start) << "s) ===========\n" << endl;
+    }
+
+    // ======== create the "outputFile" ===========
+    gatherCorrectedReads(rankOutputName, outputTempFileName, numberOfReads, bucketSize);
+    if (myRank == 0)
+    {
+        try {
+            if (spoolFileName[0] != '\0')
+            {
+                createOutputFile(spoolFileName, outputTempFileName, outputFileName, outputFile, true);
+                remove(spoolFileName);
+                removeAtAbnormalExit(NULL);
+            }
+            else
+                createOutputFile(datasetName, outputTempFileName, outputFileName, outputFile, false);
+        }
+        catch (const QuessError& error) {   cerr << error.what() << endl; MPI_Abort(MPI_COMM_WORLD, 1); }
+    }
+    for (int64_t i = 0; i < numberOfSeeds; ++i)
+        delete [] seeds[i];
+    delete [] seeds;
+    delete [] datasetName;
+    delete [] inputTempFileName;
+    delete [] outputTempFileName;
+    delete [] outputFileName;
+    delete [] spoolFileName;
+    delete [] rankInputName;
+    delete [] rankOutputName;
+    time(&total_time_end);
+    cout << "\n=================== END (" << difftime(total_time_end, total_time_start) << "s) ======================" << endl;
+    MPI_Barrier(MPI_COMM_WORLD);
+    cout.rdbuf(coutBuffer);
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,1145 @@
+/**
+  * File:     asyncIO.cpp
+  *
+  * Author1:  Lucian Ilie (ilie@uwo.ca)
+  * Author2:  Stephen Lu (slu93@uwo.ca)
+  *
+  *   This file contains code concerning the file access of
+  *   QUESS. The temp read files and the output file are read
+  *   and written sequentially in large blocks; with io_uring
+  *   several blocks are kept in flight so the disk works while
+  *   the threads process the current bucket. When io_uring is
+  *   not available, plain pread/pwrite calls are used instead.
+  *
+  */
+
+#include "QUESS.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#if USE_IO_URING
+#include <linux/io_uring.h>
+#endif
+
+static bool asyncIOEnabled = true;     // io_uring is tried first unless disabled with --no-io-uring
+static uint64_t ioBuffers = NUMBER_OF_IO_BUFFERS;      // blocks of the files opened next (setIOBuffers)
+static uint64_t ioBufferSize = IO_BUFFER_SIZE;
+
+#define STREAM_OFFSET ((uint64_t)-1)   // offset of reads/writes on pipes and terminals (no pread/pwrite)
+
+/**
+  * Name:               setAsyncIO(bool enabled)
+  *
+  * Description :       Enables or disables the io_uring backend for all files opened afterwards
+  *
+  * Input :
+  *       Parameters:
+  *           bool      enabled             false forces the pread/pwrite fallback
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :
+  *
+  */
+
+void setAsyncIO(bool enabled)
+{
+    asyncIOEnabled = enabled;
+}
+
+/**
+  * Name:               setIOBuffers(uint64_t numberOfBuffers, uint64_t bufferSize)
+  *
+  * Description :       Sets the number and the size of the blocks of the files opened afterwards
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t  numberOfBuffers     blocks in flight; MIN_NUMBER_OF_IO_BUFFERS to NUMBER_OF_IO_BUFFERS
+  *           uint64_t  bufferSize          bytes of a block; MIN_IO_BUFFER_SIZE to IO_BUFFER_SIZE
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :             Values outside the limits are clamped. Files already open keep their blocks.
+  *                     Used by the memory plan (planMemory) when the default buffers do not fit a budget.
+  *
+  */
+
+void setIOBuffers(uint64_t numberOfBuffers, uint64_t bufferSize)
+{
+    ioBuffers = min(max(numberOfBuffers, (uint64_t) MIN_NUMBER_OF_IO_BUFFERS), (uint64_t) NUMBER_OF_IO_BUFFERS);
+    ioBufferSize = min(max(bufferSize, (uint64_t) MIN_IO_BUFFER_SIZE), (uint64_t) IO_BUFFER_SIZE);
+}
+
+uint64_t getNumberOfIOBuffers()
+{
+    return ioBuffers;
+}
+
+uint64_t getIOBufferSize()
+{
+    return ioBufferSize;
+}
+
+// =============================================================
+// ====================== io_uring helpers =====================
+// submission and completion rings are used directly through the
+// system calls (no liburing needed); one ring per open file
+
+struct IORing
+{
+#if USE_IO_URING
+    int fd;
+    unsigned *sqHead, *sqTail, *sqMask, *sqArray;
+    unsigned *cqHead, *cqTail, *cqMask;
+    struct io_uring_sqe* sqes;
+    struct io_uring_cqe* cqes;
+    void *sqPtr, *cqPtr;
+    size_t sqSize, cqSize, sqesSize;
+#endif
+};
+
+/**
+  * Name:               createRing(unsigned entries)
+  *
+  * Description :       Creates an io_uring instance with 'entries' submission slots
+  *
+  * Input :
+  *       Parameters:
+  *           unsigned  entries             number of submission queue entries
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           IORing                        rings mapped in memory
+  *       Return:
+  *           IORing*                       the ring or NULL if io_uring cannot be used
+  *
+  * Process Synopsis :
+  *                     [1]  Calls io_uring_setup
+  *                     [2]  Maps the submission ring, the completion ring and the submission entries
+  *
+  * Notes :             NULL is returned on kernels without io_uring or when it is blocked (e.g., seccomp);
+  *                     the caller then uses pread/pwrite.
+  *
+  */
+
+static IORing* createRing(unsigned entries)
+{
+#if USE_IO_URING
+    if (!asyncIOEnabled)
+        return NULL;
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    int fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+    if (fd < 0)
+        return NULL;
+
+    IORing* ring = new IORing;
+    ring->fd = fd;
+    ring->sqSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    ring->cqSize = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+        ring->sqSize = ring->cqSize = max(ring->sqSize, ring->cqSize);
+    ring->sqPtr = mmap(0, ring->sqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (ring->sqPtr == MAP_FAILED)
+    {
+        close(fd);
+        delete ring;
+        return NULL;
+    }
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+        ring->cqPtr = ring->sqPtr;
+    else
+    {
+        ring->cqPtr = mmap(0, ring->cqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (ring->cqPtr == MAP_FAILED)
+        {
+            munmap(ring->sqPtr, ring->sqSize);
+            close(fd);
+            delete ring;
+            return NULL;
+        }
+    }
+    ring->sqesSize = p.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = (struct io_uring_sqe*)mmap(0, ring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED)
+    {
+        if (ring->cqPtr != ring->sqPtr)
+            munmap(ring->cqPtr, ring->cqSize);
+        munmap(ring->sqPtr, ring->sqSize);
+        close(fd);
+        delete ring;
+        return NULL;
+    }
+    char* sq = (char*)ring->sqPtr;
+    char* cq = (char*)ring->cqPtr;
+    ring->sqHead  = (unsigned*)(sq + p.sq_off.head);
+    ring->sqTail  = (unsigned*)(sq + p.sq_off.tail);
+    ring->sqMask  = (unsigned*)(sq + p.sq_off.ring_mask);
+    ring->sqArray = (unsigned*)(sq + p.sq_off.array);
+    ring->cqHead  = (unsigned*)(cq + p.cq_off.head);
+    ring->cqTail  = (unsigned*)(cq + p.cq_off.tail);
+    ring->cqMask  = (unsigned*)(cq + p.cq_off.ring_mask);
+    ring->cqes    = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+    return ring;
+#else
+    return NULL;
+#endif
+}
+
+/**
+  * Name:               destroyRing(IORing* ring)
+  *
+  * Description :       Unmaps and closes an io_uring instance created by createRing
+  *
+  * Input :
+  *       Parameters:
+  *           IORing*   ring                the ring (may be NULL)
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           IORing                        rings unmapped and deleted
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :
+  *
+  */
+
+static void destroyRing(IORing* ring)
+{
+#if USE_IO_URING
+    if (ring == NULL)
+        return;
+    munmap(ring->sqes, ring->sqesSize);
+    if (ring->cqPtr != ring->sqPtr)
+        munmap(ring->cqPtr, ring->cqSize);
+    munmap(ring->sqPtr, ring->sqSize);
+    close(ring->fd);
+    delete ring;
+#endif
+}
+
+/**
+  * Name:               submitIO(IORing* ring, bool write, int fd, char* data, uint64_t length, uint64_t offset, uint64_t tag)
+  *
+  * Description :       Queues one read or write and notifies the kernel
+  *
+  * Input :
+  *       Parameters:
+  *           IORing*   ring                the ring
+  *           bool      write               true for a write, false for a read
+  *           int       fd                  file descriptor
+  *           char*     data                buffer
+  *           uint64_t  length              number of bytes
+  *           uint64_t  offset              file offset
+  *           uint64_t  tag                 returned with the completion (buffer index)
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           bool                          true (exits on failure)
+  *
+  * Process Synopsis :
+  *                     [1]  Fill the submission entry at the tail of the submission ring
+  *                     [2]  Publish the new tail and call io_uring_enter
+  *
+  * Notes :             Only one thread uses a given ring.
+  *
+  */
+
+static bool submitIO(IORing* ring, bool write, int fd, char* data, uint64_t length, uint64_t offset, uint64_t tag)
+{
+#if USE_IO_URING
+    unsigned tail = *ring->sqTail;
+    unsigned index = tail & *ring->sqMask;
+    struct io_uring_sqe* sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = write ? IORING_OP_WRITE : IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)data;
+    sqe->len = (uint32_t)length;
+    sqe->off = offset;
+    sqe->user_data = tag;
+    ring->sqArray[index] = index;
+    __atomic_store_n(ring->sqTail, tail + 1, __ATOMIC_RELEASE);
+    long submitted = 0;
+    while (((submitted = syscall(__NR_io_uring_enter, ring->fd, 1, 0, 0, NULL, 0)) < 0) && ((errno == EINTR) || (errno == EAGAIN)))
+        ;
+    if (submitted != 1)     // the entry is already in the ring, so there is no way back to pread
+    throw QuessError("io_uring_enter failed: " + string(strerror(errno)));
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+  * Name:               waitIO(IORing* ring, uint64_t& tag, int64_t& result)
+  *
+  * Description :       Waits for the next completion
+  *
+  * Input :
+  *       Parameters:
+  *           IORing*   ring                the ring
+  *           uint64_t& tag                 tag of the completed request
+  *           int64_t&  result              bytes transferred or -errno
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           uint64_t& tag                 set from the completion entry
+  *           int64_t&  result              set from the completion entry
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  If the completion ring is empty, block in io_uring_enter until one request completes
+  *                     [2]  Consume the entry at the head of the completion ring
+  *
+  * Notes :
+  *
+  */
+
+static void waitIO(IORing* ring, uint64_t& tag, int64_t& result)
+{
+#if USE_IO_URING
+    unsigned head = *ring->cqHead;
+    while (head == __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE))
+        if ((syscall(__NR_io_uring_enter, ring->fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0) && (errno != EINTR))
+        throw QuessError("io_uring_enter failed: " + string(strerror(errno)));
+    struct io_uring_cqe* cqe = &ring->cqes[head & *ring->cqMask];
+    tag = cqe->user_data;
+    result = cqe->res;
+    __atomic_store_n(ring->cqHead, head + 1, __ATOMIC_RELEASE);
+#endif
+}
+
+/**
+  * Name:               preadFully(int fd, char* data, uint64_t length, uint64_t offset)
+  *                     pwriteFully(int fd, const char* data, uint64_t length, uint64_t offset)
+  *
+  * Description :       Blocking read/write of exactly 'length' bytes (fewer for a read at end of file)
+  *
+  * Input :
+  *       Parameters:
+  *           int       fd                  file descriptor
+  *           char*     data                buffer
+  *           uint64_t  length              number of bytes
+  *           uint64_t  offset              file offset; STREAM_OFFSET for pipes/terminals (current position)
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           uint64_t                      number of bytes transferred
+  *
+  * Process Synopsis :
+  *                     [1]  Repeat pread/pwrite (read/write for streams) until all bytes are transferred (or end of file)
+  *
+  * Notes :             Used by the fallback backend, to complete short io_uring transfers and for streams.
+  *
+  */
+
+static uint64_t preadFully(int fd, char* data, uint64_t length, uint64_t offset)
+{
+    uint64_t done = 0;
+    while (done < length)
+    {
+        ssize_t n = (offset == STREAM_OFFSET) ? ::read(fd, data + done, length - done) : pread(fd, data + done, length - done, offset + done);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw QuessError("Read failed: " + string(strerror(errno)));
+        }
+        if (n == 0)
+            break;
+        done += n;
+    }
+    return done;
+}
+
+static uint64_t pwriteFully(int fd, const char* data, uint64_t length, uint64_t offset)
+{
+    uint64_t done = 0;
+    while (done < length)
+    {
+        ssize_t n = (offset == STREAM_OFFSET) ? ::write(fd, data + done, length - done) : pwrite(fd, data + done, length - done, offset + done);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw QuessError("Write failed: " + string(strerror(errno)));
+        }
+        done += n;
+    }
+    return done;
+}
+
+// =============================================================
+// ====================== BlockReader ==========================
+
+/**
+  * Name:               BlockReader()
+  *
+  * Description :       Default constructor; no file is open
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           BlockReader                   Returns a closed reader
+  *
+  * Process Synopsis :
+  *
+  * Notes :             Buffers are allocated by open() and released by close().
+  *
+  */
+
+BlockReader::BlockReader()
+{
+    fd = -1;
+    ring = NULL;
+    fileSize = 0;
+    stream = false;
+    numberOfBuffers = NUMBER_OF_IO_BUFFERS;
+    bufferSize = IO_BUFFER_SIZE;
+    for (uint64_t i = 0; i < NUMBER_OF_IO_BUFFERS; ++i)
+    {
+        buffers[i] = NULL;
+        bufferLength[i] = 0;
+        bufferPending[i] = false;
+    }
+    currentBlock = -1;
+    currentPos = 0;
+}
+
+BlockReader::~BlockReader()
+{
+    close();
+}
+
+/**
+  * Name:               open(const char* fileName)
+  *
+  * Description :       Opens a file for sequential reading and starts reading its first blocks
+  *
+  * Input :
+  *       Parameters:
+  *           const char* fileName          name of the file; "-" for standard input
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           char*     buffers             numberOfBuffers buffers of bufferSize bytes (setIOBuffers)
+  *       Return:
+  *           bool                          false if the file cannot be opened
+  *
+  * Process Synopsis :
+  *                     [1]  Open the file and get its size
+  *                     [2]  Create the io_uring (if possible) and allocate the buffers
+  *                     [3]  Request the first numberOfBuffers blocks
+  *
+  * Notes :             Pipes, FIFOs and terminals (streams) are read with read(), in order; their size is
+  *                     known only at their end and they cannot be rewound.
+  *
+  */
+
+bool BlockReader::open(const char* fileName)
+{
+    close();
+    fd = (strcmp(fileName, "-") == 0) ? dup(STDIN_FILENO) : ::open(fileName, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    stream = !S_ISREG(st.st_mode);
+    numberOfBuffers = ioBuffers;
+    bufferSize = ioBufferSize;
+    fileSize = stream ? STREAM_OFFSET : st.st_size;
+    if (!stream)
+    {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        ring = createRing(numberOfBuffers);
+    }
+    for (uint64_t i = 0; i < numberOfBuffers; ++i)
+        buffers[i] = new char[bufferSize];
+    currentBlock = -1;
+    currentPos = 0;
+    for (uint64_t i = 0; i < numberOfBuffers; ++i)
+        requestBlock(i);
+    return true;
+}
+
+/**
+  * Name:               is_open()
+  *
+  * Description :       Returns true if a file is open
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           bool                          true if a file is open
+  *
+  * Process Synopsis :
+  *
+  * Notes :
+  *
+  */
+
+bool BlockReader::is_open()
+{
+    return (fd >= 0);
+}
+
+/**
+  * Name:               is_stream()
+  *
+  * Description :       Returns true if the open file is a pipe, FIFO or terminal (not a regular file)
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           bool                          true for streams; they can be read only once
+  *
+  * Process Synopsis :
+  *
+  * Notes :
+  *
+  */
+
+bool BlockReader::is_stream()
+{
+    return stream;
+}
+
+/**
+  * Name:               requestBlock(uint64_t block)
+  *
+  * Description :       Starts reading block number 'block' into buffer block % numberOfBuffers
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t  block               block number (offset = block * bufferSize)
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           char*     buffers             filled now (fallback) or when the read completes (io_uring)
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  Blocks past the end of the file are ignored
+  *                     [2]  With io_uring, submit the read; otherwise, pread the block
+  *                     [3]  Streams are read in order; a short read gives the size of the stream
+  *
+  * Notes :
+  *
+  */
+
+void BlockReader::requestBlock(uint64_t block)
+{
+    uint64_t offset = block * bufferSize;
+    if (offset >= fileSize)
+        return;
+    uint64_t b = block % numberOfBuffers;
+    uint64_t length = min(bufferSize, fileSize - offset);
+    bufferOffset[b] = offset;
+    if ((ring != NULL) && submitIO(ring, false, fd, buffers[b], length, offset, b))
+    {
+        bufferPending[b] = true;
+        return;
+    }
+    bufferLength[b] = preadFully(fd, buffers[b], length, stream ? STREAM_OFFSET : offset);
+    if (stream && (bufferLength[b] < length))      // end of the stream
+        fileSize = offset + bufferLength[b];
+}
+
+/**
+  * Name:               waitBlock(uint64_t block)
+  *
+  * Description :       Waits until block number 'block' is in its buffer
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t  block               block number
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           uint64_t  bufferLength        set for every completed block
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  Consume completions until the buffer of 'block' is no longer pending
+  *                     [2]  Short or failed reads are completed with pread
+  *
+  * Notes :
+  *
+  */
+
+void BlockReader::waitBlock(uint64_t block)
+{
+    uint64_t b = block % numberOfBuffers;
+    while (bufferPending[b])
+    {
+        uint64_t tag = 0;
+        int64_t result = 0;
+        waitIO(ring, tag, result);
+        bufferPending[tag] = false;
+        uint64_t offset = bufferOffset[tag];
+        uint64_t length = min(bufferSize, fileSize - offset);
+        uint64_t done = (result > 0) ? (uint64_t)result : 0;
+        if (done < length)      // short or failed read; finish it synchronously
+            done += preadFully(fd, buffers[tag] + done, length - done, offset + done);
+        bufferLength[tag] = done;
+    }
+}
+
+/**
+  * Name:               rewind()
+  *
+  * Description :       Restarts reading from the beginning of the file
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  Wait for all reads in flight
+  *                     [2]  Request the first numberOfBuffers blocks
+  *
+  * Notes :             Replaces clear() + seekg(0, ios::beg) of the former ifstream. Streams cannot be rewound.
+  *
+  */
+
+void BlockReader::rewind()
+{
+    if (fd < 0)
+        return;
+    if (stream)
+    {
+        throw QuessError("Cannot rewind a pipe or standard input");
+    }
+    for (uint64_t i = 0; i < numberOfBuffers; ++i)
+        while (bufferPending[i])
+            waitBlock(i);
+    currentBlock = -1;
+    currentPos = 0;
+    for (uint64_t i = 0; i < numberOfBuffers; ++i)
+        requestBlock(i);
+}
+
+/**
+  * Name:               nextBlock()
+  *
+  * Description :       Moves to the next block of the file
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           bool                          false at end of file
+  *
+  * Process Synopsis :
+  *                     [1]  The buffer of the block just consumed receives block currentBlock + numberOfBuffers
+  *                     [2]  Wait for the next block
+  *
+  * Notes :
+  *
+  */
+
+bool BlockReader::nextBlock()
+{
+    if ((uint64_t)(currentBlock + 1) * bufferSize >= fileSize)
+        return false;           // end of file; stay at the (consumed) last block
+    if (currentBlock >= 0)
+        requestBlock(currentBlock + numberOfBuffers);
+    ++currentBlock;
+    currentPos = 0;
+    waitBlock(currentBlock);
+    return true;
+}
+
+/**
+  * Name:               getline(char* line, uint64_t maxLength)
+  *
+  * Description :       Reads the next line (without '\n') into 'line'
+  *
+  * Input :
+  *       Parameters:
+  *           char*     line                destination
+  *           uint64_t  maxLength           size of 'line'; longer lines are truncated to maxLength - 1 characters
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           char*     line                the line, null-terminated
+  *       Memory:
+  *           None
+  *       Return:
+  *           bool                          false at end of file
+  *
+  * Process Synopsis :
+  *                     [1]  Search '\n' in the current block; lines may continue in the next block
+  *
+  * Notes :
+  *
+  */
+
+bool BlockReader::getline(char* line, uint64_t maxLength)
+{
+    uint64_t n = 0;
+    bool found = false;
+    while (true)
+    {
+        if ((currentBlock < 0) || (currentPos >= bufferLength[currentBlock % numberOfBuffers]))
+            if (!nextBlock())
+                break;
+        char* data = buffers[currentBlock % numberOfBuffers] + currentPos;
+        uint64_t available = bufferLength[currentBlock % numberOfBuffers] - currentPos;
+        char* newLine = (char*)memchr(data, '\n', available);
+        uint64_t lineLength = (newLine != NULL) ? (uint64_t)(newLine - data) : available;
+        uint64_t copy = min(lineLength, maxLength - 1 - n);
+        memcpy(line + n, data, copy);
+        n += copy;
+        currentPos += lineLength;
+        found = true;
+        if (newLine != NULL)
+        {
+            ++currentPos;
+            break;
+        }
+    }
+    line[n] = '\0';
+    return found;
+}
+
+/**
+  * Name:               read(char* data, uint64_t maxLength)
+  *
+  * Description :       Reads the next (at most) maxLength bytes
+  *
+  * Input :
+  *       Parameters:
+  *           char*     data                destination
+  *           uint64_t  maxLength           maximum number of bytes
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           char*     data                the bytes read
+  *       Memory:
+  *           None
+  *       Return:
+  *           uint64_t                      number of bytes read; 0 at end of file
+  *
+  * Process Synopsis :
+  *                     [1]  Copy from the current block, moving to the next ones as needed
+  *
+  * Notes :
+  *
+  */
+
+uint64_t BlockReader::read(char* data, uint64_t maxLength)
+{
+    uint64_t n = 0;
+    while (n < maxLength)
+    {
+        if ((currentBlock < 0) || (currentPos >= bufferLength[currentBlock % numberOfBuffers]))
+            if (!nextBlock())
+                break;
+        uint64_t available = bufferLength[currentBlock % numberOfBuffers] - currentPos;
+        uint64_t copy = min(available, maxLength - n);
+        memcpy(data + n, buffers[currentBlock % numberOfBuffers] + currentPos, copy);
+        n += copy;
+        currentPos += copy;
+    }
+    return n;
+}
+
+/**
+  * Name:               close()
+  *
+  * Description :       Closes the file and frees the buffers
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           char*     buffers             deallocated
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  Wait for the reads in flight, destroy the ring, free the buffers
+  *
+  * Notes :
+  *
+  */
+
+void BlockReader::close()
+{
+    if (fd < 0)
+        return;
+    for (uint64_t i = 0; i < numberOfBuffers; ++i)
+        while (bufferPending[i])
+            waitBlock(i);
+    destroyRing(ring);
+    ring = NULL;
+    ::close(fd);
+    fd = -1;
+    for (uint64_t i = 0; i < numberOfBuffers; ++i)
+    {
+        delete [] buffers[i];
+        buffers[i] = NULL;
+    }
+}
+
+// =============================================================
+// ====================== BlockWriter ==========================
+
+/**
+  * Name:               BlockWriter()
+  *
+  * Description :       Default constructor; no file is open
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           BlockWriter                   Returns a closed writer
+  *
+  * Process Synopsis :
+  *
+  * Notes :
+  *
+  */
+
+BlockWriter::BlockWriter()
+{
+    fd = -1;
+    ring = NULL;
+    stream = false;
+    numberOfBuffers = NUMBER_OF_IO_BUFFERS;
+    bufferSize = IO_BUFFER_SIZE;
+    for (uint64_t i = 0; i < NUMBER_OF_IO_BUFFERS; ++i)
+    {
+        buffers[i] = NULL;
+        bufferLength[i] = 0;
+        bufferOffset[i] = 0;
+        bufferPending[i] = false;
+    }
+    currentBuffer = 0;
+    fileOffset = 0;
+}
+
+BlockWriter::~BlockWriter()
+{
+    close();
+}
+
+/**
+  * Name:               open(const char* fileName)
+  *
+  * Description :       Creates (truncates) a file for sequential writing
+  *
+  * Input :
+  *       Parameters:
+  *           const char* fileName          name of the file; "-" for standard output
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           char*     buffers             numberOfBuffers buffers of bufferSize bytes (setIOBuffers)
+  *       Return:
+  *           bool                          false if the file cannot be created
+  *
+  * Process Synopsis :
+  *
+  * Notes :             Pipes, FIFOs and terminals (streams) are written with write(), in order.
+  *
+  */
+
+bool BlockWriter::open(const char* fileName)
+{
+    close();
+    fd = (strcmp(fileName, "-") == 0) ? dup(STDOUT_FILENO) : ::open(fileName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    stream = (fstat(fd, &st) != 0) || !S_ISREG(st.st_mode);
+    numberOfBuffers = ioBuffers;
+    bufferSize = ioBufferSize;
+    if (!stream)
+        ring = createRing(numberOfBuffers);
+    for (uint64_t i = 0; i < numberOfBuffers; ++i)
+    {
+        buffers[i] = new char[bufferSize];
+        bufferLength[i] = 0;
+    }
+    currentBuffer = 0;
+    fileOffset = 0;
+    return true;
+}
+
+bool BlockWriter::is_open()
+{
+    return (fd >= 0);
+}
+
+/**
+  * Name:               waitBuffer(uint64_t b)
+  *
+  * Description :       Waits until the write from buffer b (if any) has completed
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t  b                   buffer index
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  Consume completions until buffer b is no longer pending
+  *                     [2]  Short or failed writes are completed with pwrite
+  *
+  * Notes :
+  *
+  */
+
+void BlockWriter::waitBuffer(uint64_t b)
+{
+    while (bufferPending[b])
+    {
+        uint64_t tag = 0;
+        int64_t result = 0;
+        waitIO(ring, tag, result);
+        bufferPending[tag] = false;
+        uint64_t done = (result > 0) ? (uint64_t)result : 0;
+        if (done < bufferLength[tag])
+            pwriteFully(fd, buffers[tag] + done, bufferLength[tag] - done, bufferOffset[tag] + done);
+        bufferLength[tag] = 0;
+    }
+}
+
+/**
+  * Name:               flush()
+  *
+  * Description :       Writes the current buffer and moves to the next one
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  Submit the write (io_uring) or pwrite it (fallback)
+  *                     [2]  Wait until the next buffer is free
+  *
+  * Notes :
+  *
+  */
+
+void BlockWriter::flush()
+{
+    uint64_t b = currentBuffer;
+    if (bufferLength[b] == 0)
+        return;
+    bufferOffset[b] = fileOffset;
+    fileOffset += bufferLength[b];
+    if ((ring != NULL) && submitIO(ring, true, fd, buffers[b], bufferLength[b], bufferOffset[b], b))
+        bufferPending[b] = true;
+    else
+    {
+        pwriteFully(fd, buffers[b], bufferLength[b], stream ? STREAM_OFFSET : bufferOffset[b]);
+        bufferLength[b] = 0;
+    }
+    currentBuffer = (currentBuffer + 1) % numberOfBuffers;
+    waitBuffer(currentBuffer);
+}
+
+/**
+  * Name:               write(const char* data, uint64_t length)
+  *                     writeLine(const char* line)
+  *
+  * Description :       Appends 'length' bytes (or a null-terminated line followed by '\n') to the file
+  *
+  * Input :
+  *       Parameters:
+  *           const char* data              the bytes
+  *           uint64_t  length              number of bytes
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  Copy into the current buffer; full buffers are flushed
+  *
+  * Notes :
+  *
+  */
+
+void BlockWriter::write(const char* data, uint64_t length)
+{
+    while (length > 0)
+    {
+        uint64_t b = currentBuffer;
+        uint64_t copy = min(length, bufferSize - bufferLength[b]);
+        memcpy(buffers[b] + bufferLength[b], data, copy);
+        bufferLength[b] += copy;
+        data += copy;
+        length -= copy;
+        if (bufferLength[b] == bufferSize)
+            flush();
+    }
+}
+
+void BlockWriter::writeLine(const char* line)
+{
+    write(line, strlen(line));
+    write("\n", 1);
+}
+
+/**
+  * Name:               close()
+  *
+  * Description :       Writes the remaining data, closes the file and frees the buffers
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           char*     buffers             deallocated
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :
+  *
+  */
+
+void BlockWriter::close()
+{
+    if (fd < 0)
+        return;
+    flush();
+    for (uint64_t i = 0; i < numberOfBuffers; ++i)
+        waitBuffer(i);
+    destroyRing(ring);
+    ring = NULL;
+    ::close(fd);
+    fd = -1;
+    for (uint64_t i = 0; i < numberOfBuffers; ++i)
+    {
+        delete [] buffers[i];
+        buffers[i] = NULL;
+    }
+}
@@ -0,0 +1,347 @@
+/**
+  * File:     bucketTable.cpp
+  *
+  * Author1:  Lucian Ilie (ilie@uwo.ca)
+  * Author2:  Stephen Lu (slu93@uwo.ca)
+  *
+  *   This file contains the bucketized model of QUESS, used for the
+  *   correction. findPos probes the open addressing table one Element
+  *   at a time, and the sGap of the sMer found is in a separate
+  *   allocation. In the BucketTable a bucket is one cache line of 4
+  *   sMers, each with its entry (correct sGap and score). An sMer is in
+  *   its home bucket or, if that was full when it was inserted, in its
+  *   alternate bucket (bucketized cuckoo hashing); the few sMers placed
+  *   in neither are in a small sorted stash. A lookup compares the 4
+  *   sMers of the home bucket at once (AVX2 when the processor has it)
+  *   and reads the alternate bucket only when the home bucket is full:
+  *   one cache line per lookup, two on overflow, with the table 90% full.
+  *
+  */
+
+#include "QUESS.h"
+#include <algorithm>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#define BUCKET_MULTIPLIER 0x9E3779B97F4A7C15ULL     // home bucket of an sMer
+#define BUCKET_MULTIPLIER2 0xC2B2AE3D27D4EB4FULL    // alternate bucket
+#define BUCKET_EMPTY ((uint64_t)-1)                 // free slot (sMers have at most 56 bits)
+
+static bool slotLess(const BucketSlot& a, const BucketSlot& b)
+{
+    return a.key < b.key;
+}
+
+// put slot in the first free slot of bucket; false if the bucket is full
+static inline bool putInFreeSlot(Bucket& bucket, const BucketSlot& slot)
+{
+    if (bucket.slots[BUCKET_SLOTS - 1].key != BUCKET_EMPTY)
+        return false;
+    int i = 0;
+    while (bucket.slots[i].key != BUCKET_EMPTY)
+        ++i;
+    bucket.slots[i] = slot;
+    return true;
+}
+
+/**
+  * Name:               BucketTable(uint64_t* keys, uint64_t* entries, uint64_t numberOfKeys)
+  *
+  * Description :       Builds the table of the sMers keys[i] with their entries[i]
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t* keys                non-ambiguous sMers (each once)
+  *           uint64_t* entries             correct sGap | score << 56 of each sMer
+  *           uint64_t  numberOfKeys        number of sMers
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           Bucket*   buckets             about numberOfKeys / (BUCKET_SLOTS * BUCKET_LOAD) buckets
+  *           stash                         at most BUCKET_MAX_STASH sMers
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  build; if the stash would exceed BUCKET_MAX_STASH sMers, 10% more buckets and build again
+  *                     [2]  AVX2 comparison if the processor supports it
+  *
+  * Notes :
+  *
+  */
+
+BucketTable::BucketTable(uint64_t* keys, uint64_t* entries, uint64_t numberOfKeys)
+{
+    this->numberOfKeys = numberOfKeys;
+    numberOfBuckets = (uint64_t)(numberOfKeys / (BUCKET_SLOTS * BUCKET_LOAD)) + 2;
+    buckets = NULL;
+    while (!build(keys, entries))
+        numberOfBuckets += numberOfBuckets / 10 + 1;
+#if defined(__x86_64__)
+    useAVX2 = __builtin_cpu_supports("avx2");
+#else
+    useAVX2 = false;
+#endif
+    quessLog << "Bucket table: " << numberOfKeys << " sMers in " << numberOfBuckets << " buckets, " << stash.size()
+         << " in the stash" << (useAVX2 ? " (AVX2)" : "") << endl;
+}
+
+BucketTable::~BucketTable()
+{
+    delete [] buckets;
+}
+
+uint64_t BucketTable::memoryUsage()
+{
+    return numberOfBuckets * sizeof(Bucket) + stash.capacity() * sizeof(BucketSlot);
+}
+
+inline uint64_t BucketTable::homeBucket(uint64_t sMer)
+{
+    return (uint64_t)(((uint128_t)(sMer * BUCKET_MULTIPLIER) * numberOfBuckets) >> 64);
+}
+
+inline uint64_t BucketTable::alternateBucket(uint64_t sMer)
+{
+    uint64_t home = homeBucket(sMer);
+    uint64_t alternate = (uint64_t)(((uint128_t)((sMer ^ (sMer >> 29)) * BUCKET_MULTIPLIER2) * numberOfBuckets) >> 64);
+    return (alternate != home) ? alternate : ((home + 1 == numberOfBuckets) ? 0 : home + 1);
+}
+
+/**
+  * Name:               build(uint64_t* keys, uint64_t* entries)
+  *
+  * Description :       Places the sMers in numberOfBuckets buckets
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t* keys                sMers
+  *           uint64_t* entries             their entries
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           Bucket*   buckets, stash      (re)allocated and filled
+  *       Return:
+  *           bool                          false if more than BUCKET_MAX_STASH sMers would go to the stash
+  *
+  * Process Synopsis :
+  *                     [1]  An sMer goes to the first free slot of its home bucket, else of its alternate bucket
+  *                     [2]  Both full: it takes a slot of the alternate bucket and the sMer there moves to its other
+  *                          bucket, and so on (at most BUCKET_MAX_KICKS moves); the last sMer moved goes to the stash
+  *
+  * Notes :             A full bucket stays full (an sMer moved out is replaced at once), and an sMer is put in its
+  *                     alternate bucket only when its home bucket is full; so an sMer whose home bucket has a free
+  *                     slot is in it or not in the table. The slots of a bucket are filled in order.
+  *
+  */
+
+bool BucketTable::build(uint64_t* keys, uint64_t* entries)
+{
+    delete [] buckets;
+    buckets = new Bucket[numberOfBuckets];
+    for (uint64_t b = 0; b < numberOfBuckets; ++b)
+        for (int i = 0; i < BUCKET_SLOTS; ++i)
+        {
+            buckets[b].slots[i].key = BUCKET_EMPTY;
+            buckets[b].slots[i].entry = 0;
+        }
+    stash.clear();
+    uint64_t state = 0x2545F4914F6CDD1DULL;     // victims of the moves
+    for (uint64_t k = 0; k < numberOfKeys; ++k)
+    {
+        BucketSlot moving = {keys[k], entries[k]};
+        if (putInFreeSlot(buckets[homeBucket(moving.key)], moving))
+            continue;
+        uint64_t b = alternateBucket(moving.key);
+        bool placed = putInFreeSlot(buckets[b], moving);
+        for (int kicks = 0; !placed && (kicks < BUCKET_MAX_KICKS); ++kicks)
+        {
+            state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+            swap(buckets[b].slots[state % BUCKET_SLOTS], moving);      // b stays full
+            b = (b == homeBucket(moving.key)) ? alternateBucket(moving.key) : homeBucket(moving.key);
+            placed = putInFreeSlot(buckets[b], moving);
+        }
+        if (!placed)
+        {
+            if (stash.size() == BUCKET_MAX_STASH)
+                return false;
+            stash.push_back(moving);
+        }
+    }
+    sort(stash.begin(), stash.end(), slotLess);
+    return true;
+}
+
+/**
+  * Name:               matchAVX2(const Bucket& bucket, uint64_t sMer), matchScalar(...)
+  *
+  * Description :       Slots of a bucket holding sMer, and free slots
+  *
+  * Input :
+  *       Parameters:
+  *           const Bucket& bucket          a bucket (64-byte aligned)
+  *           uint64_t  sMer                the sMer
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           uint64_t                      bit i (i < 4): slot i holds sMer; bit 4 + i: slot i free
+  *
+  * Process Synopsis :
+  *                     [1]  AVX2: the cache line as two 256-bit words of (key, entry, key, entry), compared with the
+  *                          broadcast sMer and with BUCKET_EMPTY; the results of the entries are dropped
+  *
+  * Notes :             matchAVX2 is compiled for AVX2 whatever the flags of the build; it is only called when
+  *                     the processor has AVX2.
+  *
+  */
+
+#if defined(__x86_64__)
+__attribute__((target("avx2")))
+static uint64_t matchAVX2(const Bucket& bucket, uint64_t sMer)
+{
+    __m256i low  = _mm256_load_si256((const __m256i*)&bucket.slots[0]);
+    __m256i high = _mm256_load_si256((const __m256i*)&bucket.slots[2]);
+    __m256i key  = _mm256_set1_epi64x((long long)sMer);
+    __m256i empty = _mm256_set1_epi64x((long long)BUCKET_EMPTY);
+    uint64_t found = (uint64_t)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(low, key)))
+                   | ((uint64_t)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(high, key))) << 4);
+    uint64_t free = (uint64_t)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(low, empty)))
+                  | ((uint64_t)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(high, empty))) << 4);
+    found &= 0x55;      // lanes of the keys: 0, 2, 4, 6
+    free &= 0x55;
+    found = (found | (found >> 1)) & 0x33;      // to bits 0 .. 3
+    found = (found | (found >> 2)) & 0x0F;
+    free = (free | (free >> 1)) & 0x33;
+    free = (free | (free >> 2)) & 0x0F;
+    return found | (free << BUCKET_SLOTS);
+}
+#endif
+
+static inline uint64_t matchScalar(const Bucket& bucket, uint64_t sMer)
+{
+    uint64_t found = 0, free = 0;
+    for (int i = 0; i < BUCKET_SLOTS; ++i)
+    {
+        found |= (uint64_t)(bucket.slots[i].key == sMer) << i;
+        free  |= (uint64_t)(bucket.slots[i].key == BUCKET_EMPTY) << i;
+    }
+    return found | (free << BUCKET_SLOTS);
+}
+
+/**
+  * Name:               find(uint64_t sMer, uint64_t& entry)
+  *
+  * Description :       Entry of sMer
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t  sMer                the sMer
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           uint64_t& entry               correct sGap | score << 56, if found
+  *       Memory:
+  *           None
+  *       Return:
+  *           bool                          true if sMer is in the table
+  *
+  * Process Synopsis :
+  *                     [1]  Home bucket: found, or not in the table if the bucket has a free slot
+  *                     [2]  Alternate bucket (the home bucket is full)
+  *                     [3]  Stash (binary search), if not empty
+  *
+  * Notes :
+  *
+  */
+
+inline bool BucketTable::find(uint64_t sMer, uint64_t& entry)
+{
+    uint64_t b = homeBucket(sMer);
+    for (int probe = 0; probe < 2; ++probe)
+    {
+#if defined(__x86_64__)
+        uint64_t match = useAVX2 ? matchAVX2(buckets[b], sMer) : matchScalar(buckets[b], sMer);
+#else
+        uint64_t match = matchScalar(buckets[b], sMer);
+#endif
+        uint64_t found = match & ((1 << BUCKET_SLOTS) - 1);
+        if (found != 0)
+        {
+            entry = buckets[b].slots[__builtin_ctzll(found)].entry;
+            return true;
+        }
+        if ((match >> BUCKET_SLOTS) != 0)       // a free slot: sMer would be here
+            return false;
+        b = alternateBucket(sMer);
+    }
+    if (stash.empty())
+        return false;
+    BucketSlot wanted = {sMer, 0};
+    vector<BucketSlot>::iterator it = lower_bound(stash.begin(), stash.end(), wanted, slotLess);
+    if ((it == stash.end()) || (it->key != sMer))
+        return false;
+    entry = it->entry;
+    return true;
+}
+
+/**
+  * Name:               getCorrectSGap(uint64_t sMer, uint64_t sGap, uint64_t& correctSGap, uint64_t Tdiff)
+  *
+  * Description :       Same as HashTable::getCorrectSGap
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t  sMer                The sMer to be searched for
+  *           uint64_t  sGap                The sGap of the read
+  *           uint64_t  Tdiff               Threshold of differing bases between the sGap and the correct sGap
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           uint64_t& correctSGap         The correct sGap (when the return value is > 0)
+  *       Memory:
+  *           None
+  *       Return:
+  *           int64_t                       -3: sMer not in table (or ambiguous); -1: sGap too different;
+  *                                         0: sGap correct; > 0: score of correctSGap
+  *
+  * Process Synopsis :
+  *
+  * Notes :             The ambiguous sMers are left out, as in the StaticTable: the correction treats -2 and -3
+  *                     alike (a suspect position, nothing to correct), so the corrected reads are the same.
+  *
+  */
+
+int64_t BucketTable::getCorrectSGap(uint64_t sMer, uint64_t sGap, uint64_t& correctSGap, uint64_t Tdiff)
+{
+    uint64_t entry = 0;
+    if (!find(sMer, entry))
+        return -3;
+    uint64_t tableSGap = entry & (((uint64_t)1 << 56) - 1);
+    if (sGap == tableSGap)
+        return 0;
+    if (diff2Bit(sGap, tableSGap) < Tdiff)
+    {
+        correctSGap = tableSGap;
+        return (int64_t)(entry >> 56);
+    }
+    return -1;
+}
+
+bool BucketTable::getCorrectEntry(uint64_t sMer, uint64_t& sGap, uint64_t& score)
+{
+    uint64_t entry = 0;
+    if (!find(sMer, entry))
+        return false;
+    sGap = entry & (((uint64_t)1 << 56) - 1);
+    score = entry >> 56;
+    return true;
+}
@@ -0,0 +1,242 @@
+/**
+  * File:     checkpoint.cpp
+  *
+  * Author1:  Lucian Ilie (ilie@uwo.ca)
+  * Author2:  Stephen Lu (slu93@uwo.ca)
+  *
+  *   This file contains the checkpoints of QUESS. After each seed
+  *   the working file of the reads holds the reads corrected so far;
+  *   a small manifest next to it records how far the run got, so an
+  *   interrupted run (--resume) continues with the next seed instead
+  *   of starting over.
+  *
+  */
+
+#include "QUESS.h"
+#include <zlib.h>
+#include <sys/stat.h>
+
+
+/**
+  * Name:               fileChecksum(const char* fileName, uint64_t& fileSize, uint32_t& checksum)
+  *
+  * Description :       Computes the size and the CRC-32 of a file
+  *
+  * Input :
+  *       Parameters:
+  *           const char* fileName          file
+  *           uint64_t& fileSize            destination
+  *           uint32_t& checksum            destination
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           uint64_t& fileSize            size in bytes
+  *           uint32_t& checksum            CRC-32 (zlib) of the contents
+  *       Memory:
+  *           None
+  *       Return:
+  *           bool                          false if the file cannot be read
+  *
+  * Process Synopsis :
+  *
+  * Notes :             One sequential pass over the file in IO_BUFFER_SIZE blocks.
+  *
+  */
+
+bool fileChecksum(const char* fileName, uint64_t& fileSize, uint32_t& checksum)
+{
+    ifstream file(fileName, ios::in | ios::binary);
+    if (!file.is_open())
+        return false;
+    char* buffer = new char[IO_BUFFER_SIZE];
+    uLong crc = crc32(0L, Z_NULL, 0);
+    fileSize = 0;
+    while (file)
+    {
+        file.read(buffer, IO_BUFFER_SIZE);
+        uint64_t length = file.gcount();
+        crc = crc32(crc, (const Bytef*)buffer, length);
+        fileSize += length;
+    }
+    bool good = file.eof();
+    delete [] buffer;
+    checksum = (uint32_t)crc;
+    return good;
+}
+
+/**
+  * Name:               writeCheckpoint(const char* checkpointFileName, Checkpoint& checkpoint)
+  *
+  * Description :       Writes the manifest of the seeds done so far
+  *
+  * Input :
+  *       Parameters:
+  *           const char* checkpointFileName    manifest
+  *           Checkpoint& checkpoint            names, parameters and seeds done
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           Checkpoint& checkpoint            datasetSize, datasetTime, readsSize, readsChecksum filled in
+  *       Memory:
+  *           None
+  *       Return:
+  *           bool                          false if the manifest cannot be written (the run goes on without it)
+  *
+  * Process Synopsis :
+  *                     [1]  Size and time of the dataset, size and checksum of the working file of the reads
+  *                     [2]  Write <manifest>.tmp and rename it, so a manifest is always complete
+  *
+  * Notes :             Called after swapFiles: the working file holds the reads corrected by seeds 0 .. seedsDone - 1.
+  *
+  */
+
+bool writeCheckpoint(const char* checkpointFileName, Checkpoint& checkpoint)
+{
+    struct stat st;
+    if ((stat(checkpoint.datasetName, &st) != 0) || !fileChecksum(checkpoint.readsFileName, checkpoint.readsSize, checkpoint.readsChecksum))
+        return false;
+    checkpoint.datasetSize = st.st_size;
+    checkpoint.datasetTime = st.st_mtime;
+    string temporaryName = string(checkpointFileName) + ".tmp";
+    ofstream file(temporaryName.c_str(), ios::out | ios::trunc);
+    if (!file.is_open())
+        return false;
+    file << "QUESS-checkpoint " << CHECKPOINT_VERSION << "\n"
+         << "dataset " << checkpoint.datasetName << "\n"
+         << "datasetSize " << checkpoint.datasetSize << "\n"
+         << "datasetTime " << checkpoint.datasetTime << "\n"
+         << "genomeLength " << checkpoint.genomeLength << "\n"
+         << "weight " << checkpoint.weight << "\n"
+         << "numberOfSeeds " << checkpoint.numberOfSeeds << "\n"
+         << "seedsDone " << checkpoint.seedsDone << "\n"
+         << "Tc " << checkpoint.Tc << "\n"
+         << "Te " << checkpoint.Te << "\n"
+         << "Tdiff " << checkpoint.Tdiff << "\n"
+         << "numberOfReads " << checkpoint.numberOfReads << "\n"
+         << "totalReadLength " << checkpoint.totalReadLength << "\n"
+         << "reads " << checkpoint.readsFileName << "\n"
+         << "readsSize " << checkpoint.readsSize << "\n"
+         << "readsChecksum " << checkpoint.readsChecksum << "\n";
+    file.close();
+    if (!file || (rename(temporaryName.c_str(), checkpointFileName) != 0))
+    {
+        remove(temporaryName.c_str());
+        return false;
+    }
+    return true;
+}
+
+/**
+  * Name:               readCheckpoint(const char* checkpointFileName, Checkpoint& checkpoint)
+  *
+  * Description :       Reads a manifest written by writeCheckpoint
+  *
+  * Input :
+  *       Parameters:
+  *           const char* checkpointFileName    manifest
+  *           Checkpoint& checkpoint            destination
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           Checkpoint& checkpoint            contents of the manifest
+  *       Memory:
+  *           None
+  *       Return:
+  *           bool                          false if the manifest is missing, of another version or incomplete
+  *
+  * Process Synopsis :
+  *
+  * Notes :             The names are the rest of their line (they may contain blanks).
+  *
+  */
+
+bool readCheckpoint(const char* checkpointFileName, Checkpoint& checkpoint)
+{
+    ifstream file(checkpointFileName);
+    string key, line;
+    int version = 0;
+    if (!(file >> key >> version) || (key != "QUESS-checkpoint") || (version != CHECKPOINT_VERSION))
+        return false;
+    memset(&checkpoint, 0, sizeof(Checkpoint));
+    int keysRead = 0;
+    while (file >> key)
+    {
+        file.get();             // the blank after the key
+        getline(file, line);
+        const char* value = line.c_str();
+        if ((key == "dataset") || (key == "reads"))
+        {
+            if (line.size() >= CHECKPOINT_NAME_LENGTH)
+                return false;
+            strcpy((key == "dataset") ? checkpoint.datasetName : checkpoint.readsFileName, value);
+        }
+        else if (key == "datasetSize")
+            checkpoint.datasetSize = strtoull(value, NULL, 10);
+        else if (key == "datasetTime")
+            checkpoint.datasetTime = strtoll(value, NULL, 10);
+        else if (key == "genomeLength")
+            checkpoint.genomeLength = strtoull(value, NULL, 10);
+        else if (key == "weight")
+            checkpoint.weight = atoi(value);
+        else if (key == "numberOfSeeds")
+            checkpoint.numberOfSeeds = atoi(value);
+        else if (key == "seedsDone")
+            checkpoint.seedsDone = atoi(value);
+        else if (key == "Tc")
+            checkpoint.Tc = atoi(value);
+        else if (key == "Te")
+            checkpoint.Te = atoi(value);
+        else if (key == "Tdiff")
+            checkpoint.Tdiff = atoi(value);
+        else if (key == "numberOfReads")
+            checkpoint.numberOfReads = strtoll(value, NULL, 10);
+        else if (key == "totalReadLength")
+            checkpoint.totalReadLength = strtoll(value, NULL, 10);
+        else if (key == "readsSize")
+            checkpoint.readsSize = strtoull(value, NULL, 10);
+        else if (key == "readsChecksum")
+            checkpoint.readsChecksum = (uint32_t)strtoul(value, NULL, 10);
+        else
+            continue;
+        ++keysRead;
+    }
+    return (keysRead == 15);
+}
+
+/**
+  * Name:               verifyCheckpoint(Checkpoint& checkpoint)
+  *
+  * Description :       Checks that the dataset and the working file of the reads are those of the manifest
+  *
+  * Input :
+  *       Parameters:
+  *           Checkpoint& checkpoint        manifest read by readCheckpoint
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           const char*                   NULL if the run can be resumed; otherwise the reason
+  *
+  * Process Synopsis :
+  *                     [1]  Size and modification time of the dataset
+  *                     [2]  Size and CRC-32 of the working file of the reads (a run killed inside swapFiles, or
+  *                          before the manifest of the seed was written, leaves a file that does not match)
+  *
+  * Notes :             The options (genome length, weight, seeds) are compared by the caller.
+  *
+  */
+
+const char* verifyCheckpoint(Checkpoint& checkpoint)
+{
+    struct stat st;
+    if ((stat(checkpoint.datasetName, &st) != 0) || ((uint64_t)st.st_size != checkpoint.datasetSize) || ((int64_t)st.st_mtime != checkpoint.datasetTime))
+        return "the dataset has changed";
+    uint64_t readsSize = 0;
+    uint32_t readsChecksum = 0;
+    if (!fileChecksum(checkpoint.readsFileName, readsSize, readsChecksum) || (readsSize != checkpoint.readsSize) || (readsChecksum != checkpoint.readsChecksum))
+        return "the working file of the reads is missing or has changed";
+    return NULL;
+}
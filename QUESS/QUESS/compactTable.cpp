@@ -0,0 +1,275 @@
+/**
+  * File:     compactTable.cpp
+  *
+  * Author1:  Lucian Ilie (ilie@uwo.ca)
+  * Author2:  Stephen Lu (slu93@uwo.ca)
+  *
+  *   This file contains the compact counting table of QUESS. While
+  *   the sMers of a seed are counted (insertSMers) the table holds
+  *   every distinct sMer of the reads, most of them erroneous with
+  *   count 1; it is the largest structure of the model building.
+  *   An Element stores the whole sMer, although the position of the
+  *   sMer in the table already tells log2(size) bits of its hash.
+  *   The compact table stores only the remainder of an invertible
+  *   hash of the sMer, the distance from its home slot (the quotient)
+  *   and the count: 42 bits, three slots in 16 bytes instead of 24.
+  *   The sMers are recovered exactly for rehashFrequentSMers.
+  *
+  */
+
+#include "QUESS.h"
+
+#define COMPACT_HASH_MULTIPLIER 0x9E3779B97F4A7C15ULL    // odd: invertible modulo 2^keyBits
+#define COMPACT_KEY_BITS (COMPACT_SLOT_BITS - 8)        // displacement and remainder of a slot; the count above them
+
+static const uint128_t SLOT_MASK = ((uint128_t)1 << COMPACT_SLOT_BITS) - 1;
+
+// number of bits of x (0 for 0)
+static inline uint64_t bitLength(uint64_t x)
+{
+    return (x == 0) ? 0 : 64 - __builtin_clzll(x);
+}
+
+/**
+  * Name:               fits(uint64_t keyMask, uint64_t size)
+  *
+  * Description :       Tells whether the sMers of keyMask can be counted in a CompactTable of size slots
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t  keyMask             bits of the sMers (Seed::getKeyMask)
+  *           uint64_t  size                number of slots
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           bool                          true if the remainders have at most COMPACT_MAX_REMAINDER_BITS bits
+  *
+  * Process Synopsis :
+  *                     [1]  The hash of an sMer has as many bits as the sMer; remainder = hash / size
+  *
+  * Notes :             The larger the table, the shorter the remainders: 22 bits for weight 22 and a table of
+  *                     5 million slots, 21 bits for weight 27 and a table of 8 billion slots. Smaller tables of
+  *                     heavier seeds are counted in Elements.
+  *
+  */
+
+bool CompactTable::fits(uint64_t keyMask, uint64_t size)
+{
+    uint64_t keyBits = __builtin_popcountll(keyMask);
+    if ((keyMask == 0) || (size == 0) || (keyBits > 62))
+        return false;
+    return bitLength((((uint64_t)1 << keyBits) - 1) / size) <= COMPACT_MAX_REMAINDER_BITS;
+}
+
+/**
+  * Name:               CompactTable(uint64_t keyMask, uint64_t size)
+  *
+  * Description :       Creates an empty counting table of size slots for the sMers of keyMask
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t  keyMask             bits of the sMers (Seed::getKeyMask); fits(keyMask, size) must hold
+  *           uint64_t  size                number of slots (the size of the HashTable)
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           uint128_t* groups             (size + 2) / 3 groups of three slots, all 0 (empty)
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  Runs of keyMask, to gather the sMer bits into a dense key of keyBits bits
+  *                     [2]  Bits of the remainders; the other bits of the key of a slot hold the displacement
+  *                     [3]  Inverse of the hash multiplier modulo 2^64 (Newton iteration), used modulo 2^keyBits
+  *
+  * Notes :
+  *
+  */
+
+CompactTable::CompactTable(uint64_t keyMask, uint64_t size)
+{
+    this->size = size;
+    numberOfElements = 0;
+    getMaskRuns(keyMask, keyRuns);
+    keyBits = __builtin_popcountll(keyMask);
+    bitsMask = ((uint64_t)1 << keyBits) - 1;
+    remainderBits = bitLength(bitsMask / size);
+    maxDisplacement = ((uint64_t)1 << (COMPACT_KEY_BITS - remainderBits)) - 1;
+    inverse = COMPACT_HASH_MULTIPLIER;          // x * inverse = 1 (mod 2^k) doubles k at each step
+    for (int i = 0; i < 5; ++i)
+        inverse *= 2 - COMPACT_HASH_MULTIPLIER * inverse;
+    numberOfGroups = (size + 2) / 3;
+    groups = new uint128_t[numberOfGroups];
+    memset(groups, 0, numberOfGroups * sizeof(uint128_t));
+}
+
+CompactTable::~CompactTable()
+{
+    delete [] groups;
+}
+
+uint64_t CompactTable::memoryUsage()
+{
+    return numberOfGroups * sizeof(uint128_t);
+}
+
+/**
+  * Name:               hash(uint64_t sMer), unhash(uint64_t h)
+  *
+  * Description :       Invertible hash of an sMer to keyBits bits, and its inverse
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t  sMer                the sMer (bits of keyMask)
+  *           uint64_t  h                   a hash
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           uint64_t                      hash (< 2^keyBits), resp. the sMer of the hash
+  *
+  * Process Synopsis :
+  *                     [1]  Gather the sMer bits (a bijection onto keyBits bits)
+  *                     [2]  Multiply by an odd constant modulo 2^keyBits, xor-shift by half the bits (self-inverse),
+  *                          multiply again; every step is a bijection
+  *
+  * Notes :             The multiplications alone would leave the low bits depending only on the low bits of the
+  *                     sMer; the xor-shift brings the high bits down.
+  *
+  */
+
+inline uint64_t CompactTable::hash(uint64_t sMer)
+{
+    uint64_t h = (gatherBits(sMer, keyRuns) * COMPACT_HASH_MULTIPLIER) & bitsMask;
+    h ^= h >> ((keyBits + 1) / 2);
+    return (h * COMPACT_HASH_MULTIPLIER) & bitsMask;
+}
+
+inline uint64_t CompactTable::unhash(uint64_t h)
+{
+    h = (h * inverse) & bitsMask;
+    h ^= h >> ((keyBits + 1) / 2);
+    return (uint64_t)scatterBits((h * inverse) & bitsMask, keyRuns);
+}
+
+/**
+  * Name:               insert(uint64_t sMer)
+  *
+  * Description :       Counts one occurrence of sMer
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t  sMer                the sMer
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           uint128_t* groups             the count of sMer is incremented (up to 255), or sMer is added with count 1
+  *       Return:
+  *           bool                          false if the table is full (85% of the slots, or an sMer too far from its home
+  *                                         slot); then the table must be recreated with double size, as for HashTable
+  *
+  * Process Synopsis :
+  *                     [1]  h = hash(sMer); home = h % size (the quotient is the home slot), remainder = h / size
+  *                     [2]  Linear probing from home: the slot at distance d holds the sMer if its displacement is d
+  *                          and its remainder is the remainder
+  *                     [3]  The first empty slot is taken with a compare-and-swap of its group; a count is
+  *                          incremented the same way
+  *
+  * Notes :             Lock free, unlike the Element table (where only the master thread adds sMers): threads
+  *                     counting the same sMer meet on the same slot, and slots are never removed or moved.
+  *                     A group is read with two 8-byte reads, which a concurrent update may tear: a torn slot
+  *                     fails the compare-and-swap, and the middle slot of a group, which spans both halves, is
+  *                     read again at once (with a compare-and-swap) before it is passed.
+  *
+  */
+
+bool CompactTable::insert(uint64_t sMer)
+{
+    uint64_t h = hash(sMer);
+    uint64_t remainder = h / size;
+    uint64_t place = h % size;
+    for (uint64_t d = 0; d <= maxDisplacement; ++d)
+    {
+        uint128_t* group = &groups[place / 3];
+        uint64_t shift = (place % 3) * COMPACT_SLOT_BITS;
+        uint64_t mine = (d << remainderBits) | remainder;
+        uint128_t current = *group;         // two 8-byte reads: checked by the compare-and-swap
+        bool confirmed = (shift != COMPACT_SLOT_BITS);      // the middle slot spans both halves of the group
+        while (true)
+        {
+            uint64_t slot = (uint64_t)((current >> shift) & SLOT_MASK);
+            uint128_t updated;
+            if (slot == 0)                                                  // empty: take it
+                updated = current | ((uint128_t)(((uint64_t)1 << COMPACT_KEY_BITS) | mine) << shift);
+            else if ((slot & (((uint64_t)1 << COMPACT_KEY_BITS) - 1)) == mine) // sMer found: count it
+            {
+                if ((slot >> COMPACT_KEY_BITS) == 255)
+                    return true;
+                updated = current + ((uint128_t)1 << (shift + COMPACT_KEY_BITS));
+            }
+            else if (!confirmed)                                            // may be torn: read the group at once
+            {
+                current = __sync_val_compare_and_swap(group, (uint128_t)0, (uint128_t)0);
+                confirmed = true;
+                continue;
+            }
+            else
+                break;                                                      // another sMer; next slot
+            uint128_t found = __sync_val_compare_and_swap(group, current, updated);
+            if (found == current)
+                return (slot != 0) || (__sync_add_and_fetch(&numberOfElements, 1) <= 0.85 * size);
+            current = found;                                                // group changed meanwhile; look again
+        }
+        if (++place == size)
+            place = 0;
+    }
+    return false;               // displacement would not fit: too full
+}
+
+/**
+  * Name:               getEntry(uint64_t place, uint64_t& sMer, uint64_t& count)
+  *
+  * Description :       The sMer and count of a slot
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t  place               0 .. size - 1
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           uint64_t& sMer                the sMer of the slot (if not empty)
+  *           uint64_t& count               its count; 0 for an empty slot
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  home = place - displacement; h = remainder * size + home; sMer = unhash(h)
+  *
+  * Notes :             Not to be called while sMers are inserted.
+  *
+  */
+
+void CompactTable::getEntry(uint64_t place, uint64_t& sMer, uint64_t& count)
+{
+    uint64_t slot = (uint64_t)((groups[place / 3] >> ((place % 3) * COMPACT_SLOT_BITS)) & SLOT_MASK);
+    count = slot >> COMPACT_KEY_BITS;
+    if (count == 0)
+        return;
+    uint64_t displacement = (slot & (((uint64_t)1 << COMPACT_KEY_BITS) - 1)) >> remainderBits;
+    uint64_t remainder = slot & (((uint64_t)1 << remainderBits) - 1);
+    uint64_t home = (place >= displacement) ? place - displacement : place + size - displacement;
+    sMer = unhash(remainder * size + home);
+}
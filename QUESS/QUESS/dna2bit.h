@@ -0,0 +1,135 @@
+//
+//  dna2bit.h
+//
+//  Branch-free primitives on DNA in 2-bit code: A = 00, C = 01, G = 10, T = 11
+//  (complementary bases are bitwise complements). A 64-bit word holds 32 bases,
+//  the first one in the highest 2 bits, as in the windows of read.cpp; the
+//  windows of long seeds are 128-bit words (64 bases).
+//  Header only: the functions are inlined in the hot loops of read.cpp,
+//  hashTable.cpp, staticTable.cpp, lookupCache.cpp and normalize.cpp.
+//
+
+#ifndef ____DNA2BIT__
+#define ____DNA2BIT__
+
+#include <stdint.h>
+
+#define DNA2BIT_LOW_BITS 0x5555555555555555ULL      // low bit of every 2-bit block
+
+typedef unsigned __int128 uint128_t;
+
+static inline uint64_t revCompl2Bit(uint64_t x)
+    // reverse complement of the 32 bases of x: complement (negation), reverse the bytes (bswap),
+    // then the 4-bit and the 2-bit blocks inside each byte
+{
+    x = ~x;
+    x = __builtin_bswap64(x);
+    x = ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((x & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    x = ((x >> 2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2);
+    return x;
+}
+
+static inline uint128_t revCompl2Bit(uint128_t x)
+    // reverse complement of the 64 bases of x: the two halves reverse complemented and swapped
+{
+    return ((uint128_t)revCompl2Bit((uint64_t)x) << 64) | revCompl2Bit((uint64_t)(x >> 64));
+}
+
+static inline uint8_t revComplByte2Bit(uint8_t x)
+    // reverse complement of the 4 bases of a byte
+{
+    x = (uint8_t)~x;
+    x = (uint8_t)((x >> 4) | (x << 4));
+    x = (uint8_t)(((x >> 2) & 0x33) | ((x & 0x33) << 2));
+    return x;
+}
+
+static inline uint64_t diff2Bit(uint64_t x, uint64_t y)
+    // number of 2-bit blocks (bases) in which x and y differ: fold each block of x XOR y to its low bit, popcount
+{
+    uint64_t z = x ^ y;
+    return (uint64_t)__builtin_popcountll((z | (z >> 1)) & DNA2BIT_LOW_BITS);
+}
+
+static inline bool isBase2Bit(char c)
+    // true for A, C, G, T (upper or lower case)
+{
+    char lower = c | 0x20;
+    return (lower == 'a') | (lower == 'c') | (lower == 'g') | (lower == 't');
+}
+
+static inline uint64_t encodeBase2Bit(char c)
+    // 2-bit code of A, C, G, T (upper or lower case); bits 2-1 of the ASCII code are
+    // A 00, C 01, G 11, T 10, so the low bit is XORed with the high one
+{
+    uint64_t code = ((uint64_t)c >> 1) & 3;
+    return code ^ (code >> 1);
+}
+
+static inline char decodeBase2Bit(uint64_t code)
+    // base of a 2-bit code
+{
+    return "ACGT"[code & 3];
+}
+
+struct MaskRuns  // runs of consecutive 1 bits of a mask of at most 128 bits (gatherBits, scatterBits)
+{
+    uint64_t numberOfRuns;
+    uint8_t shift[64], bits[64];    // run r: bits[r] bits starting at bit shift[r]; lowest run first
+};
+
+static inline void getMaskRuns(uint128_t mask, MaskRuns& runs)
+    // runs of mask (2-bit blocks of bases: at most 64 runs; gatherBits needs runs shorter than 64 bits)
+{
+    runs.numberOfRuns = 0;
+    for (uint64_t bit = 0; bit < 128; )
+        if ((mask >> bit) & 1)
+        {
+            uint64_t first = bit;
+            while ((bit < 128) && ((mask >> bit) & 1))
+                ++bit;
+            runs.shift[runs.numberOfRuns] = (uint8_t)first;
+            runs.bits[runs.numberOfRuns++] = (uint8_t)(bit - first);
+        }
+        else
+            ++bit;
+}
+
+static inline uint64_t gatherBits(uint128_t x, const MaskRuns& runs)
+    // bits of x under the mask of runs, packed to the right in the same order (as pext); at most 64 bits
+{
+    uint64_t y = 0, length = 0;
+    for (uint64_t r = 0; r < runs.numberOfRuns; ++r)
+    {
+        y |= ((uint64_t)(x >> runs.shift[r]) & (((uint64_t)1 << runs.bits[r]) - 1)) << length;
+        length += runs.bits[r];
+    }
+    return y;
+}
+
+static inline uint64_t gatherBits(uint64_t x, const MaskRuns& runs)
+    // same for a 64-bit x (runs of a mask of at most 64 bits)
+{
+    uint64_t y = 0, length = 0;
+    for (uint64_t r = 0; r < runs.numberOfRuns; ++r)
+    {
+        y |= ((x >> runs.shift[r]) & (((uint64_t)1 << runs.bits[r]) - 1)) << length;
+        length += runs.bits[r];
+    }
+    return y;
+}
+
+static inline uint128_t scatterBits(uint64_t y, const MaskRuns& runs)
+    // inverse of gatherBits: the low bits of y placed under the mask of runs (as pdep)
+{
+    uint128_t x = 0;
+    uint64_t length = 0;
+    for (uint64_t r = 0; r < runs.numberOfRuns; ++r)
+    {
+        x |= (uint128_t)((y >> length) & (((uint64_t)1 << runs.bits[r]) - 1)) << runs.shift[r];
+        length += runs.bits[r];
+    }
+    return x;
+}
+
+#endif
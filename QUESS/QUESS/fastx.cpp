@@ -0,0 +1,465 @@
+/**
+  * File:     fastx.cpp
+  *
+  * Author1:  Lucian Ilie (ilie@uwo.ca)
+  * Author2:  Stephen Lu (slu93@uwo.ca)
+  *
+  *   This file contains code concerning the parsing of the
+  *   original dataset (FASTQ or, possibly multi-line, FASTA).
+  *   The dataset is read in windows that are split into byte
+  *   ranges; the ranges are resynchronized on record boundaries
+  *   and parsed in parallel.
+  *
+  */
+
+#include "QUESS.h"
+
+
+/**
+  * Name:               nextLine(const char* data, uint64_t length, uint64_t pos)
+  *
+  * Description :       Returns the position following the first '\n' at or after pos
+  *
+  * Input :
+  *       Parameters:
+  *           const char* data              window of the dataset
+  *           uint64_t  length              length of the window
+  *           uint64_t  pos                 start position
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           uint64_t                      start of the next line; length if there is none
+  *
+  * Process Synopsis :
+  *
+  * Notes :
+  *
+  */
+
+static uint64_t nextLine(const char* data, uint64_t length, uint64_t pos)
+{
+    if (pos >= length)
+        return length;
+    const char* newLine = (const char*)memchr(data + pos, '\n', length - pos);
+    return (newLine == NULL) ? length : (uint64_t)(newLine - data) + 1;
+}
+
+/**
+  * Name:               findRecordStart(const char* data, uint64_t length, uint64_t pos, char fastx)
+  *
+  * Description :       Finds the first record that starts at or after pos
+  *
+  * Input :
+  *       Parameters:
+  *           const char* data              window of the dataset
+  *           uint64_t  length              length of the window
+  *           uint64_t  pos                 position where the search starts
+  *           char      fastx               '@' for FASTQ, '>' for FASTA
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           uint64_t                      start of the record; length if none can be found in the window
+  *
+  * Process Synopsis :
+  *                     [1]  Move to the beginning of a line
+  *                     [2]  FASTA: the first line starting with '>'
+  *                     [3]  FASTQ: the first line starting with '@' such that the line two below starts with '+'
+  *
+  * Notes :             Quality lines may start with '@'; for such a line the line two below is the next
+  *                     sequence, which never starts with '+', so it is not mistaken for a header.
+  *
+  */
+
+uint64_t findRecordStart(const char* data, uint64_t length, uint64_t pos, char fastx)
+{
+    if ((pos > 0) && (pos < length) && (data[pos - 1] != '\n'))
+        pos = nextLine(data, length, pos);
+    while (pos < length)
+    {
+        if (data[pos] == fastx)
+        {
+            if (fastx == '>')
+                return pos;
+            uint64_t thirdLine = nextLine(data, length, nextLine(data, length, pos));
+            if (thirdLine >= length)      // cannot decide inside this window
+                return length;
+            if (data[thirdLine] == '+')
+                return pos;
+        }
+        pos = nextLine(data, length, pos);
+    }
+    return length;
+}
+
+/**
+  * Name:               getLineEnd(const char* data, uint64_t length, uint64_t pos, bool lastWindow, uint64_t& lineEnd, uint64_t& next)
+  *
+  * Description :       Delimits the line starting at pos
+  *
+  * Input :
+  *       Parameters:
+  *           const char* data              window of the dataset
+  *           uint64_t  length              length of the window
+  *           uint64_t  pos                 start of the line
+  *           bool      lastWindow          true if the window ends the dataset (last line may lack '\n')
+  *           uint64_t& lineEnd             end of the line ('\n' and '\r' excluded)
+  *           uint64_t& next                start of the following line
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           uint64_t& lineEnd, next       set if the line is complete
+  *       Memory:
+  *           None
+  *       Return:
+  *           bool                          false if the line is not complete in this window
+  *
+  * Process Synopsis :
+  *
+  * Notes :
+  *
+  */
+
+static bool getLineEnd(const char* data, uint64_t length, uint64_t pos, bool lastWindow, uint64_t& lineEnd, uint64_t& next)
+{
+    if (pos >= length)
+        return false;
+    const char* newLine = (const char*)memchr(data + pos, '\n', length - pos);
+    if (newLine == NULL)
+    {
+        if (!lastWindow)
+            return false;
+        lineEnd = next = length;
+    }
+    else
+    {
+        lineEnd = newLine - data;
+        next = lineEnd + 1;
+    }
+    if ((lineEnd > pos) && (data[lineEnd - 1] == '\r'))
+        --lineEnd;
+    return true;
+}
+
+/**
+  * Name:               copyRecordLine(const char* data, uint64_t pos, uint64_t next, uint64_t kept, bool readLine, char* out, uint64_t& outLength)
+  *
+  * Description :       Writes a line of a record to the record file of a dataset read from a pipe
+  *
+  * Input :
+  *       Parameters:
+  *           const char* data              window of the dataset
+  *           uint64_t  pos                 start of the line
+  *           uint64_t  next                start of the next line (getLineEnd)
+  *           uint64_t  kept                number of bases of a read line kept in the reads
+  *           bool      readLine            the line holds (part of) the read
+  *           char*     out                 record file buffer
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           uint64_t& outLength           increased by the bytes written
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  A header or score line is copied
+  *                     [2]  A read line is written as the number of its bases in the reads (none if 0) followed, if
+  *                          the line has more bytes (tail of a truncated read, '\r'), by ':' and those bytes
+  *
+  * Notes :             A line takes at most twice its bytes (with its '\n').
+  *
+  */
+
+static void copyRecordLine(const char* data, uint64_t pos, uint64_t next, uint64_t kept, bool readLine, char* out, uint64_t& outLength)
+{
+    uint64_t end = ((next > pos) && (data[next - 1] == '\n')) ? next - 1 : next;
+    if (readLine)
+    {
+        if (kept > 0)
+            outLength += sprintf(out + outLength, "%llu", (unsigned long long)kept);
+        pos += kept;
+        if (pos < end)
+            out[outLength++] = ':';
+    }
+    memcpy(out + outLength, data + pos, end - pos);
+    outLength += end - pos;
+    out[outLength++] = '\n';
+}
+
+/**
+  * Name:               parseRecords(const char* data, uint64_t begin, uint64_t end, uint64_t length, bool lastWindow, char fastx, char* out, uint64_t& outLength, char* qualityOut, uint64_t& qualityOutLength, char* recordOut, uint64_t& recordOutLength, FastxCounts& counts)
+  *
+  * Description :       Copies the reads of all records starting in [begin, end) to 'out', one per line
+  *
+  * Input :
+  *       Parameters:
+  *           const char* data              window of the dataset
+  *           uint64_t  begin               start of the first record of the range
+  *           uint64_t  end                 records starting at or after end belong to the next range
+  *           uint64_t  length              length of the window
+  *           bool      lastWindow          true if the window ends the dataset
+  *           char      fastx               '@' for FASTQ, '>' for FASTA
+  *           char*     out                 output buffer; end - begin + 1 bytes suffice
+  *           char*     qualityOut          output buffer of the binned scores (FASTQ); NULL = scores not kept
+  *           char*     recordOut           output buffer of the other lines (copyRecordLine); 2 * (end - begin + 1)
+  *                                         bytes suffice; NULL = not kept
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           uint64_t& outLength           number of bytes written in out
+  *           uint64_t& qualityOutLength    number of bytes written in qualityOut
+  *           uint64_t& recordOutLength     number of bytes written in recordOut
+  *           FastxCounts& counts           number of reads, total read length, truncated reads, format errors
+  *       Memory:
+  *           None
+  *       Return:
+  *           uint64_t                      end if all records are complete; otherwise the start of the first
+  *                                         record that continues past the window (to be carried over)
+  *
+  * Process Synopsis :
+  *                     [1]  FASTQ: header, read, '+' line, scores; only the read is kept (and its binned scores, packQualities)
+  *                     [2]  FASTA: header followed by any number of read lines, concatenated
+  *                     [3]  Reads longer than MAX_READ_LENGTH - 1 are truncated (createOutputFile restores the tail)
+  *                     [4]  With recordOut, the records without their bases are kept for createOutputFile (dataset
+  *                          read from a pipe)
+  *
+  * Notes :
+  *
+  */
+
+uint64_t parseRecords(const char* data, uint64_t begin, uint64_t end, uint64_t length, bool lastWindow, char fastx, char* out, uint64_t& outLength, char* qualityOut, uint64_t& qualityOutLength, char* recordOut, uint64_t& recordOutLength, FastxCounts& counts)
+{
+    uint64_t pos = begin, lineEnd = 0, next = 0;
+    outLength = qualityOutLength = recordOutLength = 0;
+    while (pos < end)
+    {
+        uint64_t recordStart = pos;
+        if (data[pos] == '\n' || data[pos] == '\r')     // empty line between records
+        {
+            pos = nextLine(data, length, pos);
+            continue;
+        }
+        if (data[pos] != fastx)
+        {
+            ++counts.badRecords;
+            pos = findRecordStart(data, end, pos + 1, fastx);
+            continue;
+        }
+        if (!getLineEnd(data, length, pos, lastWindow, lineEnd, next))     // header
+            return recordStart;
+        uint64_t recordLength = recordOutLength;     // committed once the record is complete
+        if (recordOut != NULL)
+            copyRecordLine(data, pos, next, 0, false, recordOut, recordLength);
+        pos = next;
+        uint64_t readLength = 0;
+        bool truncated = false;     // counted once the record is complete
+        if (fastx == '@')     // FASTQ
+        {
+            uint64_t readStart = pos;
+            if (!getLineEnd(data, length, pos, lastWindow, lineEnd, next))     // read
+            {
+                if (lastWindow)
+                    ++counts.badRecords;
+                return lastWindow ? end : recordStart;
+            }
+            readLength = lineEnd - readStart;
+            if (readLength > MAX_READ_LENGTH - 1)
+            {
+                readLength = MAX_READ_LENGTH - 1;
+                truncated = true;
+            }
+            memcpy(out + outLength, data + readStart, readLength);
+            if (recordOut != NULL)
+                copyRecordLine(data, readStart, next, readLength, true, recordOut, recordLength);
+            pos = next;
+            for (int i = 0; i < 2; ++i)     // score header and scores
+            {
+                if (!getLineEnd(data, length, pos, lastWindow, lineEnd, next))
+                {
+                    if (lastWindow)
+                        ++counts.badRecords;
+                    return lastWindow ? end : recordStart;
+                }
+                if ((i == 0) && (data[pos] != '+'))
+                    ++counts.badRecords;
+                if (recordOut != NULL)
+                    copyRecordLine(data, pos, next, 0, false, recordOut, recordLength);
+                if ((i == 1) && (qualityOut != NULL))
+                {
+                    packQualities(data + pos, lineEnd - pos, readLength, (uint8_t*)qualityOut + qualityOutLength);
+                    qualityOutLength += (readLength + 3) / 4;
+                }
+                pos = next;
+            }
+        }
+        else                  // FASTA; read lines up to the next header
+        {
+            while ((pos < length) && (data[pos] != '>'))
+            {
+                if (!getLineEnd(data, length, pos, lastWindow, lineEnd, next))
+                    return recordStart;
+                uint64_t copy = min(lineEnd - pos, (uint64_t)(MAX_READ_LENGTH - 1) - readLength);
+                if (copy < lineEnd - pos)
+                    truncated = true;
+                memcpy(out + outLength + readLength, data + pos, copy);
+                if (recordOut != NULL)
+                    copyRecordLine(data, pos, next, copy, true, recordOut, recordLength);
+                readLength += copy;
+                pos = next;
+            }
+            if ((pos >= length) && !lastWindow)     // the next header is not in this window
+                return recordStart;
+        }
+        outLength += readLength;
+        out[outLength++] = '\n';
+        recordOutLength = recordLength;
+        if (truncated)
+            ++counts.truncatedReads;
+        ++counts.numberOfReads;
+        counts.totalReadLength += readLength;
+    }
+    return end;
+}
+
+/**
+  * Name:               parseWindow(const char* window, uint64_t windowLength, bool lastWindow, char fastx, int64_t numberOfChunks, ParsedChunks& chunks, int64_t& chunksDone)
+  *
+  * Description :       Parses the complete records of a window of the dataset in numberOfChunks byte ranges, in parallel
+  *
+  * Input :
+  *       Parameters:
+  *           const char* window            window of the dataset
+  *           uint64_t  windowLength        length of the window
+  *           bool      lastWindow          true if the window ends the dataset
+  *           char      fastx               '@' for FASTQ, '>' for FASTA
+  *           int64_t   numberOfChunks      number of byte ranges
+  *           ParsedChunks& chunks          buffers of the ranges; qualities/records NULL = not kept
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           ParsedChunks& chunks          start, output lengths and counts of each range (parseRecords)
+  *           int64_t&  chunksDone          the output of ranges 0 .. chunksDone - 1 is to be written, in order
+  *       Memory:
+  *           None
+  *       Return:
+  *           uint64_t                      bytes consumed; the rest of the window is carried over to the next one
+  *
+  * Process Synopsis :
+  *                     [1]  The ranges start at records (findRecordStart) near k * windowLength / numberOfChunks
+  *                     [2]  Each range is parsed by parseRecords; range k writes at reads + start[k] + k,
+  *                          qualities + start[k] + k and records + 2 * (start[k] + k)
+  *                     [3]  The ranges are complete up to the first record that continues in the next window
+  *
+  * Notes :             Used by createWorkingFiles (and tests/testFastx with small windows).
+  *
+  */
+
+uint64_t parseWindow(const char* window, uint64_t windowLength, bool lastWindow, char fastx, int64_t numberOfChunks, ParsedChunks& chunks, int64_t& chunksDone)
+{
+    chunks.start[0] = 0;
+    chunks.start[numberOfChunks] = windowLength;
+#pragma omp parallel for schedule(dynamic)
+    for (int64_t k = 1; k < numberOfChunks; ++k)
+        chunks.start[k] = findRecordStart(window, windowLength, k * (windowLength / numberOfChunks), fastx);
+    for (int64_t k = 1; k < numberOfChunks; ++k)
+        chunks.start[k] = max(chunks.start[k], chunks.start[k - 1]);
+#pragma omp parallel for schedule(dynamic)
+    for (int64_t k = 0; k < numberOfChunks; ++k)
+    {
+        chunks.counts[k].numberOfReads = chunks.counts[k].totalReadLength = chunks.counts[k].truncatedReads = chunks.counts[k].badRecords = 0;
+        chunks.stop[k] = parseRecords(window, chunks.start[k], chunks.start[k + 1], windowLength, lastWindow, fastx, chunks.reads + chunks.start[k] + k, chunks.readsLength[k],
+                                      (chunks.qualities != NULL) ? chunks.qualities + chunks.start[k] + k : NULL, chunks.qualitiesLength[k],
+                                      (chunks.records != NULL) ? chunks.records + 2 * (chunks.start[k] + k) : NULL, chunks.recordsLength[k], chunks.counts[k]);
+    } // ### end omp parallel for
+
+    // stop at the first record that continues in the next window
+    for (int64_t k = 0; k < numberOfChunks; ++k)
+        if (chunks.stop[k] < chunks.start[k + 1])
+        {
+            chunksDone = k + 1;
+            return chunks.stop[k];
+        }
+    chunksDone = numberOfChunks;
+    return windowLength;
+}
+
+/**
+  * Name:               packQualities(const char* scores, uint64_t numberOfScores, uint64_t length, uint8_t* out)
+  *
+  * Description :       Bins the quality scores of a read to 2 bits each
+  *
+  * Input :
+  *       Parameters:
+  *           const char* scores            FASTQ score line (Phred + QUALITY_OFFSET)
+  *           uint64_t  numberOfScores      length of the score line
+  *           uint64_t  length              length of the read (as kept, at most MAX_READ_LENGTH - 1)
+  *           uint8_t*  out                 destination; (length + 3) / 4 bytes
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           uint8_t*  out                 4 bins per byte, the first position in the highest 2 bits
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :             bin = min(3, (score - QUALITY_OFFSET) / QUALITY_BIN_WIDTH); positions without a score
+  *                     (short score line) are put in bin 0, so they are always looked up.
+  *
+  */
+
+void packQualities(const char* scores, uint64_t numberOfScores, uint64_t length, uint8_t* out)
+{
+    memset(out, 0, (length + 3) / 4);
+    for (uint64_t p = 0; p < min(length, numberOfScores); ++p)
+    {
+        int64_t bin = ((int64_t)(uint8_t)scores[p] - QUALITY_OFFSET) / QUALITY_BIN_WIDTH;
+        bin = max((int64_t)0, min((int64_t)3, bin));
+        out[p / 4] |= (uint8_t)(bin << (6 - 2 * (p % 4)));
+    }
+}
+
+/**
+  * Name:               getLowQualityPositions(const uint8_t* qualities, uint64_t length, int minBin, uint64_t* positions)
+  *
+  * Description :       Finds the positions of a read whose quality score is below a bin
+  *
+  * Input :
+  *       Parameters:
+  *           const uint8_t* qualities      binned scores of the read (packQualities)
+  *           uint64_t  length              length of the read
+  *           int       minBin              lowest bin of the scores that are trusted
+  *           uint64_t* positions           destination; QUALITY_WORDS words
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           uint64_t* positions           bit p % 64 of word p / 64 set: position p is in a bin below minBin
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :             Used by correct (--quality-skip) for correctBinaryReadFast.
+  *
+  */
+
+void getLowQualityPositions(const uint8_t* qualities, uint64_t length, int minBin, uint64_t* positions)
+{
+    memset(positions, 0, QUALITY_WORDS * sizeof(uint64_t));
+    for (uint64_t p = 0; p < length; ++p)
+        if ((int)((qualities[p / 4] >> (6 - 2 * (p % 4))) & 3) < minBin)
+            positions[p / 64] |= (uint64_t)1 << (p % 64);
+}
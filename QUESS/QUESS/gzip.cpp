@@ -0,0 +1,1189 @@
+/**
+  * File:     gzip.cpp
+  *
+  * Author1:  Lucian Ilie (ilie@uwo.ca)
+  * Author2:  Stephen Lu (slu93@uwo.ca)
+  *
+  *   This file contains code concerning the reading of the
+  *   original dataset, which may be plain text, gzip or BGZF
+  *   (the blocked gzip written by bgzip). BGZF blocks are
+  *   independent and are inflated in parallel; a plain gzip
+  *   stream is inflated by a second thread, ahead of the reader.
+  *   The corrected dataset may be written compressed (BGZF,
+  *   gzip or zstd); its blocks are compressed in parallel and
+  *   written in order.
+  *
+  */
+
+#include "QUESS.h"
+#include <zlib.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#if USE_ZSTD
+#include <zstd.h>
+#endif
+
+struct GzipPipeline
+{
+    thread inflater;
+    mutex lock;
+    condition_variable changed;
+    char* buffers[NUMBER_OF_GZIP_BUFFERS];          // inflated data
+    uint64_t bufferLength[NUMBER_OF_GZIP_BUFFERS];
+    uint64_t produced, consumed;                    // buffers filled by the inflater / released by the reader
+    bool finished;                                  // the inflater is done (end of data or error)
+    bool stop;                                      // the reader is closed
+    const char* error;                              // NULL if no error
+};
+
+/**
+  * Name:               inflateGzip(BlockReader* file, GzipPipeline* pipeline, char* input, uint64_t inputSize, uint64_t inputLength)
+  *
+  * Description :       Inflates a (possibly multi-member) gzip stream into the buffers of the pipeline
+  *
+  * Input :
+  *       Parameters:
+  *           BlockReader* file             compressed file
+  *           GzipPipeline* pipeline        buffers shared with the reader
+  *           char*     input               input buffer; the first inputLength bytes are already read
+  *           uint64_t  inputSize           bytes of input
+  *           uint64_t  inputLength         bytes already in input
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           GzipPipeline* pipeline        buffers filled in order; finished/error set at the end
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  Wait for a free buffer
+  *                     [2]  Inflate until the buffer is full or the input ends
+  *                     [3]  At the end of a member, continue with the next one
+  *
+  * Notes :             Runs in its own thread; it is the only user of 'file' while the reader is open.
+  *
+  */
+
+static void inflateGzip(BlockReader* file, GzipPipeline* pipeline, char* input, uint64_t inputSize, uint64_t inputLength)
+{
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    inflateInit2(&stream, 15 + 16);         // gzip header and trailer
+    stream.next_in = (Bytef*)input;
+    stream.avail_in = inputLength;
+    bool endOfInput = false, endOfMember = false;
+    const char* error = NULL;
+    while (!endOfInput && (error == NULL))
+    {
+        uint64_t b;
+        {
+            unique_lock<mutex> guard(pipeline->lock);
+            pipeline->changed.wait(guard, [pipeline] { return pipeline->stop || (pipeline->produced - pipeline->consumed < NUMBER_OF_GZIP_BUFFERS); });
+            if (pipeline->stop)
+                break;
+            b = pipeline->produced % NUMBER_OF_GZIP_BUFFERS;
+        }
+        uint64_t length = 0;
+        while (length < GZIP_BUFFER_SIZE)
+        {
+            if (stream.avail_in == 0)
+            {
+                stream.next_in = (Bytef*)input;
+                stream.avail_in = file->read(input, inputSize);
+                if (stream.avail_in == 0)
+                {
+                    endOfInput = true;
+                    if (!endOfMember)
+                        error = "unexpected end of gzip file";
+                    break;
+                }
+            }
+            if (endOfMember)        // next member of a concatenated gzip file
+            {
+                inflateReset(&stream);
+                endOfMember = false;
+            }
+            stream.next_out = (Bytef*)pipeline->buffers[b] + length;
+            stream.avail_out = GZIP_BUFFER_SIZE - length;
+            int result = inflate(&stream, Z_NO_FLUSH);
+            length = GZIP_BUFFER_SIZE - stream.avail_out;
+            if (result == Z_STREAM_END)
+                endOfMember = true;
+            else if ((result != Z_OK) && (result != Z_BUF_ERROR))
+            {
+                error = "corrupted gzip file";
+                break;
+            }
+        }
+        unique_lock<mutex> guard(pipeline->lock);
+        pipeline->bufferLength[b] = length;
+        ++pipeline->produced;
+        pipeline->changed.notify_all();
+    }
+    inflateEnd(&stream);
+    unique_lock<mutex> guard(pipeline->lock);
+    pipeline->error = error;
+    pipeline->finished = true;
+    pipeline->changed.notify_all();
+}
+
+/**
+  * Name:               bgzfBlockSize(const unsigned char* header, uint64_t available, uint64_t& headerLength)
+  *
+  * Description :       Returns the total size of the BGZF block starting at header
+  *
+  * Input :
+  *       Parameters:
+  *           const unsigned char* header   start of the block
+  *           uint64_t  available           bytes available from header on
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           uint64_t& headerLength        length of the gzip header of the block
+  *       Memory:
+  *           None
+  *       Return:
+  *           uint64_t                      block size; 0 if the header is not complete; 1 if it is not a BGZF header
+  *
+  * Process Synopsis :
+  *                     [1]  gzip magic, deflate method, FEXTRA flag
+  *                     [2]  BSIZE is in the extra subfield 'B','C'
+  *
+  * Notes :
+  *
+  */
+
+static uint64_t bgzfBlockSize(const unsigned char* header, uint64_t available, uint64_t& headerLength)
+{
+    if (available < 18)
+        return 0;
+    if ((header[0] != 31) || (header[1] != 139) || (header[2] != 8) || ((header[3] & 4) == 0))
+        return 1;
+    uint64_t extraLength = header[10] | (header[11] << 8);
+    headerLength = 12 + extraLength;
+    if (available < headerLength)
+        return 0;
+    for (uint64_t i = 12; i + 4 <= headerLength; i += 4 + (header[i + 2] | (header[i + 3] << 8)))
+        if ((header[i] == 'B') && (header[i + 1] == 'C') && ((header[i + 2] | (header[i + 3] << 8)) == 2))
+            return (uint64_t)(header[i + 4] | (header[i + 5] << 8)) + 1;
+    return 1;
+}
+
+/**
+  * Name:               DatasetReader()
+  *
+  * Description :       Default constructor; no file is open
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :
+  *
+  */
+
+DatasetReader::DatasetReader()
+{
+    format = 0;
+    compressed = NULL;
+    compressedLength = 0;
+    endOfFile = false;
+    buffer = NULL;
+    bufferSize = 0;
+    data = NULL;
+    dataLength = dataPos = 0;
+    pipeline = NULL;
+}
+
+DatasetReader::~DatasetReader()
+{
+    close();
+}
+
+/**
+  * Name:               open(const char* fileName)
+  *
+  * Description :       Opens the dataset and detects its compression
+  *
+  * Input :
+  *       Parameters:
+  *           const char* fileName          name of the dataset
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           BGZF:  compressed and decompressed batch buffers
+  *           gzip:  input buffer and NUMBER_OF_GZIP_BUFFERS output buffers; the inflating thread is started
+  *           plain: one buffer of getIOBufferSize() bytes
+  *       Return:
+  *           bool                          false if the file cannot be opened
+  *
+  * Process Synopsis :
+  *                     [1]  Read the first bytes: gzip magic 31, 139; BGZF if the first header has a 'B','C' subfield
+  *                     [2]  The bytes read are the start of the first batch (BGZF), of the gzip input or of the data
+  *
+  * Notes :
+  *
+  */
+
+bool DatasetReader::open(const char* fileName)
+{
+    close();
+    if (!file.open(fileName))
+        return false;
+    char header[18];
+    uint64_t headerRead = file.read(header, 18);
+    uint64_t headerLength = 0;
+    if ((headerRead < 2) || ((unsigned char)header[0] != 31) || ((unsigned char)header[1] != 139))
+        format = 'p';
+    else
+        format = (bgzfBlockSize((unsigned char*)header, headerRead, headerLength) > 1) ? 'b' : 'g';
+    endOfFile = false;
+    bufferSize = getIOBufferSize();
+    if (format == 'p')
+    {
+        buffer = new char[bufferSize];
+        memcpy(buffer, header, headerRead);
+        data = buffer;
+        dataLength = headerRead;
+    }
+    else if (format == 'b')
+    {
+        compressed = new char[BGZF_BATCH_BLOCKS * BGZF_MAX_BLOCK_SIZE];
+        buffer = new char[BGZF_BATCH_BLOCKS * BGZF_MAX_BLOCK_SIZE];
+        memcpy(compressed, header, headerRead);
+        compressedLength = headerRead;
+        data = buffer;
+        dataLength = 0;
+    }
+    else
+    {
+        buffer = new char[bufferSize];           // compressed input of the inflating thread
+        memcpy(buffer, header, headerRead);
+        pipeline = new GzipPipeline;
+        for (uint64_t i = 0; i < NUMBER_OF_GZIP_BUFFERS; ++i)
+        {
+            pipeline->buffers[i] = new char[GZIP_BUFFER_SIZE];
+            pipeline->bufferLength[i] = 0;
+        }
+        pipeline->produced = pipeline->consumed = 0;
+        pipeline->finished = pipeline->stop = false;
+        pipeline->error = NULL;
+        pipeline->inflater = thread(inflateGzip, &file, pipeline, buffer, bufferSize, headerRead);
+        data = NULL;
+        dataLength = 0;
+    }
+    dataPos = 0;
+    return true;
+}
+
+/**
+  * Name:               is_open()
+  *
+  * Description :       Returns true if a dataset is open
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           bool                          true if a dataset is open
+  *
+  * Process Synopsis :
+  *
+  * Notes :
+  *
+  */
+
+bool DatasetReader::is_open()
+{
+    return (format != 0);
+}
+
+/**
+  * Name:               is_stream()
+  *
+  * Description :       Returns true if the dataset is a pipe, FIFO or standard input
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           bool                          true if the dataset can be read only once
+  *
+  * Process Synopsis :
+  *
+  * Notes :
+  *
+  */
+
+bool DatasetReader::is_stream()
+{
+    return file.is_stream();
+}
+
+/**
+  * Name:               compression()
+  *
+  * Description :       Returns the compression of the open dataset
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           char                          'p' plain, 'g' gzip, 'b' BGZF
+  *
+  * Process Synopsis :
+  *
+  * Notes :
+  *
+  */
+
+char DatasetReader::compression()
+{
+    return format;
+}
+
+/**
+  * Name:               memoryUsage()
+  *
+  * Description :       Returns the size of the buffers of the open dataset
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           uint64_t                      bytes allocated for buffers (the BlockReader buffers included)
+  *
+  * Process Synopsis :
+  *
+  * Notes :
+  *
+  */
+
+uint64_t DatasetReader::memoryUsage()
+{
+    uint64_t memory = getNumberOfIOBuffers() * getIOBufferSize() * sizeof(char);
+    if (format == 'b')
+        memory += 2 * BGZF_BATCH_BLOCKS * BGZF_MAX_BLOCK_SIZE * sizeof(char);
+    else if (format == 'g')
+        memory += (bufferSize + NUMBER_OF_GZIP_BUFFERS * GZIP_BUFFER_SIZE) * sizeof(char);
+    else if (format == 'p')
+        memory += bufferSize * sizeof(char);
+    return memory;
+}
+
+/**
+  * Name:               fill()
+  *
+  * Description :       Replaces the consumed data with the next decompressed bytes
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           char*     data                next bytes of the dataset (dataLength of them)
+  *       Return:
+  *           bool                          false at end of the dataset
+  *
+  * Process Synopsis :
+  *                     [1]  plain: read the next bufferSize bytes
+  *                     [2]  BGZF:  split the batch of compressed bytes into blocks, at most BGZF_BATCH_BLOCKS,
+  *                                 inflate them in parallel, each at its offset (prefix sums of ISIZE),
+  *                                 carry the incomplete last block to the next batch
+  *                     [3]  gzip:  release the buffer just consumed and wait for the next one of the inflating thread
+  *
+  * Notes :             Errors (corrupted or truncated data) terminate the program.
+  *
+  */
+
+bool DatasetReader::fill()
+{
+    dataPos = 0;
+    if (format == 'p')
+    {
+        dataLength = file.read(buffer, bufferSize);
+        return (dataLength > 0);
+    }
+    if (format == 'g')
+    {
+        unique_lock<mutex> guard(pipeline->lock);
+        if (data != NULL)               // release the buffer just consumed
+        {
+            ++pipeline->consumed;
+            pipeline->changed.notify_all();
+        }
+        pipeline->changed.wait(guard, [this] { return pipeline->finished || (pipeline->produced > pipeline->consumed); });
+        if (pipeline->produced == pipeline->consumed)
+        {
+            if (pipeline->error != NULL)
+            {
+                throw QuessError("Cannot read input dataset: " + string(pipeline->error));
+            }
+            data = NULL;
+            dataLength = 0;
+            return false;
+        }
+        data = pipeline->buffers[pipeline->consumed % NUMBER_OF_GZIP_BUFFERS];
+        dataLength = pipeline->bufferLength[pipeline->consumed % NUMBER_OF_GZIP_BUFFERS];
+        return true;
+    }
+    // BGZF
+    uint64_t blockStart[BGZF_BATCH_BLOCKS], blockLength[BGZF_BATCH_BLOCKS], outputStart[BGZF_BATCH_BLOCKS + 1];
+    dataLength = 0;
+    while (dataLength == 0)
+    {
+        uint64_t capacity = BGZF_BATCH_BLOCKS * BGZF_MAX_BLOCK_SIZE;
+        if (!endOfFile && (compressedLength < capacity))
+        {
+            uint64_t bytesRead = file.read(compressed + compressedLength, capacity - compressedLength);
+            endOfFile = (bytesRead < capacity - compressedLength);
+            compressedLength += bytesRead;
+        }
+        if (compressedLength == 0)
+            return false;
+        uint64_t pos = 0, numberOfBlocks = 0;
+        outputStart[0] = 0;
+        while (numberOfBlocks < BGZF_BATCH_BLOCKS)
+        {
+            uint64_t headerLength = 0;
+            uint64_t blockSize = bgzfBlockSize((unsigned char*)compressed + pos, compressedLength - pos, headerLength);
+            if (blockSize == 0 || (pos + blockSize > compressedLength))
+                break;
+            if ((blockSize == 1) || (blockSize < headerLength + 8))
+            {
+                throw QuessError("Cannot read input dataset: corrupted BGZF file");
+            }
+            unsigned char* trailer = (unsigned char*)compressed + pos + blockSize - 4;
+            uint64_t inflatedSize = trailer[0] | (trailer[1] << 8) | (trailer[2] << 16) | ((uint64_t)trailer[3] << 24);
+            if (inflatedSize > BGZF_MAX_BLOCK_SIZE)
+            {
+                throw QuessError("Cannot read input dataset: corrupted BGZF file");
+            }
+            blockStart[numberOfBlocks] = pos + headerLength;
+            blockLength[numberOfBlocks] = blockSize - headerLength - 8;
+            outputStart[numberOfBlocks + 1] = outputStart[numberOfBlocks] + inflatedSize;
+            ++numberOfBlocks;
+            pos += blockSize;
+        }
+        if (numberOfBlocks == 0)
+        {
+            throw QuessError("Cannot read input dataset: unexpected end of BGZF file");
+        }
+        bool corrupted = false;
+#pragma omp parallel for schedule(dynamic)
+        for (uint64_t k = 0; k < numberOfBlocks; ++k)
+        {
+            z_stream stream;
+            memset(&stream, 0, sizeof(stream));
+            inflateInit2(&stream, -15);     // raw deflate; header and trailer are parsed above
+            stream.next_in = (Bytef*)compressed + blockStart[k];
+            stream.avail_in = blockLength[k];
+            stream.next_out = (Bytef*)buffer + outputStart[k];
+            stream.avail_out = outputStart[k + 1] - outputStart[k];
+            int result = inflate(&stream, Z_FINISH);
+            uLong crc = crc32(0L, (Bytef*)buffer + outputStart[k], outputStart[k + 1] - outputStart[k]);
+            const unsigned char* trailer = (unsigned char*)compressed + blockStart[k] + blockLength[k];
+            uLong expectedCrc = trailer[0] | (trailer[1] << 8) | (trailer[2] << 16) | ((uLong)trailer[3] << 24);
+            if ((result != Z_STREAM_END) || (stream.avail_out != 0) || (crc != expectedCrc))
+            {
+#pragma omp atomic write
+                corrupted = true;
+            }
+            inflateEnd(&stream);
+        } // ### end omp parallel for
+        if (corrupted)
+        {
+            throw QuessError("Cannot read input dataset: corrupted BGZF file");
+        }
+        memmove(compressed, compressed + pos, compressedLength - pos);
+        compressedLength -= pos;
+        dataLength = outputStart[numberOfBlocks];       // 0 for empty (e.g., end-of-file) blocks only
+    }
+    return true;
+}
+
+/**
+  * Name:               getline(char* line, uint64_t maxLength)
+  *
+  * Description :       Reads the next line (without '\n') into 'line'
+  *
+  * Input :
+  *       Parameters:
+  *           char*     line                destination
+  *           uint64_t  maxLength           size of 'line'; longer lines are truncated to maxLength - 1 characters
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           char*     line                the line, null-terminated
+  *       Memory:
+  *           None
+  *       Return:
+  *           bool                          false at end of the dataset
+  *
+  * Process Synopsis :
+  *
+  * Notes :             Same as BlockReader::getline, on the decompressed data.
+  *
+  */
+
+bool DatasetReader::getline(char* line, uint64_t maxLength)
+{
+    uint64_t n = 0;
+    bool found = false;
+    while (true)
+    {
+        if (dataPos >= dataLength)
+            if (!fill())
+                break;
+        char* start = data + dataPos;
+        uint64_t available = dataLength - dataPos;
+        char* newLine = (char*)memchr(start, '\n', available);
+        uint64_t lineLength = (newLine != NULL) ? (uint64_t)(newLine - start) : available;
+        uint64_t copy = min(lineLength, maxLength - 1 - n);
+        memcpy(line + n, start, copy);
+        n += copy;
+        dataPos += lineLength;
+        found = true;
+        if (newLine != NULL)
+        {
+            ++dataPos;
+            break;
+        }
+    }
+    line[n] = '\0';
+    return found;
+}
+
+/**
+  * Name:               read(char* destination, uint64_t maxLength)
+  *
+  * Description :       Reads the next (at most) maxLength bytes of the dataset
+  *
+  * Input :
+  *       Parameters:
+  *           char*     destination         destination
+  *           uint64_t  maxLength           maximum number of bytes
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           char*     destination         the bytes read
+  *       Memory:
+  *           None
+  *       Return:
+  *           uint64_t                      number of bytes read; 0 at end of the dataset
+  *
+  * Process Synopsis :
+  *
+  * Notes :
+  *
+  */
+
+uint64_t DatasetReader::read(char* destination, uint64_t maxLength)
+{
+    uint64_t n = 0;
+    while (n < maxLength)
+    {
+        if (dataPos >= dataLength)
+            if (!fill())
+                break;
+        uint64_t copy = min(dataLength - dataPos, maxLength - n);
+        memcpy(destination + n, data + dataPos, copy);
+        n += copy;
+        dataPos += copy;
+    }
+    return n;
+}
+
+/**
+  * Name:               close()
+  *
+  * Description :       Closes the dataset and frees the buffers
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           all buffers deallocated
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  gzip: stop and join the inflating thread
+  *
+  * Notes :
+  *
+  */
+
+void DatasetReader::close()
+{
+    if (format == 0)
+        return;
+    if (pipeline != NULL)
+    {
+        {
+            unique_lock<mutex> guard(pipeline->lock);
+            pipeline->stop = true;
+            pipeline->changed.notify_all();
+        }
+        pipeline->inflater.join();
+        for (uint64_t i = 0; i < NUMBER_OF_GZIP_BUFFERS; ++i)
+            delete [] pipeline->buffers[i];
+        delete pipeline;
+        pipeline = NULL;
+    }
+    file.close();
+    delete [] compressed;
+    delete [] buffer;
+    compressed = buffer = data = NULL;
+    compressedLength = dataLength = dataPos = 0;
+    format = 0;
+}
+
+/**
+  * Name:               isCompressedName(const char* fileName, uint64_t& nameLength)
+  *
+  * Description :       Checks whether fileName has a gzip extension
+  *
+  * Input :
+  *       Parameters:
+  *           const char* fileName          name of the file
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           uint64_t& nameLength          length of fileName without the gzip extension
+  *       Memory:
+  *           None
+  *       Return:
+  *           bool                          true if fileName ends with ".gz", ".bgz" or ".bgzf"
+  *
+  * Process Synopsis :
+  *
+  * Notes :             Used to name the working files: reads.fastq.gz -> reads_temp_copy.fastq, ...
+  *
+  */
+
+bool isCompressedName(const char* fileName, uint64_t& nameLength)
+{
+    const char* extensions[3] = {".gz", ".bgz", ".bgzf"};
+    nameLength = strlen(fileName);
+    for (int i = 0; i < 3; ++i)
+    {
+        uint64_t extensionLength = strlen(extensions[i]);
+        if ((nameLength > extensionLength) && (strcmp(fileName + nameLength - extensionLength, extensions[i]) == 0))
+        {
+            nameLength -= extensionLength;
+            return true;
+        }
+    }
+    return false;
+}
+
+// =============================================================
+// ====================== DatasetWriter ========================
+
+/**
+  * Name:               DatasetWriter()
+  *
+  * Description :       Default constructor; no file is open, output not compressed
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :
+  *
+  */
+
+DatasetWriter::DatasetWriter()
+{
+    format = 'p';
+    batch = compressed = NULL;
+    batchLength = 0;
+}
+
+DatasetWriter::~DatasetWriter()
+{
+    close();
+}
+
+/**
+  * Name:               setCompression(const char* name)
+  *
+  * Description :       Selects the compression of the files opened afterwards
+  *
+  * Input :
+  *       Parameters:
+  *           const char* name              "bgzf", "gzip", "zstd" or "none"
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           bool                          false if name is not a known compression
+  *
+  * Process Synopsis :
+  *
+  * Notes :             zstd is available only if QUESS was built with USE_ZSTD=1.
+  *
+  */
+
+bool DatasetWriter::setCompression(const char* name)
+{
+    if (strcmp(name, "bgzf") == 0)
+        format = 'b';
+    else if (strcmp(name, "gzip") == 0)
+        format = 'g';
+    else if (strcmp(name, "zstd") == 0)
+    {
+#if USE_ZSTD
+        format = 'z';
+#else
+        throw QuessError("zstd output is not available; build QUESS with 'make USE_ZSTD=1'");
+#endif
+    }
+    else if (strcmp(name, "none") == 0)
+        format = 'p';
+    else
+        return false;
+    return true;
+}
+
+/**
+  * Name:               extension()
+  *
+  * Description :       Returns the file name extension of the selected compression
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           const char*                   "", ".gz" or ".zst"
+  *
+  * Process Synopsis :
+  *
+  * Notes :
+  *
+  */
+
+const char* DatasetWriter::extension()
+{
+    if (format == 'z')
+        return ".zst";
+    return (format == 'p') ? "" : ".gz";
+}
+
+/**
+  * Name:               blockSize()
+  *
+  * Description :       Returns the number of uncompressed bytes per compressed block
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           uint64_t                      BGZF_OUTPUT_BLOCK_SIZE for BGZF, COMPRESS_BLOCK_SIZE otherwise
+  *
+  * Process Synopsis :
+  *
+  * Notes :
+  *
+  */
+
+uint64_t DatasetWriter::blockSize()
+{
+    return (format == 'b') ? BGZF_OUTPUT_BLOCK_SIZE : COMPRESS_BLOCK_SIZE;
+}
+
+/**
+  * Name:               blockBound()
+  *
+  * Description :       Returns the space reserved for one compressed block
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           uint64_t                      upper bound of the compressed size of a block (headers included)
+  *
+  * Process Synopsis :
+  *
+  * Notes :
+  *
+  */
+
+uint64_t DatasetWriter::blockBound()
+{
+#if USE_ZSTD
+    if (format == 'z')
+        return ZSTD_compressBound(blockSize());
+#endif
+    return compressBound(blockSize()) + 32;     // + gzip/BGZF header and trailer
+}
+
+/**
+  * Name:               open(const char* fileName)
+  *
+  * Description :       Creates the output file
+  *
+  * Input :
+  *       Parameters:
+  *           const char* fileName          name of the file
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           compressed output: batch of COMPRESS_BATCH_SIZE bytes and space for its compressed blocks
+  *       Return:
+  *           bool                          false if the file cannot be created
+  *
+  * Process Synopsis :
+  *
+  * Notes :
+  *
+  */
+
+bool DatasetWriter::open(const char* fileName)
+{
+    close();
+    if (!file.open(fileName))
+        return false;
+    if (format != 'p')
+    {
+        batch = new char[COMPRESS_BATCH_SIZE];
+        compressed = new char[((COMPRESS_BATCH_SIZE + blockSize() - 1) / blockSize()) * blockBound()];
+        batchLength = 0;
+    }
+    return true;
+}
+
+/**
+  * Name:               is_open()
+  *
+  * Description :       Returns true if a file is open
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           bool                          true if a file is open
+  *
+  * Process Synopsis :
+  *
+  * Notes :
+  *
+  */
+
+bool DatasetWriter::is_open()
+{
+    return file.is_open();
+}
+
+/**
+  * Name:               compressBatch()
+  *
+  * Description :       Compresses the batch in parallel and writes the blocks in order
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           char*     compressed          block k is compressed at k * blockBound()
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  Split the batch into blocks of blockSize() bytes
+  *                     [2]  Each thread compresses blocks with its own stream (deflateReset between blocks)
+  *                             BGZF: raw deflate between the BGZF header ('B','C' subfield with BSIZE) and
+  *                                   the CRC32/ISIZE trailer
+  *                             gzip: one gzip member per block (a multi-member gzip file)
+  *                             zstd: one frame per block
+  *                     [3]  Write the blocks in order
+  *
+  * Notes :             Every block is an independent member/frame, so the output is readable by
+  *                     gzip/zcat (resp. zstd) and, for BGZF, by samtools/htslib.
+  *
+  */
+
+void DatasetWriter::compressBatch()
+{
+    if (batchLength == 0)
+        return;
+    uint64_t size = blockSize(), bound = blockBound();
+    int64_t numberOfBlocks = (batchLength + size - 1) / size;
+    uint64_t compressedSize[COMPRESS_BATCH_SIZE / BGZF_OUTPUT_BLOCK_SIZE + 1];
+    bool failed = false;
+#pragma omp parallel
+    {
+        z_stream stream;
+        memset(&stream, 0, sizeof(stream));
+        if (format != 'z')
+            deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, (format == 'b') ? -15 : 15 + 16, 8, Z_DEFAULT_STRATEGY);
+#pragma omp for schedule(dynamic)
+        for (int64_t k = 0; k < numberOfBlocks; ++k)
+        {
+            char* input = batch + k * size;
+            uint64_t inputLength = min(size, batchLength - k * size);
+            unsigned char* output = (unsigned char*)compressed + k * bound;
+            if (format == 'z')
+            {
+#if USE_ZSTD
+                size_t result = ZSTD_compress(output, bound, input, inputLength, 3);
+                if (ZSTD_isError(result))
+                {
+#pragma omp atomic write
+                    failed = true;
+                }
+                compressedSize[k] = result;
+#endif
+                continue;
+            }
+            uint64_t headerLength = (format == 'b') ? 18 : 0;
+            deflateReset(&stream);
+            stream.next_in = (Bytef*)input;
+            stream.avail_in = inputLength;
+            stream.next_out = output + headerLength;
+            stream.avail_out = bound - headerLength - 8;
+            if (deflate(&stream, Z_FINISH) != Z_STREAM_END)
+            {
+#pragma omp atomic write
+                failed = true;
+            }
+            uint64_t length = headerLength + stream.total_out;
+            if (format == 'b')
+            {
+                uLong crc = crc32(0L, (Bytef*)input, inputLength);
+                for (int i = 0; i < 4; ++i)
+                {
+                    output[length + i] = (crc >> (8 * i)) & 0xff;
+                    output[length + 4 + i] = (inputLength >> (8 * i)) & 0xff;
+                }
+                length += 8;
+                const unsigned char header[16] = {31, 139, 8, 4, 0, 0, 0, 0, 0, 255, 6, 0, 'B', 'C', 2, 0};
+                memcpy(output, header, 16);
+                output[16] = (length - 1) & 0xff;       // BSIZE = block size - 1
+                output[17] = (length - 1) >> 8;
+            }
+            compressedSize[k] = length;
+        }
+        if (format != 'z')
+            deflateEnd(&stream);
+    } // ### end omp parallel
+    if (failed)
+    {
+        throw QuessError("Cannot compress output file");
+    }
+    for (int64_t k = 0; k < numberOfBlocks; ++k)
+        file.write(compressed + k * bound, compressedSize[k]);
+    batchLength = 0;
+}
+
+/**
+  * Name:               write(const char* data, uint64_t length)
+  *
+  * Description :       Appends length bytes
+  *
+  * Input :
+  *       Parameters:
+  *           const char* data              bytes to write
+  *           uint64_t  length              number of bytes
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  Copy into the batch; compress it when full
+  *
+  * Notes :
+  *
+  */
+
+void DatasetWriter::write(const char* data, uint64_t length)
+{
+    if (format == 'p')
+    {
+        file.write(data, length);
+        return;
+    }
+    while (length > 0)
+    {
+        uint64_t copy = min(length, (uint64_t)COMPRESS_BATCH_SIZE - batchLength);
+        memcpy(batch + batchLength, data, copy);
+        batchLength += copy;
+        data += copy;
+        length -= copy;
+        if (batchLength == COMPRESS_BATCH_SIZE)
+            compressBatch();
+    }
+}
+
+/**
+  * Name:               writeLine(const char* line)
+  *
+  * Description :       Appends line followed by '\n'
+  *
+  * Input :
+  *       Parameters:
+  *           const char* line              null-terminated line
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :
+  *
+  */
+
+void DatasetWriter::writeLine(const char* line)
+{
+    if (format == 'p')
+    {
+        file.writeLine(line);
+        return;
+    }
+    write(line, strlen(line));
+    write("\n", 1);
+}
+
+/**
+  * Name:               close()
+  *
+  * Description :       Compresses the remaining data and closes the file
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           batch buffers deallocated
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  Compress the last (partial) batch
+  *                     [2]  BGZF: append the empty end-of-file block
+  *
+  * Notes :
+  *
+  */
+
+void DatasetWriter::close()
+{
+    if (!file.is_open())
+        return;
+    if (format != 'p')
+    {
+        compressBatch();
+        if (format == 'b')
+        {
+            const unsigned char endOfFileBlock[28] = {31, 139, 8, 4, 0, 0, 0, 0, 0, 255, 6, 0, 'B', 'C', 2, 0, 27, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+            file.write((const char*)endOfFileBlock, 28);
+        }
+        delete [] batch;
+        delete [] compressed;
+        batch = compressed = NULL;
+    }
+    file.close();
+}
@@ -52,7 +52,7 @@ const uint64_t hashTableSizes[] = {
  {
     size = maxSize = getNewSize(minRequiredSize);
 
-    cout << "New hash table of size: " << size << endl;
+    quessLog << "New hash table of size: " << size << endl;
     numberOfElements = 0;
     sMerTable = new Element[size];
     for (uint64_t i = 0; i < size; ++i)
@@ -61,6 +61,59 @@ const uint64_t hashTableSizes[] = {
         sMerTable[i].value = EMPTY;
     }
     sGapTable = NULL;
+    sGapValues = NULL;
+    ownsSGapValues = false;
+    staticTable = NULL;
+    bucketTable = NULL;
+    partition = sizeLimit = numberOfLocks = 0;
+    numberOfPartitions = 1;
+    compactTable = NULL;
+    narrowTable = NULL;
+    compactCounting = false;
+    keyMask = 0;
+}
+
+/**
+  * Name:               HashTable(Element* sMerTable, Element* sGapValues, uint64_t size)
+  *
+  * Description :       Constructor of a read-only table over the arrays of a correction index
+  *
+  * Input :
+  *       Parameters:
+  *           Element*  sMerTable           sMers (as after removeAmbigSMers) of a table of size "size"
+  *           Element*  sGapValues          correct sGap of each position; .count = score
+  *           uint64_t  size                size of the table (a prime from hashTableSizes)
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None (the arrays belong to the CorrectionIndex)
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :             Only getCorrectSGap (and clear) may be used; the arrays are mapped read-only.
+  *
+  */
+
+HashTable::HashTable(Element* sMerTable, Element* sGapValues, uint64_t size)
+{
+    this->size = maxSize = size;
+    numberOfElements = 0;
+    this->sMerTable = sMerTable;
+    this->sGapValues = sGapValues;
+    ownsSGapValues = false;
+    sGapTable = NULL;
+    staticTable = NULL;
+    bucketTable = NULL;
+    partition = sizeLimit = numberOfLocks = 0;
+    numberOfPartitions = 1;
+    compactTable = NULL;
+    narrowTable = NULL;
+    compactCounting = false;
+    keyMask = 0;
 }
 
 /**
@@ -127,6 +180,182 @@ uint64_t HashTable::getSize()
     return(size);
 }
 
+/**
+  * Name:               setPartition(uint64_t partition, uint64_t numberOfPartitions)
+  *
+  * Description :       Restricts insertSMer to the sMers of one partition
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t  partition           0 .. numberOfPartitions - 1
+  *           uint64_t  numberOfPartitions  number of partitions of the sMers; 1 = all sMers
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :             The partition of an sMer is given by the high bits of a multiplicative hash, independent
+  *                     of its position in the table.
+  *
+  */
+
+void HashTable::setPartition(uint64_t partition, uint64_t numberOfPartitions)
+{
+    this->partition = partition;
+    this->numberOfPartitions = numberOfPartitions;
+}
+
+void HashTable::setSizeLimit(uint64_t sizeLimit)
+{
+    this->sizeLimit = sizeLimit;
+}
+
+bool HashTable::canDoubleSize()
+{
+    return (sizeLimit == 0) || (getNewSize(2 * maxSize) <= sizeLimit);
+}
+
+void HashTable::setNumberOfLocks(uint64_t numberOfLocks)
+{
+    this->numberOfLocks = numberOfLocks;
+}
+
+uint64_t HashTable::getNumberOfLocks()
+{
+    return ((numberOfLocks == 0) || (numberOfLocks > size)) ? size : numberOfLocks;
+}
+
+/**
+  * Name:               setCompactCounting(bool compactCounting), setKeyMask(uint64_t keyMask, uint64_t &peakMemory, uint64_t &currentMemory)
+  *
+  * Description :       Counts the sMers in a NarrowTable or a CompactTable instead of an Element table
+  *
+  * Input :
+  *       Parameters:
+  *           bool      compactCounting     true: use a CompactTable when the remainders of the sMers fit
+  *           uint64_t  keyMask             bits of the sMers of the current seed (seed.getKeyMask())
+  *           uint64_t  &peakMemory         Peak memory of program
+  *           uint64_t  &currentMemory      Current memory of program
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           uint64_t  &peakMemory         peakMemory is recorded and estimated for testing
+  *           uint64_t  &currentMemory      currentMemory is recorded and estimated for testing
+  *       Memory:
+  *           an empty counting table (no sMer inserted yet) is reallocated for keyMask
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  setKeyMask is called before the sMers of each seed are counted; the table created by
+  *                          the constructor or by recreateOfMaxSize (with the mask of the previous seed) is replaced
+  *
+  * Notes :             A NarrowTable is chosen from keyMask alone (sMers of at most 32 bits: weight <= 16);
+  *                     otherwise, without compactCounting, an Element table is kept as it is.
+  *
+  */
+
+void HashTable::setCompactCounting(bool compactCounting)
+{
+    this->compactCounting = compactCounting;
+}
+
+void HashTable::setKeyMask(uint64_t keyMask, uint64_t &peakMemory, uint64_t &currentMemory)
+{
+    this->keyMask = keyMask;
+    if ((sGapTable != NULL) || (sGapValues != NULL) || (staticTable != NULL) || (bucketTable != NULL))
+        return;
+    if (compactTable != NULL)
+    {
+        currentMemory -= compactTable->memoryUsage();
+        delete compactTable;
+        compactTable = NULL;
+    }
+    else if (narrowTable != NULL)
+    {
+        currentMemory -= narrowTable->memoryUsage();
+        delete narrowTable;
+        narrowTable = NULL;
+    }
+    else if (!compactCounting && !NarrowTable<uint32_t>::fits(keyMask))
+        return;
+    else if ((sMerTable != NULL) && (numberOfElements == 0))
+    {
+        delete [] sMerTable;
+        sMerTable = NULL;
+        currentMemory -= size*sizeof(uint64_t);
+    }
+    else
+        return;
+    allocateCountingTable(peakMemory, currentMemory);
+}
+
+/**
+  * Name:               allocateCountingTable(uint64_t &peakMemory, uint64_t &currentMemory)
+  *
+  * Description :       Allocates the empty table in which the sMers are counted
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t  &peakMemory         Peak memory of program
+  *           uint64_t  &currentMemory      Current memory of program
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           uint64_t  &peakMemory         peakMemory is recorded and estimated for testing
+  *           uint64_t  &currentMemory      currentMemory is recorded and estimated for testing
+  *       Memory:
+  *           NarrowTable<uint32_t>* narrowTable    if the sMers of keyMask have at most 32 bits
+  *           CompactTable* compactTable    otherwise, if compactCounting and the sMers of keyMask fit a table of size "size"
+  *           Element*  sMerTable           otherwise; size Elements, all EMPTY
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :             The NarrowTable (about 5 bytes per position) is preferred to the CompactTable (5.3 bytes).
+  *
+  */
+
+void HashTable::allocateCountingTable(uint64_t &peakMemory, uint64_t &currentMemory)
+{
+    numberOfElements = 0;
+    sGapTable = NULL;
+    if (NarrowTable<uint32_t>::fits(keyMask))
+    {
+        narrowTable = new NarrowTable<uint32_t>(keyMask, size);
+        currentMemory += narrowTable->memoryUsage();
+    }
+    else if (compactCounting && CompactTable::fits(keyMask, size))
+    {
+        compactTable = new CompactTable(keyMask, size);
+        currentMemory += compactTable->memoryUsage();
+    }
+    else
+    {
+        sMerTable = new Element[size];
+        for (uint64_t i = 0; i < size; ++i)
+        {
+            sMerTable[i].count = 0;
+            sMerTable[i].value = EMPTY;
+        }
+        currentMemory += size*sizeof(uint64_t);
+    }
+    if (currentMemory > peakMemory)
+    {
+        peakMemory = currentMemory;
+#ifdef VERBOSE
+        quessLog << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
+#endif
+    }
+}
+
 /**
   * Name:               insertSMer(uint64_t sMer)
   *
@@ -161,6 +390,12 @@ uint64_t HashTable::getSize()
 
 bool HashTable::insertSMer(uint64_t sMer)
 {
+    if ((numberOfPartitions > 1) && ((((sMer * 0x9E3779B97F4A7C15ULL) >> 32) % numberOfPartitions) != partition))
+        return true;        // counted in the pass of its partition
+    if (narrowTable != NULL)
+        return narrowTable->insert(sMer);
+    if (compactTable != NULL)
+        return compactTable->insert(sMer);
     bool table_not_full = true;
     bool value_found = true;
     uint64_t former_table_value = 0;
@@ -176,7 +411,7 @@ bool HashTable::insertSMer(uint64_t sMer)
 #pragma omp master
     {
         if (numberOfElements % 50000000 == 0)
-            cout << "element added: " << numberOfElements << endl;
+            quessLog << "element added: " << numberOfElements << endl;
         former_table_value = sMerTable[place].value;
         sMerTable[place].value = sMer;
         sMerTable[place].count = 1;
@@ -228,7 +463,10 @@ bool HashTable::findPos(Element *table, uint64_t tableSize, uint64_t sMer, uint6
     uint64_t former_table_value = 0;
 
     // hash function uses a large prime number close to the hashtable size
-    place = sMer * getNewSize((uint64_t)(tableSize * 0.6)) % tableSize;
+    uint64_t multiplier = getNewSize((uint64_t)(tableSize * 0.6));
+    if (multiplier == tableSize)        // smallest size: the prime itself would send every sMer to 0
+        multiplier = 1000003;
+    place = sMer * multiplier % tableSize;
     int64_t firstREMOVED = -1;
     bool removedFound = false;
 
@@ -318,7 +556,8 @@ void HashTable::removeSGaps(uint64_t pos)
   *                     [3]  Iterates again through the old hashTable to fetch sMers of count >=Tc and adds them to the new hashTable
                         [4]  Deletes old hashTable and sets 'size' to new size
   *
-  * Notes :             
+  * Notes :             The counts and sMers of a NarrowTable or CompactTable are read with getEntry; the new table is
+  *                     an Element table.
   *
   */
 
@@ -328,12 +567,21 @@ void HashTable::rehashFrequentSMers(uint64_t Tc, uint64_t &peakMemory, uint64_t
     // get new size ~= 1.7 x number of frequent sMers
     uint64_t oldSize=size;
     uint64_t frequentSMers = 0;
+    uint64_t sMer = 0, count = 0;
     for (uint64_t i = 0; i < size; ++i)
-        if (sMerTable[i].count >= Tc)
+    {
+        if (narrowTable != NULL)
+            narrowTable->getEntry(i, sMer, count);
+        else if (compactTable != NULL)
+            compactTable->getEntry(i, sMer, count);
+        else
+            count = sMerTable[i].count;
+        if (count >= Tc)
             ++frequentSMers;
+    }
         uint64_t newSize = getNewSize((uint64_t)(1.7 * frequentSMers));
         maxSize = max(maxSize, newSize);
-        cout << "Frequent sMers: " << frequentSMers << "; Hash them to size: " << newSize << endl;
+        quessLog << "Frequent sMers: " << frequentSMers << "; Hash them to size: " << newSize << endl;
         numberOfElements = frequentSMers;
         Element* newTable = new Element[newSize];
         for (uint64_t i = 0; i< newSize; ++i)
@@ -346,25 +594,151 @@ void HashTable::rehashFrequentSMers(uint64_t Tc, uint64_t &peakMemory, uint64_t
         {   
             peakMemory = currentMemory;
 #ifdef VERBOSE
-            cout << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
+            quessLog << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
 #endif
         }
         // rehash the elements in the old table into the new one
         uint64_t place = 0;
         for (uint64_t i = 0; i < size; ++i)
-        if (sMerTable[i].count >= Tc)
+        {
+            if (narrowTable != NULL)
+                narrowTable->getEntry(i, sMer, count);
+            else if (compactTable != NULL)
+                compactTable->getEntry(i, sMer, count);
+            else
             {
-        findPos(newTable, newSize, sMerTable[i].value, place);  // false always returned by findPos is ignored
-        newTable[place].value = sMerTable[i].value; // count remains 0; will be used to count sGaps !!!
-    }
+                sMer = sMerTable[i].value;
+                count = sMerTable[i].count;
+            }
+            if (count >= Tc)
+            {
+                findPos(newTable, newSize, sMer, place);  // false always returned by findPos is ignored
+                newTable[place].value = sMer; // count remains 0; will be used to count sGaps !!!
+            }
+        }
     // reset the values and delete the old table
-    Element* temp = sMerTable;
-    delete [] temp;
-    currentMemory-=oldSize*sizeof(uint64_t);
+    if (narrowTable != NULL)
+    {
+        currentMemory -= narrowTable->memoryUsage();
+        delete narrowTable;
+        narrowTable = NULL;
+    }
+    else if (compactTable != NULL)
+    {
+        currentMemory -= compactTable->memoryUsage();
+        delete compactTable;
+        compactTable = NULL;
+    }
+    else
+    {
+        Element* temp = sMerTable;
+        delete [] temp;
+        currentMemory-=oldSize*sizeof(uint64_t);
+    }
     sMerTable = newTable;
     size = newSize;
 }
 
+/**
+  * Name:               collectFrequentSMers(uint64_t Tc, vector<uint64_t>& frequentSMers)
+  *
+  * Description :       Collects the sMers of count >= Tc
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t  Tc                  The count threshold to ascertain whether a specific sMer should be kept
+  *           vector<uint64_t>& frequentSMers   destination
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           vector<uint64_t>& frequentSMers   the frequent sMers of the table are appended
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :             Used when the sMers are counted one partition at a time.
+  *
+  */
+
+void HashTable::collectFrequentSMers(uint64_t Tc, vector<uint64_t>& frequentSMers)
+{
+    if ((narrowTable != NULL) || (compactTable != NULL))
+    {
+        uint64_t sMer = 0, count = 0;
+        for (uint64_t i = 0; i < size; ++i)
+        {
+            if (narrowTable != NULL)
+                narrowTable->getEntry(i, sMer, count);
+            else
+                compactTable->getEntry(i, sMer, count);
+            if (count >= Tc)
+                frequentSMers.push_back(sMer);
+        }
+        return;
+    }
+    for (uint64_t i = 0; i < size; ++i)
+        if ((sMerTable[i].value != EMPTY) && (sMerTable[i].value != REMOVED) && (sMerTable[i].count >= Tc))
+            frequentSMers.push_back(sMerTable[i].value);
+}
+
+/**
+  * Name:               createFromSMers(vector<uint64_t>& sMers, uint64_t &peakMemory, uint64_t &currentMemory)
+  *
+  * Description :       Creates the table of the frequent sMers of all partitions
+  *
+  * Input :
+  *       Parameters:
+  *           vector<uint64_t>& sMers       frequent sMers (each once)
+  *           uint64_t  &peakMemory         Peak memory of program
+  *           uint64_t  &currentMemory      Current memory of program
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           uint64_t  &peakMemory         peakMemory is recorded and estimated for testing
+  *           uint64_t  &currentMemory      currentMemory is recorded and estimated for testing
+  *       Memory:
+  *           Element*  sMerTable           new table of approximately 1.7 times the number of sMers (the table must be cleared)
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  Same size and contents as rehashFrequentSMers gives: the sMers with count 0
+  *
+  * Notes :             maxSize (size of the counting table) is not changed, so recreateOfMaxSize stays within the
+  *                     size limit for the next seed.
+  *
+  */
+
+void HashTable::createFromSMers(vector<uint64_t>& sMers, uint64_t &peakMemory, uint64_t &currentMemory)
+{
+    size = getNewSize((uint64_t)(1.7 * sMers.size()));
+    quessLog << "Frequent sMers: " << sMers.size() << "; Hash them to size: " << size << endl;
+    numberOfElements = sMers.size();
+    sMerTable = new Element[size];
+    for (uint64_t i = 0; i < size; ++i)
+    {
+        sMerTable[i].count = 0;
+        sMerTable[i].value = EMPTY;
+    }
+    currentMemory+=size*sizeof(uint64_t);
+    if (currentMemory > peakMemory)
+    {
+        peakMemory = currentMemory;
+#ifdef VERBOSE
+        quessLog << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
+#endif
+    }
+    uint64_t place = 0;
+    for (uint64_t i = 0; i < sMers.size(); ++i)
+    {
+        findPos(sMerTable, size, sMers[i], place);
+        sMerTable[place].value = sMers[i];  // count remains 0; will be used to count sGaps !!!
+    }
+}
+
 /**
   * Name:               createSGapTable(uint64_t &peakMemory, uint64_t &currentMemory)
   *
@@ -393,12 +767,19 @@ void HashTable::rehashFrequentSMers(uint64_t Tc, uint64_t &peakMemory, uint64_t
 
 void HashTable::createSGapTable(uint64_t &peakMemory, uint64_t &currentMemory)
 {
-        cout << "New sGapTable of size:  " << size << endl;
+        quessLog << "New sGapTable of size:  " << size << endl;
         sGapTable = new Element* [size];
         for (uint64_t i = 0; i < size; ++i)
             sGapTable[i] = NULL;
 }
 
+// unset a lock of insertSGap (none for the sharded insertion)
+static inline void unsetLock(omp_lock_t* lock)
+{
+    if (lock != NULL)
+        omp_unset_lock(lock);
+}
+
 /**
   * Name:               insertSGap(uint64_t sMer, uint64_t sGap, uint64_t Te, omp_lock_t* lockArray)
   *
@@ -410,7 +791,8 @@ void HashTable::createSGapTable(uint64_t &peakMemory, uint64_t &currentMemory)
   *           uint64_t  sGap                The identity of the binary representation of the sGap
   *           uint64_t  Te                  The count threshold for how acceptable deviants from the strongest sGap are
   *           int       seedNumber          Current iteration of program
-  *           omp_lock_t* lockArray         The lock array to prevent multiple access at a hashTable location
+  *           omp_lock_t* lockArray         The lock array (getNumberOfLocks() locks) to prevent multiple access at a hashTable location
+  *                                         (NULL: no lock, the sMers are inserted by the threads owning them)
   *
   * Output/Expected Changes :
   *       Parameters:
@@ -442,12 +824,14 @@ void HashTable::insertSGap(uint64_t sMer, uint64_t sGap, uint64_t Te, int seedNu
     uint64_t place = 0;
     if (!findPos(sMerTable, size, sMer, place))     // sMer not in table
         return;
-    omp_set_lock(&(lockArray[place]));
+    omp_lock_t* lock = (lockArray != NULL) ? &(lockArray[place % getNumberOfLocks()]) : NULL;    // = place with one lock per position
+    if (lock != NULL)
+        omp_set_lock(lock);
 
     // sMer found in table at place
     if (sMerTable[place].count == 255)  // ambiguous sMer
     {
-        omp_unset_lock(&(lockArray[place]));
+        unsetLock(lock);
         return;
     }
     // sMer is not ambiguous
@@ -457,7 +841,7 @@ void HashTable::insertSGap(uint64_t sMer, uint64_t sGap, uint64_t Te, int seedNu
         sGapTable[place] = new Element[1];
         sGapTable[place][0].value = sGap;
         sGapTable[place][0].count = 1;
-        omp_unset_lock(&(lockArray[place]));
+        unsetLock(lock);
         return;
     }
     // there are previously found sGaps in table
@@ -479,7 +863,7 @@ void HashTable::insertSGap(uint64_t sMer, uint64_t sGap, uint64_t Te, int seedNu
             {
                 sMerTable[place].count = 255;
                 removeSGaps(place);
-                omp_unset_lock(&(lockArray[place]));
+                unsetLock(lock);
                 return;
             }
         }
@@ -523,11 +907,11 @@ void HashTable::insertSGap(uint64_t sMer, uint64_t sGap, uint64_t Te, int seedNu
         {
             sMerTable[place].count = 255;
             removeSGaps(place);
-            omp_unset_lock(&(lockArray[place]));
+            unsetLock(lock);
             return;
         }
     }
-    omp_unset_lock(&(lockArray[place]));
+    unsetLock(lock);
 }
 
 /**
@@ -614,11 +998,11 @@ void HashTable::removeAmbigSMers(uint64_t Tc, uint64_t Te, int seedNumber, uint6
         }
     }
     currentMemory-=0.84*(8-seedNumber)*size*sizeof(uint64_t);
-    cout << "Ambiguous sMers removed: " << totalAmbigSMers << endl;
+    quessLog << "Ambiguous sMers removed: " << totalAmbigSMers << endl;
 }
 
 /**
-  * Name:               getCorrectSGap(uint64_t sMer, uint64_t sGap, uint64_t& correctSGap, uint64_t Tdiff, uint64_t* diff16Bits)
+  * Name:               getCorrectSGap(uint64_t sMer, uint64_t sGap, uint64_t& correctSGap, uint64_t Tdiff)
   *
   * Description :       Given a sMer and its corresponding uncorrected sGap, checks the hashTable for the appropriate sGap and returns the
   *                     status of whether or not the sGap is correctable.
@@ -629,7 +1013,6 @@ void HashTable::removeAmbigSMers(uint64_t Tc, uint64_t Te, int seedNumber, uint6
   *           uint64_t  sGap                The sGap of the read being processed associated with the sMer indicated
   *           uint64_t& correctSGap         A pointer to the identity of the correct sGap
   *           uint64_t  Tdiff               The allowance of how many bits can be different to have the uncorrected sGap be corrected
-  *           uint64_t* diff16Bits          Precomputed array to determine the difference between the sGaps
   *
   * Output/Expected Changes :
   *       Parameters:
@@ -646,16 +1029,21 @@ void HashTable::removeAmbigSMers(uint64_t Tc, uint64_t Te, int seedNumber, uint6
   * Process Synopsis :
   *                     [1]  Utilizes findpos to find the sMer being sought after
   *                     [2]  Returns a value equivalent to the status of the input sMer/sGap compared to the hashTable sGap
-  *                     [3]  If the uncorrected sGap and the correct sGap are similar (<Tdiff) using getDiff, will proceed to correct
+  *                     [3]  If the uncorrected sGap and the correct sGap are similar (<Tdiff) using diff2Bit, will proceed to correct
   *
   * Notes :             If the bits between the uncorrected and the correct sGap are too high, it is quite probable that the uncorrect sGap
   *                     is of an entirely different variant and could very well be fully correct. 
   *
   */
 
-int64_t HashTable::getCorrectSGap(uint64_t sMer, uint64_t sGap, uint64_t& correctSGap, uint64_t Tdiff, uint64_t* diff16Bits)
+int64_t HashTable::getCorrectSGap(uint64_t sMer, uint64_t sGap, uint64_t& correctSGap, uint64_t Tdiff)
 {
 
+    if (staticTable != NULL)        // buildStaticTable done
+        return staticTable->getCorrectSGap(sMer, sGap, correctSGap, Tdiff);
+    if (bucketTable != NULL)        // buildBucketTable done
+        return bucketTable->getCorrectSGap(sMer, sGap, correctSGap, Tdiff);
+
     // find sMer
     uint64_t place = 0;
     if (!findPos(sMerTable, size, sMer, place))          // sMer not in table
@@ -666,63 +1054,60 @@ int64_t HashTable::getCorrectSGap(uint64_t sMer, uint64_t sGap, uint64_t& correc
         return -2;
     
     // sMer not ambiguous; it has only one (correct) sGap at sGapTable[place][0] (because of "removeAmbigSMers")
-    if (sGap == sGapTable[place][0].value)  // sGap is already correct
+    // or at sGapValues[place] for a table read from an index
+    const Element& tableSGap = (sGapValues != NULL) ? sGapValues[place] : sGapTable[place][0];
+    if (sGap == tableSGap.value)  // sGap is already correct
         return 0;
     
     //sGap is different from the correctSGap but must not be too different
-    if (getDiff(sGap, sGapTable[place][0].value, diff16Bits) < Tdiff)
+    if (diff2Bit(sGap, tableSGap.value) < Tdiff)
     {
-        correctSGap = sGapTable[place][0].value;        // return the correct sGap in "correctSGap"
-        return (int64_t)sGapTable[place][0].count;         // return also its score (from count)
+        correctSGap = tableSGap.value;        // return the correct sGap in "correctSGap"
+        return (int64_t)tableSGap.count;         // return also its score (from count)
     }
     else
         return -1;  // sGap too different
 }
 
 /**
-  * Name:               getDiff(uint64_t x, uint64_t y, uint64_t* diff16Bits)
+  * Name:               getCorrectEntry(uint64_t sMer, uint64_t& sGap, uint64_t& score)
   *
-  * Description :       Given two integers x and y, computes the difference in bits between them
+  * Description :       Returns the correct sGap and score of a non-ambiguous sMer
   *
   * Input :
   *       Parameters:
-  *           uint64_t  x                   The first integer
-  *           uint64_t  y                   The second integer
-  *           uint64_t* diff16Bits          Precomputed array to determine the difference between the sGaps
+  *           uint64_t  sMer                sMer looked for
+  *           uint64_t& sGap                destination
+  *           uint64_t& score               destination
   *
   * Output/Expected Changes :
   *       Parameters:
-  *           None
+  *           uint64_t& sGap                correct sGap of sMer
+  *           uint64_t& score               its score
   *       Memory:
   *           None
   *       Return:
-  *           int                           Number of different bits between x and y
+  *           bool                          false if sMer is not in the table or is ambiguous
   *
   * Process Synopsis :
-  *                     [1]  Uses a mask to determin the difference between x and y in terms of bits.
   *
-  * Notes :             
+  * Notes :             After removeAmbigSMers; used by QUESS_mpi to answer the lookups of other ranks.
   *
   */
 
-uint64_t HashTable::getDiff(uint64_t x, uint64_t y, uint64_t* diff16Bits)
+bool HashTable::getCorrectEntry(uint64_t sMer, uint64_t& sGap, uint64_t& score)
 {
-    uint64_t nDiff = 0;
-    uint64_t mask = (1 << 16) - 1;
-    uint64_t xXORy = x ^ y;
-    for (uint64_t i = 0; i < 4; ++i)
-        nDiff += diff16Bits[(xXORy >> (16 * i)) & mask];
-    return nDiff;
-}
-
-
-uint64_t HashTable::computeDiff16Bits(uint16_t x)
-{
-    uint64_t nDiff = 0;
-    for (uint64_t i = 0; i < 8; ++i)
-        if (((x >> (2 * i)) & 3) != 0)      // mask = 3
-            ++nDiff;
-        return nDiff;
+    if (staticTable != NULL)
+        return staticTable->getCorrectEntry(sMer, sGap, score);
+    if (bucketTable != NULL)
+        return bucketTable->getCorrectEntry(sMer, sGap, score);
+    uint64_t place = 0;
+    if (!findPos(sMerTable, size, sMer, place) || (sMerTable[place].count == 255))
+        return false;
+    const Element& tableSGap = (sGapValues != NULL) ? sGapValues[place] : sGapTable[place][0];
+    sGap = tableSGap.value;
+    score = tableSGap.count;
+    return true;
 }
 
 /**
@@ -754,7 +1139,43 @@ uint64_t HashTable::computeDiff16Bits(uint16_t x)
 
 void HashTable::clear(uint64_t &peakMemory,uint64_t &currentMemory)
 {
-    cout << "Clear hash table of size:  " << size << endl;
+    quessLog << "Clear hash table of size:  " << size << endl;
+    if (compactTable != NULL)
+    {
+        currentMemory -= compactTable->memoryUsage();
+        delete compactTable;
+        compactTable = NULL;
+    }
+    if (narrowTable != NULL)
+    {
+        currentMemory -= narrowTable->memoryUsage();
+        delete narrowTable;
+        narrowTable = NULL;
+    }
+    if (staticTable != NULL)
+    {
+        currentMemory -= staticTable->memoryUsage();
+        delete staticTable;
+        staticTable = NULL;
+    }
+    if (bucketTable != NULL)
+    {
+        currentMemory -= bucketTable->memoryUsage();
+        delete bucketTable;
+        bucketTable = NULL;
+    }
+    if ((sGapValues != NULL) && ownsSGapValues)     // arrays of createFromModel
+    {
+        delete [] sMerTable;
+        delete [] sGapValues;
+        currentMemory-=2*size*sizeof(Element);
+        ownsSGapValues = false;
+    }
+    if (sGapValues != NULL)     // arrays of a correction index; unmapped by the index
+    {
+        sMerTable = sGapValues = NULL;
+        return;
+    }
     if (sGapTable != NULL)
     {
         for (uint64_t i = 0; i < size; ++i)
@@ -764,21 +1185,76 @@ void HashTable::clear(uint64_t &peakMemory,uint64_t &currentMemory)
 
         }
         delete [] sGapTable;
+        sGapTable = NULL;
         currentMemory-=size*sizeof(uint64_t);
     }
     if (sMerTable != NULL){
         delete [] sMerTable;
+        sMerTable = NULL;
         currentMemory-=size*sizeof(uint64_t);
     }
 }
 
 /**
-  * Name:               recreateOfMaxSize(uint64_t &peakMemory, uint64_t &currentMemory)
+  * Name:               detach()
   *
-  * Description :       Recreate a hashTable as big as the largest hashTable created during runtime prior
+  * Description :       Moves the tables into a new HashTable; this one is left empty (as after clear)
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           sMerTable, sGapTable (or sGapValues)  owned by the returned HashTable
+  *       Return:
+  *           HashTable*                    the table of the current seed (freed with clear() and delete)
+  *
+  * Process Synopsis :
+  *
+  * Notes :             maxSize is kept, so recreateOfMaxSize works for the next seed.
+  *
+  */
+
+HashTable* HashTable::detach()
+{
+    HashTable* table = new HashTable(*this);       // takes over sMerTable, sGapTable, staticTable and bucketTable
+    sMerTable = NULL;
+    sGapTable = NULL;
+    sGapValues = NULL;
+    ownsSGapValues = false;
+    staticTable = NULL;
+    bucketTable = NULL;
+    return table;
+}
+
+// smallest prime >= n (trial division; n is at most a few billion)
+static uint64_t nextPrime(uint64_t n)
+{
+    for (n = max(n, (uint64_t)3) | 1; ; n += 2)
+    {
+        bool prime = true;
+        for (uint64_t d = 3; d * d <= n; d += 2)
+            if (n % d == 0)
+            {
+                prime = false;
+                break;
+            }
+        if (prime)
+            return n;
+    }
+}
+
+/**
+  * Name:               buildStaticTable(uint64_t sMerMask, uint64_t& peakMemory, uint64_t& currentMemory)
+  *
+  * Description :       Replaces the table by a StaticTable (minimal perfect hash) of its non-ambiguous sMers
   *
   * Input :
   *       Parameters:
+  *           uint64_t  sMerMask            sMer bits, aligned right (seed.getSMerMaskRC())
   *           uint64_t  &peakMemory         Peak memory of program
   *           uint64_t  &currentMemory      Current memory of program
   *
@@ -787,49 +1263,240 @@ void HashTable::clear(uint64_t &peakMemory,uint64_t &currentMemory)
   *           uint64_t  &peakMemory         peakMemory is recorded and estimated for testing
   *           uint64_t  &currentMemory      currentMemory is recorded and estimated for testing
   *       Memory:
-  *           HashTable                     HashTable is fully deallocated from memory
+  *           sMerTable and sGapTable are freed (or dropped, for a table read from an index)
   *       Return:
   *           None
   *
   * Process Synopsis :
-  *                     [1]  Recalls the largest hashTable size created since start of runtime and allocates memory for it
+  *                     [1]  Collect sMer | correct sGap | score << 56 of each non-ambiguous sMer
+  *                     [2]  Build the StaticTable; free the open addressing table
   *
-  * Notes :             
+  * Notes :             Must be called after removeAmbigSMers; ambiguous sMers are simply left out
+  *                     (correctBinaryReadFast does not tell them from sMers not in the table).
   *
   */
 
-void HashTable::recreateOfMaxSize(uint64_t &peakMemory, uint64_t &currentMemory)
+void HashTable::buildStaticTable(uint64_t sMerMask, uint64_t& peakMemory, uint64_t& currentMemory)
 {
-    size = maxSize;
-    cout << "Recreate hash table of maxSize:  " << size << endl;
-    // allocate memory, initialize with 0
-    numberOfElements = 0;
-
-    sMerTable = new Element[size];
+    uint64_t numberOfKeys = 0;
+    for (uint64_t i = 0; i < size; ++i)
+        if ((sMerTable[i].value != EMPTY) && (sMerTable[i].value != REMOVED) && (sMerTable[i].count < 255))
+            ++numberOfKeys;
+    uint64_t* entries = new uint64_t[numberOfKeys + 1];
+    uint64_t k = 0;
     for (uint64_t i = 0; i < size; ++i)
+        if ((sMerTable[i].value != EMPTY) && (sMerTable[i].value != REMOVED) && (sMerTable[i].count < 255))
+        {
+            const Element& tableSGap = (sGapValues != NULL) ? sGapValues[i] : sGapTable[i][0];
+            if ((tableSGap.value & sMerMask) || (sMerTable[i].value & ~sMerMask))
+            {
+                throw QuessError("Static table: sMer and sGap bits overlap (seed not a palindrome?)");
+            }
+            entries[k++] = (uint64_t)sMerTable[i].value | (uint64_t)tableSGap.value | ((uint64_t)tableSGap.count << 56);
+        }
+    currentMemory += (numberOfKeys + 1) * sizeof(uint64_t);
+    StaticTable* table = new StaticTable(entries, numberOfKeys, sMerMask);
+    currentMemory += table->memoryUsage();
+    if (currentMemory > peakMemory)
     {
-        sMerTable[i].count = 0;
-        sMerTable[i].value = EMPTY;
+        peakMemory = currentMemory;
+#ifdef VERBOSE
+        quessLog << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
+#endif
     }
-    sGapTable = NULL;
+    delete [] entries;
+    currentMemory -= (numberOfKeys + 1) * sizeof(uint64_t);
+    clear(peakMemory, currentMemory);       // free the open addressing table
+    staticTable = table;
+}
 
-    currentMemory+=size*sizeof(uint64_t);
+/**
+  * Name:               buildBucketTable(uint64_t& peakMemory, uint64_t& currentMemory)
+  *
+  * Description :       Replaces the table by a BucketTable of its non-ambiguous sMers
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t  &peakMemory         Peak memory of program
+  *           uint64_t  &currentMemory      Current memory of program
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           uint64_t  &peakMemory         peakMemory is recorded and estimated for testing
+  *           uint64_t  &currentMemory      currentMemory is recorded and estimated for testing
+  *       Memory:
+  *           sMerTable and sGapTable are freed (or dropped, for a table read from an index)
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  Collect each non-ambiguous sMer and its entry: correct sGap | score << 56
+  *                     [2]  Build the BucketTable; free the open addressing table
+  *
+  * Notes :             Must be called after removeAmbigSMers; ambiguous sMers are left out, as for the StaticTable
+  *                     (the score of a non-ambiguous sMer may be 255, so it cannot mark them). Unlike the StaticTable,
+  *                     the seeds may be longer than 26.
+  *
+  */
+
+void HashTable::buildBucketTable(uint64_t& peakMemory, uint64_t& currentMemory)
+{
+    uint64_t numberOfKeys = 0;
+    for (uint64_t i = 0; i < size; ++i)
+        if ((sMerTable[i].value != EMPTY) && (sMerTable[i].value != REMOVED) && (sMerTable[i].count < 255))
+            ++numberOfKeys;
+    uint64_t* keys = new uint64_t[numberOfKeys + 1];
+    uint64_t* entries = new uint64_t[numberOfKeys + 1];
+    uint64_t k = 0;
+    for (uint64_t i = 0; i < size; ++i)
+        if ((sMerTable[i].value != EMPTY) && (sMerTable[i].value != REMOVED) && (sMerTable[i].count < 255))
+        {
+            const Element& tableSGap = (sGapValues != NULL) ? sGapValues[i] : sGapTable[i][0];
+            keys[k] = sMerTable[i].value;
+            entries[k++] = (uint64_t)tableSGap.value | ((uint64_t)tableSGap.count << 56);
+        }
+    currentMemory += 2 * (numberOfKeys + 1) * sizeof(uint64_t);
+    BucketTable* table = new BucketTable(keys, entries, numberOfKeys);
+    currentMemory += table->memoryUsage();
     if (currentMemory > peakMemory)
-    {   
+    {
         peakMemory = currentMemory;
 #ifdef VERBOSE
-        cout << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
+        quessLog << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
 #endif
     }
+    delete [] keys;
+    delete [] entries;
+    currentMemory -= 2 * (numberOfKeys + 1) * sizeof(uint64_t);
+    clear(peakMemory, currentMemory);       // free the open addressing table
+    bucketTable = table;
 }
 
 /**
-  * Name:               recreateOfDoubleSize(uint64_t &peakMemory, uint64_t &currentMemory)
+  * Name:               writeIndex(ofstream& file)
   *
-  * Description :       Recreate a hashTable of double size of the current hashTable
+  * Description :       Writes the model of the table to a correction index
+  *
+  * Input :
+  *       Parameters:
+  *           ofstream& file                the index, positioned where the arrays go
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           ofstream& file                the sMer table (Element[indexSize]) followed by the sGap array (Element[indexSize])
+  *       Memory:
+  *           None
+  *       Return:
+  *           uint64_t                      indexSize, the size of the table written
+  *
+  * Process Synopsis :
+  *                     [1]  indexSize = smallest prime >= 1.7 x the number of non-ambiguous sMers (an ambiguous sMer
+  *                          and an sMer not in the table are treated alike by the correction, as with the StaticTable)
+  *                     [2]  Rehash the sMers (with their counts) into a table of indexSize with findPos, and their correct
+  *                          sGap (count = score; 0 where the sMer has none) to the same positions
+  *                     [3]  Write both arrays
+  *
+  * Notes :             Must be called after removeAmbigSMers (one sGap per sMer). The counting table sizes (hashTableSizes)
+  *                     start at 1769627, far above the number of sMers of a small genome: written as it is, the table
+  *                     would be mostly EMPTY positions. The mapped table is read with findPos, like any other.
+  *
+  */
+
+uint64_t HashTable::writeIndex(ofstream& file)
+{
+    uint64_t numberOfSMers = 0;
+    for (uint64_t i = 0; i < size; ++i)
+        if ((sMerTable[i].value != EMPTY) && (sMerTable[i].value != REMOVED) && (sMerTable[i].count < 255))
+            ++numberOfSMers;
+    uint64_t indexSize = nextPrime((uint64_t)(1.7 * numberOfSMers) + 1);
+    Element* indexSMers = new Element[indexSize];
+    Element* indexSGaps = new Element[indexSize];
+    for (uint64_t i = 0; i < indexSize; ++i)
+    {
+        indexSMers[i].count = 0;
+        indexSMers[i].value = EMPTY;
+        indexSGaps[i].count = 0;
+        indexSGaps[i].value = 0;
+    }
+    uint64_t place = 0;
+    for (uint64_t i = 0; i < size; ++i)
+        if ((sMerTable[i].value != EMPTY) && (sMerTable[i].value != REMOVED) && (sMerTable[i].count < 255))
+        {
+            findPos(indexSMers, indexSize, sMerTable[i].value, place);
+            indexSMers[place] = sMerTable[i];
+            if (sGapValues != NULL)     // table of createFromModel
+                indexSGaps[place] = sGapValues[i];
+            else if ((sGapTable != NULL) && (sGapTable[i] != NULL))
+                indexSGaps[place] = sGapTable[i][0];
+        }
+    file.write((const char*)indexSMers, indexSize * sizeof(Element));
+    file.write((const char*)indexSGaps, indexSize * sizeof(Element));
+    delete [] indexSMers;
+    delete [] indexSGaps;
+    return indexSize;
+}
+
+/**
+  * Name:               writeModel(ofstream& file)
+  *
+  * Description :       Spills the model of the table (one partition of the sMers) to a model file
+  *
+  * Input :
+  *       Parameters:
+  *           ofstream& file                the model file, positioned at its end
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           ofstream& file                for each sMer of the table: its Element of sMerTable followed by its correct
+  *                                         sGap (count = score; 0 for ambiguous sMers)
+  *       Memory:
+  *           None
+  *       Return:
+  *           uint64_t                      number of pairs written
+  *
+  * Process Synopsis :
+  *
+  * Notes :             Must be called after removeAmbigSMers (one sGap per sMer). Unlike writeIndex, the empty
+  *                     positions are not written: the pairs of all partitions are rehashed by createFromModel.
+  *
+  */
+
+uint64_t HashTable::writeModel(ofstream& file)
+{
+    const uint64_t chunk = 1 << 19;
+    Element* pairs = new Element[2 * chunk];
+    uint64_t numberOfPairs = 0, used = 0;
+    for (uint64_t i = 0; i < size; ++i)
+    {
+        if ((sMerTable[i].value == EMPTY) || (sMerTable[i].value == REMOVED))
+            continue;
+        pairs[2 * used] = sMerTable[i];
+        pairs[2 * used + 1].count = 0;
+        pairs[2 * used + 1].value = 0;
+        if ((sGapTable != NULL) && (sGapTable[i] != NULL) && (sMerTable[i].count < 255))
+            pairs[2 * used + 1] = sGapTable[i][0];
+        if (++used == chunk)
+        {
+            file.write((const char*)pairs, 2 * used * sizeof(Element));
+            numberOfPairs += used;
+            used = 0;
+        }
+    }
+    file.write((const char*)pairs, 2 * used * sizeof(Element));
+    numberOfPairs += used;
+    delete [] pairs;
+    return numberOfPairs;
+}
+
+/**
+  * Name:               createFromModel(ifstream& file, uint64_t numberOfPairs, uint64_t &peakMemory, uint64_t &currentMemory)
+  *
+  * Description :       Creates the model of a seed from the pairs spilled by writeModel (all partitions)
   *
   * Input :
   *       Parameters:
+  *           ifstream& file                the model file, positioned at the first pair
+  *           uint64_t  numberOfPairs       pairs to read
   *           uint64_t  &peakMemory         Peak memory of program
   *           uint64_t  &currentMemory      Current memory of program
   *
@@ -838,36 +1505,128 @@ void HashTable::recreateOfMaxSize(uint64_t &peakMemory, uint64_t &currentMemory)
   *           uint64_t  &peakMemory         peakMemory is recorded and estimated for testing
   *           uint64_t  &currentMemory      currentMemory is recorded and estimated for testing
   *       Memory:
-  *           HashTable                     A new HashTable of twice the original size will be created
+  *           Element*  sMerTable, sGapValues   new arrays of approximately 1.7 times numberOfPairs (the table must be cleared)
   *       Return:
   *           None
   *
   * Process Synopsis :
-  *                     [1]  Recalls the largest hashTable size created since start of runtime and allocates memory for it
+  *                     [1]  Allocate sMerTable and sGapValues, as the arrays of a correction index
+  *                     [2]  Insert each pair at the position of its sMer
   *
-  * Notes :             Assumes that the old hashTable will be taken care of.
+  * Notes :             The lookups (getCorrectSGap) give the same answers as the table of all sMers after
+  *                     removeAmbigSMers. maxSize is not changed, so recreateOfMaxSize works for the next seed.
   *
   */
 
-void HashTable::recreateOfDoubleSize(uint64_t &peakMemory, uint64_t &currentMemory)
+void HashTable::createFromModel(ifstream& file, uint64_t numberOfPairs, uint64_t &peakMemory, uint64_t &currentMemory)
 {
-    // get new size
-    size = maxSize = getNewSize(2 * maxSize);
-    cout << "Recreate hash table of double size:  " << size << endl;
-    // allocate memory, initialize with 0
-    numberOfElements = 0;
+    size = getNewSize((uint64_t)(1.7 * numberOfPairs));
+    quessLog << "Model sMers: " << numberOfPairs << "; Hash them to size: " << size << endl;
+    numberOfElements = numberOfPairs;
     sMerTable = new Element[size];
+    sGapValues = new Element[size];
+    ownsSGapValues = true;
     for (uint64_t i = 0; i < size; ++i)
     {
         sMerTable[i].count = 0;
         sMerTable[i].value = EMPTY;
+        sGapValues[i].count = 0;
+        sGapValues[i].value = 0;
     }
-    currentMemory+=size*sizeof(uint64_t);
+    currentMemory+=2*size*sizeof(Element);
     if (currentMemory > peakMemory)
-    {   
+    {
         peakMemory = currentMemory;
 #ifdef VERBOSE
-        cout << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
+        quessLog << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
 #endif
     }
+    const uint64_t chunk = 1 << 19;
+    Element* pairs = new Element[2 * chunk];
+    uint64_t place = 0;
+    for (uint64_t start = 0; start < numberOfPairs; start += chunk)
+    {
+        uint64_t used = min(chunk, numberOfPairs - start);
+        if (!file.read((char*)pairs, 2 * used * sizeof(Element)))
+        {
+            throw QuessError("Cannot read the model file (truncated)");
+        }
+        for (uint64_t i = 0; i < used; ++i)
+        {
+            findPos(sMerTable, size, pairs[2 * i].value, place);
+            sMerTable[place] = pairs[2 * i];
+            sGapValues[place] = pairs[2 * i + 1];
+        }
+    }
+    delete [] pairs;
+}
+
+/**
+  * Name:               recreateOfMaxSize(uint64_t &peakMemory, uint64_t &currentMemory)
+  *
+  * Description :       Recreate a hashTable as big as the largest hashTable created during runtime prior
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t  &peakMemory         Peak memory of program
+  *           uint64_t  &currentMemory      Current memory of program
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           uint64_t  &peakMemory         peakMemory is recorded and estimated for testing
+  *           uint64_t  &currentMemory      currentMemory is recorded and estimated for testing
+  *       Memory:
+  *           HashTable                     HashTable is fully deallocated from memory
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  Recalls the largest hashTable size created since start of runtime and allocates memory for it
+  *
+  * Notes :             A NarrowTable or CompactTable when the sMers fit (allocateCountingTable).
+  *
+  */
+
+void HashTable::recreateOfMaxSize(uint64_t &peakMemory, uint64_t &currentMemory)
+{
+    size = maxSize;
+    quessLog << "Recreate hash table of maxSize:  " << size << endl;
+    // allocate memory, initialize with 0
+    allocateCountingTable(peakMemory, currentMemory);
+}
+
+/**
+  * Name:               recreateOfDoubleSize(uint64_t &peakMemory, uint64_t &currentMemory)
+  *
+  * Description :       Recreate a hashTable of double size of the current hashTable
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t  &peakMemory         Peak memory of program
+  *           uint64_t  &currentMemory      Current memory of program
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           uint64_t  &peakMemory         peakMemory is recorded and estimated for testing
+  *           uint64_t  &currentMemory      currentMemory is recorded and estimated for testing
+  *       Memory:
+  *           HashTable                     A new HashTable of twice the original size will be created
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  Recalls the largest hashTable size created since start of runtime and allocates memory for it
+  *
+  * Notes :             Assumes that the old hashTable will be taken care of. A NarrowTable or CompactTable
+  *                     when the sMers fit (allocateCountingTable).
+  *
+  */
+
+void HashTable::recreateOfDoubleSize(uint64_t &peakMemory, uint64_t &currentMemory)
+{
+    // get new size
+    size = maxSize = getNewSize(2 * maxSize);
+    quessLog << "Recreate hash table of double size:  " << size << endl;
+    // allocate memory, initialize with 0
+    allocateCountingTable(peakMemory, currentMemory);
 }
@@ -0,0 +1,328 @@
+/**
+  * File:     index.cpp
+  *
+  * Author1:  Lucian Ilie (ilie@uwo.ca)
+  * Author2:  Stephen Lu (slu93@uwo.ca)
+  *
+  *   This file contains the correction index of QUESS. After
+  *   removeAmbigSMers the hash table of a seed is only read:
+  *   each sMer has its correct sGap and score. The tables of all
+  *   seeds are saved in one file which is later mapped in memory,
+  *   so reads of the same genome can be corrected without
+  *   building the model again.
+  *
+  */
+
+#include "QUESS.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+
+/**
+  * Name:               CorrectionIndex()
+  *
+  * Description :       Constructor; no index written or mapped
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :
+  *
+  */
+
+CorrectionIndex::CorrectionIndex()
+{
+    memset(&header, 0, sizeof(IndexHeader));
+    map = NULL;
+    mapLength = 0;
+}
+
+CorrectionIndex::~CorrectionIndex()
+{
+    close();
+}
+
+/**
+  * Name:               create(const char* fileName, uint64_t genomeLength, int weight, int numberOfSeeds, int Tc)
+  *
+  * Description :       Starts writing an index
+  *
+  * Input :
+  *       Parameters:
+  *           const char* fileName          index file
+  *           uint64_t  genomeLength        parameters of the model, stored in the header
+  *           int       weight
+  *           int       numberOfSeeds
+  *           int       Tc
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           bool                          false if the file cannot be created
+  *
+  * Process Synopsis :
+  *                     [1]  The header is filled in memory; its place in the file is left empty (zeros) until finish
+  *
+  * Notes :
+  *
+  */
+
+bool CorrectionIndex::create(const char* fileName, uint64_t genomeLength, int weight, int numberOfSeeds, int Tc)
+{
+    memset(&header, 0, sizeof(IndexHeader));
+    memcpy(header.magic, INDEX_MAGIC, 8);
+    header.version = INDEX_VERSION;
+    header.elementSize = sizeof(Element);
+    header.byteOrder = INDEX_BYTE_ORDER;
+    header.genomeLength = genomeLength;
+    header.weight = weight;
+    header.numberOfSeeds = numberOfSeeds;
+    header.Tc = Tc;
+    header.seedsWritten = 0;
+    file.open(fileName, ios::out | ios::binary | ios::trunc);
+    if (!file.is_open())
+        return false;
+    IndexHeader empty;
+    memset(&empty, 0, sizeof(IndexHeader));
+    file.write((const char*)&empty, sizeof(IndexHeader));
+    return file.good();
+}
+
+/**
+  * Name:               addSeed(HashTable& H, const char* seed)
+  *
+  * Description :       Appends the model of the next seed
+  *
+  * Input :
+  *       Parameters:
+  *           HashTable& H                  hash table of the seed, after removeAmbigSMers
+  *           const char* seed              the seed
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  Pad the file to INDEX_ALIGNMENT; H.writeIndex writes its two arrays (rehashed to the
+  *                          size of its sMers, which is recorded)
+  *
+  * Notes :
+  *
+  */
+
+void CorrectionIndex::addSeed(HashTable& H, const char* seed)
+{
+    if ((header.seedsWritten >= header.numberOfSeeds) || (strlen(seed) >= INDEX_SEED_LENGTH))
+    {
+        throw QuessError("Cannot add seed " + string(seed) + " to the correction index");
+    }
+    IndexSeedEntry& entry = header.seeds[header.seedsWritten];
+    static const char zeros[INDEX_ALIGNMENT] = {0};
+    uint64_t offset = (uint64_t)file.tellp();
+    if (offset % INDEX_ALIGNMENT != 0)
+    {
+        file.write(zeros, INDEX_ALIGNMENT - offset % INDEX_ALIGNMENT);
+        offset += INDEX_ALIGNMENT - offset % INDEX_ALIGNMENT;
+    }
+    strcpy(entry.seed, seed);
+    entry.tableSize = H.writeIndex(file);
+    entry.sMerOffset = offset;
+    entry.sGapOffset = offset + entry.tableSize * sizeof(Element);
+    ++header.seedsWritten;
+    quessLog << "Seed " << seed << " added to the correction index (" << (2 * entry.tableSize * sizeof(Element)) / 1048576 << " MB)" << endl;
+}
+
+/**
+  * Name:               finish()
+  *
+  * Description :       Writes the header and closes the index
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           bool                          false on write error
+  *
+  * Process Synopsis :
+  *
+  * Notes :             Only a complete index (all seeds) gets its header.
+  *
+  */
+
+bool CorrectionIndex::finish()
+{
+    if (header.seedsWritten == header.numberOfSeeds)
+    {
+        file.seekp(0);
+        file.write((const char*)&header, sizeof(IndexHeader));
+    }
+    bool good = file.good() && (header.seedsWritten == header.numberOfSeeds);
+    file.close();
+    return good;
+}
+
+/**
+  * Name:               open(const char* fileName)
+  *
+  * Description :       Maps an index in memory and checks its header
+  *
+  * Input :
+  *       Parameters:
+  *           const char* fileName          index file
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           the file is mapped read-only (page cache; shared by processes using the same index)
+  *       Return:
+  *           None                          QuessError if the index cannot be used
+  *
+  * Process Synopsis :
+  *                     [1]  Map the file
+  *                     [2]  Check magic, version, Element size, byte order, and that all arrays lie in the file
+  *
+  * Notes :
+  *
+  */
+
+void CorrectionIndex::open(const char* fileName)
+{
+    close();
+    int fd = ::open(fileName, O_RDONLY);
+    if (fd < 0)
+        throw QuessError("Cannot open correction index: " + string(fileName));
+    struct stat st;
+    if ((fstat(fd, &st) != 0) || ((uint64_t)st.st_size < sizeof(IndexHeader)))
+    {
+        ::close(fd);
+        throw QuessError("Not a correction index (too short): " + string(fileName));
+    }
+    mapLength = st.st_size;
+    void* address = mmap(NULL, mapLength, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED)
+    {
+        mapLength = 0;
+        throw QuessError("Cannot map correction index: " + string(fileName));
+    }
+    map = (char*)address;
+    memcpy(&header, map, sizeof(IndexHeader));
+    const char* problem = NULL;
+    if (memcmp(header.magic, INDEX_MAGIC, 8) != 0)
+        problem = "not a correction index, or incomplete";
+    else if (header.version != INDEX_VERSION)
+        problem = "written by another version of QUESS";
+    else if ((header.elementSize != sizeof(Element)) || (header.byteOrder != INDEX_BYTE_ORDER))
+        problem = "written on an incompatible machine";
+    else if ((header.numberOfSeeds < 1) || (header.numberOfSeeds > INDEX_MAX_SEEDS) || (header.seedsWritten != header.numberOfSeeds))
+        problem = "wrong number of seeds";
+    for (int i = 0; (problem == NULL) && (i < header.numberOfSeeds); ++i)
+    {
+        IndexSeedEntry& entry = header.seeds[i];
+        uint64_t arrayLength = entry.tableSize * sizeof(Element);
+        if ((entry.tableSize == 0) || (entry.seed[INDEX_SEED_LENGTH - 1] != '\0')
+            || (entry.sMerOffset % sizeof(Element) != 0) || (entry.sGapOffset % sizeof(Element) != 0)
+            || (entry.sMerOffset + arrayLength > mapLength) || (entry.sGapOffset + arrayLength > mapLength))
+            problem = "truncated or damaged";
+    }
+    if (problem != NULL)
+    {
+        close();
+        throw QuessError("Cannot use correction index " + string(fileName) + ": " + problem);
+    }
+    madvise(map, mapLength, MADV_WILLNEED);     // lookups are random; read the tables ahead
+    quessLog << "Correction index " << fileName << ": " << header.numberOfSeeds << " seeds, weight " << header.weight << ", " << mapLength / 1048576 << " MB" << endl;
+}
+
+uint64_t CorrectionIndex::getGenomeLength()
+{
+    return header.genomeLength;
+}
+
+int CorrectionIndex::getWeight()
+{
+    return header.weight;
+}
+
+int CorrectionIndex::getNumberOfSeeds()
+{
+    return header.numberOfSeeds;
+}
+
+int CorrectionIndex::getTc()
+{
+    return header.Tc;
+}
+
+const char* CorrectionIndex::getSeed(int seedNumber)
+{
+    return header.seeds[seedNumber].seed;
+}
+
+/**
+  * Name:               getTable(int seedNumber)
+  *
+  * Description :       Returns a read-only HashTable over the mapped arrays of a seed
+  *
+  * Input :
+  *       Parameters:
+  *           int       seedNumber          0 .. numberOfSeeds - 1
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           HashTable object only (the arrays stay in the mapping)
+  *       Return:
+  *           HashTable*                    freed with clear() and delete, before close()
+  *
+  * Process Synopsis :
+  *
+  * Notes :
+  *
+  */
+
+HashTable* CorrectionIndex::getTable(int seedNumber)
+{
+    IndexSeedEntry& entry = header.seeds[seedNumber];
+    return new HashTable((Element*)(map + entry.sMerOffset), (Element*)(map + entry.sGapOffset), entry.tableSize);
+}
+
+void CorrectionIndex::close()
+{
+    if (file.is_open())
+        file.close();
+    if (map != NULL)
+    {
+        munmap(map, mapLength);
+        map = NULL;
+        mapLength = 0;
+    }
+}
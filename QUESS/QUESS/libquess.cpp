@@ -0,0 +1,1633 @@
+/**
+  * File:     libquess.cpp
+  *
+  * Author1:  Lucian Ilie (ilie@uwo.ca)
+  * Author2:  Stephen Lu (slu93@uwo.ca)
+  *
+  *   This file contains the QuessCorrector class, the library
+  *   interface of QUESS (libquess.h). It runs the same steps as
+  *   the former main(): working files, seeds, and for each seed
+  *   insertion of sMers and sGaps, removal of ambiguous sMers and
+  *   correction. The reads may come from a dataset or from memory;
+  *   the model of each seed may be kept to correct further reads
+  *   in memory.
+  *
+  */
+
+#include "QUESS.h"
+#include "libquess.h"
+#include <unistd.h>
+
+
+/**
+  * Name:               LogBuffer
+  *
+  * Description :       Stream buffer of quessLog: to the current buffer of cout, to the logger of setLogger
+  *                     one line at a time, or nowhere (setVerbose(false))
+  *
+  * Notes :             cout is looked up at each write, so a redirection of cout (main with -o -, the ranks > 0
+  *                     of QUESS_mpi) also applies to quessLog.
+  *
+  */
+
+static void (*logFunction)(const char* line, void* context) = NULL;
+static void* logContext = NULL;
+static bool verboseLog = true;
+
+class LogBuffer : public streambuf
+{
+private:
+    string line;
+
+protected:
+    int overflow(int c)
+    {
+        if ((c == EOF) || !verboseLog)
+            return 0;
+        if (logFunction == NULL)
+            return cout.rdbuf()->sputc((char)c);
+        if (c == '\n')
+        {
+            logFunction(line.c_str(), logContext);
+            line.clear();
+        }
+        else
+            line += (char)c;
+        return c;
+    }
+
+    streamsize xsputn(const char* data, streamsize length)
+    {
+        if (verboseLog && (logFunction == NULL))
+            return cout.rdbuf()->sputn(data, length);
+        for (streamsize i = 0; i < length; ++i)
+            overflow((unsigned char)data[i]);
+        return length;
+    }
+
+    int sync()
+    {
+        return (verboseLog && (logFunction == NULL)) ? cout.rdbuf()->pubsync() : 0;
+    }
+};
+
+static LogBuffer logBuffer;
+ostream quessLog(&logBuffer);
+
+/**
+  * Name:               setLogger(void (*logger)(const char* line, void* context), void* context)
+  *
+  * Description :       Sends the progress messages of the library to logger, one line at a time
+  *
+  * Input :
+  *       Parameters:
+  *           logger                        function called for each line (without '\n'); NULL = standard output
+  *           void*     context             passed to logger
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :             A line not ended when the logger is changed is dropped.
+  *
+  */
+
+void setLogger(void (*logger)(const char* line, void* context), void* context)
+{
+    quessLog.flush();
+    logFunction = logger;
+    logContext = context;
+}
+
+/**
+  * Name:               setVerbose(bool verbose)
+  *
+  * Description :       Turns the progress messages of the library on or off
+  *
+  * Input :
+  *       Parameters:
+  *           bool      verbose             false = no messages
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :
+  *
+  */
+
+void setVerbose(bool verbose)
+{
+    quessLog.flush();
+    verboseLog = verbose;
+}
+
+
+/**
+  * Name:               QuessCorrector(uint64_t genomeLength, int weight, int numberOfSeeds)
+  *
+  * Description :       Constructor; no read source yet
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t  genomeLength        approximate length of the genome
+  *           int       weight              seed weight 10-26; 0 = chosen from the total read length
+  *           int       numberOfSeeds       1-8
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           file names (9 * 10000 chars)
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :
+  *
+  */
+
+QuessCorrector::QuessCorrector(uint64_t genomeLength, int weight, int numberOfSeeds)
+{
+    this->genomeLength = genomeLength;
+    this->weight = weight;
+    this->numberOfSeeds = numberOfSeeds;
+    keepTables = false;
+    staticTables = false;
+    bucketTables = false;
+    compactTables = false;
+    shardedCounting = false;
+    datasetName = new char[10000];
+    inputTempFileName = new char[10000];
+    outputTempFileName = new char[10000];
+    outputFileName = new char[10000];
+    spoolFileName = new char[10000];
+    modelFileName = new char[10000];
+    checkpointFileName = new char[10000];
+    indexFileName = new char[10000];
+    shardFileName = new char[10000];
+    qualityFileName = new char[10000];
+    datasetName[0] = inputTempFileName[0] = outputTempFileName[0] = outputFileName[0] = spoolFileName[0] = modelFileName[0] = checkpointFileName[0] = indexFileName[0] = shardFileName[0] = qualityFileName[0] = '\0';
+    shard = numberOfShards = 0;
+    maxMemory = numberOfPartitions = modelPartitions = 0;
+    resume = false;
+    resumedSeeds = 0;
+    convergence = 0;
+    skipSolid = false;
+    solidReads = NULL;
+    qualitySkip = 0;
+    normalizeCoverage = 0;
+    modelReads = NULL;
+    readsFile = NULL;
+    outputFile = new DatasetWriter;
+    numberOfReads = totalReadLength = readLength = 0;
+    seeds = NULL;
+    Tc = 8;
+    bucketSize = 0;
+    H = NULL;
+    tables = NULL;
+    shards = NULL;
+    index = NULL;
+    indexLoaded = false;
+    seedsDone = 0;
+    peakMemory = currentMemory = 10*10000*sizeof(char);
+}
+
+/**
+  * Name:               ~QuessCorrector()
+  *
+  * Description :       Destructor; frees the tables and removes the working files left
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           all deallocated
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :             The working files are normally removed by swapFiles and createOutputFile/getCorrectedReads.
+  *                     The checkpoint manifest is kept only if the process is killed.
+  *
+  */
+
+QuessCorrector::~QuessCorrector()
+{
+    if (readsFile != NULL)
+    {
+        readsFile->close();
+        delete readsFile;
+        remove(inputTempFileName);
+    }
+    if ((seedsDone > 0) && (outputTempFileName[0] != '\0'))
+        remove(outputTempFileName);
+    if (seedsDone < numberOfSeeds)
+        remove(inputTempFileName);
+    if (spoolFileName[0] != '\0')
+        remove(spoolFileName);
+    if (modelFileName[0] != '\0')
+        remove(modelFileName);
+    if (checkpointFileName[0] != '\0')
+        remove(checkpointFileName);
+    if (shardFileName[0] != '\0')
+        remove(shardFileName);
+    if (qualityFileName[0] != '\0')
+        remove(qualityFileName);
+    if (H != NULL)
+    {
+        H->clear(peakMemory, currentMemory);
+        delete H;
+    }
+    if (tables != NULL)
+    {
+        for (int64_t i = 0; i < numberOfSeeds; ++i)
+            if (tables[i] != NULL)
+            {
+                tables[i]->clear(peakMemory, currentMemory);
+                delete tables[i];
+            }
+        delete [] tables;
+    }
+    if (shards != NULL)
+    {
+        currentMemory -= shards->memoryUsage();
+        delete shards;
+    }
+    delete index;           // after the tables mapped from it
+    if (seeds != NULL)
+    {
+        for (int64_t i = 0; i < numberOfSeeds; ++i)
+            delete [] seeds[i];
+        delete [] seeds;
+    }
+    delete [] solidReads;
+    delete [] modelReads;
+    delete outputFile;
+    delete [] datasetName;
+    delete [] inputTempFileName;
+    delete [] outputTempFileName;
+    delete [] outputFileName;
+    delete [] spoolFileName;
+    delete [] modelFileName;
+    delete [] checkpointFileName;
+    delete [] indexFileName;
+    delete [] shardFileName;
+    delete [] qualityFileName;
+}
+
+/**
+  * Name:               setCompression(const char* name)
+  *
+  * Description :       Selects the compression of the output file
+  *
+  * Input :
+  *       Parameters:
+  *           const char* name              "bgzf", "gzip", "zstd" or "none"
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           bool                          false if name is unknown
+  *
+  * Process Synopsis :
+  *
+  * Notes :             Must be called before setDataset (the extension is added to the output name).
+  *
+  */
+
+bool QuessCorrector::setCompression(const char* name)
+{
+    return outputFile->setCompression(name);
+}
+
+/**
+  * Name:               setKeepTables(bool keep)
+  *
+  * Description :       Keeps the model of every seed for correctBatch
+  *
+  * Input :
+  *       Parameters:
+  *           bool      keep                true to keep the tables
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :             Memory grows with one (reduced) hash table per seed.
+  *
+  */
+
+void QuessCorrector::setKeepTables(bool keep)
+{
+    keepTables = keep;
+}
+
+/**
+  * Name:               setSeeds(const std::vector<std::string>& seeds)
+  *
+  * Description :       Uses the given seeds instead of the precomputed seeds of the weight (getSeed)
+  *
+  * Input :
+  *       Parameters:
+  *           const std::vector<std::string>& seeds   1-8 seeds of the same weight (isValidSeed)
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           seeds, weight and numberOfSeeds are set
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  Check every seed (isValidSeed) and their weights
+  *                     [2]  Copy them; prepare then skips getSeed
+  *
+  * Notes :             For heavier and longer seeds than those precomputed (weight 10-26, length at most 26),
+  *                     e.g. for large repetitive genomes; seeds longer than 26 use 128-bit windows (Seed::isWide).
+  *                     Must be called before the first seed and not with loadIndex.
+  *
+  */
+
+void QuessCorrector::setSeeds(const std::vector<std::string>& seeds)
+{
+    if ((seeds.size() < 1) || (seeds.size() > INDEX_MAX_SEEDS) || (this->seeds != NULL))
+    {
+        throw QuessError("QuessCorrector: 1 to " + to_string(INDEX_MAX_SEEDS) + " seeds must be given once, before the first seed");
+    }
+    int seedWeight = 0;
+    for (uint64_t i = 0; i < seeds.size(); ++i)
+    {
+        const char* problem;
+        if (!isValidSeed(seeds[i].c_str(), problem))
+        {
+            throw QuessError("QuessCorrector: seed " + string(seeds[i]) + ": " + problem);
+        }
+        int w = 0;
+        for (uint64_t j = 0; j < seeds[i].size(); ++j)
+            if (seeds[i][j] == '1')
+                ++w;
+        if ((i > 0) && (w != seedWeight))
+        {
+            throw QuessError("QuessCorrector: all seeds must have the same weight");
+        }
+        seedWeight = w;
+    }
+    weight = seedWeight;
+    numberOfSeeds = seeds.size();
+    this->seeds = new char*[numberOfSeeds];
+    for (int64_t i = 0; i < numberOfSeeds; ++i)
+    {
+        this->seeds[i] = new char[1000];
+        strcpy(this->seeds[i], seeds[i].c_str());
+    }
+}
+
+/**
+  * Name:               setStaticTables(bool use)
+  *
+  * Description :       Corrects with a minimal perfect hash table of each model
+  *
+  * Input :
+  *       Parameters:
+  *           bool      use                 true to build the static tables
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :             The static table is built after removeAmbiguousSMers (and after the model is added to a
+  *                     correction index); for a loaded index, by loadIndex, which is why it must be called before.
+  *
+  */
+
+void QuessCorrector::setStaticTables(bool use)
+{
+    staticTables = use;
+}
+
+/**
+  * Name:               setBucketTables(bool use)
+  *
+  * Description :       Corrects with a bucketized hash table of each model
+  *
+  * Input :
+  *       Parameters:
+  *           bool      use                 true to build the bucket tables
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :             Built where the static tables are (ignored with setStaticTables(true)); any seed length.
+  *
+  */
+
+void QuessCorrector::setBucketTables(bool use)
+{
+    bucketTables = use;
+}
+
+/**
+  * Name:               setCompactTables(bool use)
+  *
+  * Description :       Counts the sMers of each seed in a CompactTable
+  *
+  * Input :
+  *       Parameters:
+  *           bool      use                 true to count in compact tables
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :             The counting table takes 16 bytes per 3 positions instead of 24; a seed whose sMer
+  *                     remainders do not fit (small table, heavy seed) is counted in Elements. The models built
+  *                     afterwards are the usual tables.
+  *
+  */
+
+void QuessCorrector::setCompactTables(bool use)
+{
+    compactTables = use;
+}
+
+/**
+  * Name:               setShardedCounting(bool use)
+  *
+  * Description :       Counts the sMers and inserts the sGaps of each seed in shards owned by the threads
+  *
+  * Input :
+  *       Parameters:
+  *           bool      use                 true for sharded counting
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :             The ShardedCounter is created by prepare, with one shard per thread. With a memory budget
+  *                     (setMaxMemory) or setModelPartitions the usual tables are used.
+  *
+  */
+
+void QuessCorrector::setShardedCounting(bool use)
+{
+    shardedCounting = use;
+}
+
+/**
+  * Name:               setShard(int shard, int numberOfShards)
+  *
+  * Description :       Corrects only one of numberOfShards consecutive ranges of records of the dataset
+  *
+  * Input :
+  *       Parameters:
+  *           int       shard               1 .. numberOfShards
+  *           int       numberOfShards      number of shards
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :             Meant for a loaded index (loadIndex): each shard is corrected with the model of the whole
+  *                     dataset. The default output name is <prefix>_QUESS_corrected_shard<i>of<n>.<ext>.
+  *
+  */
+
+void QuessCorrector::setShard(int shard, int numberOfShards)
+{
+    if ((numberOfShards < 1) || (shard < 1) || (shard > numberOfShards) || (datasetName[0] != '\0') || (readsFile != NULL))
+    {
+        throw QuessError("QuessCorrector: shard " + to_string(shard) + "/" + to_string(numberOfShards) + " cannot be used");
+    }
+    this->shard = shard;
+    this->numberOfShards = numberOfShards;
+}
+
+/**
+  * Name:               setMaxMemory(uint64_t bytes)
+  *
+  * Description :       Sets a memory budget; the sizes are planned by planMemory before the first seed
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t  bytes               budget; 0 = none (the cgroup limit, if any, still applies)
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :             The models kept with setKeepTables(true) are not part of the plan.
+  *
+  */
+
+void QuessCorrector::setMaxMemory(uint64_t bytes)
+{
+    if (seedsDone > 0)
+    {
+        throw QuessError("QuessCorrector: setMaxMemory must be called before the first seed");
+    }
+    maxMemory = bytes;
+}
+
+/**
+  * Name:               setModelPartitions(int numberOfPartitions)
+  *
+  * Description :       Builds the model of each seed in partitions of the sMers, spilled to disk
+  *
+  * Input :
+  *       Parameters:
+  *           int       numberOfPartitions  1 or more (more are used if the table of a partition does not fit)
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :             Each partition reads the reads twice; the model file is next to the working files.
+  *
+  */
+
+void QuessCorrector::setModelPartitions(int numberOfPartitions)
+{
+    if ((seedsDone > 0) || (numberOfPartitions < 1))
+    {
+        throw QuessError("QuessCorrector: " + to_string(numberOfPartitions) + " model partitions cannot be used");
+    }
+    modelPartitions = numberOfPartitions;
+}
+
+/**
+  * Name:               setConvergence(double correctionsPerMillion)
+  *
+  * Description :       Adaptive seed schedule: stops when a seed corrects too few positions
+  *
+  * Input :
+  *       Parameters:
+  *           double    correctionsPerMillion   stop after a seed (from seed ADAPTIVE_MIN_SEEDS - 1 on) that writes fewer
+  *                                             corrections per million bases of reads; 0 = run all seeds
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :             Not applied with setKeepTables(true) or saveIndex, which need the models of all seeds.
+  *                     A seed with no read left with suspect positions also stops the run.
+  *
+  */
+
+void QuessCorrector::setConvergence(double correctionsPerMillion)
+{
+    convergence = correctionsPerMillion;
+}
+
+/**
+  * Name:               setNormalize(int coverage)
+  *
+  * Description :       Builds the models from a coverage-capped subset of the reads
+  *
+  * Input :
+  *       Parameters:
+  *           int       coverage            k-mer coverage of the reads kept (1 .. 254); 0 = all reads
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :             The subset is selected by prepare (selectModelReads) and Tc is computed from its number of
+  *                     reads (the effective coverage). Not with a loaded index (no models are built).
+  *
+  */
+
+void QuessCorrector::setNormalize(int coverage)
+{
+    normalizeCoverage = coverage;
+}
+
+/**
+  * Name:               setSkipSolid(bool skip)
+  *
+  * Description :       Skips the correction of reads found solid with an earlier seed
+  *
+  * Input :
+  *       Parameters:
+  *           bool      skip                true to skip solid reads
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :             A read is solid when correctBinaryReadFast leaves no suspect position (all its sMers in the
+  *                     model, all its sGaps correct). Solid reads are still counted by insertSMers and insertSGaps;
+  *                     correct copies them unchanged. The later seeds may then miss a few corrections in them.
+  *                     The bitmap (1 bit per read) is not saved in checkpoints: a resumed run probes all reads again.
+  *
+  */
+
+void QuessCorrector::setSkipSolid(bool skip)
+{
+    skipSolid = skip;
+}
+
+/**
+  * Name:               setQualitySkip(int minQuality)
+  *
+  * Description :       Skips the lookups of the windows of high quality
+  *
+  * Input :
+  *       Parameters:
+  *           int       minQuality          Phred score trusted (10 .. 93); 0 = all windows looked up
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :             The scores are kept in bins of QUALITY_BIN_WIDTH (createWorkingFiles), so minQuality is rounded
+  *                     down to a bin; scores of 30 and above share the last bin. Only FASTQ datasets have scores.
+  *                     Errors at high quality positions are not corrected, which may change the output.
+  *
+  */
+
+void QuessCorrector::setQualitySkip(int minQuality)
+{
+    if ((seedsDone > 0) || (datasetName[0] != '\0'))
+    {
+        throw QuessError("QuessCorrector: setQualitySkip must be called before setDataset");
+    }
+    qualitySkip = min(3, minQuality / QUALITY_BIN_WIDTH);
+}
+
+/**
+  * Name:               setResume(bool resume)
+  *
+  * Description :       Continues an interrupted run from its checkpoint
+  *
+  * Input :
+  *       Parameters:
+  *           bool      resume              true to resume
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :             setDataset then looks for the checkpoint (resumeFromCheckpoint); if there is none usable,
+  *                     the run starts over.
+  *
+  */
+
+void QuessCorrector::setResume(bool resume)
+{
+    this->resume = resume;
+}
+
+/**
+  * Name:               setDataset(const char* datasetName, const char* outputFileName)
+  *
+  * Description :       Uses a FASTA/FASTQ file as read source
+  *
+  * Input :
+  *       Parameters:
+  *           const char* datasetName       original dataset; "-" = standard input
+  *           const char* outputFileName    corrected dataset; NULL = derived from datasetName, "-" = standard output
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  With setShard: extractShard; the shard file is the dataset from now on
+  *                     [2]  With setResume: the working files of an interrupted run (resumeFromCheckpoint), if usable
+  *                     [3]  createWorkingFiles: copy of the reads and names of the working files
+  *
+  * Notes :
+  *
+  */
+
+void QuessCorrector::setDataset(const char* datasetName, const char* outputFileName)
+{
+    if ((seedsDone > 0) || (readsFile != NULL) || (this->datasetName[0] != '\0'))
+    {
+        throw QuessError("QuessCorrector: the read source is already set");
+    }
+    strcpy(this->datasetName, datasetName);
+    strcpy(this->outputFileName, (outputFileName != NULL) ? outputFileName : "");
+    if (numberOfShards > 0)     // the records of the shard become the dataset
+    {
+        extractShard(this->datasetName, shardFileName, this->outputFileName, *outputFile, shard, numberOfShards);
+        strcpy(this->datasetName, shardFileName);
+    }
+    if (resume && resumeFromCheckpoint())
+        return;
+    createWorkingFiles(inputTempFileName, outputTempFileName, this->datasetName, this->outputFileName, spoolFileName, (qualitySkip > 0) ? qualityFileName : NULL, *outputFile, numberOfReads, totalReadLength, peakMemory, currentMemory);
+    if ((spoolFileName[0] == '\0') && (numberOfShards == 0))     // a dataset file: checkpoints after each seed
+    {
+        sprintf(checkpointFileName, "%s.checkpoint", inputTempFileName);
+        remove(checkpointFileName);     // of an earlier run
+    }
+    quessLog << datasetName << endl;
+}
+
+/**
+  * Name:               resumeFromCheckpoint()
+  *
+  * Description :       Uses the working files of an interrupted run instead of creating them
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           bool                          false (with the reason) if the run must start over
+  *
+  * Process Synopsis :
+  *                     [1]  Name the working files (nameWorkingFiles) and read the checkpoint manifest
+  *                     [2]  Compare the options; check the dataset and the working file of the reads (verifyCheckpoint)
+  *                     [3]  Take the counts of reads and the weight from the manifest; runSeed continues with seed seedsDone
+  *
+  * Notes :             Not for standard input, shards or --save-index (the index would miss the seeds done).
+  *                     Tc is computed again from the same counts, so the remaining seeds run as they would have.
+  *
+  */
+
+bool QuessCorrector::resumeFromCheckpoint()
+{
+    const char* problem = NULL;
+    Checkpoint checkpoint;
+    if ((strcmp(datasetName, "-") == 0) || (numberOfShards > 0))
+        problem = "only a dataset file can be resumed";
+    else if (indexFileName[0] != '\0')
+        problem = "--save-index needs all seeds";
+    else
+    {
+        nameWorkingFiles(inputTempFileName, outputTempFileName, datasetName, outputFileName, spoolFileName, *outputFile, false);
+        sprintf(checkpointFileName, "%s.checkpoint", inputTempFileName);
+        if (!readCheckpoint(checkpointFileName, checkpoint))
+            problem = "no checkpoint";
+        else if ((strcmp(checkpoint.datasetName, datasetName) != 0) || (strcmp(checkpoint.readsFileName, inputTempFileName) != 0)
+                 || (checkpoint.genomeLength != genomeLength) || (checkpoint.numberOfSeeds != numberOfSeeds)
+                 || ((weight != 0) && (checkpoint.weight != weight)) || (checkpoint.seedsDone < 1) || (checkpoint.seedsDone >= numberOfSeeds))
+            problem = "the options have changed";
+        else
+            problem = verifyCheckpoint(checkpoint);
+        if ((problem == NULL) && (qualitySkip > 0))     // the scores kept by the interrupted run (FASTQ only)
+        {
+            sprintf(qualityFileName, "%s_qual", inputTempFileName);
+            if (access(qualityFileName, R_OK) != 0)
+            {
+                quessLog << "No quality scores kept by the interrupted run; all windows are looked up" << endl;
+                qualityFileName[0] = '\0';
+            }
+        }
+    }
+    if (problem != NULL)
+    {
+        quessLog << "Cannot resume (" << problem << "); starting over" << endl;
+        checkpointFileName[0] = '\0';
+        return false;
+    }
+    weight = checkpoint.weight;
+    numberOfReads = checkpoint.numberOfReads;
+    totalReadLength = checkpoint.totalReadLength;
+    resumedSeeds = checkpoint.seedsDone;
+    quessLog << "Resuming after seed " << resumedSeeds - 1 << " of " << numberOfSeeds << " (checkpoint " << checkpointFileName << ")" << endl;
+    quessLog << "numberOfReads = " << numberOfReads << endl;
+    quessLog << "totalReadLength = " << totalReadLength << endl;
+    return true;
+}
+
+/**
+  * Name:               addReads(const vector<string>& reads)
+  *
+  * Description :       Adds reads in memory to the read source
+  *
+  * Input :
+  *       Parameters:
+  *           const vector<string>& reads   reads (A, C, G, T, other characters are N)
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  The first call names the working files QUESS_reads_<pid>_* (current directory)
+  *                     [2]  The reads are appended to the working copy
+  *
+  * Notes :             Reads longer than MAX_READ_LENGTH - 1 are truncated.
+  *
+  */
+
+void QuessCorrector::addReads(const vector<string>& reads)
+{
+    if ((seedsDone > 0) || (datasetName[0] != '\0'))
+    {
+        throw QuessError("QuessCorrector: reads can be added only to an in-memory source, before the first seed");
+    }
+    if (readsFile == NULL)
+    {
+        sprintf(inputTempFileName, "QUESS_reads_%d_temp_copy.fastx", (int)getpid());
+        sprintf(outputTempFileName, "QUESS_reads_%d_temp_corrected.fastx", (int)getpid());
+        readsFile = new BlockWriter;
+        readsFile->open(inputTempFileName);
+        if (!readsFile->is_open()) throw QuessError("Cannot open input temp file: " + string(inputTempFileName));
+    }
+    for (uint64_t i = 0; i < reads.size(); ++i)
+    {
+        uint64_t length = min((uint64_t)reads[i].size(), (uint64_t)(MAX_READ_LENGTH - 1));
+        readsFile->write(reads[i].data(), length);
+        readsFile->write("\n", 1);
+        ++numberOfReads;
+        totalReadLength += length;
+    }
+}
+
+/**
+  * Name:               saveIndex(const char* fileName)
+  *
+  * Description :       Saves the model of every seed in a correction index
+  *
+  * Input :
+  *       Parameters:
+  *           const char* fileName          index file (written while the seeds run, completed after the last one)
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :             Must be called before the first seed; not with loadIndex.
+  *
+  */
+
+void QuessCorrector::saveIndex(const char* fileName)
+{
+    if ((seedsDone > 0) || indexLoaded)
+    {
+        throw QuessError("QuessCorrector: saveIndex must be called before the first seed, without loadIndex");
+    }
+    strcpy(indexFileName, fileName);
+}
+
+/**
+  * Name:               loadIndex(const char* fileName)
+  *
+  * Description :       Uses the models of a correction index instead of building them
+  *
+  * Input :
+  *       Parameters:
+  *           const char* fileName          index file written with saveIndex
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           seeds; the index is mapped (not counted in currentMemory)
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  Map the index; weight, number of seeds and seeds come from it
+  *                     [2]  One read-only table per seed over the mapped arrays
+  *                          (with setStaticTables(true): a StaticTable built from them; the index is then unmapped;
+  *                          likewise a BucketTable with setBucketTables(true))
+  *
+  * Notes :             Must be called before the first seed; not with saveIndex.
+  *                     The reads should come from the same genome as those the index was built from.
+  *
+  */
+
+void QuessCorrector::loadIndex(const char* fileName)
+{
+    if ((seedsDone > 0) || indexLoaded || (indexFileName[0] != '\0'))
+    {
+        throw QuessError("QuessCorrector: loadIndex must be called once, before the first seed, without saveIndex");
+    }
+    index = new CorrectionIndex;
+    index->open(fileName);
+    indexLoaded = true;
+    if (genomeLength == 0)
+        genomeLength = index->getGenomeLength();
+    weight = index->getWeight();
+    numberOfSeeds = index->getNumberOfSeeds();
+    seeds = new char*[numberOfSeeds];
+    tables = new HashTable*[numberOfSeeds];
+    for (int64_t i = 0; i < numberOfSeeds; ++i)
+    {
+        seeds[i] = new char[1000];
+        strcpy(seeds[i], index->getSeed(i));
+        tables[i] = index->getTable(i);
+        if (staticTables && Seed(seeds[i]).isWide())
+        {
+            throw QuessError("QuessCorrector: static tables need seeds of length at most " + to_string(MAX_NARROW_SEED_LENGTH));
+        }
+        if (staticTables)   // the mapped arrays are not needed afterwards
+            tables[i]->buildStaticTable(Seed(seeds[i]).getSMerMaskRC(), peakMemory, currentMemory);
+        else if (bucketTables)
+            tables[i]->buildBucketTable(peakMemory, currentMemory);
+    }
+    if (staticTables || bucketTables)
+        index->close();
+}
+
+/**
+  * Name:               getNumberOfSeeds()
+  *
+  * Description :       Returns the number of seeds
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           int                           number of seeds
+  *
+  * Process Synopsis :
+  *
+  * Notes :
+  *
+  */
+
+int QuessCorrector::getNumberOfSeeds()
+{
+    return numberOfSeeds;
+}
+
+/**
+  * Name:               prepare()
+  *
+  * Description :       Computes seeds, thresholds and the starting hash table (before the first seed)
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           seeds, hash table of size 2 * genomeLength (rounded up to a prime)
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  Weight from the total read length (unless given)
+  *                     [2]  Seeds
+  *                     [3]  Bucket size (number of reads simultaneously read) and Tc
+  *                          (with a memory budget: planMemory for the bucket size, the table and the sMer partitions)
+  *                     [4]  Start the correction index (saveIndex)
+  *
+  * Notes :             With a loaded index only [3] is done (Tc from the index) and there is no hash table.
+  *
+  */
+
+void QuessCorrector::prepare()
+{
+    if (readsFile != NULL)      // in-memory source complete
+    {
+        readsFile->close();
+        delete readsFile;
+        readsFile = NULL;
+    }
+    if (numberOfReads == 0)
+    {
+        throw QuessError("QuessCorrector: no reads to correct");
+    }
+    if (!indexLoaded && (seeds == NULL))       // with an index, the seeds come from loadIndex; with setSeeds, given
+    {
+        if (totalReadLength>1000000000 && weight==0)
+            weight=20;
+        if (totalReadLength<=1000000000 && weight==0)
+            weight=16;
+        seeds = new char*[numberOfSeeds]; // seed will hold the actual seed provided by the function getSeed
+        for (int64_t i = 0; i < numberOfSeeds; ++i)
+        {
+            seeds[i] = new char[1000];
+            getSeed(seeds[i],weight, numberOfSeeds, i, peakMemory, currentMemory);
+        }
+    }
+
+    if (staticTables && Seed(seeds[0]).isWide())
+    {
+        throw QuessError("QuessCorrector: static tables need seeds of length at most " + to_string(MAX_NARROW_SEED_LENGTH));
+    }
+
+    quessLog << "============ SEEDS ============\n";
+    quessLog << "weight = " << weight << endl;
+    quessLog << "numberOfSeeds = " << numberOfSeeds << endl;
+    quessLog << "seeds:" << endl;
+    for (int64_t i = 0; i < numberOfSeeds; ++i)
+        quessLog << seeds[i] << endl;
+
+    currentMemory+=5*sizeof(uint64_t)+4*sizeof(int)+numberOfSeeds*1000*sizeof(char)+430*sizeof(uint64_t)+4*sizeof(time_t);
+    if (currentMemory > peakMemory)
+    {
+        peakMemory = currentMemory;
+#ifdef VERBOSE
+        quessLog << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
+#endif
+    }
+
+    // 2 * "bucketSize" = the number of reads loaded at a time
+    bucketSize = uint64_t(genomeLength * 10 / MAX_READ_LENGTH);
+
+    // memory budget: the smaller of setMaxMemory and the cgroup limit
+    MemoryPlan plan;
+    uint64_t budget = maxMemory;
+    uint64_t cgroupLimit = getMemoryLimit();
+    if ((cgroupLimit != 0) && ((budget == 0) || (cgroupLimit < budget)))
+        budget = cgroupLimit;
+    if ((budget != 0) && !planMemory(budget, genomeLength, bucketSize, !indexLoaded, plan))
+    {
+        if (budget == maxMemory)
+        {
+            throw QuessError("--max-memory " + to_string(budget/1048576) + " MB is too small; at least " + to_string(plan.required/1048576) + " MB are needed");
+        }
+        quessLog << "cgroup memory limit " << budget/1048576 << " MB is below the estimated " << plan.required/1048576 << " MB; not planning" << endl;
+        budget = 0;
+    }
+    if (budget == 0)
+        setIOBuffers(NUMBER_OF_IO_BUFFERS, IO_BUFFER_SIZE);
+    else
+    {
+        bucketSize = plan.bucketSize;
+        setIOBuffers(plan.numberOfIOBuffers, plan.ioBufferSize);
+        quessLog << "============ MEMORY PLAN ============\n";
+        quessLog << "budget = " << budget/1048576 << " MB" << endl;
+        quessLog << "I/O buffers = " << plan.numberOfIOBuffers << " x " << plan.ioBufferSize/1024 << " KB per file" << endl;
+        quessLog << "bucketSize = " << bucketSize << endl;
+        if (!indexLoaded)
+        {
+            numberOfPartitions = plan.numberOfPartitions;
+            if (plan.partitionedModel)
+                modelPartitions = max(modelPartitions, plan.numberOfPartitions);
+            quessLog << "table size = " << plan.tableSize << " (limit " << plan.tableLimit << ")" << endl;
+            quessLog << "sMer partitions = " << numberOfPartitions << endl;
+            if (modelPartitions != 0)
+                quessLog << "model partitions (spilled to disk) = " << modelPartitions << endl;
+            quessLog << "sGap locks = " << plan.numberOfLocks << endl;
+        }
+    }
+    currentMemory+=PLAN_OPEN_FILES*getNumberOfIOBuffers()*getIOBufferSize()*sizeof(char);
+    if (currentMemory > peakMemory)
+        peakMemory = currentMemory;
+
+    readLength = (int64_t)(totalReadLength / numberOfReads);
+    if (indexLoaded)
+    {
+        Tc = index->getTc();
+        quessLog << "\n=============== QUESS V 1.0.1 (correction index) ==============\n";
+        return;
+    }
+    int64_t modelNumberOfReads = numberOfReads;
+    if (normalizeCoverage > 0)      // models from a coverage-capped subset of the reads
+    {
+        modelReads = new uint64_t[(numberOfReads + 63) / 64];
+        memset(modelReads, 0, ((numberOfReads + 63) / 64) * sizeof(uint64_t));
+        currentMemory+=((numberOfReads + 63) / 64) * sizeof(uint64_t);
+        BlockReader inputTempFile;
+        inputTempFile.open(inputTempFileName);
+        if (!inputTempFile.is_open()) throw QuessError("Cannot open input temp file: " + string(inputTempFileName));
+        int64_t modelReadLength = 0;
+        modelNumberOfReads = selectModelReads(inputTempFile, genomeLength, normalizeCoverage, modelReads, modelReadLength, peakMemory, currentMemory);
+        inputTempFile.close();
+        if (modelNumberOfReads > 0)
+            readLength = (int64_t)(modelReadLength / modelNumberOfReads);
+        quessLog << "effective coverage = " << (double)modelReadLength / genomeLength << endl;
+    }
+    computeTc(readLength, modelNumberOfReads, genomeLength, weight, 0.005, Tc);
+    sprintf(modelFileName, "%s_model", inputTempFileName);
+    H = new HashTable((numberOfPartitions != 0) ? plan.tableSize : (uint64_t)(genomeLength*2));          // starting hash size
+    H->setCompactCounting(compactTables);
+    if (shardedCounting && (numberOfPartitions == 0) && (modelPartitions == 0))
+    {
+        shards = new ShardedCounter(omp_get_max_threads(), H->getSize());
+        currentMemory += shards->memoryUsage();
+    }
+    if (numberOfPartitions != 0)
+    {
+        H->setSizeLimit(plan.tableLimit);
+        H->setNumberOfLocks(plan.numberOfLocks);
+    }
+
+    currentMemory+=H->getSize()*sizeof(uint64_t);
+    if (currentMemory > peakMemory)
+    {
+        peakMemory = currentMemory;
+#ifdef VERBOSE
+        quessLog << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
+#endif
+    }
+    if (keepTables)
+    {
+        tables = new HashTable*[numberOfSeeds];
+        for (int64_t i = 0; i < numberOfSeeds; ++i)
+            tables[i] = NULL;
+    }
+    if (indexFileName[0] != '\0')
+    {
+        index = new CorrectionIndex;
+        if (!index->create(indexFileName, genomeLength, weight, numberOfSeeds, Tc)) throw QuessError("Cannot create correction index: " + string(indexFileName));
+    }
+
+    quessLog << "\n=============== QUESS V 1.0.1 ==============\n";
+}
+
+/**
+  * Name:               runSeed()
+  *
+  * Description :       Builds the model of the next seed and corrects the reads of the source with it
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           hash table of the seed; kept in tables[seedNumber] with setKeepTables(true)
+  *       Return:
+  *           bool                          false if all seeds have already been run
+  *
+  * Process Synopsis :
+  *                     [1]  Insert the sMers of the reads (steps [1]-[4] are skipped with a loaded index)
+  *                     [2]  Rehash the aforementioned sMers into only values with high frequency
+  *                     [3]  Insert the sGaps of the reads
+  *                          ([1]-[4] one partition of the sMers at a time with setModelPartitions or when the plan says so;
+  *                          [1]-[3] by the threads owning the sMers with setShardedCounting)
+  *                     [4]  Determine the sGaps with the highest amount of support/delete ambigious sMers;
+  *                          add the table to the correction index (saveIndex); build the static table
+  *                     [5]  Correct the reads based on the correct sGaps
+  *                     [6]  The corrected reads become the reads of the next seed; checkpoint manifest (writeCheckpoint)
+  *                          (with setConvergence: the corrected reads are final if the yield of the seed is too low)
+  *
+  * Notes :
+  *
+  */
+
+bool QuessCorrector::runSeed()
+{
+    if (seedsDone >= numberOfSeeds)
+        return false;
+    if (seedsDone == 0)
+    {
+        prepare();
+        seedsDone = resumedSeeds;       // seeds done before an interrupted run (setResume); 0 otherwise
+    }
+    int64_t seedNumber = seedsDone;
+    time_t iteration_time_start, iteration_time_end;
+
+    quessLog << "\n=============== SEED " << seedNumber <<  " ==============\n";
+    time(&iteration_time_start);
+
+    Seed currentSeed = Seed(seeds[seedNumber]);
+    BlockReader inputTempFile;
+    BlockWriter outputTempFile;
+
+    inputTempFile.open(inputTempFileName);      // in: uncorrected reads
+    if (!inputTempFile.is_open()) throw QuessError("Cannot open input temp file: " + string(inputTempFileName));
+    outputTempFile.open(outputTempFileName);  // out: corrected reads
+    if (!outputTempFile.is_open()) throw QuessError("Cannot open output temp file: " + string(outputTempFileName));
+    int Te = max(2,(seedNumber<=3) ? Tc/4 : Tc/2);
+    int Tdiff = (seedNumber <= 3) ? 4 : 2;
+    CorrectionStats stats;
+    if (skipSolid && (solidReads == NULL))      // bit of each read: solid with a seed done (skipped by correct)
+    {
+        solidReads = new uint64_t[(numberOfReads + 63) / 64];
+        memset(solidReads, 0, ((numberOfReads + 63) / 64) * sizeof(uint64_t));
+        currentMemory+=((numberOfReads + 63) / 64) * sizeof(uint64_t);
+    }
+    BlockReader qualityReader;                  // binned scores of the reads (--quality-skip, FASTQ)
+    BlockReader* qualityFile = NULL;
+    if ((qualitySkip > 0) && (qualityFileName[0] != '\0'))
+    {
+        qualityReader.open(qualityFileName);
+        if (!qualityReader.is_open()) throw QuessError("Cannot open quality temp file: " + string(qualityFileName));
+        qualityFile = &qualityReader;
+    }
+
+    if (indexLoaded)        // model of the seed from the index
+        correct(seedNumber, currentSeed, *tables[seedNumber], inputTempFile, outputTempFile, Tdiff, bucketSize, stats, solidReads, qualityFile, qualitySkip, peakMemory,currentMemory);
+    else
+    {
+        if (modelPartitions != 0)       // model built one partition at a time, spilled to disk
+            buildPartitionedModel(seedNumber, currentSeed, *H, inputTempFile, bucketSize, modelReads, Tc, Te, modelPartitions, modelFileName, peakMemory,currentMemory);
+        else
+        {
+            if (numberOfPartitions != 0)    // memory budget: table size limited, sMers possibly counted in partitions
+                insertFrequentSMers(seedNumber, currentSeed, *H, inputTempFile, bucketSize, modelReads, Tc, numberOfPartitions, peakMemory,currentMemory);
+            else if (shards != NULL)        // counted by the threads owning the sMers
+                insertSMersSharded(currentSeed, *H, *shards, inputTempFile, bucketSize, modelReads, Tc, peakMemory,currentMemory);
+            else
+            {
+                insertSMers(seedNumber, currentSeed, *H, inputTempFile, bucketSize, modelReads, peakMemory,currentMemory);
+                rehashFrequentSMers(*H, Tc,peakMemory,currentMemory);
+            }
+            if (shards != NULL)
+                insertSGapsSharded(currentSeed, *H, *shards, inputTempFile, Te, bucketSize, (int)seedNumber, modelReads, peakMemory,currentMemory);
+            else
+                insertSGaps(currentSeed, *H, inputTempFile, Te, bucketSize, (int)seedNumber, modelReads, peakMemory,currentMemory);
+            removeAmbiguousSMers(*H, Tc, Te, (int)seedNumber, peakMemory,currentMemory);
+        }
+        if (index != NULL)
+            index->addSeed(*H, seeds[seedNumber]);
+        if (staticTables)
+            H->buildStaticTable(currentSeed.getSMerMaskRC(), peakMemory, currentMemory);
+        else if (bucketTables)
+            H->buildBucketTable(peakMemory, currentMemory);
+
+        correct(seedNumber, currentSeed, *H, inputTempFile, outputTempFile, Tdiff, bucketSize, stats, solidReads, qualityFile, qualitySkip, peakMemory,currentMemory);
+    }
+
+    quessLog << "\n==== PARAMETERS ====\n";
+    quessLog << "genomeLength = " << genomeLength << endl;
+    quessLog << "number of reads = " << numberOfReads << endl;
+    quessLog << "read length (weighted avg.) = " << readLength << endl;
+    quessLog << "seed weight = " << weight << endl;
+    quessLog << "Peak Memory Usage = " << peakMemory/1048576 << " MB"<<endl;
+    quessLog << "Current Memory Usage = " << currentMemory/1048576 << " MB"<<endl;
+    quessLog << "Tc    = " << Tc << endl;
+    quessLog << "Te    = " << Te << endl;
+    quessLog << "Tdiff = " << Tdiff << endl;
+    quessLog << "====================\n" << endl;
+    inputTempFile.close();
+    outputTempFile.close();
+    qualityReader.close();
+    if ((index != NULL) && !indexLoaded && (seedNumber == numberOfSeeds - 1))
+    {
+        if (!index->finish()) throw QuessError("Cannot write correction index: " + string(indexFileName));
+        quessLog << "Correction index saved: " << indexFileName << endl;
+    }
+    if (keepTables && !indexLoaded)
+        tables[seedNumber] = H->detach();       // H is empty again; the model stays in tables[seedNumber]
+    else if (!indexLoaded)
+        H->clear(peakMemory,currentMemory);     // (a loaded index stays mapped for the next seeds/batches)
+    // adaptive schedule: stop when the seed corrected fewer than "convergence" positions per million bases
+    bool converged = false;
+    if ((convergence > 0) && (seedNumber + 1 >= ADAPTIVE_MIN_SEEDS) && (seedNumber < numberOfSeeds - 1) && !keepTables && ((index == NULL) || indexLoaded))
+    {
+        double yield = 1e6 * stats.correctedPositions / max(totalReadLength, (int64_t)1);
+        quessLog << "Yield = " << yield << " corrections per million bases (stop below " << convergence << "); reads with suspect positions: " << stats.suspectReads << endl;
+        converged = (yield < convergence) || (stats.suspectReads == 0);
+        if (converged)
+            quessLog << "Corrections converged; seeds " << seedNumber + 1 << " to " << numberOfSeeds - 1 << " skipped" << endl;
+    }
+    swapFiles(inputTempFileName, outputTempFileName, seedNumber, converged ? seedNumber + 1 : numberOfSeeds);
+    ++seedsDone;
+    if (converged)
+        seedsDone = numberOfSeeds;
+    if ((checkpointFileName[0] != '\0') && (seedsDone < numberOfSeeds))      // the reads corrected so far are in inputTempFileName
+    {
+        Checkpoint checkpoint;
+        strcpy(checkpoint.datasetName, datasetName);
+        strcpy(checkpoint.readsFileName, inputTempFileName);
+        checkpoint.genomeLength = genomeLength;
+        checkpoint.weight = weight;
+        checkpoint.numberOfSeeds = numberOfSeeds;
+        checkpoint.seedsDone = seedsDone;
+        checkpoint.Tc = Tc;
+        checkpoint.Te = Te;
+        checkpoint.Tdiff = Tdiff;
+        checkpoint.numberOfReads = numberOfReads;
+        checkpoint.totalReadLength = totalReadLength;
+        if (writeCheckpoint(checkpointFileName, checkpoint))
+            quessLog << "Checkpoint: " << checkpointFileName << endl;
+        else
+            quessLog << "Cannot write checkpoint: " << checkpointFileName << endl;
+    }
+    else if (checkpointFileName[0] != '\0')      // last seed: nothing to resume
+        remove(checkpointFileName);
+
+    time(&iteration_time_end);
+    quessLog << "\n============ DONE SEED " << seedNumber << " (" << difftime(iteration_time_end, iteration_time_start) << "s) ===========\n" << endl;
+    return true;
+}
+
+/**
+  * Name:               runSeeds()
+  *
+  * Description :       Runs all remaining seeds
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :
+  *
+  */
+
+void QuessCorrector::runSeeds()
+{
+    while (runSeed())
+        ;
+}
+
+/**
+  * Name:               writeOutput()
+  *
+  * Description :       Writes the corrected dataset
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  headers and scores from the dataset (or its copy, for a pipe) with the corrected reads
+  *
+  * Notes :
+  *
+  */
+
+void QuessCorrector::writeOutput()
+{
+    if ((datasetName[0] == '\0') || (seedsDone < numberOfSeeds))
+    {
+        throw QuessError("QuessCorrector: writeOutput requires a dataset source and all seeds run");
+    }
+    if (spoolFileName[0] != '\0')     // the dataset was read from a pipe; use its records file
+    {
+        createOutputFile(spoolFileName, outputTempFileName, outputFileName, *outputFile, true);
+        remove(spoolFileName);
+        removeAtAbnormalExit(NULL);
+        spoolFileName[0] = '\0';
+    }
+    else
+        createOutputFile(datasetName, outputTempFileName, outputFileName, *outputFile, false);
+    outputTempFileName[0] = '\0';       // removed by createOutputFile
+    if (shardFileName[0] != '\0')
+    {
+        remove(shardFileName);
+        shardFileName[0] = '\0';
+    }
+}
+
+/**
+  * Name:               getCorrectedReads(vector<string>& reads)
+  *
+  * Description :       Returns the corrected reads of an in-memory source
+  *
+  * Input :
+  *       Parameters:
+  *           vector<string>& reads         destination
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           vector<string>& reads         the corrected reads, in the order they were added
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :             The corrected working file is removed.
+  *
+  */
+
+void QuessCorrector::getCorrectedReads(vector<string>& reads)
+{
+    if ((datasetName[0] != '\0') || (seedsDone < numberOfSeeds) || (outputTempFileName[0] == '\0'))
+    {
+        throw QuessError("QuessCorrector: getCorrectedReads requires an in-memory source and all seeds run");
+    }
+    BlockReader correctedReads;
+    correctedReads.open(outputTempFileName);
+    if (!correctedReads.is_open()) throw QuessError("Cannot open output temp file: " + string(outputTempFileName));
+    char* read = new char[MAX_READ_LENGTH];
+    reads.clear();
+    reads.reserve(numberOfReads);
+    while (correctedReads.getline(read, MAX_READ_LENGTH))
+        reads.push_back(read);
+    correctedReads.close();
+    delete [] read;
+    remove(outputTempFileName);
+    outputTempFileName[0] = '\0';
+}
+
+/**
+  * Name:               correctBatch(vector<string>& reads)
+  *
+  * Description :       Corrects reads in memory with the kept models of all seeds
+  *
+  * Input :
+  *       Parameters:
+  *           vector<string>& reads         reads to correct
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           vector<string>& reads         corrected in place
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  For each seed, in order, correct all reads in parallel as correct() does
+  *
+  * Notes :             Requires loadIndex(), or setKeepTables(true) and runSeeds(). Only the first MAX_READ_LENGTH - 1
+  *                     characters of a read are corrected; the rest is left unchanged.
+  *
+  */
+
+void QuessCorrector::correctBatch(vector<string>& reads)
+{
+    if (!indexLoaded && (!keepTables || (seedsDone < numberOfSeeds)))
+    {
+        throw QuessError("QuessCorrector: correctBatch requires loadIndex, or setKeepTables(true) and all seeds run");
+    }
+    uint64_t corr = 0;
+    int64_t numberOfBatchReads = reads.size();
+    for (int64_t seedNumber = 0; seedNumber < numberOfSeeds; ++seedNumber)
+    {
+        Seed currentSeed = Seed(seeds[seedNumber]);
+        int Tdiff = (seedNumber <= 3) ? 4 : 2;
+#pragma omp parallel
+        {
+            Read currentRead;
+            char* read = new char[MAX_READ_LENGTH];
+#pragma omp for schedule(dynamic)
+            for (int64_t i = 0 ; i < numberOfBatchReads; ++i)
+            {
+                uint64_t length = min((uint64_t)reads[i].size(), (uint64_t)(MAX_READ_LENGTH - 1));
+                memcpy(read, reads[i].data(), length);
+                read[length] = '\0';
+                currentRead = Read(read);
+                int64_t errPositions = currentRead.correctBinaryReadFast(*tables[seedNumber], currentSeed, Tdiff, corr);
+                if (errPositions > -1)  // errPositions == -1 means read was not corrected
+                    if  ((seedNumber >= 2) || errPositions == 0)   // for the first two seeds implement corrections only when "perfectly" corrected
+                        currentRead.correctCharRead();
+                currentRead.outputRead(read);
+                currentRead.clear();
+                reads[i].replace(0, length, read, length);
+            } // ### end omp for schedule (dynamic)
+            delete [] read;
+        } // ### end omp parallel
+    }
+}
+
+/**
+  * Name:               getPeakMemory()
+  *
+  * Description :       Returns the estimated peak memory
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           uint64_t                      peak memory in bytes
+  *
+  * Process Synopsis :
+  *
+  * Notes :
+  *
+  */
+
+uint64_t QuessCorrector::getPeakMemory()
+{
+    return peakMemory;
+}
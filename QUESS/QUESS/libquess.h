@@ -0,0 +1,229 @@
+//
+//  libquess.h
+//
+//  Public interface of libquess (libquess.a, libquess.so): QUESS error correction
+//  inside another program. The QUESS command line program is built on top of it.
+//
+//  Usage:
+//      QuessCorrector corrector(genomeLength);
+//      corrector.setDataset("reads.fastq");        // or corrector.addReads(reads) for reads in memory
+//      corrector.runSeeds();
+//      corrector.writeOutput();                    // or corrector.getCorrectedReads(reads)
+//
+//  With setKeepTables(true) the model of every seed is kept after runSeeds and
+//  further batches of reads (e.g., right after basecalling) are corrected in memory
+//  with correctBatch, without any file.
+//
+//  saveIndex(file) stores the models of all seeds in a correction index; with
+//  loadIndex(file) later runs only correct (runSeeds or correctBatch) with the
+//  mapped models, without building them from the reads.
+//
+//  With setShard(i, n) only the i-th of n consecutive ranges of records is
+//  corrected, so that several processes (e.g., with the same loaded index,
+//  shared through the page cache) correct one dataset; their outputs are
+//  concatenated.
+//
+//  With setMaxMemory(bytes) (or a cgroup memory limit) the sizes are planned before the
+//  first seed: smaller buckets, fewer sGap locks, and the sMers counted in partitions
+//  when the counting table would not fit; if the model itself would not fit, it is
+//  built in partitions spilled to disk (as with setModelPartitions). The corrected
+//  reads are the same.
+//
+//  After each seed a checkpoint manifest is written next to the working files;
+//  with setResume(true) an interrupted run continues with the next seed.
+//
+//  serveCorrections keeps a corrector with a loaded index resident and corrects
+//  batches of reads sent over a Unix domain socket (protocol in server.cpp).
+//
+//  Errors (wrong use of a method, files that cannot be read or written, datasets
+//  not in FASTA/FASTQ format) are thrown as QuessError; the library does not exit.
+//  After a QuessError the corrector can only be destroyed (its working files are
+//  removed). Progress messages go to standard output, to a function given to
+//  setLogger, or nowhere with setVerbose(false).
+//
+
+#ifndef ____LIBQUESS__
+#define ____LIBQUESS__
+
+#include <stdint.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+class HashTable;
+class ShardedCounter;
+class BlockWriter;
+class DatasetWriter;
+class CorrectionIndex;
+
+void setAsyncIO(bool enabled);
+    // enable/disable io_uring for the files opened afterwards (pread/pwrite when disabled)
+
+void setLogger(void (*logger)(const char* line, void* context), void* context = NULL);
+    // the progress messages of the library go to logger, one line at a time (without '\n'), with context;
+    // NULL = standard output (default)
+
+void setVerbose(bool verbose);
+    // false: no progress messages; true (default): messages to the logger (setLogger)
+
+class QuessError : public std::runtime_error  // error of the library; what() is the message
+{
+public:
+    explicit QuessError(const std::string& message) : std::runtime_error(message) {}
+};
+
+class QuessCorrector  // error corrector: read source -> seeds -> corrected reads
+{
+private:
+    uint64_t genomeLength;
+    int weight, numberOfSeeds;          // weight = 0: chosen from the total read length
+    bool keepTables;                    // keep the model of each seed for correctBatch
+    bool staticTables;                  // correct with a StaticTable (minimal perfect hash) of each model
+    bool bucketTables;                  // correct with a BucketTable (cache-line buckets) of each model
+    bool compactTables;                 // count the sMers in a CompactTable (quotient table)
+    bool shardedCounting;               // count the sMers and insert the sGaps by the threads owning them
+    char* datasetName;                  // FASTA/FASTQ source; empty for reads given in memory
+    char* inputTempFileName;            // reads being corrected
+    char* outputTempFileName;           // reads corrected by the current seed
+    char* outputFileName;
+    char* spoolFileName;                // headers and scores of a dataset read from a pipe
+    char* modelFileName;                // models of the partitions of a seed (buildPartitionedModel)
+    char* checkpointFileName;           // manifest written after each seed; empty if the run cannot be resumed
+    bool resume;                        // continue an interrupted run from its checkpoint (setResume)
+    int64_t resumedSeeds;               // seeds done before the interruption
+    double convergence;                 // stop when a seed corrects fewer positions per million bases; 0 = all seeds
+    bool skipSolid;                     // skip the correction of reads solid with an earlier seed (setSkipSolid)
+    uint64_t* solidReads;               // bit i: read i was solid with a seed done; NULL if not skipping
+    int qualitySkip;                    // windows with sGap scores all in this bin or above are not looked up; 0 = none
+    char* qualityFileName;              // binned FASTQ scores of the reads (createWorkingFiles); empty if not kept
+    int normalizeCoverage;              // models built from reads of about this coverage (setNormalize); 0 = all reads
+    uint64_t* modelReads;               // bit i: read i is counted in the models (selectModelReads); NULL = all
+    char* shardFileName;                // records of the shard being corrected (setShard); empty if none
+    int shard, numberOfShards;          // --shard shard/numberOfShards; 0/0 = whole dataset
+    uint64_t maxMemory;                 // memory budget in bytes (setMaxMemory); 0 = none
+    uint64_t numberOfPartitions;        // sMers counted in this many passes (insertFrequentSMers); 0 = no budget
+    uint64_t modelPartitions;           // model built in this many partitions spilled to disk; 0 = in memory
+    BlockWriter* readsFile;             // in-memory source: reads given by addReads
+    DatasetWriter* outputFile;
+    int64_t numberOfReads, totalReadLength, readLength;
+    char** seeds;
+    int Tc;
+    uint64_t bucketSize;
+    HashTable* H;                       // table of the current seed
+    HashTable** tables;                 // tables[k] = model of seed k (keepTables or loaded index)
+    ShardedCounter* shards;             // shards of the threads (setShardedCounting); NULL otherwise
+    char* indexFileName;                // index to save; empty if none
+    CorrectionIndex* index;             // index being saved or loaded
+    bool indexLoaded;                   // models come from the index: correction only
+    int64_t seedsDone;
+    uint64_t peakMemory, currentMemory;
+
+    void prepare();
+        // choose the seeds and the thresholds, create the hash table (before the first seed)
+
+    bool resumeFromCheckpoint();
+        // setDataset with setResume(true): use the working files of an interrupted run; false if not possible
+
+public:
+    QuessCorrector(uint64_t genomeLength, int weight = 0, int numberOfSeeds = 8);
+    ~QuessCorrector();
+
+    bool setCompression(const char* name);
+        // compression of the output file: "bgzf", "gzip", "zstd" or "none"; false if unknown
+
+    void setKeepTables(bool keep);
+        // keep the model of every seed so that correctBatch can be used after runSeeds
+
+    void setSeeds(const std::vector<std::string>& seeds);
+        // use these seeds (1-8 palindromes of 0/1 of the same weight; length up to 53, with at most 26 0s;
+        // weight at most 27, as the table keys stay 56-bit) instead of the precomputed ones of the weight; seeds longer than 26 are run with
+        // 128-bit windows; before the first seed
+
+    void setStaticTables(bool use);
+        // once its ambiguous sMers are removed, replace the model of each seed by a minimal perfect hash table
+        // (smaller, faster lookups); must be called before loadIndex
+
+    void setBucketTables(bool use);
+        // once its ambiguous sMers are removed, replace the model of each seed by a bucketized hash table (one or
+        // two cache lines per lookup); not with setStaticTables; must be called before loadIndex
+
+    void setCompactTables(bool use);
+        // count the sMers of each seed in a quotient table (a third smaller; thread safe) when they fit; before runSeeds
+
+    void setShardedCounting(bool use);
+        // split the sMers into one shard per thread; the sMers and sGaps are passed to the thread owning them,
+        // which alone inserts them (no locks); not with a memory budget or model partitions; before runSeeds
+
+    void setShard(int shard, int numberOfShards);
+        // correct only records (shard-1)*N/numberOfShards .. shard*N/numberOfShards - 1 of the dataset (1 <= shard <= numberOfShards);
+        // the outputs of all shards, concatenated in order, are the corrected dataset; must be called before setDataset
+
+    void setMaxMemory(uint64_t bytes);
+        // plan I/O buffers, bucket size, table size, sMer partitions and locks to stay within bytes (0 = only the cgroup limit,
+        // which is also applied when smaller); must be called before the first seed
+
+    void setModelPartitions(int numberOfPartitions);
+        // build the model of each seed one partition of the sMers at a time, spilled to disk and merged for the
+        // correction (bounded memory, more passes over the reads); must be called before the first seed
+
+    void setConvergence(double correctionsPerMillion);
+        // adaptive schedule: skip the remaining seeds once a seed (the 4th or later) writes fewer corrections
+        // per million bases; 0 = run all seeds (default)
+
+    void setNormalize(int coverage);
+        // build the models from a subset of the reads with a k-mer coverage of about coverage (digital
+        // normalization, decided in one pass before the first seed); all reads are corrected; 0 = all reads
+
+    void setSkipSolid(bool skip);
+        // reads left with no suspect position by a seed are copied unchanged by the later seeds (no lookups);
+        // they are still counted in the models
+
+    void setQualitySkip(int minQuality);
+        // keep the FASTQ quality scores binned to 2 bits; a window whose sGap positions all score at least
+        // minQuality (rounded down to 10, 20 or 30) is taken as correct without a lookup; must be called before setDataset
+
+    void setResume(bool resume);
+        // with a dataset file: continue after the last seed done by an interrupted run with the same options
+        // (its checkpoint manifest and working files); must be called before setDataset
+
+    void setDataset(const char* datasetName, const char* outputFileName = NULL);
+        // read source = FASTA/FASTQ file (plain, gzip, BGZF; "-" = stdin)
+        // outputFileName: NULL = <prefix>_QUESS_corrected.<ext>, "-" = stdout
+
+    void addReads(const std::vector<std::string>& reads);
+        // read source = reads in memory; may be called several times before the first seed
+
+    void saveIndex(const char* fileName);
+        // save the model of every seed in a correction index (before the first seed)
+
+    void loadIndex(const char* fileName);
+        // use the models of a correction index (before the first seed): runSeed only corrects;
+        // weight, seeds and (if 0) genomeLength are taken from the index
+
+    int getNumberOfSeeds();
+
+    bool runSeed();
+        // build the model of the next seed and correct the reads of the source with it
+        // return false if all seeds have been run
+
+    void runSeeds();
+        // run all remaining seeds
+
+    void writeOutput();
+        // dataset source: write the corrected dataset (headers and qualities from the original)
+
+    void getCorrectedReads(std::vector<std::string>& reads);
+        // in-memory source: the corrected reads, in the order they were added
+
+    void correctBatch(std::vector<std::string>& reads);
+        // correct reads in place with the models of all seeds (setKeepTables(true) after runSeeds, or loadIndex)
+
+    uint64_t getPeakMemory();
+        // estimated peak memory in bytes
+};
+
+void serveCorrections(QuessCorrector& corrector, const char* socketName);
+    // correct batches of reads sent to the Unix domain socket socketName until a client sends SHUTDOWN
+    // (corrector with loadIndex; see server.cpp for the protocol)
+
+#endif /* defined(____LIBQUESS__) */
@@ -0,0 +1,206 @@
+/**
+  * File:     lookupCache.cpp
+  *
+  * Author1:  Lucian Ilie (ilie@uwo.ca)
+  * Author2:  Stephen Lu (slu93@uwo.ca)
+  *
+  *   This file contains the lookup cache of QUESS_mpi. Each
+  *   MPI rank owns part of the sMers of a seed; the correct
+  *   sGaps of the sMers of the reads being corrected are fetched
+  *   from the ranks owning them and kept here, so that the reads
+  *   are corrected by correctBinaryReadFast as with the whole
+  *   hash table.
+  *
+  */
+
+#include "QUESS.h"
+
+#define CACHE_INITIAL_SIZE (1 << 16)
+
+
+LookupCache::LookupCache()
+{
+    size = CACHE_INITIAL_SIZE;
+    numberOfElements = 0;
+    keys = new uint64_t[size];
+    entries = new uint64_t[size];
+    memset(keys, 0, size * sizeof(uint64_t));
+    numberOfThreads = omp_get_max_threads();
+    misses = new vector<uint64_t>[numberOfThreads];
+}
+
+LookupCache::~LookupCache()
+{
+    delete [] keys;
+    delete [] entries;
+    delete [] misses;
+}
+
+/**
+  * Name:               findPos(uint64_t sMer, uint64_t& place)
+  *
+  * Description :       Finds the position of sMer (linear probing)
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t  sMer                sMer looked for
+  *           uint64_t& place               destination
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           uint64_t& place               position of sMer, or the empty position where it goes
+  *       Memory:
+  *           None
+  *       Return:
+  *           bool                          true if sMer is in the cache
+  *
+  * Process Synopsis :
+  *
+  * Notes :             The cache is at most half full.
+  *
+  */
+
+bool LookupCache::findPos(uint64_t sMer, uint64_t& place)
+{
+    place = ((sMer + 1) * 0x9E3779B97F4A7C15ULL) >> (64 - __builtin_ctzll(size));     // high bits of the product
+    while ((keys[place] != 0) && (keys[place] != sMer + 1))
+        place = (place + 1) & (size - 1);
+    return (keys[place] == sMer + 1);
+}
+
+/**
+  * Name:               grow()
+  *
+  * Description :       Doubles the size of the cache
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           keys and entries are reallocated with double size
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :
+  *
+  */
+
+void LookupCache::grow()
+{
+    uint64_t oldSize = size;
+    uint64_t* oldKeys = keys;
+    uint64_t* oldEntries = entries;
+    size *= 2;
+    keys = new uint64_t[size];
+    entries = new uint64_t[size];
+    memset(keys, 0, size * sizeof(uint64_t));
+    for (uint64_t i = 0; i < oldSize; ++i)
+        if (oldKeys[i] != 0)
+        {
+            uint64_t place = 0;
+            findPos(oldKeys[i] - 1, place);
+            keys[place] = oldKeys[i];
+            entries[place] = oldEntries[i];
+        }
+    delete [] oldKeys;
+    delete [] oldEntries;
+}
+
+void LookupCache::clear()
+{
+    memset(keys, 0, size * sizeof(uint64_t));
+    numberOfElements = 0;
+    for (int t = 0; t < numberOfThreads; ++t)
+        misses[t].clear();
+}
+
+bool LookupCache::contains(uint64_t sMer)
+{
+    uint64_t place = 0;
+    return findPos(sMer, place);
+}
+
+void LookupCache::insert(uint64_t sMer, uint64_t entry)
+{
+    if (2 * (numberOfElements + 1) > size)
+        grow();
+    uint64_t place = 0;
+    if (!findPos(sMer, place))
+    {
+        keys[place] = sMer + 1;
+        ++numberOfElements;
+    }
+    entries[place] = entry;
+}
+
+uint64_t LookupCache::getNumberOfMisses()
+{
+    return misses[omp_get_thread_num()].size();
+}
+
+void LookupCache::takeMisses(vector<uint64_t>& sMers)
+{
+    for (int t = 0; t < numberOfThreads; ++t)
+    {
+        sMers.insert(sMers.end(), misses[t].begin(), misses[t].end());
+        misses[t].clear();
+    }
+}
+
+/**
+  * Name:               getCorrectSGap(uint64_t sMer, uint64_t sGap, uint64_t& correctSGap, uint64_t Tdiff)
+  *
+  * Description :       Same as HashTable::getCorrectSGap, with the fetched sMers
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t  sMer                The sMer of the read being processed
+  *           uint64_t  sGap                The sGap of the read being processed associated with the sMer indicated
+  *           uint64_t& correctSGap         A pointer to the identity of the correct sGap
+  *           uint64_t  Tdiff               The allowance of how many bits can be different to have the uncorrected sGap be corrected
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           uint64_t& correctSGap         correctSGap will change to the correct variant
+  *       Memory:
+  *           sMer is added to the misses of the thread if it has not been fetched
+  *       Return:
+  *           int                           -3: sMer not in the model (or not fetched: miss)
+  *                                         -1: sGap too different
+  *                                          0: already correct
+  *                                         >0: correctSGap NOT too different; correction can be done
+  *
+  * Process Synopsis :
+  *
+  * Notes :             A read with misses must be corrected again (from its original) after they are fetched.
+  *
+  */
+
+int64_t LookupCache::getCorrectSGap(uint64_t sMer, uint64_t sGap, uint64_t& correctSGap, uint64_t Tdiff)
+{
+    uint64_t place = 0;
+    if (!findPos(sMer, place))
+    {
+        misses[omp_get_thread_num()].push_back(sMer);
+        return -3;
+    }
+    uint64_t entry = entries[place];
+    if (entry == CACHE_ABSENT)
+        return -3;
+    uint64_t tableSGap = entry & ((((uint64_t)1) << 56) - 1);
+    if (sGap == tableSGap)
+        return 0;
+    if (diff2Bit(sGap, tableSGap) < Tdiff)
+    {
+        correctSGap = tableSGap;
+        return (int64_t)(entry >> 56);
+    }
+    else
+        return -1;
+}
@@ -0,0 +1,432 @@
+/**
+  * File:     main.cpp
+  *
+  * Author1:  Lucian Ilie (ilie@uwo.ca)
+  * Author2:  Stephen Lu (slu93@uwo.ca)
+  *
+  *   QUality Error correction using Spaced Seeds
+  *
+  *   This file contains the QUESS command line program, built
+  *   on top of libquess (libquess.h).
+  *
+  */
+
+
+#include "libquess.h"
+#include <iostream>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <time.h>
+
+using namespace std;
+
+
+
+/**
+  * Name:               void show_usage() {
+  *
+  * Description :       Shows usage
+  *
+  * Input :
+  *
+  * Process Synopsis :
+  *
+  * Notes :             
+  *
+  */
+void show_usage()
+{
+  cerr << "Usage: ./QUESS <option(s)>\n"
+       << "Required:\n"
+       << "\t-i,--input-file <filename>\t\tSpecify the target fastx file ('-' = stdin; output then goes to stdout)\n"
+       << "\t-g,--genome-length <genome length>\tSpecify the approximate length of the genome\n\n"
+       << "Optional:\n"
+       << "\t-h,--help\t\t\t\tShows Help\n"
+       << "\t-n,--number-of-seeds\t\t\tSpecify number of seeds 1-8 (default 8)\n"
+       << "\t-w,--weight <weight>\t\t\tSpecify weight of seeds 10-26 (default to determined by program)\n"
+       << "\t--seeds <s1,s2,...>\t\t\tUse these seeds (palindromes of 0/1, same weight, length up to 53,\n"
+       << "\t\t\t\t\t\tweight at most 27, at most 26 0s) instead of -w and -n\n"
+       << "\t-o,--output-file <file>\t\t\tCorrected file ('-' = stdout; default <input_prefix>_QUESS_corrected.<ext>)\n"
+       << "\t--no-io-uring\t\t\t\tUse pread/pwrite instead of io_uring for file access\n"
+       << "\t-z,--compress-output <format>\t\tCompress the corrected file: bgzf, gzip, zstd or none (default none)\n"
+       << "\t--save-index <file>\t\t\tSave the model of every seed in a correction index\n"
+       << "\t--load-index <file>\t\t\tCorrect with the models of a correction index (no model building;\n"
+       << "\t\t\t\t\t\tweight and seeds from the index, -g optional)\n"
+       << "\t--static-table\t\t\t\tCorrect with a minimal perfect hash table of each model (less memory)\n"
+       << "\t--bucket-table\t\t\t\tCorrect with a bucketized hash table of each model (cache-line lookups)\n"
+       << "\t--compact-table\t\t\t\tCount the sMers in a quotient table (a third smaller)\n"
+       << "\t--sharded\t\t\t\tCount the sMers and insert the sGaps by the threads owning them (no locks)\n"
+       << "\t--shard <i>/<n>\t\t\t\tWith --load-index: correct only the i-th of n ranges of records (1 <= i <= n);\n"
+       << "\t\t\t\t\t\tthe outputs of shards 1..n, concatenated, are the corrected dataset\n"
+       << "\t--max-memory <size>\t\t\tPlan I/O buffers, buckets, table and sMer partitions to stay within size bytes\n"
+       << "\t\t\t\t\t\t(suffix K, M or G; the cgroup memory limit applies as well)\n"
+       << "\t--partitions <P>\t\t\tBuild the model of each seed in P partitions of the sMers, spilled to\n"
+       << "\t\t\t\t\t\tdisk (two passes over the reads per partition; less memory)\n"
+       << "\t--converge <c>\t\t\t\tStop after a seed (4th or later) writing fewer than c corrections\n"
+       << "\t\t\t\t\t\tper million bases (e.g. 10; default: all seeds)\n"
+       << "\t--normalize <C>\t\t\t\tBuild the models from a subset of the reads of k-mer coverage about C\n"
+       << "\t\t\t\t\t\t(e.g. 30 for deep amplicon runs; all reads are corrected)\n"
+       << "\t--skip-solid\t\t\t\tLater seeds do not correct reads solid with an earlier seed (faster)\n"
+       << "\t--quality-skip <Q>\t\t\tFASTQ: do not look up windows whose sGap positions all have quality\n"
+       << "\t\t\t\t\t\tscores >= Q (10, 20 or 30; faster, errors scored >= Q are kept)\n"
+       << "\t--resume\t\t\t\tContinue an interrupted run (same options) after its last seed done\n"
+       << "\t--serve <socket>\t\t\tWith --load-index: keep the models resident and correct batches of\n"
+       << "\t\t\t\t\t\treads sent to the Unix domain socket (no -i)\n\n"
+       << "Example Usage:\n"
+       << "./QUESS -g 2000000 -i file.fastq\n"
+       << "./QUESS -g 2000000 -i run1.fastq --save-index strain.qidx; ./QUESS -i run2.fastq --load-index strain.qidx\n"
+       << "./QUESS -i run2.fastq --load-index strain.qidx --shard 2/4\n"
+       << "./QUESS -g 2000000 -i file.fastq --max-memory 4G\n"
+       << "./QUESS --load-index strain.qidx --serve /tmp/quess.sock\n"
+       << "demultiplexer | ./QUESS -g 2000000 -i - | aligner"
+       << endl;
+}
+
+
+/**
+  * Name:               bool legal_int(char *str) {
+  *
+  * Description :       determine intger
+  *
+  * Input :
+  *       Parameters:
+  *           char*     str               input char array
+  *
+  *       Return:
+  *           bool                        true if integer    
+  * Process Synopsis :
+  *
+  * Notes :             
+  *
+  */
+
+
+bool legal_int(char *str) {
+    while (*str)
+        if (!isdigit(*str++))
+            return false;
+    return true;
+}
+
+/**
+  * Name:               int main(int argc, char* argv[])
+  *
+  * Description :       Main function of program
+  *
+  * Input :
+  *       Parameters:
+  *           int       argc                Number of arguments passed to program 
+  *           char*     argv[]              An array containing the aforementioned arguments
+  *
+  *
+  * Process Synopsis :
+  *                     [1]  Parse the arguments (--serve: load the index and serve corrections until SHUTDOWN)
+  *                     [2]  QuessCorrector (libquess): creates the working temp files, computes seeds and,
+  *                             for each seed, builds its model (or maps it from a correction index) and
+  *                             corrects the temp fastx file
+  *                     [3]  Write the corrected dataset; delete the working files
+  *
+  * Notes :             The program only uses the libquess interface (libquess.h).
+  *
+  */
+
+int main(int argc, char* argv[])
+{
+
+  time_t total_time_start, total_time_end;
+  time(&total_time_start);
+  int weight = 0, numberOfSeeds = 0;
+  uint64_t genomeLength=0;
+  char *inputFileName = new char [1000];
+  bool setFile=false;
+  char *outputName = NULL;      // --output-file; "-" = standard output
+  const char *compression = "none";     // --compress-output
+  char *saveIndexName = NULL, *loadIndexName = NULL;     // --save-index, --load-index
+  char *socketName = NULL;      // --serve
+  bool staticTable = false;     // --static-table
+  bool bucketTable = false;     // --bucket-table
+  bool compactTable = false;    // --compact-table
+  bool sharded = false;         // --sharded
+  int shard = 0, numberOfShards = 0;    // --shard
+  uint64_t maxMemory = 0;               // --max-memory
+  int modelPartitions = 0;              // --partitions
+  bool resume = false;                  // --resume
+  double convergence = 0;               // --converge
+  bool skipSolid = false;               // --skip-solid
+  int qualitySkip = 0;                  // --quality-skip
+  int normalizeCoverage = 0;            // --normalize
+  vector<string> seeds;                 // --seeds
+  if (argc < 3) {
+      show_usage();
+      return 1;
+  }
+  for (int i = 1; i < argc; ++i) {
+      string arg = argv[i];
+      if ((arg == "-h") || (arg == "--help")) {
+          show_usage();
+          return 0;
+      } 
+      else {
+        if ((arg == "-g") || (arg == "--genome-size")){
+          if (i+1 <argc && legal_int(argv[i+1])){
+              genomeLength=strtoull(argv[i+1], NULL, 10);
+          }
+          else{
+            cerr << "--genome-size requires a integer argument! Run ./QUESS --help for all options!"<<endl; 
+            exit(1);
+          }
+        }
+        if ((arg == "-i") || (arg == "--input-file")){
+          if (i+1 <argc){
+            inputFileName=argv[i+1];
+    	    setFile=true;
+          }
+          else{
+            cerr << "--input-file requires a filename! Run ./QUESS --help for all options!"<<endl; 
+            exit(1);
+          }
+        }
+        if ((arg == "-w") || (arg == "--weight")){
+          if (i+1 <argc && legal_int(argv[i+1]) && strtoull(argv[i+1], NULL, 10)>=10 && strtoull(argv[i+1], NULL, 10)<=26 ){
+            weight=strtoull(argv[i+1], NULL, 10);
+          }
+          else{
+            cerr << "--weight requires an integer between 10 to 26! Run ./QUESS --help for all options!"<<endl; 
+            exit(1);
+          }
+        }
+        if ((arg == "-n") || (arg == "--number-of-seeds")){
+          if (i+1 <argc && legal_int(argv[i+1]) && strtoull(argv[i+1], NULL, 10)>=1 && strtoull(argv[i+1], NULL, 10)<=8 ){
+            numberOfSeeds=strtoull(argv[i+1], NULL, 10);
+          }
+          else{
+            cerr << "--number-of-seeds requires an integer between 1 to 8! Run ./QUESS --help for all options!"<<endl; 
+            exit(1);
+          }
+        }
+        if ((arg == "-o") || (arg == "--output-file")){
+          if (i+1 <argc){
+            outputName=argv[i+1];
+          }
+          else{
+            cerr << "--output-file requires a filename! Run ./QUESS --help for all options!"<<endl; 
+            exit(1);
+          }
+        }
+        if (arg == "--no-io-uring")
+          setAsyncIO(false);
+        if (arg == "--static-table")
+          staticTable = true;
+        if (arg == "--bucket-table")
+          bucketTable = true;
+        if (arg == "--compact-table")
+          compactTable = true;
+        if (arg == "--sharded")
+          sharded = true;
+        if (arg == "--resume")
+          resume = true;
+        if (arg == "--skip-solid")
+          skipSolid = true;
+        if ((arg == "--save-index") || (arg == "--load-index")){
+          if (i+1 <argc){
+            if (arg == "--save-index")
+              saveIndexName=argv[i+1];
+            else
+              loadIndexName=argv[i+1];
+          }
+          else{
+            cerr << arg << " requires a filename! Run ./QUESS --help for all options!"<<endl; 
+            exit(1);
+          }
+        }
+        if (arg == "--shard"){
+          char slash = 0, extra = 0;
+          if (!(i+1 <argc && sscanf(argv[i+1], "%d%c%d%c", &shard, &slash, &numberOfShards, &extra) == 3 && slash == '/'
+                && numberOfShards >= 1 && shard >= 1 && shard <= numberOfShards)){
+            cerr << "--shard requires <i>/<n> with 1 <= i <= n! Run ./QUESS --help for all options!"<<endl; 
+            exit(1);
+          }
+        }
+        if (arg == "--max-memory"){
+          char* end = NULL;
+          if (i+1 <argc && isdigit(argv[i+1][0]))
+            maxMemory=strtoull(argv[i+1], &end, 10);
+          if (end != NULL && (*end == 'K' || *end == 'k'))
+            maxMemory <<= 10, ++end;
+          else if (end != NULL && (*end == 'M' || *end == 'm'))
+            maxMemory <<= 20, ++end;
+          else if (end != NULL && (*end == 'G' || *end == 'g'))
+            maxMemory <<= 30, ++end;
+          if (end == NULL || *end != '\0' || maxMemory == 0){
+            cerr << "--max-memory requires a size in bytes (suffix K, M or G)! Run ./QUESS --help for all options!"<<endl; 
+            exit(1);
+          }
+        }
+        if (arg == "--partitions"){
+          if (i+1 <argc && legal_int(argv[i+1]) && strtoull(argv[i+1], NULL, 10)>=1 && strtoull(argv[i+1], NULL, 10)<=65536 ){
+            modelPartitions=strtoull(argv[i+1], NULL, 10);
+          }
+          else{
+            cerr << "--partitions requires an integer between 1 to 65536! Run ./QUESS --help for all options!"<<endl; 
+            exit(1);
+          }
+        }
+        if (arg == "--normalize"){
+          if (i+1 <argc && legal_int(argv[i+1]) && strtoull(argv[i+1], NULL, 10)>=1 && strtoull(argv[i+1], NULL, 10)<=254 ){
+            normalizeCoverage=strtoull(argv[i+1], NULL, 10);
+          }
+          else{
+            cerr << "--normalize requires an integer between 1 to 254! Run ./QUESS --help for all options!"<<endl; 
+            exit(1);
+          }
+        }
+        if (arg == "--quality-skip"){
+          if (i+1 <argc && legal_int(argv[i+1]) && strtoull(argv[i+1], NULL, 10)>=10 && strtoull(argv[i+1], NULL, 10)<=93 ){
+            qualitySkip=strtoull(argv[i+1], NULL, 10);
+          }
+          else{
+            cerr << "--quality-skip requires an integer between 10 to 93! Run ./QUESS --help for all options!"<<endl; 
+            exit(1);
+          }
+        }
+        if (arg == "--converge"){
+          char* end = NULL;
+          if (i+1 <argc)
+            convergence=strtod(argv[i+1], &end);
+          if (end == NULL || end == argv[i+1] || *end != '\0' || convergence <= 0){
+            cerr << "--converge requires a positive number of corrections per million bases! Run ./QUESS --help for all options!"<<endl; 
+            exit(1);
+          }
+        }
+        if (arg == "--seeds"){
+          if (i+1 <argc){
+            string list = argv[i+1];
+            for (size_t start = 0, end; start <= list.size(); start = end + 1){
+              end = list.find(',', start);
+              if (end == string::npos)
+                end = list.size();
+              seeds.push_back(list.substr(start, end - start));
+            }
+          }
+          else{
+            cerr << "--seeds requires a comma separated list of seeds! Run ./QUESS --help for all options!"<<endl; 
+            exit(1);
+          }
+        }
+        if (arg == "--serve"){
+          if (i+1 <argc){
+            socketName=argv[i+1];
+          }
+          else{
+            cerr << "--serve requires a socket name! Run ./QUESS --help for all options!"<<endl; 
+            exit(1);
+          }
+        }
+        if ((arg == "-z") || (arg == "--compress-output")){
+          if (i+1 <argc){
+            compression=argv[i+1];
+          }
+          else{
+            cerr << "--compress-output requires bgzf, gzip, zstd or none! Run ./QUESS --help for all options!"<<endl; 
+            exit(1);
+          }
+        }
+      }
+    }
+    if (!seeds.empty() && (weight != 0 || numberOfSeeds != 0 || loadIndexName != NULL)){
+      cerr << "--seeds cannot be used with --weight, --number-of-seeds or --load-index! Run ./QUESS --help for all options!"<<endl;
+      exit(1);
+    }
+    if (numberOfSeeds == 0)
+      numberOfSeeds = 8;
+    if (saveIndexName != NULL && loadIndexName != NULL){
+      cerr << "--save-index and --load-index cannot be used together! Run ./QUESS --help for all options!"<<endl;
+      exit(1);
+    }
+    if (staticTable && bucketTable){
+      cerr << "--static-table and --bucket-table cannot be used together! Run ./QUESS --help for all options!"<<endl;
+      exit(1);
+    }
+    if (socketName != NULL){
+      if (loadIndexName == NULL || setFile){
+        cerr << "--serve requires --load-index and no --input-file! Run ./QUESS --help for all options!"<<endl;
+        exit(1);
+      }
+      try {
+        QuessCorrector corrector(genomeLength, weight, numberOfSeeds);
+        corrector.setStaticTables(staticTable);
+        corrector.setBucketTables(bucketTable);
+        corrector.loadIndex(loadIndexName);
+        serveCorrections(corrector, socketName);
+      }
+      catch (const QuessError& error) {
+        cerr << error.what() << endl;
+        return 1;
+      }
+      return 0;
+    }
+    if (genomeLength==0 && loadIndexName == NULL){
+      cerr << "--genome-length is required! Run ./QUESS --help for all options!"<<endl;  
+      exit(1);
+    }
+    if (setFile==false){
+      cerr << "--input-file is required! Run ./QUESS --help for all options!"<<endl;
+      exit(1);
+    }
+    if (numberOfShards > 0 && (loadIndexName == NULL || strcmp(inputFileName, "-") == 0)){
+      cerr << "--shard requires --load-index and an input file (not -)! Run ./QUESS --help for all options!"<<endl;
+      exit(1);
+    }
+    if (strcmp(inputFileName, "-") == 0 && outputName == NULL)
+      outputName = (char*)"-";      // streaming: reads on stdin, corrected reads on stdout
+    if (outputName != NULL && strcmp(outputName, "-") == 0)
+      cout.rdbuf(cerr.rdbuf());     // stdout carries the corrected dataset; messages go to stderr
+    // ============ FILES ====================
+    // inputTempFile = only the reads from the dataset; outputTempFile = only reads but corrected
+    // outputFile = corrected dataset (FASTX); created at the end with headers and scores from original dataset and corrected reads
+
+    try {     // errors of the library (files, dataset format, memory budget) end the run; the working files are removed
+      QuessCorrector corrector(genomeLength, weight, numberOfSeeds);
+      if (!corrector.setCompression(compression)){
+        cerr << "--compress-output requires bgzf, gzip, zstd or none! Run ./QUESS --help for all options!"<<endl; 
+        exit(1);
+      }
+      corrector.setStaticTables(staticTable);
+      corrector.setBucketTables(bucketTable);
+      corrector.setCompactTables(compactTable);
+      corrector.setShardedCounting(sharded);
+      if (!seeds.empty())
+        corrector.setSeeds(seeds);
+      corrector.setMaxMemory(maxMemory);
+      if (modelPartitions > 0)
+        corrector.setModelPartitions(modelPartitions);
+      if (saveIndexName != NULL)
+        corrector.saveIndex(saveIndexName);
+      if (loadIndexName != NULL)
+        corrector.loadIndex(loadIndexName);       // model of every seed from the index; only correction is run
+      if (numberOfShards > 0)
+        corrector.setShard(shard, numberOfShards);
+      corrector.setResume(resume);
+      corrector.setConvergence(convergence);
+      corrector.setSkipSolid(skipSolid);
+      corrector.setNormalize(normalizeCoverage);
+      corrector.setQualitySkip(qualitySkip);
+      corrector.setDataset(inputFileName, outputName);
+
+      //======== START CORRECTING =================
+      corrector.runSeeds();
+
+      // ======== create the "outputFile" ===========
+      // headers and scores from "datasetName" with corrected reads from "outputTempFile"
+      corrector.writeOutput();
+    }
+    catch (const QuessError& error) {
+      cerr << error.what() << endl;
+      return 1;
+    }
+    time(&total_time_end);
+    cout << "\n=================== END (" << difftime(total_time_end, total_time_start) << "s) ======================" << endl;
+    cout << "==================================================" << endl;
+    return 0;
+}
@@ -0,0 +1,208 @@
+/**
+  * File:     narrowTable.cpp
+  *
+  * Author1:  Lucian Ilie (ilie@uwo.ca)
+  * Author2:  Stephen Lu (slu93@uwo.ca)
+  *
+  *   This file contains the narrow counting table of QUESS. The
+  *   default weight for datasets under 1 Gbp is 16, so the 32 bits of
+  *   an sMer (gathered from the positions of the seed) fit a uint32_t,
+  *   while an Element spends 56 bits on it. The NarrowTable keeps the
+  *   keys in one array of Key and the counts in a separate array of
+  *   bytes: about 5 bytes per position instead of 8 for uint32_t, and
+  *   16 keys per cache line instead of 8 (and one bit per position
+  *   telling that its key is written). HashTable selects it from the
+  *   seed (setKeyMask) whenever the sMers fit the key.
+  *
+  */
+
+#include "QUESS.h"
+
+#define NARROW_HASH_MULTIPLIER 0x9E3779B97F4A7C15ULL     // home slot of a key
+
+/**
+  * Name:               fits(uint64_t keyMask)
+  *
+  * Description :       Tells whether the sMers of keyMask can be counted in a NarrowTable<Key>
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t  keyMask             bits of the sMers (Seed::getKeyMask)
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           bool                          true if keyMask has at most 8 * sizeof(Key) bits (weight <= 16 for uint32_t)
+  *
+  * Process Synopsis :
+  *
+  * Notes :
+  *
+  */
+
+template <typename Key>
+bool NarrowTable<Key>::fits(uint64_t keyMask)
+{
+    return (keyMask != 0) && (__builtin_popcountll(keyMask) <= 8 * (int)sizeof(Key));
+}
+
+/**
+  * Name:               NarrowTable(uint64_t keyMask, uint64_t size)
+  *
+  * Description :       Creates an empty counting table of size positions for the sMers of keyMask
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t  keyMask             bits of the sMers (Seed::getKeyMask); fits(keyMask) must hold
+  *           uint64_t  size                number of positions (the size of the HashTable)
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           Key*      keys                size keys
+  *           uint8_t*  counts              size counts, all 0 (empty)
+  *           uint64_t* written             one bit per position, all 0
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  Runs of keyMask, to gather the sMer bits into a key
+  *
+  * Notes :
+  *
+  */
+
+template <typename Key>
+NarrowTable<Key>::NarrowTable(uint64_t keyMask, uint64_t size)
+{
+    this->size = size;
+    numberOfElements = 0;
+    getMaskRuns(keyMask, keyRuns);
+    keys = new Key[size];
+    counts = new uint8_t[size];
+    memset(counts, 0, size * sizeof(uint8_t));
+    written = new uint64_t[(size + 63) / 64];
+    memset(written, 0, ((size + 63) / 64) * sizeof(uint64_t));
+}
+
+template <typename Key>
+NarrowTable<Key>::~NarrowTable()
+{
+    delete [] keys;
+    delete [] counts;
+    delete [] written;
+}
+
+template <typename Key>
+uint64_t NarrowTable<Key>::memoryUsage()
+{
+    return size * (sizeof(Key) + sizeof(uint8_t)) + ((size + 63) / 64) * sizeof(uint64_t);
+}
+
+/**
+  * Name:               insert(uint64_t sMer)
+  *
+  * Description :       Counts one occurrence of sMer
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t  sMer                the sMer
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           counts                        the count of sMer is incremented (up to 255), or sMer is added with count 1
+  *       Return:
+  *           bool                          false if the table is 85% full; then the table must be recreated with
+  *                                         double size, as for HashTable
+  *
+  * Process Synopsis :
+  *                     [1]  key = gathered sMer bits; linear probing from its home slot
+  *                     [2]  An empty slot is taken by setting its count to 1 (compare-and-swap), the key is written
+  *                          and the written bit of the slot set; a count is incremented with a compare-and-swap
+  *
+  * Notes :             Lock free, as the CompactTable: a thread meeting a taken slot waits for its written bit
+  *                     before comparing the key, so the threads counting the same sMer meet on the same slot.
+  *                     Slots are never removed. Counts stop at 255, as in an Element (Tc may be 255 or 256).
+  *
+  */
+
+template <typename Key>
+bool NarrowTable<Key>::insert(uint64_t sMer)
+{
+    Key key = (Key)gatherBits(sMer, keyRuns);
+    uint64_t place = (uint64_t)(((uint128_t)((uint64_t)key * NARROW_HASH_MULTIPLIER) * size) >> 64);
+    for (uint64_t probes = 0; probes < size; ++probes)
+    {
+        uint64_t* word = &written[place / 64];
+        uint64_t bit = (uint64_t)1 << (place % 64);
+        uint8_t count = __atomic_load_n(&counts[place], __ATOMIC_ACQUIRE);
+        while (true)
+        {
+            if (count == 0)                                     // empty: take it
+            {
+                if (!__sync_bool_compare_and_swap(&counts[place], (uint8_t)0, (uint8_t)1))
+                {
+                    count = __atomic_load_n(&counts[place], __ATOMIC_ACQUIRE);
+                    continue;
+                }
+                keys[place] = key;
+                __atomic_fetch_or(word, bit, __ATOMIC_RELEASE);
+                return __sync_add_and_fetch(&numberOfElements, 1) <= 0.85 * size;
+            }
+            while ((__atomic_load_n(word, __ATOMIC_ACQUIRE) & bit) == 0)
+                ;                                               // key being written
+            if (keys[place] != key)
+                break;                                          // another sMer; next slot
+            if (count == 255)
+                return true;
+            uint8_t found = __sync_val_compare_and_swap(&counts[place], count, (uint8_t)(count + 1));
+            if (found == count)
+                return true;
+            count = found;
+        }
+        if (++place == size)
+            place = 0;
+    }
+    return false;
+}
+
+/**
+  * Name:               getEntry(uint64_t place, uint64_t& sMer, uint64_t& count)
+  *
+  * Description :       The sMer and count of a position
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t  place               0 .. size - 1
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           uint64_t& sMer                the sMer of the position (if not empty)
+  *           uint64_t& count               its count; 0 for an empty position
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  sMer = key scattered back to the positions of the seed
+  *
+  * Notes :             Not to be called while sMers are inserted.
+  *
+  */
+
+template <typename Key>
+void NarrowTable<Key>::getEntry(uint64_t place, uint64_t& sMer, uint64_t& count)
+{
+    count = counts[place];
+    if (count != 0)
+        sMer = (uint64_t)scatterBits((uint64_t)keys[place], keyRuns);
+}
+
+template class NarrowTable<uint32_t>;
@@ -0,0 +1,207 @@
+/**
+  * File:     normalize.cpp
+  *
+  * Author1:  Lucian Ilie (ilie@uwo.ca)
+  * Author2:  Stephen Lu (slu93@uwo.ca)
+  *
+  *   This file contains the digital normalization of the reads
+  *   (--normalize): a coverage-capped subset of the reads is
+  *   selected in one pass, using a count-min sketch of their
+  *   k-mers, and the models of the seeds are built from it.
+  *
+  */
+
+#include "QUESS.h"
+#include <algorithm>
+
+// multipliers (odd) of the hash functions of the rows
+static const uint64_t sketchMultipliers[NORMALIZE_SKETCH_DEPTH] =
+    {0x9E3779B97F4A7C15ULL, 0xC2B2AE3D27D4EB4FULL, 0x165667B19E3779F9ULL, 0xD6E8FEB86659FD93ULL};
+
+
+CountMinSketch::CountMinSketch(uint64_t minWidth)
+{
+    width = 1;
+    widthBits = 0;
+    while (width < minWidth)
+    {
+        width <<= 1;
+        ++widthBits;
+    }
+    counters = new uint8_t[NORMALIZE_SKETCH_DEPTH * width];
+    memset(counters, 0, NORMALIZE_SKETCH_DEPTH * width * sizeof(uint8_t));
+}
+
+CountMinSketch::~CountMinSketch()
+{
+    delete [] counters;
+}
+
+/**
+  * Name:               position(uint64_t key, uint64_t row)
+  *
+  * Description :       Position of the counter of key in a row
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t  key                 k-mer (2 bits per base)
+  *           uint64_t  row                 0 .. NORMALIZE_SKETCH_DEPTH - 1
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           uint64_t                      index in counters
+  *
+  * Process Synopsis :
+  *                     [1]  Mix the bits of key (MurmurHash3 finalizer), multiply by the constant of the row
+  *                          and keep the high widthBits bits
+  *
+  * Notes :
+  *
+  */
+
+uint64_t CountMinSketch::position(uint64_t key, uint64_t row)
+{
+    key ^= key >> 33;
+    key *= 0xFF51AFD7ED558CCDULL;
+    key ^= key >> 33;
+    uint64_t h = (widthBits == 0) ? 0 : (key * sketchMultipliers[row]) >> (64 - widthBits);
+    return row * width + h;
+}
+
+uint64_t CountMinSketch::getCount(uint64_t key)
+{
+    uint64_t count = 255;
+    for (uint64_t row = 0; row < NORMALIZE_SKETCH_DEPTH; ++row)
+        count = min(count, (uint64_t)counters[position(key, row)]);
+    return count;
+}
+
+void CountMinSketch::add(uint64_t key)
+{
+    uint64_t count = getCount(key);
+    if (count == 255)
+        return;
+    for (uint64_t row = 0; row < NORMALIZE_SKETCH_DEPTH; ++row)
+    {
+        uint64_t pos = position(key, row);
+        if (counters[pos] == count)
+            counters[pos] = count + 1;
+    }
+}
+
+uint64_t CountMinSketch::memoryUsage()
+{
+    return NORMALIZE_SKETCH_DEPTH * width * sizeof(uint8_t);
+}
+
+/**
+  * Name:               selectModelReads(BlockReader& inputTempFile, uint64_t genomeLength, int coverage, uint64_t* modelReads, int64_t& modelReadLength, uint64_t& peakMemory, uint64_t& currentMemory)
+  *
+  * Description :       Selects the reads the models are built from (digital normalization)
+  *
+  * Input :
+  *       Parameters:
+  *           BlockReader& inputTempFile    The reads (one per line)
+  *           uint64_t  genomeLength        Estimated length of the genome (size of the sketch)
+  *           int       coverage            Coverage of the k-mers of the reads kept (1 .. 254)
+  *           uint64_t* modelReads          destination; (numberOfReads + 63) / 64 words, cleared
+  *           int64_t&  modelReadLength     destination
+  *           uint64_t  &peakMemory         Peak memory of program
+  *           uint64_t  &currentMemory      Current memory of program
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           uint64_t* modelReads          bit i set: read i is kept for the models
+  *           int64_t&  modelReadLength     total length of the reads kept
+  *       Memory:
+  *           None
+  *       Return:
+  *           int64_t                       number of reads kept
+  *
+  * Process Synopsis :
+  *                     [1]  For each read, in order: canonical k-mers (min of the k-mer and its reverse complement;
+  *                          positions not in {A,C,G,T} break the k-mers)
+  *                     [2]  Median of their estimated counts in the sketch; below coverage: keep the read and add
+  *                          its k-mers to the sketch
+  *
+  * Notes :             A single sequential pass (the decision for a read depends on the reads kept before it), so
+  *                     the subset is the same for any number of threads. Reads without k-mers are kept.
+  *                     The k-mers of a kept read that contains an error are rare in the sketch, but the median
+  *                     is decided by its correct k-mers.
+  *
+  */
+
+int64_t selectModelReads(BlockReader& inputTempFile, uint64_t genomeLength, int coverage, uint64_t* modelReads, int64_t& modelReadLength, uint64_t& peakMemory, uint64_t& currentMemory)
+{
+    quessLog << "\n============ NORMALIZE COVERAGE ============\n";
+    time_t t_start, t_end;
+    time(&t_start);
+
+    CountMinSketch sketch(NORMALIZE_SKETCH_FACTOR * genomeLength);
+    char* read = new char[MAX_READ_LENGTH];
+    uint64_t* keys = new uint64_t[MAX_READ_LENGTH];
+    uint64_t* counts = new uint64_t[MAX_READ_LENGTH];
+    currentMemory+=sketch.memoryUsage()+MAX_READ_LENGTH*(sizeof(char)+2*sizeof(uint64_t));
+    if (currentMemory > peakMemory)
+    {
+        peakMemory = currentMemory;
+#ifdef VERBOSE
+        quessLog << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
+#endif
+    }
+
+    uint64_t kMerMask = ((uint64_t)1 << (2 * NORMALIZE_K)) - 1;
+    int64_t readNumber = 0, keptReads = 0;
+    modelReadLength = 0;
+    inputTempFile.rewind();
+    while (inputTempFile.getline(read, MAX_READ_LENGTH))
+    {
+        // canonical k-mers of the read
+        uint64_t numberOfKeys = 0, kMer = 0, kMerRC = 0, run = 0;
+        uint64_t length = strlen(read);
+        for (uint64_t pos = 0; pos < length; ++pos)
+        {
+            if (!isBase2Bit(read[pos]))
+            {
+                run = 0;
+                continue;
+            }
+            uint64_t base = encodeBase2Bit(read[pos]);
+            kMer   = ((kMer << 2) | base) & kMerMask;
+            kMerRC = (kMerRC >> 2) | ((3 - base) << (2 * (NORMALIZE_K - 1)));
+            if (++run >= NORMALIZE_K)
+                keys[numberOfKeys++] = min(kMer, kMerRC);
+        }
+        // median estimated count
+        bool keep = (numberOfKeys == 0);
+        if (!keep)
+        {
+            for (uint64_t i = 0; i < numberOfKeys; ++i)
+                counts[i] = sketch.getCount(keys[i]);
+            nth_element(counts, counts + numberOfKeys / 2, counts + numberOfKeys);
+            keep = (counts[numberOfKeys / 2] < (uint64_t)coverage);
+        }
+        if (keep)
+        {
+            for (uint64_t i = 0; i < numberOfKeys; ++i)
+                sketch.add(keys[i]);
+            modelReads[readNumber >> 6] |= (uint64_t)1 << (readNumber & 63);
+            ++keptReads;
+            modelReadLength += length;
+        }
+        ++readNumber;
+    }
+
+    delete [] read;
+    delete [] keys;
+    delete [] counts;
+    currentMemory-=sketch.memoryUsage()+MAX_READ_LENGTH*(sizeof(char)+2*sizeof(uint64_t));
+    time(&t_end);
+    quessLog << "Reads kept for the models: " << keptReads << " of " << readNumber << " (coverage " << coverage << ")" << endl;
+    quessLog << "============ DONE normalizing (" << difftime(t_end,t_start) << "s) ===========\n" << endl;
+    return keptReads;
+}
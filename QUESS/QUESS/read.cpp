@@ -14,15 +14,16 @@
 
 #include "QUESS.h"
 
+static bool lookupReuse = true;     // later passes of correctWindows reuse the lookups of unchanged windows
 
 /**
-  * Name:             Read()
+  * Name:               setLookupReuse(bool enabled)
   *
-  * Description :     Default constructor
+  * Description :       Enables or disables the reuse of the lookups of unchanged windows (correctWindows)
   *
   * Input :
   *       Parameters:
-  *           None
+  *           bool      enabled             false: every pass looks up all the windows
   *
   * Output/Expected Changes :
   *       Parameters:
@@ -30,59 +31,61 @@
   *       Memory:
   *           None
   *       Return:
-  *           Read                      Returns a blank read
+  *           None
   *
   * Process Synopsis :
   *
-  * Notes :             
+  * Notes :             The corrections are the same either way; full passes are kept to check it (make test).
   *
   */
 
-Read::Read()
+void setLookupReuse(bool enabled)
 {
-    length = numberOfNs = 0;
+    lookupReuse = enabled;
 }
 
-// nucleotide-wise reverse complements of all 8-bit values, that is, bit-negation: A = 00 --rc--> 11 = T; C = 01 --rc--> 10 = G, and so on
-const uint8_t byteRC[256] = {
-    255, 191, 127, 63, 239, 175, 111, 47, 223, 159, 95, 31, 207, 143, 79, 15, 251, 187, 123, 59, 235, 171, 107, 43, 219, 155, 91, 27, 203, 139, 75, 11, 247, 183, 119, 55, 231, 167, 103, 39, 215, 151, 87, 23, 199, 135, 71, 7, 243, 179, 115, 51, 227, 163, 99, 35, 211, 147, 83, 19, 195, 131, 67, 3, 254, 190, 126, 62, 238, 174, 110, 46, 222, 158, 94, 30, 206, 142, 78, 14, 250, 186, 122, 58, 234, 170, 106, 42, 218, 154, 90, 26, 202, 138, 74, 10, 246, 182, 118, 54, 230, 166, 102, 38, 214, 150, 86, 22, 198, 134, 70, 6, 242, 178, 114, 50, 226, 162, 98, 34, 210, 146, 82, 18, 194, 130, 66, 2, 253, 189, 125, 61, 237, 173, 109, 45, 221, 157, 93, 29, 205, 141, 77, 13, 249, 185, 121, 57, 233, 169, 105, 41, 217, 153, 89, 25, 201, 137, 73, 9, 245, 181, 117, 53, 229, 165, 101, 37, 213, 149, 85, 21, 197, 133, 69, 5, 241, 177, 113, 49, 225, 161, 97, 33, 209, 145, 81, 17, 193, 129, 65, 1, 252, 188, 124, 60, 236, 172, 108, 44, 220, 156, 92, 28, 204, 140, 76, 12, 248, 184, 120, 56, 232, 168, 104, 40, 216, 152, 88, 24, 200, 136, 72, 8, 244, 180, 116, 52, 228, 164, 100, 36, 212, 148, 84, 20, 196, 132, 68, 4, 240, 176, 112, 48, 224, 160, 96, 32, 208, 144, 80, 16, 192, 128, 64, 0
-};
+// key of the window bits under a mask (aligned right): the bits themselves in a 64-bit window,
+// the bits gathered (Seed::getSMerRuns, getSGapRuns) in the 128-bit window of a wide seed
+static inline uint64_t windowKey(uint64_t bits, const MaskRuns& runs)
+{   return bits;    }
+
+static inline uint64_t windowKey(uint128_t bits, const MaskRuns& runs)
+{   return gatherBits(bits, runs);    }
+
+// inverse of windowKey
+static inline void keyToWindow(uint64_t key, const MaskRuns& runs, uint64_t& bits)
+{   bits = key;     }
+
+static inline void keyToWindow(uint64_t key, const MaskRuns& runs, uint128_t& bits)
+{   bits = scatterBits(key, runs);  }
+
 
 /**
-  * Name:               computeRevCompl(uint64_t x)
+  * Name:             Read()
   *
-  * Description :       Computes the reverse complement of integer x
+  * Description :     Default constructor
   *
   * Input :
   *       Parameters:
-  *           uint64_t  x               Integer to be given the reverse complement of
+  *           None
   *
   * Output/Expected Changes :
   *       Parameters:
   *           None
   *       Memory:
   *           None
-  *       Return:                       
-  *           int64_t                   Returns the reverse complement
+  *       Return:
+  *           Read                      Returns a blank read
   *
   * Process Synopsis :
-  *                     [1]  Iterates through the integer using masks 
   *
-  * Notes :             Ex. Reverse complement of 000101011101 is 010001010111.
+  * Notes :             
   *
   */
 
-uint64_t computeRevCompl(uint64_t x)
+Read::Read()
 {
-    // computes the reverse complement of integer x
-    uint64_t y = 0, mask = (1 << 8) - 1;
-    for (uint64_t i = 0; i < 7; ++i) {
-        y |= byteRC[(uint8_t)(x & mask)];
-        y <<= 8;
-        x >>= 8;
-    }
-    y |= byteRC[(uint8_t)(x & mask)];
-    return(y);
+    length = numberOfNs = 0;
 }
 
 /**
@@ -129,42 +132,14 @@ Read::Read(char* inputString)
         binRead[i] = 0;
     numberOfNs = 0;
     for (uint64_t currCharPos = 0, currByte = 0; currCharPos < length; ++currCharPos)
-    {   switch (inputString[currCharPos])
-        {   case 'A':
-                binRead[currByte] <<= 2;
-                break;
-            case 'a':
-                binRead[currByte] <<= 2;
-                break;
-            case 'C':
-                binRead[currByte] <<= 2;
-                binRead[currByte] |= 1;
-                break;
-            case 'c':
-                binRead[currByte] <<= 2;
-                binRead[currByte] |= 1;
-                break;
-            case 'G':
-                binRead[currByte] <<= 2;
-                binRead[currByte] |= 2;
-                break;
-            case 'g':
-                binRead[currByte] <<= 2;
-                binRead[currByte] |= 2;
-                break;
-            case 'T':
-                binRead[currByte] <<= 2;
-                binRead[currByte] |= 3;
-                break;
-            case 't':
-                binRead[currByte] <<= 2;
-                binRead[currByte] |= 3;
-                break;
-            default:
-                binRead[currByte] <<= 2;
-                binRead[currByte] |= rand() % 4; // replace N's with random bases
-                ++numberOfNs;
-                break;
+    {
+        binRead[currByte] <<= 2;
+        if (isBase2Bit(inputString[currCharPos]))
+            binRead[currByte] |= encodeBase2Bit(inputString[currCharPos]);
+        else
+        {
+            binRead[currByte] |= rand() % 4; // replace N's with random bases
+            ++numberOfNs;
         }
         if (currCharPos % 4 == 3)   // move to next byte
             ++currByte;             // currCharPos % 4 == 0 next iteration
@@ -204,7 +179,7 @@ int64_t Read::getLength()
 }
 
 /**
-  * Name:               insertSMersOfRead(HashTable& H, Seed& seed)
+  * Name:               insertSMersOfWindows(HashTable& H, Seed& seed)
   *
   * Description :       Inserts all of the sMers of this read
   *
@@ -232,34 +207,38 @@ int64_t Read::getLength()
   *
   */
 
-bool Read::insertSMersOfRead(HashTable& H, Seed& seed)
+template <class Window>
+bool Read::insertSMersOfWindows(HashTable& H, Seed& seed)
 {
     // Inserts all of the S-Mers found in this read into the hashtable, is expected to be done in parallel
     if (numberOfNs > length / 2)        // skip reads with half N's
         return true;
     if (seed.getLength() + 2 > length)      // seed too long for read; do nothing (+2 is needed for sGap that includes adjacent positions)
         return true;
-    uint64_t sMerMask = seed.getSMerMask(), sMerMaskRC = seed.getSMerMaskRC();
+    Window sMerMask, sGapMask, sMerMaskRC, sGapMaskRC;
+    seed.getMasks(sMerMask, sGapMask, sMerMaskRC, sGapMaskRC);
+    const MaskRuns& sMerRuns = seed.getSMerRuns();
+    uint64_t windowBits = 8 * sizeof(Window);                                           // window length in bits
     uint64_t binLength = length * 2;                                                    // length in bits
     uint64_t maskLength = 2 * (seed.getLength() + 2);                                   // mask length in bits
     uint64_t binBytes = binLength / 8 + ((binLength % 8 == 0) ? 0 : 1);   // length in bytes
     uint64_t sMer = 0, sMerRC = 0, minSMer = 0;             // minSMer = min(sMer,sMerRC) is in the table
-    uint64_t window = 0, windowRC = 0;                      // 64-bit windows to slide through the read and readRC resp.
+    Window window = 0, windowRC = 0;                        // windows (64 or 128 bits) to slide through the read and readRC resp.
     // sMerMask, sGapMask are aligned to the left, sMerMastRC, sGapMaskRC to the right
     // initialize working windows;
     window = windowRC = 0;
-    for (uint64_t i = 0; i < min((uint64_t)8, binBytes); ++i)
+    for (uint64_t i = 0; i < min((uint64_t)sizeof(Window), binBytes); ++i)
     {
-        window   |= ((uint64_t)binRead[i]         << 8 * (7 - i));
-        windowRC |= ((uint64_t)byteRC[binRead[i]] << 8 * i      );
+        window   |= ((Window)binRead[i]                   << 8 * (sizeof(Window) - 1 - i));
+        windowRC |= ((Window)revComplByte2Bit(binRead[i]) << 8 * i);
     }
     
     // there are (binLength - masklength)/2 + 1 possible shifts to consider
     for (uint64_t shift = 0; shift <= (binLength - maskLength) / 2; ++shift)
     {
         // compute sMer and sMerRC and insert the min in the table
-        sMer   = (window   & sMerMask) >> (64 - maskLength);
-        sMerRC = (windowRC & sMerMaskRC);
+        sMer   = windowKey((window   & sMerMask) >> (windowBits - maskLength), sMerRuns);
+        sMerRC = windowKey(windowRC & sMerMaskRC, sMerRuns);
         // the min is taken to reduce redundancy
         minSMer = min(sMer, sMerRC);
         if(H.insertSMer(minSMer) == false)          // table too full; need to restart
@@ -270,11 +249,11 @@ bool Read::insertSMersOfRead(HashTable& H, Seed& seed)
         windowRC >>= 2;
         if (shift%4 == 3)   // add new bytes (if any) every 4 shifts (shifts 3, 7, 11, ...)
         {
-            uint64_t nextByte = 8 + (shift + 1) / 4 - 1;
+            uint64_t nextByte = sizeof(Window) + (shift + 1) / 4 - 1;
             if (binBytes > nextByte)  // if unprocesssed bytes exist
             {
-                window |= (uint64_t)binRead[nextByte];
-                windowRC |= ((uint64_t)(byteRC[binRead[nextByte]]) << 56);
+                window |= (Window)binRead[nextByte];
+                windowRC |= ((Window)revComplByte2Bit(binRead[nextByte]) << (windowBits - 8));
             }
         }
     }
@@ -282,7 +261,7 @@ bool Read::insertSMersOfRead(HashTable& H, Seed& seed)
 }
 
 /**
-  * Name:               insertSGapsOfRead(HashTable& H, Seed& seed, uint64_t Te, uint64_t Ta, omp_lock_t* lockArray)
+  * Name:               insertSGapsOfWindows(HashTable& H, Seed& seed, uint64_t Te, int seedNumber, omp_lock_t* lockArray)
   *
   * Description :       Inserts all of the sGaps of the sMers of this read
   *
@@ -313,36 +292,41 @@ bool Read::insertSMersOfRead(HashTable& H, Seed& seed)
   *
   */
 
-void Read::insertSGapsOfRead(HashTable& H, Seed& seed, uint64_t Te, int seedNumber, omp_lock_t* lockArray)
+template <class Window>
+void Read::insertSGapsOfWindows(HashTable& H, Seed& seed, uint64_t Te, int seedNumber, omp_lock_t* lockArray)
 {
     // Inserts all the SGaps of the read into the hashtable, expected to be done in parallel
     if (numberOfNs > length / 2)        // skip reads with half N's
         return;
     if (seed.getLength() + 2 > length)      // seed too long for read; do nothing (+2 is needed for the sGap -- adjacent positions needed)
         return;
-    uint64_t sMerMask = seed.getSMerMask(), sMerMaskRC = seed.getSMerMaskRC(), sGapMask = seed.getSGapMask(), sGapMaskRC = seed.getSGapMaskRC();
+    Window sMerMask, sGapMask, sMerMaskRC, sGapMaskRC;
+    seed.getMasks(sMerMask, sGapMask, sMerMaskRC, sGapMaskRC);
+    const MaskRuns& sMerRuns = seed.getSMerRuns();
+    const MaskRuns& sGapRuns = seed.getSGapRuns();
+    uint64_t windowBits = 8 * sizeof(Window);                                           // window length in bits
     uint64_t binLength = length * 2;                                                    // length in bits
     uint64_t maskLength = 2 * (seed.getLength() + 2);                                   // mask length in bits
     uint64_t binBytes = binLength / 8 + ((binLength % 8 == 0) ? 0 : 1);   // length in bytes
     uint64_t sMer = 0, sMerRC = 0, minSMer = 0, sGap = 0, sGapRC = 0, minSGap = 0;      // min SMer = min(sMer,sMerRC) is the table, minSGap is the corresponding sGap
-    uint64_t window = 0, windowRC = 0;                      // 64-bit windows to slide through the read and readRC resp.
+    Window window = 0, windowRC = 0;                        // windows (64 or 128 bits) to slide through the read and readRC resp.
     // sMerMask, sGapMask are applied to the left, sMerMastRC, sGapMaskRC to the right
     // initialize working windows
     window = windowRC = 0;
-    for (uint64_t i = 0; i < min((uint64_t)8, binBytes); ++i)
+    for (uint64_t i = 0; i < min((uint64_t)sizeof(Window), binBytes); ++i)
     {
-        window   |= ((uint64_t)binRead[i]         << 8 * (7 - i));
-        windowRC |= ((uint64_t)byteRC[binRead[i]] << 8 * i      );
+        window   |= ((Window)binRead[i]                   << 8 * (sizeof(Window) - 1 - i));
+        windowRC |= ((Window)revComplByte2Bit(binRead[i]) << 8 * i);
     }
     
     // there are (binLength - masklength)/2 + 1 possible shifts to consider
     for (uint64_t shift = 0; shift <= (binLength - maskLength) / 2; ++shift)
     {
         // compute sMer and sMerRC and search the min in the table
-        sMer   = (window   & sMerMask) >> (64 - maskLength);
-        sGap   = (window   & sGapMask) >> (64 - maskLength);
-        sMerRC = (windowRC & sMerMaskRC);
-        sGapRC = (windowRC & sGapMaskRC);
+        sMer   = windowKey((window   & sMerMask) >> (windowBits - maskLength), sMerRuns);
+        sGap   = windowKey((window   & sGapMask) >> (windowBits - maskLength), sGapRuns);
+        sMerRC = windowKey(windowRC & sMerMaskRC, sMerRuns);
+        sGapRC = windowKey(windowRC & sGapMaskRC, sGapRuns);
         // the min is taken to reduce redundancy
         minSMer = min(sMer, sMerRC);
         minSGap = (sMer < sMerRC) ? sGap : sGapRC;        
@@ -352,11 +336,11 @@ void Read::insertSGapsOfRead(HashTable& H, Seed& seed, uint64_t Te, int seedNumb
         windowRC >>= 2;
         if (shift%4 == 3)   // add new bytes (if any) every 4 shifts (shifts 3, 7, 11, ...)
         {
-            uint64_t nextByte = 8 + (shift + 1) / 4 - 1;
+            uint64_t nextByte = sizeof(Window) + (shift + 1) / 4 - 1;
             if (binBytes > nextByte)  // if unprocesssed bytes exist
             {
-                window |= (uint64_t)binRead[nextByte];
-                windowRC |= ((uint64_t)(byteRC[binRead[nextByte]]) << 56);
+                window |= (Window)binRead[nextByte];
+                windowRC |= ((Window)revComplByte2Bit(binRead[nextByte]) << (windowBits - 8));
             }
         }
     }
@@ -364,17 +348,17 @@ void Read::insertSGapsOfRead(HashTable& H, Seed& seed, uint64_t Te, int seedNumb
 }
 
 /**
-  * Name:               correctBinaryReadFast(HashTable& H, Seed& seed, uint64_t Tdiff, uint64_t* diff16Bits, uint64_t &corr)
+  * Name:               correctWindows(Table& H, Seed& seed, uint64_t Tdiff, uint64_t &corr, const uint64_t* lowQuality)
   *
   * Description :       corrects the 2-bit representation to the correct variant as determined by the hashTable
   *
   * Input :
   *       Parameters:
-  *           HashTable& H             The hashTable to be inserted into
+  *           Table&     H             The hashTable (or, for QUESS_mpi, the LookupCache of the sMers of all ranks)
   *           Seed&      seed          The reference seed to draw the correct mask for this iteration
   *           uint64_t   Tdiff         The acceptable difference between the old read sGap and the replacing read sGap
-  *           uint64_t*  diff16Bits    Precomputed array to determine the difference between the sGaps
   *           uint64_t   &corr         The number of corrections made so far
+  *           const uint64_t* lowQuality  bit set of the low quality positions (getLowQualityPositions); NULL = all looked up
   *
   * Output/Expected Changes :
   *       Parameters:
@@ -389,35 +373,62 @@ void Read::insertSGapsOfRead(HashTable& H, Seed& seed, uint64_t Te, int seedNumb
   *                     [2]  Fetches the identity of the sMer/sGap and its sMerRC/sGapRC by ANDing the sMer/sGap masks
   *                     [3]  Takes the lesser of the two sGaps and sets the correct sGap given by getCorrectSGap()
   *                     [4]  Shifts the masks and repeats the 2-3 if there were errors found in the first iteration, at max 3 times
+  *                          (a window whose content is the same as in the previous iteration reuses the result of its lookup)
   *
   * Notes :             Assumed that the first sGap associated with the sMer is the correct one, as computed by removeAmbig 
   *                     Note that multiple iterations are required because changes on prior iterations may change outcome of following
   *                     iterations.
+  *                     The lookups of the later iterations are needed only for the windows that overlap positions
+  *                     changed since their previous lookup: the model does not change during the correction, so a
+  *                     window with the same content gets the same answer (and the same correction). The content
+  *                     (sMer and sGap bits of the direct window) and the answer of each window are kept, and the
+  *                     answer is reused when the content is unchanged; the result is the same as with full passes.
+  *                     With lowQuality, a window whose sGap positions all have high quality scores is taken as correct
+  *                     without looking up its sMer (the lookups are most of the correction time); its sGap is neither
+  *                     corrected nor counted as erroneous.
+  *                     Instantiated for HashTable and LookupCache and both window widths at the end of this file.
   *
   */
 
 
-int64_t Read::correctBinaryReadFast(HashTable& H, Seed& seed, uint64_t Tdiff, uint64_t* diff16Bits, uint64_t &corr)
+template <class Table, class Window>
+int64_t Read::correctWindows(Table& H, Seed& seed, uint64_t Tdiff, uint64_t &corr, const uint64_t* lowQuality)
 {
     // corrects a read given only one correct variant of each SGap
     if (numberOfNs > length / 2)        // skip reads with half N's
         return -1;
     if (seed.getLength() + 2 > length)      // seed too long for read; do nothing (+2 is needed for the sGap -- adjacent positions needed)
         return -1;
-    uint64_t sMerMask = seed.getSMerMask(), sMerMaskRC = seed.getSMerMaskRC(), sGapMask = seed.getSGapMask(), sGapMaskRC = seed.getSGapMaskRC();
+    Window sMerMask, sGapMask, sMerMaskRC, sGapMaskRC;
+    seed.getMasks(sMerMask, sGapMask, sMerMaskRC, sGapMaskRC);
+    const MaskRuns& sMerRuns = seed.getSMerRuns();
+    const MaskRuns& sGapRuns = seed.getSGapRuns();
+    uint64_t windowBits = 8 * sizeof(Window);                                           // window length in bits
     uint64_t binLength = length * 2;                                                    // length in bits
     uint64_t maskLength = 2 * (seed.getLength() + 2);                                   // mask length in bits
     uint64_t binBytes = binLength / 8 + ((binLength % 8 == 0) ? 0 : 1);   // length in bytes
     uint64_t sMer = 0, sMerRC = 0, minSMer = 0, sGap = 0, sGapRC = 0, minSGap = 0;      // min SMer = min(sMer,sMerRC) is the table, minSGap is the corresponding sGap
-    uint64_t correctSGapInTable = 0, correctSGap = 0, correctSGapRC = 0;                // correctSGapInTable is the correct sGap in hash table (corrspondign to minSGap); correctSGap is the direct correct sGap and correctSGapRC is the rev compl correct sGap
-    uint64_t window = 0, windowRC = 0;                      // 64-bit windows to slide through the read and readRC resp.
+    uint64_t correctSGapInTable = 0;                    // correctSGapInTable is the correct sGap in hash table (corrspondign to minSGap)
+    Window correctSGap = 0, correctSGapRC = 0;          // correctSGap is the direct correct sGap and correctSGapRC is the rev compl correct sGap
+    Window window = 0, windowRC = 0;                        // windows (64 or 128 bits) to slide through the read and readRC resp.
     uint8_t processedByte = 0;
-    uint64_t leftmostTwoBits = (uint64_t)3 << 62;         // processedByte accumulates processed bits (as they fall off shifted at the end of working window)
+    Window leftmostTwoBits = (Window)3 << (windowBits - 2);   // processedByte accumulates processed bits (as they fall off shifted at the end of working window)
     // sMerMask, sGapMask are applied to the left, sMerMastRC, sGapMaskRC to the right
     
     int64_t errPositions = 1;   // will store the number of erroneous positions suspected
     uint64_t numberOfShifts = (binLength - maskLength) / 2 + 1;
     uint64_t iterations = 0;
+    uint64_t sGapPositions = 0;     // bit j set: position j of the window is in the sGap (for lowQuality)
+    // content (direct window under the masks), answer and correct sGap of the last lookup of each window
+    Window windowMask = sMerMask | sGapMask;
+    Window seenWindow[MAX_READ_LENGTH];
+    uint64_t seenCorrectSGap[MAX_READ_LENGTH];
+    int64_t seenStatus[MAX_READ_LENGTH];
+    bool reuse = lookupReuse;
+    if (lowQuality != NULL)
+        for (uint64_t j = 0; j < seed.getLength() + 2; ++j)
+            if ((sGapMask >> (windowBits - 2 - 2 * j)) & 3)
+                sGapPositions |= (uint64_t)1 << j;
     
     while ((iterations < 3) && (errPositions > 0))
     {
@@ -426,19 +437,19 @@ int64_t Read::correctBinaryReadFast(HashTable& H, Seed& seed, uint64_t Tdiff, ui
         // CORRECT READ
         // initialize working windows
         window = windowRC = 0;
-        for (uint64_t i = 0; i < min((uint64_t)8, binBytes); ++i)
+        for (uint64_t i = 0; i < min((uint64_t)sizeof(Window), binBytes); ++i)
         {
-            window   |= ((uint64_t)binRead[i]         << 8 * (7 - i));
-            windowRC |= ((uint64_t)byteRC[binRead[i]] << 8 * i      );
+            window   |= ((Window)binRead[i]                   << 8 * (sizeof(Window) - 1 - i));
+            windowRC |= ((Window)revComplByte2Bit(binRead[i]) << 8 * i);
         }
         // there are  numberOfShifts = (binLength - masklength) / 2 + 1 possible shifts to consider
         for (uint64_t shift = 0; shift < numberOfShifts; ++shift)
         {
             // compute sMer and sMerRC and search the min in the table
-            sMer   = (window   & sMerMask) >> (64 - maskLength);
-            sGap   = (window   & sGapMask) >> (64 - maskLength);
-            sMerRC = (windowRC & sMerMaskRC);
-            sGapRC = (windowRC & sGapMaskRC);
+            sMer   = windowKey((window   & sMerMask) >> (windowBits - maskLength), sMerRuns);
+            sGap   = windowKey((window   & sGapMask) >> (windowBits - maskLength), sGapRuns);
+            sMerRC = windowKey(windowRC & sMerMaskRC, sMerRuns);
+            sGapRC = windowKey(windowRC & sGapMaskRC, sGapRuns);
             
             // perform correction: change both working windows and store changes to be copied in binRead[]
             bool directSMerStored = (sMer < sMerRC);
@@ -447,7 +458,28 @@ int64_t Read::correctBinaryReadFast(HashTable& H, Seed& seed, uint64_t Tdiff, ui
             // get correctSGapInTable; if it exists, then correct working windows
             // getCorrectSGap returns: -3: sMer not in table; -2: sMer ambiguous; -1: sGap too different (sMer is in table and NOT ambiguous)
             //              0: already correct; count >= 1: correctSGap NOT too different; correction can be done
-            int64_t corrStatus = H.getCorrectSGap(minSMer, minSGap, correctSGapInTable, Tdiff, diff16Bits);
+            int64_t corrStatus = 0;
+            if (reuse && (iterations > 0) && (seenWindow[shift] == (window & windowMask)))     // unchanged since the last lookup
+            {
+                corrStatus = seenStatus[shift];
+                correctSGapInTable = seenCorrectSGap[shift];
+            }
+            else
+            {
+                if (lowQuality == NULL)
+                    corrStatus = H.getCorrectSGap(minSMer, minSGap, correctSGapInTable, Tdiff);
+                else
+                {   // low quality positions of the window (positions shift, shift + 1, ...)
+                    uint64_t lowWindow = lowQuality[shift / 64] >> (shift % 64);
+                    if ((shift % 64 != 0) && (shift / 64 + 1 < QUALITY_WORDS))
+                        lowWindow |= lowQuality[shift / 64 + 1] << (64 - shift % 64);
+                    if (lowWindow & sGapPositions)
+                        corrStatus = H.getCorrectSGap(minSMer, minSGap, correctSGapInTable, Tdiff);
+                }
+                seenWindow[shift] = window & windowMask;
+                seenStatus[shift] = corrStatus;
+                seenCorrectSGap[shift] = correctSGapInTable;
+            }
             if (corrStatus != 0)    // count erroneous positions
                 ++errPositions;
             if (corrStatus > 0)     // can be corrected
@@ -455,13 +487,14 @@ int64_t Read::correctBinaryReadFast(HashTable& H, Seed& seed, uint64_t Tdiff, ui
                 ++corr;
                 if (directSMerStored)  // correctSGapInTable is the direct sGap but aligned right
                 {
-                    correctSGap   = correctSGapInTable << (64 - maskLength);
-                    correctSGapRC = computeRevCompl(correctSGap) & sGapMaskRC;
+                    keyToWindow(correctSGapInTable, sGapRuns, correctSGap);
+                    correctSGap <<= (windowBits - maskLength);
+                    correctSGapRC = revCompl2Bit(correctSGap) & sGapMaskRC;
                 }
                 else        // correctSGapInTable is the rev compl sGap
                 {
-                    correctSGapRC = correctSGapInTable;
-                    correctSGap   = computeRevCompl(correctSGapRC) & sGapMask;      // the correct direct sGap
+                    keyToWindow(correctSGapInTable, sGapRuns, correctSGapRC);
+                    correctSGap   = revCompl2Bit(correctSGapRC) & sGapMask;      // the correct direct sGap
                 }
                 // change direct window
                 window &= (~ sGapMask);                          // set on 0 all mask bits
@@ -472,7 +505,7 @@ int64_t Read::correctBinaryReadFast(HashTable& H, Seed& seed, uint64_t Tdiff, ui
             }   // done changing working windows
             
             // store the leftmost 2 processed bits to be copied back into binRead[] (before they fall off the end of the working window)
-            processedByte |= (uint8_t)((window & leftmostTwoBits) >> (56 + 2 * (shift % 4)));
+            processedByte |= (uint8_t)((window & leftmostTwoBits) >> (windowBits - 8 + 2 * (shift % 4)));
             
             // copy corrections (accumulated in processedByte) back to binRead[] every 4 shifts
             if (shift % 4 == 3)
@@ -486,11 +519,11 @@ int64_t Read::correctBinaryReadFast(HashTable& H, Seed& seed, uint64_t Tdiff, ui
             windowRC >>= 2;
             if (shift % 4 == 3)   // add new bytes (if any) every 4 shifts (shifts 3, 7, 11, ...)
             {
-                uint64_t nextByte = 8 + (shift + 1) / 4 - 1;
+                uint64_t nextByte = sizeof(Window) + (shift + 1) / 4 - 1;
                 if (binBytes > nextByte)  // if unprocesssed bytes exist
                 {
-                    window |= (uint64_t)binRead[nextByte];
-                    windowRC |= ((uint64_t)(byteRC[binRead[nextByte]]) << 56);
+                    window |= (Window)binRead[nextByte];
+                    windowRC |= ((Window)revComplByte2Bit(binRead[nextByte]) << (windowBits - 8));
                 }
             }
         }       // done all shifts
@@ -498,7 +531,7 @@ int64_t Read::correctBinaryReadFast(HashTable& H, Seed& seed, uint64_t Tdiff, ui
         // continue shifting from where we left off: shift = (binLength - maskLength) / 2 + 1
         for (uint64_t shift = numberOfShifts; shift < binLength / 2; ++shift)
         {
-            processedByte |= (uint8_t)((window & leftmostTwoBits) >> (56 + 2 * (shift % 4)));
+            processedByte |= (uint8_t)((window & leftmostTwoBits) >> (windowBits - 8 + 2 * (shift % 4)));
             if (shift % 4 == 3)
             {
                 binRead[(shift - 3) / 4] = processedByte;
@@ -551,20 +584,7 @@ void Read::correctCharRead()
     for (uint64_t pos = 0; pos < length; ++pos)
     {
         charValue = (currByteValue & (3 << 6)) >> 6;    // leftmost 2 bits of the byte shifted right
-        switch (charValue)
-        {   case 0:
-                charRead[pos] = 'A';
-                break;
-            case 1:
-                charRead[pos] = 'C';
-                break;
-            case 2:
-                charRead[pos] = 'G';
-                break;
-            case 3:
-                charRead[pos] = 'T';
-                break;
-        }
+        charRead[pos] = decodeBase2Bit(charValue);
         currByteValue <<= 2;
         if (pos % 4 == 3)   // move to next byte
         {
@@ -632,3 +652,147 @@ void Read::outputRead(char* outputString)
     strcpy(outputString, charRead);
 }
 
+/**
+  * Name:               getSMersOfWindows(Seed& seed, uint64_t* sMers, uint64_t* sGaps)
+  *
+  * Description :       Computes the sMers (and sGaps) of this read without inserting them
+  *
+  * Input :
+  *       Parameters:
+  *           Seed&      seed           The reference seed to draw the correct mask for this iteration
+  *           uint64_t*  sMers          destination; at least MAX_READ_LENGTH elements
+  *           uint64_t*  sGaps          destination (NULL = sMers only); at least MAX_READ_LENGTH elements
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           uint64_t*  sMers          min(sMer, sMerRC) of each position, as inserted by insertSMersOfWindows
+  *           uint64_t*  sGaps          the corresponding sGaps, as inserted by insertSGapsOfWindows
+  *       Memory:
+  *           None
+  *       Return:
+  *           uint64_t                  number of positions (0 for reads skipped by insertSMersOfWindows)
+  *
+  * Process Synopsis :
+  *                     [1]  Same windows as insertSGapsOfWindows
+  *
+  * Notes :             Used by QUESS_mpi to send the sMers/sGaps to the rank owning them.
+  *
+  */
+
+template <class Window>
+uint64_t Read::getSMersOfWindows(Seed& seed, uint64_t* sMers, uint64_t* sGaps)
+{
+    if (numberOfNs > length / 2)        // skip reads with half N's
+        return 0;
+    if (seed.getLength() + 2 > length)      // seed too long for read; do nothing (+2 is needed for the sGap -- adjacent positions needed)
+        return 0;
+    Window sMerMask, sGapMask, sMerMaskRC, sGapMaskRC;
+    seed.getMasks(sMerMask, sGapMask, sMerMaskRC, sGapMaskRC);
+    const MaskRuns& sMerRuns = seed.getSMerRuns();
+    const MaskRuns& sGapRuns = seed.getSGapRuns();
+    uint64_t windowBits = 8 * sizeof(Window);                                           // window length in bits
+    uint64_t binLength = length * 2;                                                    // length in bits
+    uint64_t maskLength = 2 * (seed.getLength() + 2);                                   // mask length in bits
+    uint64_t binBytes = binLength / 8 + ((binLength % 8 == 0) ? 0 : 1);   // length in bytes
+    uint64_t sMer = 0, sMerRC = 0, count = 0;
+    Window window = 0, windowRC = 0;                        // windows (64 or 128 bits) to slide through the read and readRC resp.
+    for (uint64_t i = 0; i < min((uint64_t)sizeof(Window), binBytes); ++i)
+    {
+        window   |= ((Window)binRead[i]                   << 8 * (sizeof(Window) - 1 - i));
+        windowRC |= ((Window)revComplByte2Bit(binRead[i]) << 8 * i);
+    }
+    for (uint64_t shift = 0; shift <= (binLength - maskLength) / 2; ++shift)
+    {
+        sMer   = windowKey((window   & sMerMask) >> (windowBits - maskLength), sMerRuns);
+        sMerRC = windowKey(windowRC & sMerMaskRC, sMerRuns);
+        sMers[count] = min(sMer, sMerRC);
+        if (sGaps != NULL)
+            sGaps[count] = (sMer < sMerRC) ? windowKey((window & sGapMask) >> (windowBits - maskLength), sGapRuns) : windowKey(windowRC & sGapMaskRC, sGapRuns);
+        ++count;
+        // update working windows
+        window <<= 2;
+        windowRC >>= 2;
+        if (shift%4 == 3)   // add new bytes (if any) every 4 shifts (shifts 3, 7, 11, ...)
+        {
+            uint64_t nextByte = sizeof(Window) + (shift + 1) / 4 - 1;
+            if (binBytes > nextByte)  // if unprocesssed bytes exist
+            {
+                window |= (Window)binRead[nextByte];
+                windowRC |= ((Window)revComplByte2Bit(binRead[nextByte]) << (windowBits - 8));
+            }
+        }
+    }
+    return count;
+}
+
+/**
+  * Name:               insertSMersOfRead(...), insertSGapsOfRead(...), correctBinaryReadFast(...), getSMersOfRead(...)
+  *
+  * Description :       Run insertSMersOfWindows, insertSGapsOfWindows, correctWindows, getSMersOfWindows
+  *                     with the windows of the seed
+  *
+  * Input :
+  *       Parameters:
+  *           as for the functions run
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           as for the functions run
+  *       Memory:
+  *           None
+  *       Return:
+  *           as for the functions run
+  *
+  * Process Synopsis :
+  *                     [1]  Window = uint128_t for wide seeds (Seed::isWide), uint64_t otherwise
+  *
+  * Notes :             The width is chosen once per read; the loops over the windows are compiled for each width,
+  *                     so the 64-bit windows of the usual seeds cost nothing more.
+  *
+  */
+
+bool Read::insertSMersOfRead(HashTable& H, Seed& seed)
+{
+    if (seed.isWide())
+        return insertSMersOfWindows<uint128_t>(H, seed);
+    return insertSMersOfWindows<uint64_t>(H, seed);
+}
+
+void Read::insertSGapsOfRead(HashTable& H, Seed& seed, uint64_t Te, int seedNumber, omp_lock_t* lockArray)
+{
+    if (seed.isWide())
+        insertSGapsOfWindows<uint128_t>(H, seed, Te, seedNumber, lockArray);
+    else
+        insertSGapsOfWindows<uint64_t>(H, seed, Te, seedNumber, lockArray);
+}
+
+template <class Table>
+int64_t Read::correctBinaryReadFast(Table& H, Seed& seed, uint64_t Tdiff, uint64_t &corr, const uint64_t* lowQuality)
+{
+    if (seed.isWide())
+        return correctWindows<Table, uint128_t>(H, seed, Tdiff, corr, lowQuality);
+    return correctWindows<Table, uint64_t>(H, seed, Tdiff, corr, lowQuality);
+}
+
+uint64_t Read::getSMersOfRead(Seed& seed, uint64_t* sMers, uint64_t* sGaps)
+{
+    if (seed.isWide())
+        return getSMersOfWindows<uint128_t>(seed, sMers, sGaps);
+    return getSMersOfWindows<uint64_t>(seed, sMers, sGaps);
+}
+
+// the window widths
+template bool Read::insertSMersOfWindows<uint64_t>(HashTable& H, Seed& seed);
+template bool Read::insertSMersOfWindows<uint128_t>(HashTable& H, Seed& seed);
+template void Read::insertSGapsOfWindows<uint64_t>(HashTable& H, Seed& seed, uint64_t Te, int seedNumber, omp_lock_t* lockArray);
+template void Read::insertSGapsOfWindows<uint128_t>(HashTable& H, Seed& seed, uint64_t Te, int seedNumber, omp_lock_t* lockArray);
+template uint64_t Read::getSMersOfWindows<uint64_t>(Seed& seed, uint64_t* sMers, uint64_t* sGaps);
+template uint64_t Read::getSMersOfWindows<uint128_t>(Seed& seed, uint64_t* sMers, uint64_t* sGaps);
+template int64_t Read::correctWindows<HashTable, uint64_t>(HashTable& H, Seed& seed, uint64_t Tdiff, uint64_t &corr, const uint64_t* lowQuality);
+template int64_t Read::correctWindows<HashTable, uint128_t>(HashTable& H, Seed& seed, uint64_t Tdiff, uint64_t &corr, const uint64_t* lowQuality);
+template int64_t Read::correctWindows<LookupCache, uint64_t>(LookupCache& H, Seed& seed, uint64_t Tdiff, uint64_t &corr, const uint64_t* lowQuality);
+template int64_t Read::correctWindows<LookupCache, uint128_t>(LookupCache& H, Seed& seed, uint64_t Tdiff, uint64_t &corr, const uint64_t* lowQuality);
+
+// the models correctBinaryReadFast is used with
+template int64_t Read::correctBinaryReadFast<HashTable>(HashTable& H, Seed& seed, uint64_t Tdiff, uint64_t &corr, const uint64_t* lowQuality);
+template int64_t Read::correctBinaryReadFast<LookupCache>(LookupCache& H, Seed& seed, uint64_t Tdiff, uint64_t &corr, const uint64_t* lowQuality);
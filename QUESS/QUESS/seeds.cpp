@@ -48,10 +48,11 @@
 
 Seed::Seed(char* seed)
 {
+    const char* problem;
+    if (!isValidSeed(seed, problem)) throw QuessError("ERROR: seed " + string(seed) + ": " + problem);
     charSeed = new char[100];
     strcpy(charSeed, seed);
     length = strlen(charSeed);
-    if (length > 26) { cerr << "ERROR: seed too long"; exit(EXIT_FAILURE); }
     weight  = 0;
     for (uint64_t i = 0; i < length; ++i)
         if (charSeed[i] == '1')
@@ -62,6 +63,7 @@ Seed::Seed(char* seed)
     // ===================================================================================
     //   EXAMPLE: general seed; the actual seeds used in QUESS are palindromes
     //   seed = 111011001; length = 9; weight = 6; reverseSeed = 100110111
+    //   (64-bit window; the 128-bit masks have 64 more 0 bits on the right, resp. left)
     // sMerMask:   00111111 00111100 00110000 00000000 00000000 00000000 00000000 00000000
     // sGapMask:   11000000 11000011 11000000 00000000 00000000 00000000 00000000 00000000
     // sMerMaskRC: 00000000 00000000 00000000 00000000 00000000 00001100 00111100 11111100
@@ -77,20 +79,74 @@ Seed::Seed(char* seed)
 			sMerMask |= 3;
 	}
 	sMerMask <<= 2;
-	sGapMask = ~sMerMask & (((uint64_t)1 << (2 * (length + 2))) - 1);
+	sGapMask = ~sMerMask & (((uint128_t)1 << (2 * (length + 2))) - 1);
 	// shift both masks to be aligned to the left
-	sMerMask <<= (uint64_t)(64 - 2 * (length + 2));
-	sGapMask <<= (uint64_t)(64 - 2 * (length + 2));
+	sMerMask <<= (uint64_t)(128 - 2 * (length + 2));
+	sGapMask <<= (uint64_t)(128 - 2 * (length + 2));
 
     // !!! THIS WORKS BECAUSE SEEDS ARE PALINDROMES !!!
     
-    sMerMaskRC = sMerMask >> (64 - 2 * (length + 2));
-	sGapMaskRC = sGapMask >> (64 - 2 * (length + 2));
+    sMerMaskRC = sMerMask >> (128 - 2 * (length + 2));
+	sGapMaskRC = sGapMask >> (128 - 2 * (length + 2));
+    getMaskRuns(sMerMaskRC, sMerRuns);
+    getMaskRuns(sGapMaskRC, sGapRuns);
+}
 
+/**
+  * Name:               isValidSeed(const char* seed, const char*& problem)
+  *
+  * Description :       Checks that a seed given by the user can be used
+  *
+  * Input :
+  *       Parameters:
+  *           const char* seed              The seed, e.g. "1101011"
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           const char*& problem          why the seed cannot be used (if false is returned)
+  *       Memory:
+  *           None
+  *       Return:
+  *           bool                          true if the seed can be used
+  *
+  * Process Synopsis :
+  *                     [1]  Only 0s and 1s, first and last positions 1, a palindrome (the masks of the
+  *                          reverse complement are those of the seed)
+  *                     [2]  Length, weight and sGap positions within the limits of the windows and of Element
+  *
+  * Notes :             The precomputed seeds of getSeed are all valid.
+  *
+  */
+
+bool isValidSeed(const char* seed, const char*& problem)
+{
+    uint64_t length = strlen(seed), weight = 0;
+    problem = NULL;
+    for (uint64_t i = 0; i < length; ++i)
+    {
+        if ((seed[i] != '0') && (seed[i] != '1'))
+            problem = "only 0 and 1 allowed";
+        else if (seed[i] != seed[length - 1 - i])
+            problem = "not a palindrome";
+        if (seed[i] == '1')
+            ++weight;
+    }
+    if (problem != NULL)
+        return false;
+    if ((length == 0) || (seed[0] != '1'))
+        problem = "must start and end with 1";
+    else if (length > MAX_SEED_LENGTH)
+        problem = "too long (at most 53)";
+    else if (weight > MAX_SEED_WEIGHT)
+        problem = "weight too large (at most 27)";
+    else if (length + 2 - weight > MAX_SEED_GAP_POSITIONS)
+        problem = "too many 0s (length - weight at most 26)";
+    return (problem == NULL);
 }
 
 /**
-  * Name:               getLength(), getWeight(), getSMerMask(), getSGapMask(), getSMerMaskRC(), getSGapMaskRC()
+  * Name:               getLength(), getWeight(), isWide(), getSMerMask(), getSGapMask(), getSMerMaskRC(), getSGapMaskRC(),
+  *                     getMasks(...), getSMerRuns(), getSGapRuns(), getKeyMask()
   *
   * Description :       Returns relevant information about a particular seed
   *
@@ -110,6 +166,9 @@ Seed::Seed(char* seed)
   *           sGapMask                  the sGap mask. ex.   11000000 11000011 11000000 00000000 00000000 00000000 00000000 00000000
   *           sMerMaskRC                the sMerRC mask. ex. 00000000 00000000 00000000 00000000 00000000 00001100 00111100 11111100
   *           sGapMaskRC                the sGapRC mask. ex. 00000000 00000000 00000000 00000000 00000000 00110011 11000011 00000011
+  *           getMasks                  the four masks in a window of type Window (uint64_t or uint128_t)
+  *           sMerRuns, sGapRuns        runs of sMerMaskRC and sGapMaskRC, to gather the sMers and sGaps of wide seeds
+  *           keyMask                   the bits of the sMers as inserted in a HashTable (2 * weight low bits for wide seeds)
   *
   * Process Synopsis :
   *                     [1]  Fetch relevant information
@@ -124,17 +183,41 @@ uint64_t Seed::getLength()
 uint64_t Seed::getWeight()
 {   return(weight);     }
 
+bool Seed::isWide()
+{   return(length > MAX_NARROW_SEED_LENGTH);   }
+
 uint64_t Seed::getSMerMask()
-{   return(sMerMask);   }
+{   return((uint64_t)(sMerMask >> 64));   }
 
 uint64_t Seed::getSGapMask()
-{   return(sGapMask);   }
+{   return((uint64_t)(sGapMask >> 64));   }
 
 uint64_t Seed::getSMerMaskRC()
-{   return(sMerMaskRC); }
+{   return((uint64_t)sMerMaskRC); }
 
 uint64_t Seed::getSGapMaskRC()
-{   return(sGapMaskRC); }
+{   return((uint64_t)sGapMaskRC); }
+
+template <class Window>
+void Seed::getMasks(Window& sMerMask, Window& sGapMask, Window& sMerMaskRC, Window& sGapMaskRC)
+{
+    sMerMask   = (Window)(this->sMerMask >> (128 - 8 * sizeof(Window)));
+    sGapMask   = (Window)(this->sGapMask >> (128 - 8 * sizeof(Window)));
+    sMerMaskRC = (Window)this->sMerMaskRC;
+    sGapMaskRC = (Window)this->sGapMaskRC;
+}
+
+template void Seed::getMasks<uint64_t>(uint64_t& sMerMask, uint64_t& sGapMask, uint64_t& sMerMaskRC, uint64_t& sGapMaskRC);
+template void Seed::getMasks<uint128_t>(uint128_t& sMerMask, uint128_t& sGapMask, uint128_t& sMerMaskRC, uint128_t& sGapMaskRC);
+
+const MaskRuns& Seed::getSMerRuns()
+{   return(sMerRuns);   }
+
+const MaskRuns& Seed::getSGapRuns()
+{   return(sGapRuns);   }
+
+uint64_t Seed::getKeyMask()
+{   return(isWide() ? ((uint64_t)1 << (2 * weight)) - 1 : getSMerMaskRC());   }
 
 /**
   * Name:               printSeedInfo()
@@ -162,15 +245,15 @@ uint64_t Seed::getSGapMaskRC()
 
 void Seed::printSeedInfo()
 {
-    cout << "========== seed ==============\n";
-    cout << "seed = " << charSeed << endl;
-    cout << "length = " << length << endl;
-    cout << "weight = " << weight << endl;
-    cout << "sMerMask:   "; printIntInBinary(sMerMask);
-    cout << "sMerMaskRC: "; printIntInBinary(sMerMaskRC);
-    cout << "sGapMask:   "; printIntInBinary(sGapMask);
-    cout << "sGapMaskRC: "; printIntInBinary(sGapMaskRC);
-    cout << "========== seed ================\n";
+    quessLog << "========== seed ==============\n";
+    quessLog << "seed = " << charSeed << endl;
+    quessLog << "length = " << length << endl;
+    quessLog << "weight = " << weight << endl;
+    quessLog << "sMerMask:   "; printIntInBinary(getSMerMask());
+    quessLog << "sMerMaskRC: "; printIntInBinary(getSMerMaskRC());
+    quessLog << "sGapMask:   "; printIntInBinary(getSGapMask());
+    quessLog << "sGapMaskRC: "; printIntInBinary(getSGapMaskRC());
+    quessLog << "========== seed ================\n";
 }
 
 /**
@@ -212,8 +295,7 @@ void getSeed(char* &seed, uint64_t seedWeight, uint64_t numberOfSeeds, uint64_t
 	if ((seedWeight < 10) || (seedWeight > 26) ||
 		(numberOfSeeds < 1) || (numberOfSeeds > 8) ||       // if numberOfSeeds is not a power of 2, then get the first seeds from the next
 		(seedNumber > numberOfSeeds)) {
-		cout << "ERROR: wrong seed request" << endl;
-		exit(EXIT_FAILURE);
+		throw QuessError("ERROR: wrong seed request");
 	}
 	
 
@@ -238,7 +320,7 @@ void getSeed(char* &seed, uint64_t seedWeight, uint64_t numberOfSeeds, uint64_t
     {
         peakMemory = currentMemory;
 #ifdef VERBOSE
-        cout << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
+        quessLog << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
 #endif
     }
     // ===================================================================================
@@ -0,0 +1,211 @@
+/**
+  * File:     server.cpp
+  *
+  * Author1:  Lucian Ilie (ilie@uwo.ca)
+  * Author2:  Stephen Lu (slu93@uwo.ca)
+  *
+  *   This file contains the correction server of QUESS
+  *   (QUESS --serve). The models of all seeds stay in memory
+  *   (mapped from a correction index) and batches of reads sent
+  *   over a Unix domain socket are corrected with correctBatch;
+  *   the OpenMP threads are reused from one batch to the next.
+  *
+  *   Protocol (text, one item per line, '\n' terminated):
+  *       client: CORRECT <n>         followed by n reads
+  *       server: OK <n>              followed by the n corrected reads, in the same order
+  *       client: QUIT                close the connection (end of file does the same)
+  *       client: SHUTDOWN            stop the server (answer: BYE)
+  *       server: ERROR <message>     for a request not understood; the connection is closed
+  *
+  */
+
+#include "QUESS.h"
+#include "libquess.h"
+#include <vector>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#define SERVER_MAX_BATCH_READS 10000000         // reads in one CORRECT request
+#define SERVER_IO_BUFFER_SIZE (1 << 20)
+
+
+/**
+  * Name:               serveConnection(QuessCorrector& corrector, int connection)
+  *
+  * Description :       Answers the requests of one client
+  *
+  * Input :
+  *       Parameters:
+  *           QuessCorrector& corrector     corrector with a loaded index
+  *           int       connection          connected socket
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           the reads of the current batch
+  *       Return:
+  *           bool                          true if the client asked the server to stop (SHUTDOWN)
+  *
+  * Process Synopsis :
+  *                     [1]  Read a request line
+  *                     [2]  CORRECT <n>: read n reads, correctBatch, send them back
+  *                     [3]  Until QUIT, SHUTDOWN, end of file or an error
+  *
+  * Notes :             The connection is closed on return.
+  *
+  */
+
+static bool serveConnection(QuessCorrector& corrector, int connection)
+{
+    FILE* in = fdopen(connection, "r");
+    FILE* out = fdopen(dup(connection), "w");
+    if ((in == NULL) || (out == NULL))
+    {
+        cerr << "Cannot use connection" << endl;
+        if (in != NULL) fclose(in); else ::close(connection);
+        if (out != NULL) fclose(out);
+        return false;
+    }
+    char* inBuffer = new char[SERVER_IO_BUFFER_SIZE];
+    char* outBuffer = new char[SERVER_IO_BUFFER_SIZE];
+    setvbuf(in, inBuffer, _IOFBF, SERVER_IO_BUFFER_SIZE);
+    setvbuf(out, outBuffer, _IOFBF, SERVER_IO_BUFFER_SIZE);
+    char* line = new char[MAX_LINE_LENGTH];
+    vector<string> reads;
+    bool shutdown = false;
+    int64_t batches = 0, totalReads = 0;
+
+    while (fgets(line, MAX_LINE_LENGTH, in) != NULL)
+    {
+        line[strcspn(line, "\r\n")] = '\0';
+        long long n = -1;
+        char extra;
+        if (sscanf(line, "CORRECT %lld %c", &n, &extra) == 1)
+        {
+            if ((n < 0) || (n > SERVER_MAX_BATCH_READS))
+            {
+                fprintf(out, "ERROR batch of %lld reads (at most %d)\n", n, SERVER_MAX_BATCH_READS);
+                break;
+            }
+            reads.resize(n);
+            bool complete = true;
+            for (long long i = 0; (i < n) && complete; ++i)
+            {
+                complete = (fgets(line, MAX_LINE_LENGTH, in) != NULL);
+                line[strcspn(line, "\r\n")] = '\0';
+                reads[i] = line;
+            }
+            if (!complete)
+                break;          // client gone in the middle of a batch
+            corrector.correctBatch(reads);
+            fprintf(out, "OK %lld\n", n);
+            for (long long i = 0; i < n; ++i)
+            {
+                fwrite(reads[i].data(), 1, reads[i].size(), out);
+                fputc('\n', out);
+            }
+            if (fflush(out) != 0)
+                break;
+            ++batches;
+            totalReads += n;
+        }
+        else if (strcmp(line, "QUIT") == 0)
+            break;
+        else if (strcmp(line, "SHUTDOWN") == 0)
+        {
+            fprintf(out, "BYE\n");
+            shutdown = true;
+            break;
+        }
+        else
+        {
+            fprintf(out, "ERROR unknown request\n");
+            break;
+        }
+    }
+    fflush(out);
+    fclose(out);
+    fclose(in);
+    delete [] inBuffer;
+    delete [] outBuffer;
+    delete [] line;
+    quessLog << "Connection closed: " << batches << " batches, " << totalReads << " reads corrected" << endl;
+    return shutdown;
+}
+
+/**
+  * Name:               serveCorrections(QuessCorrector& corrector, const char* socketName)
+  *
+  * Description :       Corrects batches of reads sent over a Unix domain socket until SHUTDOWN
+  *
+  * Input :
+  *       Parameters:
+  *           QuessCorrector& corrector     corrector with a loaded index (loadIndex)
+  *           const char* socketName        path of the socket
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  Create the socket (a stale socket at that path is replaced)
+  *                     [2]  Serve the clients one after another (others wait in the listen queue)
+  *                     [3]  Remove the socket
+  *
+  * Notes :             SIGPIPE is ignored so that a client leaving early does not stop the server.
+  *
+  */
+
+void serveCorrections(QuessCorrector& corrector, const char* socketName)
+{
+    struct sockaddr_un address;
+    if (strlen(socketName) >= sizeof(address.sun_path))
+    {
+        throw QuessError("Socket name too long: " + string(socketName));
+    }
+    struct stat st;
+    if (lstat(socketName, &st) == 0)
+    {
+        if (!S_ISSOCK(st.st_mode))
+        {
+            throw QuessError("Not a socket, not replaced: " + string(socketName));
+        }
+        unlink(socketName);
+    }
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socketName);
+    if ((server < 0) || (bind(server, (struct sockaddr*)&address, sizeof(address)) != 0) || (listen(server, 64) != 0))
+    {
+        throw QuessError("Cannot create socket: " + string(socketName));
+    }
+    signal(SIGPIPE, SIG_IGN);
+    quessLog << "Serving corrections on " << socketName << endl;
+
+    bool shutdown = false;
+    while (!shutdown)
+    {
+        int connection = accept(server, NULL, NULL);
+        if (connection < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            cerr << "Cannot accept connection on " << socketName << endl;
+            break;
+        }
+        shutdown = serveConnection(corrector, connection);
+    }
+    ::close(server);
+    unlink(socketName);
+    quessLog << "Server stopped" << endl;
+}
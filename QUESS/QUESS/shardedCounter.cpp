@@ -0,0 +1,531 @@
+/**
+  * File:     shardedCounter.cpp
+  *
+  * Author1:  Lucian Ilie (ilie@uwo.ca)
+  * Author2:  Stephen Lu (slu93@uwo.ca)
+  *
+  *   This file contains the sharded counting of QUESS. The sMers are
+  *   split into shards by a hash and each shard is owned by one
+  *   thread: only its owner inserts in its counting table, or inserts
+  *   the sGaps of its sMers in the model, so no atomics and no locks
+  *   are needed on the tables. The threads extract the sMers (and
+  *   sGaps) of their reads and pass them to the owners in batches,
+  *   through one single-producer single-consumer queue per pair of
+  *   threads, as QUESS_mpi passes them to the ranks owning them. The
+  *   reads are taken in chunks and each owner consumes the chunks in
+  *   order, so the sGaps of an sMer are inserted in the order of the
+  *   reads, as with one thread: the models, hence the corrected reads,
+  *   do not depend on the number of threads or their timing.
+  *
+  */
+
+#include "QUESS.h"
+#include <sched.h>
+
+#define SHARD_MULTIPLIER 0x9E3779B97F4A7C15ULL     // home position of an sMer in the table of its shard
+
+/**
+  * Name:               ShardedCounter(int numberOfShards, uint64_t totalSize)
+  *
+  * Description :       Shards and queues for numberOfShards threads
+  *
+  * Input :
+  *       Parameters:
+  *           int       numberOfShards      number of shards (the number of threads)
+  *           uint64_t  totalSize           initial number of positions of all the counting tables together
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           ShardQueue* queues            numberOfShards^2 queues of SHARD_QUEUE_BATCHES batches
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :             The counting tables are allocated for each seed (createTables); the size a shard has
+  *                     grown to is kept for the next seed, as maxSize of HashTable.
+  *
+  */
+
+ShardedCounter::ShardedCounter(int numberOfShards, uint64_t totalSize)
+{
+    this->numberOfShards = numberOfShards;
+    queues = new ShardQueue[numberOfShards * numberOfShards];
+    for (int i = 0; i < numberOfShards * numberOfShards; ++i)
+    {
+        queues[i].words = new uint64_t[SHARD_QUEUE_BATCHES * SHARD_BATCH_WORDS];
+        queues[i].filled = queues[i].head = queues[i].tail = 0;
+    }
+    tables = new Element*[numberOfShards];
+    sizes = new uint64_t[numberOfShards];
+    elements = new uint64_t[numberOfShards];
+    for (int s = 0; s < numberOfShards; ++s)
+    {
+        tables[s] = NULL;
+        sizes[s] = totalSize / numberOfShards + 1;
+        elements[s] = 0;
+    }
+    nextChunks = new uint64_t[numberOfShards];
+    H = NULL;
+    Te = 0;
+    seedNumber = 0;
+    numberOfChunks = 0;
+}
+
+ShardedCounter::~ShardedCounter()
+{
+    uint64_t peakMemory = 0, currentMemory = 0;
+    freeTables(peakMemory, currentMemory);
+    for (int i = 0; i < numberOfShards * numberOfShards; ++i)
+        delete [] queues[i].words;
+    delete [] queues;
+    delete [] tables;
+    delete [] sizes;
+    delete [] nextChunks;
+    delete [] elements;
+}
+
+int ShardedCounter::getNumberOfShards()
+{
+    return numberOfShards;
+}
+
+uint64_t ShardedCounter::memoryUsage()
+{
+    uint64_t bytes = (uint64_t)numberOfShards * numberOfShards * SHARD_QUEUE_BATCHES * SHARD_BATCH_WORDS * sizeof(uint64_t);
+    for (int s = 0; s < numberOfShards; ++s)
+        if (tables[s] != NULL)
+            bytes += sizes[s] * sizeof(Element);
+    return bytes;
+}
+
+/**
+  * Name:               ownerOf(uint64_t sMer)
+  *
+  * Description :       Shard of sMer
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t  sMer                sMer (min of direct and reverse complement)
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           int                           0 .. numberOfShards - 1
+  *
+  * Process Synopsis :
+  *
+  * Notes :             Same hash as the ranks of QUESS_mpi; independent of the position in the table of the shard
+  *                     and of the sMer partitions of HashTable.
+  *
+  */
+
+inline int ShardedCounter::ownerOf(uint64_t sMer)
+{
+    uint64_t h = sMer * 0xff51afd7ed558ccdULL;
+    h ^= h >> 29;
+    return (int)(((uint128_t)h * (uint64_t)numberOfShards) >> 64);
+}
+
+/**
+  * Name:               createTables(uint64_t &peakMemory, uint64_t &currentMemory), freeTables(...)
+  *
+  * Description :       Allocates (frees) the counting tables of the shards
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t  &peakMemory         Peak memory of program
+  *           uint64_t  &currentMemory      Current memory of program
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           uint64_t  &peakMemory         peakMemory is recorded and estimated for testing
+  *           uint64_t  &currentMemory      currentMemory is recorded and estimated for testing
+  *       Memory:
+  *           Element** tables              sizes[s] empty Elements (count 0) for each shard s
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :
+  *
+  */
+
+void ShardedCounter::createTables(uint64_t &peakMemory, uint64_t &currentMemory)
+{
+    for (int s = 0; s < numberOfShards; ++s)
+    {
+        tables[s] = new Element[sizes[s]];
+        memset(tables[s], 0, sizes[s] * sizeof(Element));
+        elements[s] = 0;
+        currentMemory += sizes[s] * sizeof(Element);
+    }
+    if (currentMemory > peakMemory)
+    {
+        peakMemory = currentMemory;
+#ifdef VERBOSE
+        quessLog << "New peak Memory = " << (peakMemory/1048576) <<" MB" << endl << flush;
+#endif
+    }
+}
+
+void ShardedCounter::freeTables(uint64_t &peakMemory, uint64_t &currentMemory)
+{
+    for (int s = 0; s < numberOfShards; ++s)
+        if (tables[s] != NULL)
+        {
+            delete [] tables[s];
+            tables[s] = NULL;
+            currentMemory -= sizes[s] * sizeof(Element);
+        }
+}
+
+/**
+  * Name:               insert(int shard, uint64_t sMer)
+  *
+  * Description :       Counts one occurrence of sMer in the table of its shard (by the owner only)
+  *
+  * Input :
+  *       Parameters:
+  *           int       shard               ownerOf(sMer)
+  *           uint64_t  sMer                the sMer
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           Element*  tables[shard]       count of sMer incremented (up to 255), or sMer added with count 1
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  Linear probing from the home position; count 0 = empty
+  *                     [2]  Beyond 85% load the table is rehashed to double size, with the counts
+  *
+  * Notes :             Unlike HashTable, a full shard is grown in place: the pass over the reads goes on.
+  *
+  */
+
+void ShardedCounter::insert(int shard, uint64_t sMer)
+{
+    Element* table = tables[shard];
+    uint64_t size = sizes[shard];
+    uint64_t place = ((sMer * SHARD_MULTIPLIER) >> 20) % size;
+    while ((table[place].count != 0) && (table[place].value != sMer))
+        if (++place == size)
+            place = 0;
+    if (table[place].count != 0)
+    {
+        if (table[place].count < 255)
+            ++table[place].count;
+        return;
+    }
+    table[place].value = sMer;
+    table[place].count = 1;
+    if (++elements[shard] <= 0.85 * size)
+        return;
+    // grow: rehash with the counts
+    uint64_t newSize = 2 * size + 1;
+    Element* newTable = new Element[newSize];
+    memset(newTable, 0, newSize * sizeof(Element));
+    for (uint64_t i = 0; i < size; ++i)
+        if (table[i].count != 0)
+        {
+            place = ((table[i].value * SHARD_MULTIPLIER) >> 20) % newSize;
+            while (newTable[place].count != 0)
+                if (++place == newSize)
+                    place = 0;
+            newTable[place] = table[i];
+        }
+    delete [] table;
+    tables[shard] = newTable;
+    sizes[shard] = newSize;
+}
+
+/**
+  * Name:               consume(int shard, const uint64_t* words, uint64_t length)
+  *
+  * Description :       Inserts a batch of its shard (by the owner)
+  *
+  * Input :
+  *       Parameters:
+  *           int       shard               shard of the sMers of the batch
+  *           const uint64_t* words         sMers (counting) or sMer, sGap pairs (H != NULL)
+  *           uint64_t  length              number of words
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           the table of the shard, or the sGaps of the sMers in H
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :             HashTable::insertSGap without locks: the sMers of a shard, hence their positions in H,
+  *                     are only changed by its owner.
+  *
+  */
+
+void ShardedCounter::consume(int shard, const uint64_t* words, uint64_t length)
+{
+    if (H == NULL)
+        for (uint64_t i = 0; i < length; ++i)
+            insert(shard, words[i]);
+    else
+        for (uint64_t i = 0; i + 1 < length; i += 2)
+            H->insertSGap(words[i], words[i + 1], Te, seedNumber, NULL);
+}
+
+/**
+  * Name:               drain(int thread, int numberOfThreads)
+  *
+  * Description :       Consumes the batches published to the shards of a thread
+  *
+  * Input :
+  *       Parameters:
+  *           int       thread              the consumer
+  *           int       numberOfThreads     threads of the parallel region; thread t owns shards t, t + numberOfThreads, ...
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           the batches are consumed; head of their queues advanced
+  *       Return:
+  *           uint64_t                      number of batches consumed
+  *
+  * Process Synopsis :
+  *                     [1]  For each shard of the thread: consume the batches published by the producer of its next
+  *                          chunk (tail read with acquire: the words of a published batch are visible); after the
+  *                          last batch of the chunk, go on with the next chunk
+  *                     [2]  head is advanced with release: the producer may then refill the batch
+  *
+  * Notes :             The batches of a later chunk wait in their queue: a shard receives its sMers in the order of
+  *                     the reads. The producer of the lowest chunk not yet published is never waiting for a later
+  *                     one, so the threads always make progress.
+  *
+  */
+
+uint64_t ShardedCounter::drain(int thread, int numberOfThreads)
+{
+    uint64_t consumed = 0;
+    for (int s = thread; s < numberOfShards; s += numberOfThreads)
+        while (nextChunks[s] < numberOfChunks)
+        {
+            ShardQueue& q = queues[(nextChunks[s] % numberOfThreads) * numberOfShards + s];
+            if (q.head == __atomic_load_n(&q.tail, __ATOMIC_ACQUIRE))
+                break;                          // producer of the chunk not there yet
+            uint64_t batch = q.head % SHARD_QUEUE_BATCHES;
+            consume(s, q.words + batch * SHARD_BATCH_WORDS, q.lengths[batch]);
+            if (q.ends[batch])
+                ++nextChunks[s];
+            __atomic_store_n(&q.head, q.head + 1, __ATOMIC_RELEASE);
+            ++consumed;
+        }
+    return consumed;
+}
+
+/**
+  * Name:               publish(int thread, int numberOfThreads, ShardQueue& q, bool end)
+  *
+  * Description :       Passes the batch being filled to the owner of its shard
+  *
+  * Input :
+  *       Parameters:
+  *           int       thread              the producer (owner of q)
+  *           int       numberOfThreads     threads of the parallel region
+  *           ShardQueue& q                 queue of the producer to the shard
+  *           bool      end                 the batch is the last of its chunk (published even if empty)
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           tail of q advanced; the next batch of q is free
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  Length of the batch; tail advanced with release
+  *                     [2]  While the queue is full the producer consumes the batches of its own shards, so the
+  *                          threads waiting for each other make progress
+  *
+  * Notes :
+  *
+  */
+
+void ShardedCounter::publish(int thread, int numberOfThreads, ShardQueue& q, bool end)
+{
+    q.lengths[q.tail % SHARD_QUEUE_BATCHES] = q.filled;
+    q.ends[q.tail % SHARD_QUEUE_BATCHES] = end;
+    __atomic_store_n(&q.tail, q.tail + 1, __ATOMIC_RELEASE);
+    q.filled = 0;
+    while (q.tail - __atomic_load_n(&q.head, __ATOMIC_ACQUIRE) >= SHARD_QUEUE_BATCHES)
+        if (drain(thread, numberOfThreads) == 0)
+            sched_yield();
+}
+
+/**
+  * Name:               route(Seed& seed, char** bucket, int64_t bucketSize)
+  *
+  * Description :       Passes the sMers (sMer, sGap pairs if H != NULL) of the reads of a bucket to the owners
+  *
+  * Input :
+  *       Parameters:
+  *           Seed&     seed                current seed
+  *           char**    bucket              reads
+  *           int64_t   bucketSize          number of reads
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           every sMer (pair) of the bucket consumed by the owner of its shard
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  Thread t takes the chunks t, t + numberOfThreads, ... of SHARD_CHUNK_READS reads and
+  *                          appends the sMers (pairs) to the batch of their shard in its queue; full batches are
+  *                          published
+  *                     [2]  At the end of a chunk its last batch is published to every shard
+  *                     [3]  At the end of its chunks a thread consumes the batches of its shards until they have
+  *                          consumed all chunks
+  *
+  * Notes :             A thread is producer and consumer at the same time; the queues are empty at the end.
+  *
+  */
+
+void ShardedCounter::route(Seed& seed, char** bucket, int64_t bucketSize)
+{
+    uint64_t wordsPerSMer = (H == NULL) ? 1 : 2;
+    numberOfChunks = (bucketSize + SHARD_CHUNK_READS - 1) / SHARD_CHUNK_READS;
+    for (int s = 0; s < numberOfShards; ++s)
+        nextChunks[s] = 0;
+#pragma omp parallel num_threads(numberOfShards)
+    {
+        int thread = omp_get_thread_num();
+        int numberOfThreads = omp_get_num_threads();        // fewer than the shards: a thread owns several
+        uint64_t* sMers = new uint64_t[MAX_READ_LENGTH];
+        uint64_t* sGaps = new uint64_t[MAX_READ_LENGTH];
+        Read currentRead;
+        for (uint64_t chunk = thread; chunk < numberOfChunks; chunk += numberOfThreads)
+        {
+            int64_t first = chunk * SHARD_CHUNK_READS, last = min(bucketSize, first + SHARD_CHUNK_READS);
+            for (int64_t i = first; i < last; ++i)
+            {
+                currentRead = Read(bucket[i]);
+                uint64_t count = currentRead.getSMersOfRead(seed, sMers, (H == NULL) ? NULL : sGaps);
+                currentRead.clear();
+                for (uint64_t k = 0; k < count; ++k)
+                {
+                    ShardQueue& q = queues[thread * numberOfShards + ownerOf(sMers[k])];
+                    uint64_t* batch = q.words + (q.tail % SHARD_QUEUE_BATCHES) * SHARD_BATCH_WORDS;
+                    batch[q.filled++] = sMers[k];
+                    if (H != NULL)
+                        batch[q.filled++] = sGaps[k];
+                    if (q.filled + wordsPerSMer > SHARD_BATCH_WORDS)
+                        publish(thread, numberOfThreads, q, false);
+                }
+            }
+            for (int s = 0; s < numberOfShards; ++s)
+                publish(thread, numberOfThreads, queues[thread * numberOfShards + s], true);
+        }
+        delete [] sMers;
+        delete [] sGaps;
+        // consume the remaining chunks of the shards of the thread
+        bool done = false;
+        while (!done)
+        {
+            done = true;
+            for (int s = thread; s < numberOfShards; s += numberOfThreads)
+                if (nextChunks[s] < numberOfChunks)     // only changed by this thread
+                    done = false;
+            if (!done && (drain(thread, numberOfThreads) == 0))
+                sched_yield();
+        }
+    }
+}
+
+/**
+  * Name:               countSMers(Seed& seed, char** bucket, int64_t bucketSize), insertSGaps(...)
+  *
+  * Description :       Counts the sMers of a bucket in the tables of the shards; inserts the sGaps of a bucket in H
+  *
+  * Input :
+  *       Parameters:
+  *           Seed&     seed                current seed
+  *           char**    bucket              reads
+  *           int64_t   bucketSize          number of reads
+  *           HashTable& H                  table of the frequent sMers, with its sGapTable (createSGapTable)
+  *           uint64_t  Te, int seedNumber  as for HashTable::insertSGap
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           the tables of the shards (countSMers; createTables first), or the sGaps of H
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  route
+  *
+  * Notes :
+  *
+  */
+
+void ShardedCounter::countSMers(Seed& seed, char** bucket, int64_t bucketSize)
+{
+    H = NULL;
+    route(seed, bucket, bucketSize);
+}
+
+void ShardedCounter::insertSGaps(Seed& seed, char** bucket, int64_t bucketSize, HashTable& H, uint64_t Te, int seedNumber)
+{
+    this->H = &H;
+    this->Te = Te;
+    this->seedNumber = seedNumber;
+    route(seed, bucket, bucketSize);
+    this->H = NULL;
+}
+
+/**
+  * Name:               collectFrequentSMers(uint64_t Tc, vector<uint64_t>& frequentSMers)
+  *
+  * Description :       Collects the sMers of count >= Tc of all shards
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t  Tc                  The count threshold to ascertain whether a specific sMer should be kept
+  *           vector<uint64_t>& frequentSMers   destination
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           vector<uint64_t>& frequentSMers   the frequent sMers are appended
+  *       Memory:
+  *           None
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *
+  * Notes :             The tables are freed with freeTables.
+  *
+  */
+
+void ShardedCounter::collectFrequentSMers(uint64_t Tc, vector<uint64_t>& frequentSMers)
+{
+    for (int s = 0; s < numberOfShards; ++s)
+        for (uint64_t i = 0; i < sizes[s]; ++i)
+            if ((tables[s][i].count != 0) && (tables[s][i].count >= Tc))
+                frequentSMers.push_back(tables[s][i].value);
+}
@@ -0,0 +1,361 @@
+/**
+  * File:     staticTable.cpp
+  *
+  * Author1:  Lucian Ilie (ilie@uwo.ca)
+  * Author2:  Stephen Lu (slu93@uwo.ca)
+  *
+  *   This file contains the static table of QUESS. After the
+  *   ambiguous sMers are removed the sMers of a seed do not
+  *   change anymore; a minimal perfect hash function (BBHash)
+  *   maps each of them to one packed entry holding the sMer,
+  *   its correct sGap and score. A lookup is one hash per level
+  *   (almost always the first one or two) plus one access to
+  *   the entries, and the table takes about 8.5 bytes per sMer.
+  *
+  */
+
+#include "QUESS.h"
+#include <vector>
+#include <algorithm>
+
+#define ENTRY_BITS_MASK ((((uint64_t)1) << 56) - 1)      // sMer | sGap part of an entry
+
+
+/**
+  * Name:               hashPosition(uint64_t sMer, int level, uint64_t size)
+  *
+  * Description :       Position of sMer in the bits of a level
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t  sMer                key
+  *           int       level               level (a different hash function for each)
+  *           uint64_t  size                bits of the level
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           uint64_t                      position in [0, size)
+  *
+  * Process Synopsis :
+  *                     [1]  64-bit mix (murmur3 finalizer) of the sMer and the level
+  *                     [2]  Multiply-shift to [0, size) instead of a division
+  *
+  * Notes :
+  *
+  */
+
+inline uint64_t StaticTable::hashPosition(uint64_t sMer, int level, uint64_t size)
+{
+    uint64_t h = sMer + 0x9E3779B97F4A7C15ULL * (uint64_t)(level + 1);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return (uint64_t)(((unsigned __int128)h * size) >> 64);
+}
+
+/**
+  * Name:               StaticTable(uint64_t* entries, uint64_t numberOfKeys, uint64_t sMerMask)
+  *
+  * Description :       Builds the minimal perfect hash function and the packed entries
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t* entries             sMer | sGap | score << 56 of each non-ambiguous sMer
+  *           uint64_t  numberOfKeys        number of entries
+  *           uint64_t  sMerMask            sMer bits of an entry
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           bits (about 3.7 bits per key), ranks, entries (8 bytes per key)
+  *       Return:
+  *           None
+  *
+  * Process Synopsis :
+  *                     [1]  For each level, in parallel: set the bit of every key left; bits hit twice are collisions
+  *                     [2]  Remove the collisions from the level; the colliding keys go to the next level
+  *                     [3]  Keys left after the last level are kept in a sorted array
+  *                     [4]  Ranks of the bits; each entry is stored at the rank of the bit of its key
+  *
+  * Notes :
+  *
+  */
+
+StaticTable::StaticTable(uint64_t* entries, uint64_t numberOfKeys, uint64_t sMerMask)
+{
+    this->numberOfKeys = numberOfKeys;
+    this->sMerMask = sMerMask;
+    numberOfLevels = 0;
+    vector<uint64_t> keys(numberOfKeys), nextKeys;
+#pragma omp parallel for
+    for (int64_t i = 0; i < (int64_t)numberOfKeys; ++i)
+        keys[i] = entries[i] & sMerMask;
+
+    vector<uint64_t*> levelBits;
+    uint64_t totalBits = 0;
+    while ((keys.size() > 0) && (numberOfLevels < STATIC_MAX_LEVELS))
+    {
+        int level = numberOfLevels;
+        uint64_t size = ((uint64_t)(STATIC_GAMMA * keys.size()) / 64 + 1) * 64;
+        uint64_t words = size / 64;
+        uint64_t* levelA = new uint64_t[words];         // bits of the level
+        uint64_t* levelC = new uint64_t[words];         // collisions
+        memset(levelA, 0, words * sizeof(uint64_t));
+        memset(levelC, 0, words * sizeof(uint64_t));
+        int64_t n = keys.size();
+#pragma omp parallel for
+        for (int64_t i = 0; i < n; ++i)
+        {
+            uint64_t pos = hashPosition(keys[i], level, size);
+            uint64_t bit = (uint64_t)1 << (pos & 63);
+            if (__atomic_fetch_or(&levelA[pos >> 6], bit, __ATOMIC_RELAXED) & bit)
+                __atomic_fetch_or(&levelC[pos >> 6], bit, __ATOMIC_RELAXED);
+        }
+#pragma omp parallel for
+        for (int64_t w = 0; w < (int64_t)words; ++w)
+            levelA[w] &= ~levelC[w];
+        nextKeys.clear();
+#pragma omp parallel
+        {
+            vector<uint64_t> threadKeys;
+#pragma omp for nowait
+            for (int64_t i = 0; i < n; ++i)
+            {
+                uint64_t pos = hashPosition(keys[i], level, size);
+                if (levelC[pos >> 6] & ((uint64_t)1 << (pos & 63)))
+                    threadKeys.push_back(keys[i]);
+            }
+#pragma omp critical
+            nextKeys.insert(nextKeys.end(), threadKeys.begin(), threadKeys.end());
+        }
+        delete [] levelC;
+        levelBits.push_back(levelA);
+        levelStart[level] = totalBits;
+        levelSize[level] = size;
+        totalBits += size;
+        ++numberOfLevels;
+        keys.swap(nextKeys);
+    }
+
+    // concatenate the levels and compute the ranks
+    uint64_t totalWords = totalBits / 64;
+    bits = new uint64_t[totalWords + 1];
+    for (int level = 0; level < numberOfLevels; ++level)
+    {
+        memcpy(bits + levelStart[level] / 64, levelBits[level], levelSize[level] / 8);
+        delete [] levelBits[level];
+    }
+    bits[totalWords] = 0;
+    uint64_t numberOfBlocks = totalBits / STATIC_RANK_BLOCK + 1;
+    ranks = new uint64_t[numberOfBlocks];
+    uint64_t rank = 0;
+    for (uint64_t w = 0; w < totalWords; ++w)
+    {
+        if (w % (STATIC_RANK_BLOCK / 64) == 0)
+            ranks[w / (STATIC_RANK_BLOCK / 64)] = rank;
+        rank += __builtin_popcountll(bits[w]);
+    }
+    if (totalWords % (STATIC_RANK_BLOCK / 64) == 0)
+        ranks[totalWords / (STATIC_RANK_BLOCK / 64)] = rank;
+
+    // place the entries; the keys left are the fallback
+    numberOfFallback = keys.size();
+    fallback = new uint64_t[numberOfFallback + 1];
+    this->entries = new uint64_t[rank + 1];
+    uint64_t placed = 0;
+#pragma omp parallel for reduction(+:placed)
+    for (int64_t i = 0; i < (int64_t)numberOfKeys; ++i)
+    {
+        uint64_t sMer = entries[i] & sMerMask;
+        for (int level = 0; level < numberOfLevels; ++level)
+        {
+            uint64_t pos = levelStart[level] + hashPosition(sMer, level, levelSize[level]);
+            uint64_t word = pos >> 6;
+            if (bits[word] & ((uint64_t)1 << (pos & 63)))
+            {
+                uint64_t r = ranks[pos / STATIC_RANK_BLOCK];
+                for (uint64_t w = (pos / STATIC_RANK_BLOCK) * (STATIC_RANK_BLOCK / 64); w < word; ++w)
+                    r += __builtin_popcountll(bits[w]);
+                r += __builtin_popcountll(bits[word] & (((uint64_t)1 << (pos & 63)) - 1));
+                this->entries[r] = entries[i];
+                ++placed;
+                break;
+            }
+        }
+    }
+    if (numberOfFallback > 0)
+    {
+        uint64_t f = 0;
+        sort(keys.begin(), keys.end());
+        for (uint64_t i = 0; i < numberOfKeys; ++i)     // entries of the keys left, in the order of the keys
+            if (binary_search(keys.begin(), keys.end(), entries[i] & sMerMask))
+                fallback[f++] = entries[i];
+        sort(fallback, fallback + f, [sMerMask](uint64_t a, uint64_t b) { return (a & sMerMask) < (b & sMerMask); });
+    }
+    if (placed + numberOfFallback != numberOfKeys)
+    {
+        throw QuessError("Static table: " + to_string(numberOfKeys - placed - numberOfFallback) + " sMers not placed (duplicate sMers?)");
+    }
+    quessLog << "Static table: " << numberOfKeys << " sMers, " << numberOfLevels << " levels, "
+         << (double)(totalBits + 64 * numberOfBlocks) / max(numberOfKeys, (uint64_t)1) << " bits/sMer for the hash function" << endl;
+}
+
+StaticTable::~StaticTable()
+{
+    delete [] bits;
+    delete [] ranks;
+    delete [] entries;
+    delete [] fallback;
+}
+
+/**
+  * Name:               memoryUsage()
+  *
+  * Description :       Bytes used by the table
+  *
+  * Input :
+  *       Parameters:
+  *           None
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           None
+  *       Memory:
+  *           None
+  *       Return:
+  *           uint64_t                      bytes
+  *
+  * Process Synopsis :
+  *
+  * Notes :
+  *
+  */
+
+uint64_t StaticTable::memoryUsage()
+{
+    uint64_t totalBits = (numberOfLevels > 0) ? levelStart[numberOfLevels - 1] + levelSize[numberOfLevels - 1] : 0;
+    return totalBits / 8 + (totalBits / STATIC_RANK_BLOCK + 1) * sizeof(uint64_t) + (numberOfKeys + 1) * sizeof(uint64_t);
+}
+
+/**
+  * Name:               find(uint64_t sMer, uint64_t& entry)
+  *
+  * Description :       Finds the entry of sMer
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t  sMer                sMer looked for
+  *           uint64_t& entry               destination
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           uint64_t& entry               the entry of sMer, if found
+  *       Memory:
+  *           None
+  *       Return:
+  *           bool                          true if sMer is in the table
+  *
+  * Process Synopsis :
+  *                     [1]  The first level where the bit of sMer is set gives the entry (rank of that bit)
+  *                     [2]  Its sMer bits must be sMer (otherwise sMer is not in the table)
+  *                     [3]  No bit set in any level: binary search in the fallback
+  *
+  * Notes :             A key of the table never has its bit set in a level before its own (those bits are collisions).
+  *
+  */
+
+inline bool StaticTable::find(uint64_t sMer, uint64_t& entry)
+{
+    for (int level = 0; level < numberOfLevels; ++level)
+    {
+        uint64_t pos = levelStart[level] + hashPosition(sMer, level, levelSize[level]);
+        uint64_t word = pos >> 6;
+        if (bits[word] & ((uint64_t)1 << (pos & 63)))
+        {
+            uint64_t r = ranks[pos / STATIC_RANK_BLOCK];
+            for (uint64_t w = (pos / STATIC_RANK_BLOCK) * (STATIC_RANK_BLOCK / 64); w < word; ++w)
+                r += __builtin_popcountll(bits[w]);
+            r += __builtin_popcountll(bits[word] & (((uint64_t)1 << (pos & 63)) - 1));
+            entry = entries[r];
+            return ((entry & sMerMask) == sMer);
+        }
+    }
+    uint64_t low = 0, high = numberOfFallback;
+    while (low < high)
+    {
+        uint64_t middle = (low + high) / 2;
+        if ((fallback[middle] & sMerMask) < sMer)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    if ((low < numberOfFallback) && ((fallback[low] & sMerMask) == sMer))
+    {
+        entry = fallback[low];
+        return true;
+    }
+    return false;
+}
+
+/**
+  * Name:               getCorrectSGap(uint64_t sMer, uint64_t sGap, uint64_t& correctSGap, uint64_t Tdiff)
+  *
+  * Description :       Same as HashTable::getCorrectSGap, on the static table
+  *
+  * Input :
+  *       Parameters:
+  *           uint64_t  sMer                The sMer of the read being processed
+  *           uint64_t  sGap                The sGap of the read being processed associated with the sMer indicated
+  *           uint64_t& correctSGap         A pointer to the identity of the correct sGap
+  *           uint64_t  Tdiff               The allowance of how many bits can be different to have the uncorrected sGap be corrected
+  *
+  * Output/Expected Changes :
+  *       Parameters:
+  *           uint64_t& correctSGap         correctSGap will change to the correct variant as indicated by the table
+  *       Memory:
+  *           None
+  *       Return:
+  *           int                           -3: sMer not in table (ambiguous sMers are not in the table)
+  *                                         -1: sGap too different
+  *                                          0: already correct
+  *                                         >0: correctSGap NOT too different; correction can be done
+  *
+  * Process Synopsis :
+  *
+  * Notes :             correctBinaryReadFast treats -3 and -2 alike.
+  *
+  */
+
+int64_t StaticTable::getCorrectSGap(uint64_t sMer, uint64_t sGap, uint64_t& correctSGap, uint64_t Tdiff)
+{
+    uint64_t entry = 0;
+    if (!find(sMer, entry))
+        return -3;
+    uint64_t tableSGap = entry & ENTRY_BITS_MASK & ~sMerMask;
+    if (sGap == tableSGap)
+        return 0;
+    if (diff2Bit(sGap, tableSGap) < Tdiff)
+    {
+        correctSGap = tableSGap;
+        return (int64_t)(entry >> 56);
+    }
+    else
+        return -1;
+}
+
+bool StaticTable::getCorrectEntry(uint64_t sMer, uint64_t& sGap, uint64_t& score)
+{
+    uint64_t entry = 0;
+    if (!find(sMer, entry))
+        return false;
+    sGap = entry & ENTRY_BITS_MASK & ~sMerMask;
+    score = entry >> 56;
+    return true;
+}
@@ -0,0 +1,117 @@
+/**
+  * File:     serveClient.cpp
+  *
+  * Author1:  Lucian Ilie (ilie@uwo.ca)
+  * Author2:  Stephen Lu (slu93@uwo.ca)
+  *
+  *   Client of the correction server (QUESS --serve) for the scripted
+  *   checks in tests/: the reads on stdin (one per line) are sent in
+  *   <batches> CORRECT requests, the corrected reads of the OK answers
+  *   are written to stdout in order, then SHUTDOWN must be answered BYE.
+  *   Any other answer is an error (exit status 1).
+  *
+  *   Usage: serveClient <socket> <batches> < reads > corrected reads
+  *
+  */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+using namespace std;
+
+#define CONNECT_ATTEMPTS 600        // every 0.1 s: the server first maps its index
+
+// the answer line without '\n'; false at end of the connection
+static bool readLine(FILE* in, string& line)
+{
+    line.clear();
+    int c;
+    while (((c = fgetc(in)) != EOF) && (c != '\n'))
+        line += (char)c;
+    return (c != EOF) || !line.empty();
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        cerr << "Usage: serveClient <socket> <batches> < reads > corrected reads" << endl;
+        return 1;
+    }
+    int64_t batches = atoll(argv[2]);
+    struct sockaddr_un address;
+    if ((batches < 1) || (strlen(argv[1]) >= sizeof(address.sun_path)))
+    {
+        cerr << "serveClient: wrong arguments" << endl;
+        return 1;
+    }
+    vector<string> reads;
+    string read;
+    while (getline(cin, read))
+        reads.push_back(read);
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, argv[1]);
+    int connection = -1;
+    for (int attempt = 0; (attempt < CONNECT_ATTEMPTS) && (connection < 0); ++attempt)
+    {
+        connection = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (connect(connection, (struct sockaddr*)&address, sizeof(address)) != 0)
+        {
+            close(connection);
+            connection = -1;
+            usleep(100000);
+        }
+    }
+    if (connection < 0)
+    {
+        cerr << "serveClient: cannot connect to " << argv[1] << endl;
+        return 1;
+    }
+    FILE* in = fdopen(connection, "r");
+    FILE* out = fdopen(dup(connection), "w");
+
+    string line;
+    uint64_t sent = 0;
+    for (int64_t b = 0; b < batches; ++b)
+    {
+        uint64_t n = reads.size() * (b + 1) / batches - sent;
+        fprintf(out, "CORRECT %llu\n", (unsigned long long)n);
+        for (uint64_t i = sent; i < sent + n; ++i)
+            fprintf(out, "%s\n", reads[i].c_str());
+        fflush(out);
+        if (!readLine(in, line) || (line != "OK " + to_string(n)))
+        {
+            cerr << "serveClient: batch " << b << " answered \"" << line << "\"" << endl;
+            return 1;
+        }
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            if (!readLine(in, line))
+            {
+                cerr << "serveClient: batch " << b << " ends after " << i << " of " << n << " reads" << endl;
+                return 1;
+            }
+            cout << line << "\n";
+        }
+        sent += n;
+    }
+    fprintf(out, "SHUTDOWN\n");
+    fflush(out);
+    if (!readLine(in, line) || (line != "BYE"))
+    {
+        cerr << "serveClient: SHUTDOWN answered \"" << line << "\"" << endl;
+        return 1;
+    }
+    fclose(out);
+    fclose(in);
+    return 0;
+}
@@ -0,0 +1,69 @@
+/**
+  * File:     simulateReads.cpp
+  *
+  * Author1:  Lucian Ilie (ilie@uwo.ca)
+  * Author2:  Stephen Lu (slu93@uwo.ca)
+  *
+  *   Writes to stdout a FASTQ dataset for the scripted checks in tests/:
+  *   reads of a random genome, both strands, with 1% substitutions (they
+  *   get lower qualities).
+  *
+  *   Usage: simulateReads <genome length> <number of reads> <read length> [seed]
+  *
+  */
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static uint64_t state = 0x2545F4914F6CDD1DULL;
+
+static uint64_t nextRandom()
+{
+    state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+    return state;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 4)
+    {
+        cerr << "Usage: simulateReads <genome length> <number of reads> <read length> [seed]" << endl;
+        return 1;
+    }
+    int64_t genomeLength = atoll(argv[1]), numberOfReads = atoll(argv[2]), readLength = atoll(argv[3]);
+    if (argc > 4)
+        state += strtoull(argv[4], NULL, 10);
+    if ((genomeLength < readLength) || (readLength <= 0))
+    {
+        cerr << "simulateReads: the read length must be between 1 and the genome length" << endl;
+        return 1;
+    }
+    const char bases[] = "ACGT";
+    string genome(genomeLength, 'A');
+    for (int64_t i = 0; i < genomeLength; ++i)
+        genome[i] = bases[nextRandom() % 4];
+    for (int64_t r = 0; r < numberOfReads; ++r)
+    {
+        string read = genome.substr(nextRandom() % (genomeLength - readLength + 1), readLength);
+        if (nextRandom() % 2)
+        {
+            string reverse(read.rbegin(), read.rend());
+            for (char& c : reverse)
+                c = (c == 'A') ? 'T' : (c == 'C') ? 'G' : (c == 'G') ? 'C' : 'A';
+            read = reverse;
+        }
+        string quality(readLength, 'I');
+        for (int64_t i = 0; i < readLength; ++i)
+            if (nextRandom() % 100 == 0)
+            {
+                read[i] = bases[(string(bases).find(read[i]) + 1 + nextRandom() % 3) % 4];
+                quality[i] = '#' + nextRandom() % 10;
+            }
+        cout << "@read" << r << "\n" << read << "\n+\n" << quality << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,147 @@
+/**
+  * File:     testBucketTable.cpp
+  *
+  * Author1:  Lucian Ilie (ilie@uwo.ca)
+  * Author2:  Stephen Lu (slu93@uwo.ca)
+  *
+  *   Check (make test) the bucketized cuckoo table (--bucket-table): with
+  *   few and many sMers it finds every sMer with its correct sGap and
+  *   score and no other sMer; and the reads corrected with it are those
+  *   corrected with the usual tables.
+  *
+  */
+
+#include "../QUESS.h"
+#include "../libquess.h"
+#include <omp.h>
+#include <set>
+
+using namespace std;
+
+#define NUMBER_OF_KEYS 300000
+#define GENOME_LENGTH 20000
+#define READ_LENGTH 100
+#define NUMBER_OF_READS 12000       // coverage 60
+
+static uint64_t state = 0x2545F4914F6CDD1DULL;
+
+static uint64_t nextRandom()
+{
+    state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+    return state;
+}
+
+// reads of a random genome, both strands, with 1% substitutions
+static void simulateReads(vector<string>& reads)
+{
+    const char bases[] = "ACGT";
+    string genome(GENOME_LENGTH, 'A');
+    for (int i = 0; i < GENOME_LENGTH; ++i)
+        genome[i] = bases[nextRandom() % 4];
+    for (int r = 0; r < NUMBER_OF_READS; ++r)
+    {
+        string read = genome.substr(nextRandom() % (GENOME_LENGTH - READ_LENGTH + 1), READ_LENGTH);
+        if (nextRandom() % 2)
+        {
+            string reverse(read.rbegin(), read.rend());
+            for (char& c : reverse)
+                c = (c == 'A') ? 'T' : (c == 'C') ? 'G' : (c == 'G') ? 'C' : 'A';
+            read = reverse;
+        }
+        for (char& c : read)
+            if (nextRandom() % 100 == 0)
+                c = bases[(string(bases).find(c) + 1 + nextRandom() % 3) % 4];
+        reads.push_back(read);
+    }
+}
+
+static vector<string> correct(const vector<string>& reads, bool bucketTables)
+{
+    QuessCorrector corrector(GENOME_LENGTH);
+    corrector.setBucketTables(bucketTables);
+    corrector.addReads(reads);
+    corrector.runSeeds();
+    vector<string> corrected;
+    corrector.getCorrectedReads(corrected);
+    return corrected;
+}
+
+// distinct random sMers of the seed with their entries (sGap | score << 56), and sMers not among them
+static int checkTable(uint64_t sMerMask, uint64_t sGapMask, uint64_t numberOfKeys)
+{
+    set<uint64_t> sMers;
+    vector<uint64_t> keys, entries;
+    while (sMers.size() < numberOfKeys)
+    {
+        uint64_t sMer = nextRandom() & sMerMask;
+        if (sMers.insert(sMer).second)
+        {
+            keys.push_back(sMer);
+            entries.push_back((nextRandom() & sGapMask) | ((nextRandom() % 256) << 56));
+        }
+    }
+    vector<uint64_t> absent;
+    while (absent.size() < numberOfKeys / 4 + 10)
+    {
+        uint64_t sMer = nextRandom() & sMerMask;
+        if (sMers.count(sMer) == 0)
+            absent.push_back(sMer);
+    }
+    BucketTable table(keys.data(), entries.data(), numberOfKeys);
+
+    int failures = 0;
+    for (uint64_t i = 0; i < numberOfKeys; ++i)
+    {
+        uint64_t sMer = keys[i], sGap = entries[i] & sGapMask, score = entries[i] >> 56, foundSGap = 0, foundScore = 0, correctSGap = 0;
+        if (!table.getCorrectEntry(sMer, foundSGap, foundScore) || (foundSGap != sGap) || (foundScore != score)
+            || (table.getCorrectSGap(sMer, sGap, correctSGap, 4) != 0))
+        {
+            ++failures;
+            break;
+        }
+    }
+    for (uint64_t sMer : absent)
+    {
+        uint64_t foundSGap = 0, foundScore = 0, correctSGap = 0;
+        if (table.getCorrectEntry(sMer, foundSGap, foundScore) || (table.getCorrectSGap(sMer, 0, correctSGap, 4) != -3))
+        {
+            ++failures;
+            break;
+        }
+    }
+    if (failures > 0)
+        cerr << "testBucketTable: " << numberOfKeys << " sMers: wrong entries" << endl;
+    return failures;
+}
+
+int main()
+{
+    uint64_t peakMemory = 0, currentMemory = 0;
+    char* seedString = new char[1000];
+    getSeed(seedString, 16, 8, 0, peakMemory, currentMemory);
+    Seed seed(seedString);
+
+    int failures = 0;
+    const uint64_t numbersOfKeys[] = {1, 7, 100, NUMBER_OF_KEYS};
+    for (uint64_t n : numbersOfKeys)
+        failures += checkTable(seed.getSMerMaskRC(), seed.getSGapMaskRC(), n);
+
+    vector<string> reads;
+    simulateReads(reads);
+    setVerbose(false);
+    omp_set_num_threads(1);       // the order of the sGaps (hence the model) is that of the reads
+    vector<string> expected = correct(reads, false);
+    if (expected == reads)
+    {
+        cerr << "testBucketTable: no read corrected" << endl;
+        ++failures;
+    }
+    if (correct(reads, true) != expected)
+    {
+        cerr << "testBucketTable: --bucket-table differs from the usual tables" << endl;
+        ++failures;
+    }
+    delete [] seedString;
+    cout << "testBucketTable: " << (failures == 0 ? "passed" : "FAILED") << endl;
+    return (failures == 0) ? 0 : 1;
+}
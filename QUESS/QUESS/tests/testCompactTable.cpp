@@ -0,0 +1,120 @@
+/**
+  * File:     testCompactTable.cpp
+  *
+  * Author1:  Lucian Ilie (ilie@uwo.ca)
+  * Author2:  Stephen Lu (slu93@uwo.ca)
+  *
+  *   Check (make test) the quotient counting table (--compact-table): the
+  *   sMers of a weight 20 seed inserted by 4 threads are given back by
+  *   getEntry with their counts (saturating at 255), a table too full
+  *   refuses sMers, and a HashTable counting in a CompactTable finds the
+  *   same frequent sMers as the Element table.
+  *
+  */
+
+#include "../QUESS.h"
+#include <omp.h>
+#include <algorithm>
+#include <map>
+
+#define WEIGHT 20                   // more than 32 sMer bits: not a NarrowTable
+#define NUMBER_OF_SMERS 5000
+#define TABLE_SIZE 100003
+
+// frequent sMers of the table, sorted
+static vector<uint64_t> frequent(HashTable& H, uint64_t Tc)
+{
+    vector<uint64_t> sMers;
+    H.collectFrequentSMers(Tc, sMers);
+    sort(sMers.begin(), sMers.end());
+    return sMers;
+}
+
+int main()
+{
+    uint64_t peakMemory = 0, currentMemory = 0;
+    char* seedString = new char[1000];
+    getSeed(seedString, WEIGHT, 8, 0, peakMemory, currentMemory);
+    Seed seed(seedString);
+    uint64_t keyMask = seed.getKeyMask();
+    int failures = 0;
+    if (!CompactTable::fits(keyMask, TABLE_SIZE) || CompactTable::fits(keyMask, 1))
+    {
+        cerr << "testCompactTable: fits is wrong" << endl;
+        ++failures;
+    }
+
+    // sMers counted 1 .. 300 times, around 254, 255 and 256 in particular
+    const uint64_t counts[] = {1, 2, 3, 4, 5, 8, 100, 253, 254, 255, 256, 257, 300};
+    const int numberOfCounts = sizeof(counts) / sizeof(counts[0]);
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+    map<uint64_t, uint64_t> expected;
+    vector<uint64_t> insertions;
+    for (int i = 0; i < NUMBER_OF_SMERS; ++i)
+    {
+        state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+        uint64_t sMer = state & keyMask;
+        expected[sMer] += counts[i % numberOfCounts];
+        insertions.insert(insertions.end(), counts[i % numberOfCounts], sMer);
+    }
+
+    CompactTable table(keyMask, TABLE_SIZE);
+    bool inserted = true;
+    omp_set_num_threads(4);
+#pragma omp parallel for reduction(&&:inserted)
+    for (uint64_t i = 0; i < insertions.size(); ++i)
+        inserted = table.insert(insertions[(i * 7919) % insertions.size()]) && inserted;    // interleaved sMers
+    map<uint64_t, uint64_t> found;
+    for (uint64_t place = 0; place < TABLE_SIZE; ++place)
+    {
+        uint64_t sMer, count;
+        table.getEntry(place, sMer, count);
+        if (count > 0)
+            found[sMer] += count;
+    }
+    for (auto& e : expected)
+        e.second = min(e.second, (uint64_t)255);
+    if (!inserted || (found != expected))
+    {
+        cerr << "testCompactTable: " << found.size() << " sMers found, " << expected.size() << " inserted" << (inserted ? "" : " (refused)") << endl;
+        ++failures;
+    }
+
+    // more sMers than slots
+    CompactTable small(keyMask, 1009);
+    bool refused = false;
+    for (uint64_t i = 0; (i < 2000) && !refused; ++i)
+        refused = !small.insert(insertions[i * 97 % insertions.size()] ^ (i & keyMask));
+    if (!refused)
+    {
+        cerr << "testCompactTable: a full table takes more sMers" << endl;
+        ++failures;
+    }
+
+    HashTable elements(20000);                  // Element table
+    elements.setKeyMask(keyMask, peakMemory, currentMemory);
+    HashTable compact(20000);
+    compact.setCompactCounting(true);
+    compact.setKeyMask(keyMask, peakMemory, currentMemory);
+    for (uint64_t sMer : insertions)
+    {
+        elements.insertSMer(sMer);
+        compact.insertSMer(sMer);
+    }
+    const uint64_t thresholds[] = {1, 4, 254, 255, 256};
+    for (uint64_t Tc : thresholds)
+    {
+        vector<uint64_t> expectedSMers = frequent(elements, Tc), foundSMers = frequent(compact, Tc);
+        if ((expectedSMers != foundSMers) || ((Tc == 255) && expectedSMers.empty()))
+        {
+            cerr << "testCompactTable: Tc = " << Tc << ": " << foundSMers.size() << " frequent sMers, expected "
+                 << expectedSMers.size() << endl;
+            ++failures;
+        }
+    }
+    elements.clear(peakMemory, currentMemory);
+    compact.clear(peakMemory, currentMemory);
+    delete [] seedString;
+    cout << "testCompactTable: " << (failures == 0 ? "passed" : "FAILED") << endl;
+    return (failures == 0) ? 0 : 1;
+}
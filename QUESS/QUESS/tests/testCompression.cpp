@@ -0,0 +1,259 @@
+/**
+  * File:     testCompression.cpp
+  *
+  * Author1:  Lucian Ilie (ilie@uwo.ca)
+  * Author2:  Stephen Lu (slu93@uwo.ca)
+  *
+  *   Check (make test) that DatasetReader gives back the bytes of a
+  *   dataset compressed with gzip (one member or several) and BGZF
+  *   (more than one batch of blocks, so a block is carried over), that
+  *   it detects the format, and that a truncated gzip file is an error.
+  *   Then that DatasetWriter (-z) writes files that give the bytes back,
+  *   the same files with 1 and 4 threads, BGZF ending with its EOF block.
+  *
+  */
+
+#include "../QUESS.h"
+#include <omp.h>
+#include <unistd.h>
+#include <zlib.h>
+#if USE_ZSTD
+#include <zstd.h>
+#endif
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+#define DATA_LENGTH (40 << 20)      // incompressible: more than one BGZF batch (BGZF_BATCH_BLOCKS blocks)
+
+static void writeFile(const string& name, const string& data)
+{
+    ofstream out(name, ios::binary);
+    out << data;
+}
+
+static string readFile(const string& name)
+{
+    ifstream in(name, ios::binary);
+    ostringstream data;
+    data << in.rdbuf();
+    return data.str();
+}
+
+// gzip members of the parts of data, one after the other
+static string gzipMembers(const string& data, int numberOfMembers)
+{
+    string members;
+    for (int m = 0; m < numberOfMembers; ++m)
+    {
+        uint64_t from = data.size() * m / numberOfMembers, to = data.size() * (m + 1) / numberOfMembers;
+        z_stream stream;
+        memset(&stream, 0, sizeof(stream));
+        deflateInit2(&stream, 1, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+        string member(deflateBound(&stream, to - from), '\0');
+        stream.next_in = (Bytef*)data.data() + from;
+        stream.avail_in = to - from;
+        stream.next_out = (Bytef*)&member[0];
+        stream.avail_out = member.size();
+        deflate(&stream, Z_FINISH);
+        member.resize(stream.total_out);
+        deflateEnd(&stream);
+        members += member;
+    }
+    return members;
+}
+
+// BGZF as bgzip writes it: blocks of at most 0xff00 bytes with a 'B','C' subfield (block size - 1), then the empty EOF block
+static string bgzf(const string& data)
+{
+    string blocks;
+    for (uint64_t from = 0; from <= data.size(); from += 0xff00)
+    {
+        uint64_t length = min((uint64_t)0xff00, data.size() - from);
+        z_stream stream;
+        memset(&stream, 0, sizeof(stream));
+        deflateInit2(&stream, 1, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+        string block(18 + deflateBound(&stream, length) + 8, '\0');
+        const unsigned char header[18] = {31, 139, 8, 4, 0, 0, 0, 0, 0, 255, 6, 0, 'B', 'C', 2, 0, 0, 0};
+        memcpy(&block[0], header, 18);
+        stream.next_in = (Bytef*)data.data() + from;
+        stream.avail_in = length;
+        stream.next_out = (Bytef*)&block[18];
+        stream.avail_out = block.size() - 18 - 8;
+        deflate(&stream, Z_FINISH);
+        uint64_t blockSize = 18 + stream.total_out + 8;
+        deflateEnd(&stream);
+        uint32_t crc = crc32(crc32(0L, Z_NULL, 0), (const Bytef*)data.data() + from, length);
+        for (int i = 0; i < 4; ++i)
+        {
+            block[18 + stream.total_out + i] = (char)(crc >> (8 * i));
+            block[18 + stream.total_out + 4 + i] = (char)(length >> (8 * i));
+        }
+        block[16] = (char)((blockSize - 1) & 0xff);
+        block[17] = (char)((blockSize - 1) >> 8);
+        block.resize(blockSize);
+        blocks += block;
+        if (length == 0)        // the EOF block
+            break;
+    }
+    return blocks;
+}
+
+// the dataset of fileName through DatasetReader (read in pieces of odd sizes); empty if an error is thrown
+static string readDataset(const string& fileName, char& format, bool& error)
+{
+    DatasetReader reader;
+    string data;
+    error = false;
+    format = 0;
+    if (!reader.open(fileName.c_str()))
+    {
+        error = true;
+        return data;
+    }
+    format = reader.compression();
+    string piece(1 << 20, '\0');
+    try
+    {
+        uint64_t pieceLength = 1;
+        while (uint64_t length = reader.read(&piece[0], pieceLength))
+        {
+            data.append(piece, 0, length);
+            pieceLength = (pieceLength * 7 + 3) % piece.size() + 1;
+        }
+    }
+    catch (const QuessError&)
+    {
+        error = true;
+    }
+    return data;
+}
+
+// data through DatasetWriter with compression (in pieces of odd sizes and lines); the file written
+static string writeDataset(const string& fileName, const char* compression, const string& data, int numberOfThreads)
+{
+    omp_set_num_threads(numberOfThreads);
+    DatasetWriter writer;
+    writer.setCompression(compression);
+    writer.open(fileName.c_str());
+    uint64_t from = 0, pieceLength = 1;
+    while (from < data.size())
+    {
+        uint64_t length = min(pieceLength, (uint64_t)data.size() - from);
+        writer.write(data.data() + from, length);
+        from += length;
+        pieceLength = (pieceLength * 7 + 3) % (3 << 20) + 1;
+    }
+    writer.writeLine("@last");
+    writer.close();
+    string file = readFile(fileName);
+    remove(fileName.c_str());
+    return file;
+}
+
+int main()
+{
+    string data(DATA_LENGTH, '\0');
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+    for (char& c : data)
+    {
+        state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+        c = (char)(state >> 56);
+    }
+    string small = "@r1\nACGT\n+\nIIII\n";
+    string prefix = "testCompression_" + to_string(getpid());
+
+    struct Case
+    {
+        const char* name;
+        string file;
+        char format;
+        bool error;
+        const string* expected;
+    };
+    const string truncatedGzip = gzipMembers(data, 1);
+    Case cases[] = {
+        {"plain", data, 'p', false, &data},
+        {"gzip", gzipMembers(data, 1), 'g', false, &data},
+        {"gzip, 3 members", gzipMembers(data, 3), 'g', false, &data},
+        {"gzip, small", gzipMembers(small, 1), 'g', false, &small},
+        {"BGZF", bgzf(data), 'b', false, &data},
+        {"BGZF, small", bgzf(small), 'b', false, &small},
+        {"gzip, truncated", truncatedGzip.substr(0, truncatedGzip.size() - 1000), 'g', true, NULL},
+    };
+
+    int failures = 0;
+    for (Case& c : cases)
+    {
+        string fileName = prefix + ".gz";
+        writeFile(fileName, c.file);
+        char format;
+        bool error;
+        string read = readDataset(fileName, format, error);
+        remove(fileName.c_str());
+        if (format != c.format)
+        {
+            cerr << "testCompression: " << c.name << ": format '" << format << "', expected '" << c.format << "'" << endl;
+            ++failures;
+        }
+        else if (error != c.error)
+        {
+            cerr << "testCompression: " << c.name << ": " << (error ? "error reading" : "no error reading") << " the dataset" << endl;
+            ++failures;
+        }
+        else if ((c.expected != NULL) && (read != *c.expected))
+        {
+            cerr << "testCompression: " << c.name << ": " << read.size() << " bytes read differ from the " << c.expected->size() << " of the dataset" << endl;
+            ++failures;
+        }
+    }
+
+    const unsigned char bgzfEOF[28] = {31, 139, 8, 4, 0, 0, 0, 0, 0, 255, 6, 0, 66, 67, 2, 0, 27, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    const char* compressions[] = {"none", "gzip", "bgzf", "zstd"};
+    string written = data + "@last\n";
+    for (const char* compression : compressions)
+    {
+        if ((strcmp(compression, "zstd") == 0) && !USE_ZSTD)
+            continue;
+        string fileName = prefix + ".out";
+        string file = writeDataset(fileName, compression, data, 4);
+        if (file != writeDataset(fileName, compression, data, 1))
+        {
+            cerr << "testCompression: -z " << compression << ": the files written with 1 and 4 threads differ" << endl;
+            ++failures;
+        }
+        if ((strcmp(compression, "bgzf") == 0) && ((file.size() < 28) || (memcmp(file.data() + file.size() - 28, bgzfEOF, 28) != 0)))
+        {
+            cerr << "testCompression: -z bgzf: no EOF block at the end" << endl;
+            ++failures;
+        }
+        string read;
+        char format = 0, expectedFormat = compression[0];
+        bool error = false;
+        if (strcmp(compression, "zstd") == 0)
+        {
+#if USE_ZSTD
+            read.resize(written.size());
+            size_t result = ZSTD_decompress(&read[0], read.size(), file.data(), file.size());     // all the frames
+            error = ZSTD_isError(result) || (result != written.size());
+            format = 'z';
+#endif
+        }
+        else
+        {
+            writeFile(fileName, file);
+            read = readDataset(fileName, format, error);
+            remove(fileName.c_str());
+            expectedFormat = (strcmp(compression, "none") == 0) ? 'p' : expectedFormat;
+        }
+        if ((format != expectedFormat) || error || (read != written))
+        {
+            cerr << "testCompression: -z " << compression << ": the file written does not give the data back" << endl;
+            ++failures;
+        }
+    }
+    cout << "testCompression: " << (failures == 0 ? "passed" : "FAILED") << endl;
+    return (failures == 0) ? 0 : 1;
+}
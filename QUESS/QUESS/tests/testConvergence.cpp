@@ -0,0 +1,126 @@
+/**
+  * File:     testConvergence.cpp
+  *
+  * Author1:  Lucian Ilie (ilie@uwo.ca)
+  * Author2:  Stephen Lu (slu93@uwo.ca)
+  *
+  *   Check (make test) the adaptive seed schedule (--converge): with a
+  *   threshold no seed reaches, the run stops after ADAPTIVE_MIN_SEEDS
+  *   seeds, says so, and gives the reads of a run with only those seeds;
+  *   with a threshold only a seed writing no correction misses, the reads
+  *   are those of the usual schedule.
+  *
+  */
+
+#include "../QUESS.h"
+#include "../libquess.h"
+#include <omp.h>
+
+using namespace std;
+
+#define GENOME_LENGTH 20000
+#define READ_LENGTH 100
+#define NUMBER_OF_READS 12000       // coverage 60
+#define WEIGHT 16
+#define NUMBER_OF_SEEDS 8
+
+static uint64_t state = 0x2545F4914F6CDD1DULL;
+
+static uint64_t nextRandom()
+{
+    state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+    return state;
+}
+
+// reads of a random genome, both strands, with 1% substitutions
+static void simulateReads(vector<string>& reads)
+{
+    const char bases[] = "ACGT";
+    string genome(GENOME_LENGTH, 'A');
+    for (int i = 0; i < GENOME_LENGTH; ++i)
+        genome[i] = bases[nextRandom() % 4];
+    for (int r = 0; r < NUMBER_OF_READS; ++r)
+    {
+        string read = genome.substr(nextRandom() % (GENOME_LENGTH - READ_LENGTH + 1), READ_LENGTH);
+        if (nextRandom() % 2)
+        {
+            string reverse(read.rbegin(), read.rend());
+            for (char& c : reverse)
+                c = (c == 'A') ? 'T' : (c == 'C') ? 'G' : (c == 'G') ? 'C' : 'A';
+            read = reverse;
+        }
+        for (char& c : read)
+            if (nextRandom() % 100 == 0)
+                c = bases[(string(bases).find(c) + 1 + nextRandom() % 3) % 4];
+        reads.push_back(read);
+    }
+}
+
+static bool converged = false;      // "Corrections converged" logged
+
+static void logger(const char* line, void*)
+{
+    if (strstr(line, "Corrections converged") != NULL)
+        converged = true;
+}
+
+// the corrected reads and the number of seeds run; seeds empty: the precomputed ones of WEIGHT
+static vector<string> correct(const vector<string>& reads, const vector<string>& seeds, double convergence, int& seedsRun)
+{
+    QuessCorrector corrector(GENOME_LENGTH, WEIGHT, NUMBER_OF_SEEDS);
+    if (!seeds.empty())
+        corrector.setSeeds(seeds);
+    corrector.setConvergence(convergence);
+    corrector.addReads(reads);
+    converged = false;
+    for (seedsRun = 0; corrector.runSeed(); ++seedsRun)
+        ;
+    vector<string> corrected;
+    corrector.getCorrectedReads(corrected);
+    return corrected;
+}
+
+int main()
+{
+    vector<string> reads;
+    simulateReads(reads);
+    omp_set_num_threads(4);
+    setLogger(logger, NULL);
+
+    uint64_t peakMemory = 0, currentMemory = 0;
+    char* seedString = new char[1000];
+    vector<string> firstSeeds;
+    for (int i = 0; i < ADAPTIVE_MIN_SEEDS; ++i)
+    {
+        getSeed(seedString, WEIGHT, NUMBER_OF_SEEDS, i, peakMemory, currentMemory);
+        firstSeeds.push_back(seedString);
+    }
+    delete [] seedString;
+
+    int failures = 0, seedsRun = 0, firstSeedsRun = 0;
+    vector<string> expected = correct(reads, vector<string>(), 0, seedsRun);
+    if ((seedsRun != NUMBER_OF_SEEDS) || converged || (expected == reads))
+    {
+        cerr << "testConvergence: the usual schedule ran " << seedsRun << " seeds" << endl;
+        ++failures;
+    }
+    // a seed writing no correction (or leaving no suspect read) stops it: the later seeds would not change the reads
+    if ((correct(reads, vector<string>(), 1e-9, seedsRun) != expected) || (seedsRun < ADAPTIVE_MIN_SEEDS) || (converged != (seedsRun < NUMBER_OF_SEEDS)))
+    {
+        cerr << "testConvergence: --converge 1e-9 (" << seedsRun << " seeds) differs from the usual schedule" << endl;
+        ++failures;
+    }
+    vector<string> stopped = correct(reads, vector<string>(), 1e12, seedsRun);
+    if ((seedsRun != ADAPTIVE_MIN_SEEDS) || !converged)
+    {
+        cerr << "testConvergence: --converge 1e12 ran " << seedsRun << " seeds" << (converged ? "" : " and did not say it converged") << endl;
+        ++failures;
+    }
+    if ((stopped != correct(reads, firstSeeds, 0, firstSeedsRun)) || (firstSeedsRun != ADAPTIVE_MIN_SEEDS))
+    {
+        cerr << "testConvergence: --converge 1e12 differs from a run with the first " << ADAPTIVE_MIN_SEEDS << " seeds" << endl;
+        ++failures;
+    }
+    cout << "testConvergence: " << (failures == 0 ? "passed" : "FAILED") << endl;
+    return (failures == 0) ? 0 : 1;
+}
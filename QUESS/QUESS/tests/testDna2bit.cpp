@@ -0,0 +1,212 @@
+/**
+  * File:     testDna2bit.cpp
+  *
+  * Author1:  Lucian Ilie (ilie@uwo.ca)
+  * Author2:  Stephen Lu (slu93@uwo.ca)
+  *
+  *   Check (make test) of the primitives of dna2bit.h against the
+  *   table-based implementations they replaced (byteRC and
+  *   computeRevCompl of read.cpp, diff16Bits and HashTable::getDiff,
+  *   the switch statements of Read) and, for gatherBits/scatterBits,
+  *   against bit by bit pext/pdep: all bytes, all 16-bit blocks in
+  *   each position, all chars, and random 64- and 128-bit words.
+  *
+  */
+
+#include "../dna2bit.h"
+#include <iostream>
+
+using namespace std;
+
+// ============== reference implementations ==============
+
+// nucleotide-wise reverse complements of all 8-bit values (read.cpp)
+const uint8_t byteRC[256] = {
+    255, 191, 127, 63, 239, 175, 111, 47, 223, 159, 95, 31, 207, 143, 79, 15, 251, 187, 123, 59, 235, 171, 107, 43, 219, 155, 91, 27, 203, 139, 75, 11, 247, 183, 119, 55, 231, 167, 103, 39, 215, 151, 87, 23, 199, 135, 71, 7, 243, 179, 115, 51, 227, 163, 99, 35, 211, 147, 83, 19, 195, 131, 67, 3, 254, 190, 126, 62, 238, 174, 110, 46, 222, 158, 94, 30, 206, 142, 78, 14, 250, 186, 122, 58, 234, 170, 106, 42, 218, 154, 90, 26, 202, 138, 74, 10, 246, 182, 118, 54, 230, 166, 102, 38, 214, 150, 86, 22, 198, 134, 70, 6, 242, 178, 114, 50, 226, 162, 98, 34, 210, 146, 82, 18, 194, 130, 66, 2, 253, 189, 125, 61, 237, 173, 109, 45, 221, 157, 93, 29, 205, 141, 77, 13, 249, 185, 121, 57, 233, 169, 105, 41, 217, 153, 89, 25, 201, 137, 73, 9, 245, 181, 117, 53, 229, 165, 101, 37, 213, 149, 85, 21, 197, 133, 69, 5, 241, 177, 113, 49, 225, 161, 97, 33, 209, 145, 81, 17, 193, 129, 65, 1, 252, 188, 124, 60, 236, 172, 108, 44, 220, 156, 92, 28, 204, 140, 76, 12, 248, 184, 120, 56, 232, 168, 104, 40, 216, 152, 88, 24, 200, 136, 72, 8, 244, 180, 116, 52, 228, 164, 100, 36, 212, 148, 84, 20, 196, 132, 68, 4, 240, 176, 112, 48, 224, 160, 96, 32, 208, 144, 80, 16, 192, 128, 64, 0
+};
+
+uint64_t computeRevCompl(uint64_t x)
+{
+    uint64_t y = 0, mask = (1 << 8) - 1;
+    for (uint64_t i = 0; i < 7; ++i) {
+        y |= byteRC[(uint8_t)(x & mask)];
+        y <<= 8;
+        x >>= 8;
+    }
+    y |= byteRC[(uint8_t)(x & mask)];
+    return(y);
+}
+
+uint64_t computeDiff16Bits(uint16_t x)
+{
+    uint64_t nDiff = 0;
+    for (uint64_t i = 0; i < 8; ++i)
+        if (((x >> (2 * i)) & 3) != 0)
+            ++nDiff;
+    return nDiff;
+}
+
+uint64_t diff16Bits[1 << 16];
+
+uint64_t getDiff(uint64_t x, uint64_t y)
+{
+    uint64_t nDiff = 0;
+    uint64_t mask = (1 << 16) - 1;
+    uint64_t xXORy = x ^ y;
+    for (uint64_t i = 0; i < 4; ++i)
+        nDiff += diff16Bits[(xXORy >> (16 * i)) & mask];
+    return nDiff;
+}
+
+// -1 for a non-base (Read(char*) replaces it by a random base)
+int encodeBase(char c)
+{
+    switch (c)
+    {   case 'A': case 'a': return 0;
+        case 'C': case 'c': return 1;
+        case 'G': case 'g': return 2;
+        case 'T': case 't': return 3;
+        default: return -1;
+    }
+}
+
+char decodeBase(uint64_t code)
+{
+    switch (code)
+    {   case 0: return 'A';
+        case 1: return 'C';
+        case 2: return 'G';
+        default: return 'T';
+    }
+}
+
+uint128_t revCompl128(uint128_t x)
+{
+    uint128_t y = 0;
+    for (int i = 0; i < 64; ++i)
+        y = (y << 2) | (3 - (uint64_t)((x >> (2 * i)) & 3));
+    return y;
+}
+
+uint64_t pext(uint128_t x, uint128_t mask)
+{
+    uint64_t y = 0, length = 0;
+    for (int bit = 0; bit < 128; ++bit)
+        if ((mask >> bit) & 1)
+            y |= (uint64_t)((x >> bit) & 1) << length++;
+    return y;
+}
+
+uint128_t pdep(uint64_t y, uint128_t mask)
+{
+    uint128_t x = 0;
+    uint64_t length = 0;
+    for (int bit = 0; bit < 128; ++bit)
+        if ((mask >> bit) & 1)
+            x |= (uint128_t)((y >> length++) & 1) << bit;
+    return x;
+}
+
+// ============== checks ==============
+
+static uint64_t state = 0x2545F4914F6CDD1DULL;
+
+static uint64_t random64()
+{
+    state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+    return state;
+}
+
+static int failures = 0;
+
+static void check(bool ok, const char* what, uint64_t x)
+{
+    if (!ok && (++failures <= 10))
+        cerr << "testDna2bit: " << what << " differs for " << x << endl;
+}
+
+// mask of at most 64 bits with runs shorter than 64 bits: 2-bit blocks (as the seeds) or single bits
+static uint128_t randomMask(bool wide, bool blocks)
+{
+    uint128_t mask = 0;
+    int positions = blocks ? (wide ? 64 : 32) : (wide ? 128 : 64);
+    int width = blocks ? 2 : 1;
+    int set = 1 + (int)(random64() % (64 / width));
+    for (int i = 0; i < set; ++i)
+        mask |= (uint128_t)(width == 2 ? 3 : 1) << (width * (random64() % positions));
+    if (!wide && !blocks && ((uint64_t)mask == ~(uint64_t)0))
+        mask &= ~(uint128_t)1;
+    return mask;
+}
+
+int main()
+{
+    for (uint64_t i = 0; i < (1 << 16); ++i)
+        diff16Bits[i] = computeDiff16Bits((uint16_t)i);
+
+    // bytes
+    for (uint64_t b = 0; b < 256; ++b)
+        check(revComplByte2Bit((uint8_t)b) == byteRC[b], "revComplByte2Bit", b);
+
+    // every 16-bit block in each position of a word
+    for (uint64_t i = 0; i < 4; ++i)
+        for (uint64_t v = 0; v < (1 << 16); ++v)
+        {
+            uint64_t x = v << (16 * i);
+            check(revCompl2Bit(x) == computeRevCompl(x), "revCompl2Bit", x);
+            check(diff2Bit(x, 0) == getDiff(x, 0), "diff2Bit", x);
+        }
+
+    // random words
+    for (uint64_t n = 0; n < 10000000; ++n)
+    {
+        uint64_t x = random64(), y = random64();
+        check(revCompl2Bit(x) == computeRevCompl(x), "revCompl2Bit", x);
+        check(diff2Bit(x, y) == getDiff(x, y), "diff2Bit", x);
+        check(diff2Bit(x, x ^ (y & (y >> 7))) == getDiff(x, x ^ (y & (y >> 7))), "diff2Bit (close words)", x);
+        if (n < 1000000)
+        {
+            uint128_t w = ((uint128_t)x << 64) | y;
+            check(revCompl2Bit(w) == revCompl128(w), "revCompl2Bit (128 bits)", x);
+            check(revCompl2Bit(revCompl2Bit(w)) == w, "revCompl2Bit (128 bits, twice)", x);
+        }
+    }
+
+    // chars
+    for (int c = 0; c < 256; ++c)
+    {
+        int code = encodeBase((char)c);
+        check(isBase2Bit((char)c) == (code >= 0), "isBase2Bit", c);
+        if (code >= 0)
+            check(encodeBase2Bit((char)c) == (uint64_t)code, "encodeBase2Bit", c);
+    }
+    for (uint64_t code = 0; code < 4; ++code)
+    {
+        check(decodeBase2Bit(code) == decodeBase(code), "decodeBase2Bit", code);
+        check(encodeBase2Bit(decodeBase2Bit(code)) == code, "encodeBase2Bit(decodeBase2Bit)", code);
+    }
+
+    // gather/scatter under random masks of 64 and 128 bits
+    MaskRuns runs;
+    for (uint64_t n = 0; n < 200000; ++n)
+    {
+        bool wide = (n & 1), blocks = (n & 2);
+        uint128_t mask = randomMask(wide, blocks);
+        getMaskRuns(mask, runs);
+        for (int k = 0; k < 8; ++k)
+        {
+            uint128_t x = wide ? (((uint128_t)random64() << 64) | random64()) : (uint128_t)random64();
+            uint64_t gathered = pext(x, mask);
+            if (wide)
+                check(gatherBits(x, runs) == gathered, "gatherBits (128 bits)", (uint64_t)mask);
+            else
+                check(gatherBits((uint64_t)x, runs) == gathered, "gatherBits", (uint64_t)mask);
+            uint64_t y = random64();
+            check(scatterBits(y, runs) == pdep(y, mask), "scatterBits", (uint64_t)mask);
+            check(scatterBits(gathered, runs) == (x & mask), "scatterBits(gatherBits)", (uint64_t)mask);
+        }
+    }
+
+    cout << "testDna2bit: " << (failures == 0 ? "passed" : "FAILED") << endl;
+    return (failures == 0) ? 0 : 1;
+}
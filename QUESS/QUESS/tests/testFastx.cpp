@@ -0,0 +1,248 @@
+/**
+  * File:     testFastx.cpp
+  *
+  * Author1:  Lucian Ilie (ilie@uwo.ca)
+  * Author2:  Stephen Lu (slu93@uwo.ca)
+  *
+  *   Check (make test) the parallel FASTQ/FASTA parser (parseWindow)
+  *   against a line-by-line reference parser: crafted datasets are cut
+  *   into two windows at every byte and parsed with several numbers of
+  *   threads; the reads, binned scores, records file and counts must not
+  *   depend on the cut or the threads. The records file must also give
+  *   back the dataset through createOutputFile.
+  *
+  */
+
+#include "../QUESS.h"
+#include <omp.h>
+#include <unistd.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+typedef struct
+{
+    string reads, qualities, records;
+    int64_t numberOfReads, totalReadLength, truncatedReads, badRecords;
+}
+Parsed;
+
+static bool sameParse(const Parsed& a, const Parsed& b)
+{
+    return (a.reads == b.reads) && (a.qualities == b.qualities) && (a.records == b.records) && (a.numberOfReads == b.numberOfReads)
+           && (a.totalReadLength == b.totalReadLength) && (a.truncatedReads == b.truncatedReads) && (a.badRecords == b.badRecords);
+}
+
+// a read line in the records file: bases kept in the reads, then ':' and the other bytes of the line
+static string recordLine(const string& line, uint64_t kept)
+{
+    string encoded = (kept > 0) ? to_string(kept) : "";
+    if (line.size() > kept)
+        encoded += ":" + line.substr(kept);
+    return encoded + "\n";
+}
+
+// reference: the dataset line by line (valid datasets only)
+static Parsed referenceParse(const string& dataset)
+{
+    vector<string> lines;
+    istringstream in(dataset);
+    string line;
+    while (getline(in, line))
+        lines.push_back(line);
+    Parsed parsed = {"", "", "", 0, 0, 0, 0};
+    char fastx = dataset[0];
+    uint64_t maxKept = MAX_READ_LENGTH - 1;
+    auto strip = [](const string& l) { return (!l.empty() && l.back() == '\r') ? l.substr(0, l.size() - 1) : l; };
+    size_t i = 0;
+    while (i < lines.size())
+    {
+        if (lines[i].empty() || (lines[i][0] == '\r'))     // empty line between records
+        {
+            ++i;
+            continue;
+        }
+        parsed.records += lines[i++] + "\n";
+        string read;
+        bool truncated = false;
+        if (fastx == '@')
+        {
+            string bases = strip(lines[i]);
+            read = bases.substr(0, min((uint64_t)bases.size(), maxKept));
+            truncated = (bases.size() > maxKept);
+            parsed.records += recordLine(lines[i++], read.size());
+            parsed.records += lines[i++] + "\n";
+            string scores = strip(lines[i]);
+            parsed.records += lines[i++] + "\n";
+            string bins((read.size() + 3) / 4, '\0');
+            for (size_t p = 0; p < min(read.size(), scores.size()); ++p)
+            {
+                int bin = max(0, min(3, ((int)(uint8_t)scores[p] - QUALITY_OFFSET) / QUALITY_BIN_WIDTH));
+                bins[p / 4] |= (char)(bin << (6 - 2 * (p % 4)));
+            }
+            parsed.qualities += bins;
+        }
+        else
+            while ((i < lines.size()) && (lines[i].empty() || (lines[i][0] != '>')))
+            {
+                string bases = strip(lines[i]);
+                uint64_t copy = min((uint64_t)bases.size(), maxKept - read.size());
+                truncated = truncated || (copy < bases.size());
+                read += bases.substr(0, copy);
+                parsed.records += recordLine(lines[i++], copy);
+            }
+        parsed.reads += read + "\n";
+        ++parsed.numberOfReads;
+        parsed.totalReadLength += read.size();
+        parsed.truncatedReads += truncated ? 1 : 0;
+    }
+    return parsed;
+}
+
+// parseWindow on the windows [0, cut) and the rest, as createWorkingFiles reads them
+static Parsed windowParse(const string& dataset, uint64_t cut, bool oneWindow)
+{
+    Parsed parsed = {"", "", "", 0, 0, 0, 0};
+    int64_t numberOfChunks = 4 * omp_get_max_threads();
+    char fastx = dataset[0];
+    string window;
+    uint64_t next = 0;
+    for (int w = 0; w < 2; ++w)
+    {
+        uint64_t add = (w == 0 && !oneWindow) ? cut : dataset.size() - next;
+        window += dataset.substr(next, add);
+        next += add;
+        bool lastWindow = (w == 1) || oneWindow;
+        uint64_t windowLength = window.size();
+        vector<char> reads(windowLength + numberOfChunks), qualities(windowLength + numberOfChunks), records(2 * (windowLength + numberOfChunks));
+        vector<uint64_t> start(numberOfChunks + 1), stop(numberOfChunks), readsLength(numberOfChunks), qualitiesLength(numberOfChunks), recordsLength(numberOfChunks);
+        vector<FastxCounts> counts(numberOfChunks);
+        ParsedChunks chunks = {start.data(), stop.data(), reads.data(), (fastx == '@') ? qualities.data() : NULL, records.data(),
+                               readsLength.data(), qualitiesLength.data(), recordsLength.data(), counts.data()};
+        int64_t chunksDone = 0;
+        uint64_t consumed = parseWindow(window.data(), windowLength, lastWindow, fastx, numberOfChunks, chunks, chunksDone);
+        for (int64_t k = 0; k < chunksDone; ++k)
+        {
+            parsed.reads.append(chunks.reads + start[k] + k, readsLength[k]);
+            if (chunks.qualities != NULL)
+                parsed.qualities.append(chunks.qualities + start[k] + k, qualitiesLength[k]);
+            parsed.records.append(chunks.records + 2 * (start[k] + k), recordsLength[k]);
+            parsed.numberOfReads += counts[k].numberOfReads;
+            parsed.totalReadLength += counts[k].totalReadLength;
+            parsed.truncatedReads += counts[k].truncatedReads;
+            parsed.badRecords += counts[k].badRecords;
+        }
+        window.erase(0, consumed);
+        if (lastWindow)
+            break;
+    }
+    if (!window.empty())        // the last window must be consumed
+        ++parsed.badRecords;
+    return parsed;
+}
+
+static void writeFile(const string& name, const string& data)
+{
+    ofstream out(name, ios::binary);
+    out << data;
+}
+
+static string readFile(const string& name)
+{
+    ifstream in(name, ios::binary);
+    ostringstream data;
+    data << in.rdbuf();
+    return data.str();
+}
+
+// createOutputFile from the records file gives the dataset back (all reads unchanged, empty lines between records dropped)
+static bool recordsGiveDataset(const string& dataset, const Parsed& parsed)
+{
+    string prefix = "testFastx_" + to_string(getpid());
+    string datasetName = prefix + "_dataset", recordsName = prefix + "_records", readsName = prefix + "_reads";
+    string fromDatasetName = prefix + "_fromDataset", fromRecordsName = prefix + "_fromRecords";
+    writeFile(datasetName, dataset);
+    writeFile(recordsName, parsed.records);
+    DatasetWriter fromDataset, fromRecords;
+    writeFile(readsName, parsed.reads);
+    createOutputFile((char*)datasetName.c_str(), (char*)readsName.c_str(), (char*)fromDatasetName.c_str(), fromDataset, false);
+    writeFile(readsName, parsed.reads);
+    createOutputFile((char*)recordsName.c_str(), (char*)readsName.c_str(), (char*)fromRecordsName.c_str(), fromRecords, true);
+    bool same = (readFile(fromDatasetName) == readFile(fromRecordsName));
+    remove(datasetName.c_str());
+    remove(recordsName.c_str());
+    remove(fromDatasetName.c_str());
+    remove(fromRecordsName.c_str());
+    return same;
+}
+
+int main()
+{
+    string longBases, longScores;
+    for (int i = 0; i < 2 * MAX_READ_LENGTH; ++i)
+    {
+        longBases += "ACGT"[(i * 7) % 4];
+        longScores += (char)('#' + i % 40);
+    }
+    string manyRecords;
+    for (int r = 0; r < 40; ++r)
+    {
+        string bases, scores;
+        for (int i = 0; i < 20 + (r * 13) % 70; ++i)
+        {
+            bases += "ACGTN"[(r + i * 3) % 5];
+            scores += "@+I#5"[(r * 5 + i) % 5];     // score lines starting with '@' or '+'
+        }
+        manyRecords += "@read" + to_string(r) + ((r % 3 == 0) ? " +x" : "") + "\n" + bases + "\n+" + ((r % 4 == 0) ? "read" + to_string(r) : "") + "\n" + scores + "\n";
+    }
+    const string datasets[] = {
+        // scores starting with '@' and '+', headers with '+' and '@'
+        "@r1 a+b\nACGTACGTAC\n+\n@IIII+III#\n@r2 @x\nGGGGCCCCAA\n+r2\n+@@@@IIIII\n@r3\nTTTTTTTTTT\n+\n@+@+@+@+@+\n",
+        // CRLF, empty lines between records, no final end of line
+        "@r1\r\nACGTACGTAC\r\n+\r\n@IIII+III#\r\n\r\n@r2\r\nGGGGCCCCAA\r\n+\r\n+@@@@IIIII\r\n\n@r3\r\nTTTTTTTTTT\r\n+\r\n@+@+@+@+@+",
+        // long read (truncated) and a score line shorter than its read
+        "@long\n" + longBases + "\n+\n" + longScores + "\n@short\nACGTACGTACGT\n+\nIIII\n@r3\nACGT\n+\nIIII\n",
+        // records spread over many chunks
+        manyRecords,
+        // multi-line FASTA: line widths, empty record, empty lines, CRLF, long multi-line read, no final end of line
+        ">s1 first\nACGTACGTAC\nGGTTA\nC\n>s2 empty\n>s3\r\nAAAACCCC\r\nGGGG\r\n\r\n>s4\n" + longBases.substr(0, 250) + "\n" + longBases.substr(0, 250)
+            + "\n" + longBases.substr(0, 50) + "\n>s5\nTTTT\nAC",
+        // FASTA, one line per read
+        ">a\nACGTTGCA\n>b\nTTTTGGGGCCCCAAAA\n>c\nA\n"
+    };
+    const int threads[] = {1, 2, 3, 8};
+
+    int failures = 0;
+    int datasetNumber = 0;
+    for (const string& dataset : datasets)
+    {
+        Parsed expected = referenceParse(dataset);
+        for (int t : threads)
+        {
+            omp_set_num_threads(t);
+            if (!sameParse(windowParse(dataset, 0, true), expected))
+            {
+                cerr << "testFastx: dataset " << datasetNumber << ", one window, " << t << " threads: differs from the reference" << endl;
+                ++failures;
+            }
+            for (uint64_t cut = 0; cut <= dataset.size(); ++cut)
+                if (!sameParse(windowParse(dataset, cut, false), expected))
+                {
+                    cerr << "testFastx: dataset " << datasetNumber << ", windows cut at " << cut << ", " << t << " threads: differs from the reference" << endl;
+                    ++failures;
+                    break;
+                }
+        }
+        if (!recordsGiveDataset(dataset, expected))
+        {
+            cerr << "testFastx: dataset " << datasetNumber << ": the records file does not give the dataset back" << endl;
+            ++failures;
+        }
+        ++datasetNumber;
+    }
+    cout << "testFastx: " << (failures == 0 ? "passed" : "FAILED") << endl;
+    return (failures == 0) ? 0 : 1;
+}
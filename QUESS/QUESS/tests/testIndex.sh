@@ -0,0 +1,25 @@
+#!/bin/sh
+#
+# Check (make test) the correction index: the models saved with --save-index,
+# loaded with --load-index, correct the reads as the run that saved them did,
+# with the usual tables, --static-table and --bucket-table.
+#
+# Usage: tests/testIndex.sh (from the QUESS directory, after make QUESS tests/simulateReads)
+
+DIR=$(mktemp -d /tmp/testIndex.XXXXXX)
+trap 'rm -rf "$DIR"' EXIT
+
+./tests/simulateReads 50000 20000 100 3 > "$DIR/reads.fastq" || exit 1
+./QUESS -i "$DIR/reads.fastq" -g 50000 --save-index "$DIR/reads.qidx" -o "$DIR/saved.fastq" > "$DIR/saved.log" 2>&1 \
+    || { echo "testIndex: --save-index failed"; cat "$DIR/saved.log"; exit 1; }
+if cmp -s "$DIR/reads.fastq" "$DIR/saved.fastq"; then echo "testIndex: no read corrected"; exit 1; fi
+
+failures=0
+for table in "" --static-table --bucket-table; do
+    if ! ./QUESS -i "$DIR/reads.fastq" --load-index "$DIR/reads.qidx" $table -o "$DIR/loaded.fastq" > "$DIR/loaded.log" 2>&1; then
+        echo "testIndex: --load-index $table failed"; cat "$DIR/loaded.log"; failures=$((failures + 1))
+    elif ! cmp -s "$DIR/saved.fastq" "$DIR/loaded.fastq"; then
+        echo "testIndex: --load-index $table differs from the run that saved the index"; failures=$((failures + 1))
+    fi
+done
+if [ $failures -eq 0 ]; then echo "testIndex: passed"; else echo "testIndex: FAILED"; exit 1; fi
@@ -0,0 +1,96 @@
+/**
+  * File:     testLookupReuse.cpp
+  *
+  * Author1:  Lucian Ilie (ilie@uwo.ca)
+  * Author2:  Stephen Lu (slu93@uwo.ca)
+  *
+  *   Check (make test) that the later passes of correctBinaryReadFast,
+  *   which reuse the lookups of the windows unchanged since the previous
+  *   pass, correct the reads as full passes do (setLookupReuse(false)),
+  *   with the precomputed seeds and with wide (128-bit window) seeds.
+  *
+  */
+
+#include "../QUESS.h"
+#include "../libquess.h"
+#include <omp.h>
+
+using namespace std;
+
+#define GENOME_LENGTH 20000
+#define READ_LENGTH 100
+#define NUMBER_OF_READS 12000       // coverage 60
+
+static uint64_t state = 0x2545F4914F6CDD1DULL;
+
+static uint64_t nextRandom()
+{
+    state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+    return state;
+}
+
+// reads of a random genome, both strands, with 1% substitutions
+static void simulateReads(vector<string>& reads)
+{
+    const char bases[] = "ACGT";
+    string genome(GENOME_LENGTH, 'A');
+    for (int i = 0; i < GENOME_LENGTH; ++i)
+        genome[i] = bases[nextRandom() % 4];
+    for (int r = 0; r < NUMBER_OF_READS; ++r)
+    {
+        string read = genome.substr(nextRandom() % (GENOME_LENGTH - READ_LENGTH + 1), READ_LENGTH);
+        if (nextRandom() % 2)
+        {
+            string reverse(read.rbegin(), read.rend());
+            for (char& c : reverse)
+                c = (c == 'A') ? 'T' : (c == 'C') ? 'G' : (c == 'G') ? 'C' : 'A';
+            read = reverse;
+        }
+        for (char& c : read)
+            if (nextRandom() % 100 == 0)
+                c = bases[(string(bases).find(c) + 1 + nextRandom() % 3) % 4];
+        reads.push_back(read);
+    }
+}
+
+static vector<string> correct(const vector<string>& reads, const vector<string>& seeds, bool reuse)
+{
+    setLookupReuse(reuse);
+    QuessCorrector corrector(GENOME_LENGTH);
+    if (!seeds.empty())
+        corrector.setSeeds(seeds);
+    corrector.addReads(reads);
+    corrector.runSeeds();
+    vector<string> corrected;
+    corrector.getCorrectedReads(corrected);
+    return corrected;
+}
+
+int main()
+{
+    vector<string> reads;
+    simulateReads(reads);
+    setVerbose(false);
+    omp_set_num_threads(1);         // the sGaps (hence the models) in the order of the reads
+
+    int failures = 0;
+    const vector<string> wideSeeds = {"1111111111110000000000111111111111", "1111110111111000000001111110111111"};
+    const vector<string>* seedSets[] = {NULL, &wideSeeds};
+    for (const vector<string>* seeds : seedSets)
+    {
+        const char* name = (seeds == NULL) ? "precomputed seeds" : "wide seeds";
+        vector<string> expected = correct(reads, (seeds == NULL) ? vector<string>() : *seeds, false);
+        if (expected == reads)
+        {
+            cerr << "testLookupReuse: " << name << ": no read corrected" << endl;
+            ++failures;
+        }
+        if (correct(reads, (seeds == NULL) ? vector<string>() : *seeds, true) != expected)
+        {
+            cerr << "testLookupReuse: " << name << ": the reused lookups differ from full passes" << endl;
+            ++failures;
+        }
+    }
+    cout << "testLookupReuse: " << (failures == 0 ? "passed" : "FAILED") << endl;
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,27 @@
+#!/bin/sh
+#
+# Check (make test-mpi) that QUESS_mpi corrects the reads as QUESS does,
+# with 1, 2 and 4 ranks (one thread each, as the order of the sGaps of a
+# bucket is the order of the reads only then).
+#
+# Usage: tests/testMPI.sh (from the QUESS directory, after make QUESS QUESS_mpi tests/simulateReads)
+
+MPIRUN=${MPIRUN:-mpirun}
+DIR=$(mktemp -d /tmp/testMPI.XXXXXX)
+trap 'rm -rf "$DIR"' EXIT
+export OMP_NUM_THREADS=1
+
+./tests/simulateReads 50000 20000 100 3 > "$DIR/reads.fastq" || exit 1
+./QUESS -i "$DIR/reads.fastq" -g 50000 -o "$DIR/serial.fastq" > "$DIR/serial.log" 2>&1 \
+    || { echo "testMPI: QUESS failed"; cat "$DIR/serial.log"; exit 1; }
+if cmp -s "$DIR/reads.fastq" "$DIR/serial.fastq"; then echo "testMPI: no read corrected"; exit 1; fi
+
+failures=0
+for ranks in 1 2 4; do
+    if ! $MPIRUN --oversubscribe -np $ranks ./QUESS_mpi -i "$DIR/reads.fastq" -g 50000 -o "$DIR/mpi$ranks.fastq" > "$DIR/mpi$ranks.log" 2>&1; then
+        echo "testMPI: QUESS_mpi with $ranks ranks failed"; cat "$DIR/mpi$ranks.log"; failures=$((failures + 1))
+    elif ! cmp -s "$DIR/serial.fastq" "$DIR/mpi$ranks.fastq"; then
+        echo "testMPI: QUESS_mpi with $ranks ranks differs from QUESS"; failures=$((failures + 1))
+    fi
+done
+if [ $failures -eq 0 ]; then echo "testMPI: passed"; else echo "testMPI: FAILED"; exit 1; fi
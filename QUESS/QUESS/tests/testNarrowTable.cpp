@@ -0,0 +1,70 @@
+/**
+  * File:     testNarrowTable.cpp
+  *
+  * Author1:  Lucian Ilie (ilie@uwo.ca)
+  * Author2:  Stephen Lu (slu93@uwo.ca)
+  *
+  *   Check (make test) that the NarrowTable counts the sMers of a
+  *   weight 16 seed as the Element table does: the same sMers with
+  *   count >= Tc, for the usual Tc and for Tc = 255 and 256 (computeTc
+  *   gives up to 256, so the counts must go up to 255).
+  *
+  */
+
+#include "../QUESS.h"
+#include <algorithm>
+
+// frequent sMers of the table, sorted
+static vector<uint64_t> frequent(HashTable& H, uint64_t Tc)
+{
+    vector<uint64_t> sMers;
+    H.collectFrequentSMers(Tc, sMers);
+    sort(sMers.begin(), sMers.end());
+    return sMers;
+}
+
+int main()
+{
+    uint64_t peakMemory = 0, currentMemory = 0;
+    char* seedString = new char[1000];
+    getSeed(seedString, 16, 8, 0, peakMemory, currentMemory);
+    Seed seed(seedString);
+    uint64_t keyMask = seed.getKeyMask();
+
+    HashTable elements(20000);                  // no key mask: Element table
+    HashTable narrow(20000);
+    narrow.setKeyMask(keyMask, peakMemory, currentMemory);      // weight 16: NarrowTable
+
+    // sMers counted 1 .. 300 times, around 254, 255 and 256 in particular
+    const uint64_t counts[] = {1, 2, 3, 4, 5, 8, 100, 253, 254, 255, 256, 257, 300};
+    const int numberOfCounts = sizeof(counts) / sizeof(counts[0]);
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+    for (int i = 0; i < 5000; ++i)
+    {
+        state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+        uint64_t sMer = state & keyMask;
+        for (uint64_t c = 0; c < counts[i % numberOfCounts]; ++c)
+        {
+            elements.insertSMer(sMer);
+            narrow.insertSMer(sMer);
+        }
+    }
+
+    int failures = 0;
+    const uint64_t thresholds[] = {1, 4, 254, 255, 256};
+    for (uint64_t Tc : thresholds)
+    {
+        vector<uint64_t> expected = frequent(elements, Tc), found = frequent(narrow, Tc);
+        if ((expected != found) || ((Tc == 255) && expected.empty()))
+        {
+            cerr << "testNarrowTable: Tc = " << Tc << ": " << found.size() << " frequent sMers, expected "
+                 << expected.size() << endl;
+            ++failures;
+        }
+    }
+    elements.clear(peakMemory, currentMemory);
+    narrow.clear(peakMemory, currentMemory);
+    delete [] seedString;
+    cout << "testNarrowTable: " << (failures == 0 ? "passed" : "FAILED") << endl;
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,161 @@
+/**
+  * File:     testNormalize.cpp
+  *
+  * Author1:  Lucian Ilie (ilie@uwo.ca)
+  * Author2:  Stephen Lu (slu93@uwo.ca)
+  *
+  *   Check (make test) digital normalization (--normalize): the count-min
+  *   sketch never gives a count below the true one (up to its saturation),
+  *   and exact counts when it is wide; the models built from the reads it
+  *   keeps (a part of them) correct the reads about as well as the models
+  *   of all the reads, the same with 1 and 4 threads.
+  *
+  */
+
+#include "../QUESS.h"
+#include "../libquess.h"
+#include <omp.h>
+#include <map>
+
+using namespace std;
+
+#define GENOME_LENGTH 20000
+#define READ_LENGTH 100
+#define NUMBER_OF_READS 12000       // coverage 60
+#define COVERAGE 20
+
+static uint64_t state = 0x2545F4914F6CDD1DULL;
+
+static uint64_t nextRandom()
+{
+    state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+    return state;
+}
+
+// reads of a random genome, both strands, with 1% substitutions; truth = the reads without them
+static void simulateReads(vector<string>& reads, vector<string>& truth)
+{
+    const char bases[] = "ACGT";
+    string genome(GENOME_LENGTH, 'A');
+    for (int i = 0; i < GENOME_LENGTH; ++i)
+        genome[i] = bases[nextRandom() % 4];
+    for (int r = 0; r < NUMBER_OF_READS; ++r)
+    {
+        string read = genome.substr(nextRandom() % (GENOME_LENGTH - READ_LENGTH + 1), READ_LENGTH);
+        if (nextRandom() % 2)
+        {
+            string reverse(read.rbegin(), read.rend());
+            for (char& c : reverse)
+                c = (c == 'A') ? 'T' : (c == 'C') ? 'G' : (c == 'G') ? 'C' : 'A';
+            read = reverse;
+        }
+        truth.push_back(read);
+        for (char& c : read)
+            if (nextRandom() % 100 == 0)
+                c = bases[(string(bases).find(c) + 1 + nextRandom() % 3) % 4];
+        reads.push_back(read);
+    }
+}
+
+static int64_t keptReads = -1, modelReads = -1;      // "Reads kept for the models"
+
+static void logger(const char* line, void*)
+{
+    long long kept, all;
+    if (sscanf(line, "Reads kept for the models: %lld of %lld", &kept, &all) == 2)
+    {
+        keptReads = kept;
+        modelReads = all;
+    }
+}
+
+static vector<string> correct(const vector<string>& reads, int coverage, int numberOfThreads)
+{
+    omp_set_num_threads(numberOfThreads);
+    QuessCorrector corrector(GENOME_LENGTH);
+    corrector.setNormalize(coverage);
+    corrector.addReads(reads);
+    corrector.runSeeds();
+    vector<string> corrected;
+    corrector.getCorrectedReads(corrected);
+    return corrected;
+}
+
+// bases differing from the genome
+static uint64_t errors(const vector<string>& reads, const vector<string>& truth)
+{
+    uint64_t e = 0;
+    for (uint64_t r = 0; r < reads.size(); ++r)
+        for (uint64_t i = 0; i < reads[r].size(); ++i)
+            e += (reads[r][i] != truth[r][i]);
+    return e;
+}
+
+// keys added to a sketch of width counters per row: counts never below the true ones; return the keys counted exactly
+static uint64_t checkSketch(uint64_t width, int& failures)
+{
+    CountMinSketch sketch(width);
+    map<uint64_t, uint64_t> counts;
+    for (int i = 0; i < 20000; ++i)
+    {
+        uint64_t key = nextRandom() & (((uint64_t)1 << (2 * NORMALIZE_K)) - 1);
+        uint64_t times = (i % 100 == 0) ? 300 : 1 + nextRandom() % 20;      // a few saturate the counters
+        for (uint64_t t = 0; t < times; ++t)
+            sketch.add(key);
+        counts[key] += times;
+    }
+    uint64_t exact = 0;
+    for (auto& c : counts)
+    {
+        uint64_t count = sketch.getCount(c.first);
+        if (count < min(c.second, (uint64_t)255))
+        {
+            cerr << "testNormalize: width " << width << ": count " << count << " below " << c.second << endl;
+            ++failures;
+            break;
+        }
+        exact += (count == min(c.second, (uint64_t)255));
+    }
+    return exact * 100 / counts.size();
+}
+
+int main()
+{
+    int failures = 0;
+    checkSketch(1024, failures);            // many collisions
+    uint64_t exact = checkSketch(1 << 22, failures);
+    if (exact < 99)
+    {
+        cerr << "testNormalize: a wide sketch counts only " << exact << "% of the keys exactly" << endl;
+        ++failures;
+    }
+
+    vector<string> reads, truth;
+    simulateReads(reads, truth);
+    setLogger(logger, NULL);
+    vector<string> usual = correct(reads, 0, 1);
+    if (keptReads != -1)
+    {
+        cerr << "testNormalize: reads selected without --normalize" << endl;
+        ++failures;
+    }
+    vector<string> normalized = correct(reads, COVERAGE, 1);
+    if ((modelReads != NUMBER_OF_READS) || (keptReads <= 0) || (keptReads >= NUMBER_OF_READS))
+    {
+        cerr << "testNormalize: " << keptReads << " of " << modelReads << " reads kept for the models" << endl;
+        ++failures;
+    }
+    if (correct(reads, COVERAGE, 4) != normalized)
+    {
+        cerr << "testNormalize: 1 and 4 threads differ" << endl;
+        ++failures;
+    }
+    uint64_t before = errors(reads, truth), afterUsual = errors(usual, truth), afterNormalized = errors(normalized, truth);
+    if ((afterNormalized > afterUsual + before / 1000) || (afterNormalized * 100 > before))
+    {
+        cerr << "testNormalize: " << afterNormalized << " errors left of " << before << ", " << afterUsual << " without --normalize" << endl;
+        ++failures;
+    }
+    cout << "testNormalize: " << (failures == 0 ? "passed" : "FAILED") << endl;
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,94 @@
+/**
+  * File:     testPartitions.cpp
+  *
+  * Author1:  Lucian Ilie (ilie@uwo.ca)
+  * Author2:  Stephen Lu (slu93@uwo.ca)
+  *
+  *   Check (make test) that the model built in partitions spilled to
+  *   disk (--partitions) corrects the reads as the whole model does,
+  *   with several partitions and threads.
+  *
+  */
+
+#include "../libquess.h"
+#include <omp.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#define GENOME_LENGTH 20000
+#define READ_LENGTH 100
+#define NUMBER_OF_READS 12000       // coverage 60
+
+static uint64_t state = 0x2545F4914F6CDD1DULL;
+
+static uint64_t nextRandom()
+{
+    state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+    return state;
+}
+
+// reads of a random genome, both strands, with 1% substitutions
+static void simulateReads(vector<string>& reads)
+{
+    const char bases[] = "ACGT";
+    string genome(GENOME_LENGTH, 'A');
+    for (int i = 0; i < GENOME_LENGTH; ++i)
+        genome[i] = bases[nextRandom() % 4];
+    for (int r = 0; r < NUMBER_OF_READS; ++r)
+    {
+        string read = genome.substr(nextRandom() % (GENOME_LENGTH - READ_LENGTH + 1), READ_LENGTH);
+        if (nextRandom() % 2)
+        {
+            string reverse(read.rbegin(), read.rend());
+            for (char& c : reverse)
+                c = (c == 'A') ? 'T' : (c == 'C') ? 'G' : (c == 'G') ? 'C' : 'A';
+            read = reverse;
+        }
+        for (char& c : read)
+            if (nextRandom() % 100 == 0)
+                c = bases[(string(bases).find(c) + 1 + nextRandom() % 3) % 4];
+        reads.push_back(read);
+    }
+}
+
+static vector<string> correct(const vector<string>& reads, int numberOfPartitions, int numberOfThreads)
+{
+    omp_set_num_threads(numberOfThreads);
+    QuessCorrector corrector(GENOME_LENGTH);
+    if (numberOfPartitions > 0)
+        corrector.setModelPartitions(numberOfPartitions);
+    corrector.addReads(reads);
+    corrector.runSeeds();
+    vector<string> corrected;
+    corrector.getCorrectedReads(corrected);
+    return corrected;
+}
+
+int main()
+{
+    vector<string> reads;
+    simulateReads(reads);
+    setVerbose(false);
+
+    int failures = 0;
+    vector<string> expected = correct(reads, 0, 1);
+    if (expected == reads)
+    {
+        cerr << "testPartitions: no read corrected" << endl;
+        ++failures;
+    }
+    const int partitions[] = {1, 3, 8};
+    const int threads[] = {1, 4};
+    for (int p : partitions)
+        for (int t : threads)
+            if (correct(reads, p, t) != expected)
+            {
+                cerr << "testPartitions: " << p << " partitions with " << t << " threads differ from the whole model" << endl;
+                ++failures;
+            }
+    cout << "testPartitions: " << (failures == 0 ? "passed" : "FAILED") << endl;
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,106 @@
+/**
+  * File:     testPlanMemory.cpp
+  *
+  * Author1:  Lucian Ilie (ilie@uwo.ca)
+  * Author2:  Stephen Lu (slu93@uwo.ca)
+  *
+  *   Check (make test) the choices of planMemory (--max-memory): a large
+  *   budget keeps the default I/O buffers and one pass over the sMers;
+  *   smaller budgets use fewer and then smaller buffers, and below the
+  *   whole model the model is built (and the sMers counted) in partitions
+  *   when that is smaller; a budget below plan.required is refused.
+  *
+  */
+
+#include "../QUESS.h"
+#include <omp.h>
+
+using namespace std;
+
+#define BUCKET_SIZE 100000          // reads, without a budget
+#define SMALL_GENOME 50000
+#define LARGE_GENOME 100000000
+
+static int failures = 0;
+
+static void check(bool condition, const char* name, uint64_t genomeLength, uint64_t budget)
+{
+    if (condition)
+        return;
+    cerr << "testPlanMemory: genome " << genomeLength << ", budget " << budget << ": " << name << endl;
+    ++failures;
+}
+
+// planMemory(budget) with the checks every plan must pass
+static bool plan(uint64_t budget, uint64_t genomeLength, MemoryPlan& p)
+{
+    bool planned = planMemory(budget, genomeLength, BUCKET_SIZE, true, p);
+    check(planned == (budget >= p.required), "accepted iff budget >= required", genomeLength, budget);
+    if (!planned)
+        return false;
+    check((p.numberOfIOBuffers >= MIN_NUMBER_OF_IO_BUFFERS) && (p.numberOfIOBuffers <= NUMBER_OF_IO_BUFFERS)
+          && (p.ioBufferSize >= MIN_IO_BUFFER_SIZE) && (p.ioBufferSize <= IO_BUFFER_SIZE), "I/O buffers within their limits", genomeLength, budget);
+    check((p.ioBufferSize == IO_BUFFER_SIZE) || (p.numberOfIOBuffers == MIN_NUMBER_OF_IO_BUFFERS), "fewer blocks before smaller ones", genomeLength, budget);
+    check((p.bucketSize >= PLAN_MIN_BUCKET_SIZE) && (p.bucketSize <= BUCKET_SIZE), "bucket size within its limits", genomeLength, budget);
+    check((p.numberOfPartitions >= 1) && (p.tableSize * p.numberOfPartitions <= 2 * genomeLength)
+          && (p.tableSize * p.numberOfPartitions > 2 * genomeLength - p.numberOfPartitions), "partitions cover the table", genomeLength, budget);
+    check((p.tableSize <= max(p.tableLimit, (uint64_t) PLAN_MIN_TABLE_SIZE)), "table within its limit", genomeLength, budget);
+    return true;
+}
+
+int main()
+{
+    omp_set_num_threads(4);
+    const uint64_t genomeLengths[] = {SMALL_GENOME, LARGE_GENOME};
+    for (uint64_t genomeLength : genomeLengths)
+    {
+        MemoryPlan p;
+        uint64_t large = 1ULL << 40;
+        if (plan(large, genomeLength, p))
+        {
+            check((p.numberOfIOBuffers == NUMBER_OF_IO_BUFFERS) && (p.ioBufferSize == IO_BUFFER_SIZE), "default I/O buffers", genomeLength, large);
+            check((p.numberOfPartitions == 1) && !p.partitionedModel && (p.bucketSize == BUCKET_SIZE), "nothing partitioned", genomeLength, large);
+        }
+        uint64_t required = p.required;         // the whole model
+
+        // as the budget shrinks: fewer and smaller buffers, and never fewer partitions
+        uint64_t lastIOMemory = NUMBER_OF_IO_BUFFERS * IO_BUFFER_SIZE, lastPartitions = 1;
+        bool shrunk = false;
+        for (uint64_t budget = required + 256 * (uint64_t) IO_BUFFER_SIZE; budget >= required; budget -= IO_BUFFER_SIZE / 4)
+        {
+            if (!plan(budget, genomeLength, p))
+                break;
+            check(!p.partitionedModel, "whole model while it fits", genomeLength, budget);
+            check((p.numberOfIOBuffers * p.ioBufferSize <= lastIOMemory) && (p.numberOfPartitions >= lastPartitions), "monotonic", genomeLength, budget);
+            lastIOMemory = p.numberOfIOBuffers * p.ioBufferSize;
+            lastPartitions = p.numberOfPartitions;
+            shrunk = shrunk || (p.ioBufferSize < IO_BUFFER_SIZE);
+        }
+        check(shrunk, "smaller I/O buffers before refusing", genomeLength, required);
+        if (plan(required, genomeLength, p))
+            check((p.numberOfIOBuffers == MIN_NUMBER_OF_IO_BUFFERS) && (p.ioBufferSize == MIN_IO_BUFFER_SIZE), "smallest I/O buffers at plan.required", genomeLength, required);
+
+        // below the whole model: built in partitions if that is smaller (large genomes), else refused
+        if (!plan(required - 1, genomeLength, p))
+        {
+            check(genomeLength == SMALL_GENOME, "refused although the model can be partitioned", genomeLength, required - 1);
+            check(p.required == required, "same requirement", genomeLength, required - 1);
+        }
+        else
+        {
+            check(genomeLength == LARGE_GENOME, "accepted below the whole model", genomeLength, required - 1);
+            check(p.partitionedModel && (p.numberOfPartitions >= 2) && (p.required < required), "model built in partitions", genomeLength, required - 1);
+            check(!plan(p.required - 1, genomeLength, p), "refused below the partitioned model", genomeLength, p.required - 1);
+        }
+    }
+
+    // models from an index: only the buckets
+    MemoryPlan p;
+    if (!planMemory(1ULL << 30, LARGE_GENOME, BUCKET_SIZE, false, p) || (p.numberOfPartitions != 1) || (p.tableSize != 0) || p.partitionedModel)
+    {
+        cerr << "testPlanMemory: without models only the buckets are planned" << endl;
+        ++failures;
+    }
+    cout << "testPlanMemory: " << (failures == 0 ? "passed" : "FAILED") << endl;
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,37 @@
+#!/bin/sh
+#
+# Check (make test) --quality-skip: the errors of the simulated reads have
+# low scores, so skipping the windows whose sGap positions all score 30 or
+# more gives the reads of a usual run. With every score in the top bin
+# (30, '?') nothing is looked up, hence nothing corrected; with every score
+# one below it (29, '>') every window is looked up as in a usual run.
+#
+# Usage: tests/testQualitySkip.sh (from the QUESS directory, after make QUESS tests/simulateReads)
+
+DIR=$(mktemp -d /tmp/testQualitySkip.XXXXXX)
+trap 'rm -rf "$DIR"' EXIT
+
+./tests/simulateReads 50000 20000 100 3 > "$DIR/reads.fastq" || exit 1
+./QUESS -i "$DIR/reads.fastq" -g 50000 -o "$DIR/usual.fastq" > "$DIR/usual.log" 2>&1 \
+    || { echo "testQualitySkip: QUESS failed"; cat "$DIR/usual.log"; exit 1; }
+awk 'NR % 4 == 2' "$DIR/reads.fastq" > "$DIR/reads.txt"
+awk 'NR % 4 == 2' "$DIR/usual.fastq" > "$DIR/usual.txt"
+if cmp -s "$DIR/reads.txt" "$DIR/usual.txt"; then echo "testQualitySkip: no read corrected"; exit 1; fi
+
+# the reads corrected with --quality-skip 30 from the dataset $1 with every score replaced by $2 (none if empty)
+skipped()
+{
+    awk -v score="$2" 'NR % 4 == 0 && score != "" { gsub(/./, score) } 1' "$DIR/reads.fastq" > "$DIR/$1.fastq"
+    ./QUESS -i "$DIR/$1.fastq" -g 50000 -o "$DIR/$1_out.fastq" --quality-skip 30 > "$DIR/$1.log" 2>&1 \
+        || { echo "testQualitySkip: $1: QUESS failed" >&2; cat "$DIR/$1.log" >&2; return 1; }
+    awk 'NR % 4 == 2' "$DIR/$1_out.fastq"
+}
+
+failures=0
+skipped simulated "" > "$DIR/simulated.txt" && cmp -s "$DIR/usual.txt" "$DIR/simulated.txt" \
+    || { echo "testQualitySkip: the simulated scores: differs from the usual run"; failures=$((failures + 1)); }
+skipped high "?" > "$DIR/high.txt" && cmp -s "$DIR/reads.txt" "$DIR/high.txt" \
+    || { echo "testQualitySkip: scores 30: reads corrected"; failures=$((failures + 1)); }
+skipped low ">" > "$DIR/low.txt" && cmp -s "$DIR/usual.txt" "$DIR/low.txt" \
+    || { echo "testQualitySkip: scores 29: differs from the usual run"; failures=$((failures + 1)); }
+if [ $failures -eq 0 ]; then echo "testQualitySkip: passed"; else echo "testQualitySkip: FAILED"; exit 1; fi
@@ -0,0 +1,53 @@
+#!/bin/sh
+#
+# Check (make test) --resume: a run killed during its second seed, resumed
+# from its checkpoint, gives the reads of an uninterrupted run; with a wrong
+# CRC-32 of the reads in the checkpoint the run starts over and gives them
+# as well. No working file may be left.
+#
+# Usage: tests/testResume.sh (from the QUESS directory, after make QUESS tests/simulateReads)
+
+DIR=$(mktemp -d /tmp/testResume.XXXXXX)
+trap 'rm -rf "$DIR"' EXIT
+export OMP_NUM_THREADS=1
+CHECKPOINT="$DIR/reads_temp_copy.fastq.checkpoint"
+
+./tests/simulateReads 100000 40000 100 3 > "$DIR/reads.fastq" || exit 1
+./QUESS -i "$DIR/reads.fastq" -g 100000 -o "$DIR/full.fastq" > "$DIR/full.log" 2>&1 \
+    || { echo "testResume: QUESS failed"; cat "$DIR/full.log"; exit 1; }
+
+# start a run and kill it once the checkpoint of its first seed is written
+interrupt()
+{
+    ./QUESS -i "$DIR/reads.fastq" -g 100000 -o "$DIR/resumed.fastq" > "$DIR/interrupted.log" 2>&1 &
+    run=$!
+    while [ ! -e "$CHECKPOINT" ]; do
+        if ! kill -0 $run 2>/dev/null; then echo "testResume: the run ended before its first checkpoint"; return 1; fi
+        sleep 0.01
+    done
+    kill -9 $run
+    wait $run 2>/dev/null
+    return 0
+}
+
+# resume; the log must say $1 and the reads must be those of the uninterrupted run
+resume()
+{
+    if ! ./QUESS -i "$DIR/reads.fastq" -g 100000 -o "$DIR/resumed.fastq" --resume > "$DIR/resumed.log" 2>&1; then
+        echo "testResume: $2: --resume failed"; cat "$DIR/resumed.log"; return 1
+    fi
+    if ! grep -q "$1" "$DIR/resumed.log"; then echo "testResume: $2: no \"$1\" in the log"; return 1; fi
+    if ! cmp -s "$DIR/full.fastq" "$DIR/resumed.fastq"; then echo "testResume: $2: differs from the uninterrupted run"; return 1; fi
+    if ls "$DIR" | grep -q _temp; then echo "testResume: $2: working files left"; return 1; fi
+    return 0
+}
+
+failures=0
+interrupt && resume "Resuming after seed 0" "interrupted run" || failures=$((failures + 1))
+if interrupt; then
+    sed -i 's/^readsChecksum .*/readsChecksum 1/' "$CHECKPOINT"
+    resume "Cannot resume" "wrong CRC-32" || failures=$((failures + 1))
+else
+    failures=$((failures + 1))
+fi
+if [ $failures -eq 0 ]; then echo "testResume: passed"; else echo "testResume: FAILED"; exit 1; fi
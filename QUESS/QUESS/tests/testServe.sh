@@ -0,0 +1,36 @@
+#!/bin/sh
+#
+# Check (make test) the correction server: a scripted session on the socket
+# of QUESS --serve (three CORRECT batches, then SHUTDOWN) gives the reads
+# corrected by a batch run with the same index (--load-index), and the
+# server stops and removes its socket.
+#
+# Usage: tests/testServe.sh (from the QUESS directory, after make QUESS tests/simulateReads tests/serveClient)
+
+DIR=$(mktemp -d /tmp/testServe.XXXXXX)
+trap 'rm -rf "$DIR"' EXIT
+
+./tests/simulateReads 50000 20000 100 3 > "$DIR/reads.fastq" || exit 1
+./QUESS -i "$DIR/reads.fastq" -g 50000 --save-index "$DIR/reads.qidx" -o "$DIR/saved.fastq" > "$DIR/saved.log" 2>&1 \
+    || { echo "testServe: --save-index failed"; cat "$DIR/saved.log"; exit 1; }
+./QUESS -i "$DIR/reads.fastq" --load-index "$DIR/reads.qidx" -o "$DIR/batch.fastq" > "$DIR/batch.log" 2>&1 \
+    || { echo "testServe: --load-index failed"; cat "$DIR/batch.log"; exit 1; }
+awk 'NR % 4 == 2' "$DIR/reads.fastq" > "$DIR/reads.txt"
+awk 'NR % 4 == 2' "$DIR/batch.fastq" > "$DIR/batch.txt"
+if cmp -s "$DIR/reads.txt" "$DIR/batch.txt"; then echo "testServe: no read corrected"; exit 1; fi
+
+./QUESS --load-index "$DIR/reads.qidx" --serve "$DIR/quess.sock" > "$DIR/serve.log" 2>&1 &
+server=$!
+failures=0
+if ! ./tests/serveClient "$DIR/quess.sock" 3 < "$DIR/reads.txt" > "$DIR/served.txt"; then
+    echo "testServe: session failed"; failures=$((failures + 1))
+    kill $server 2>/dev/null
+elif ! cmp -s "$DIR/batch.txt" "$DIR/served.txt"; then
+    echo "testServe: the served reads differ from the batch run"; failures=$((failures + 1))
+fi
+if ! wait $server; then
+    echo "testServe: the server failed"; cat "$DIR/serve.log"; failures=$((failures + 1))
+elif [ -e "$DIR/quess.sock" ]; then
+    echo "testServe: socket left after SHUTDOWN"; failures=$((failures + 1))
+fi
+if [ $failures -eq 0 ]; then echo "testServe: passed"; else echo "testServe: FAILED"; exit 1; fi
@@ -0,0 +1,36 @@
+#!/bin/sh
+#
+# Check (make test) --shard: with the same index (--load-index), the outputs
+# of shards 1..3, concatenated, are the reads corrected by the full run, and
+# a shard named from the dataset (no -o) gets the records of its range.
+#
+# Usage: tests/testShard.sh (from the QUESS directory, after make QUESS tests/simulateReads)
+
+DIR=$(mktemp -d /tmp/testShard.XXXXXX)
+trap 'rm -rf "$DIR"' EXIT
+
+./tests/simulateReads 50000 20000 100 3 > "$DIR/reads.fastq" || exit 1
+./QUESS -i "$DIR/reads.fastq" -g 50000 --save-index "$DIR/reads.qidx" -o "$DIR/saved.fastq" > "$DIR/saved.log" 2>&1 \
+    || { echo "testShard: --save-index failed"; cat "$DIR/saved.log"; exit 1; }
+./QUESS -i "$DIR/reads.fastq" --load-index "$DIR/reads.qidx" -o "$DIR/full.fastq" > "$DIR/full.log" 2>&1 \
+    || { echo "testShard: --load-index failed"; cat "$DIR/full.log"; exit 1; }
+
+failures=0
+for i in 1 2 3; do
+    if ! ./QUESS -i "$DIR/reads.fastq" --load-index "$DIR/reads.qidx" --shard $i/3 -o "$DIR/shard$i.fastq" > "$DIR/shard$i.log" 2>&1; then
+        echo "testShard: --shard $i/3 failed"; cat "$DIR/shard$i.log"; failures=$((failures + 1))
+    fi
+done
+cat "$DIR/shard1.fastq" "$DIR/shard2.fastq" "$DIR/shard3.fastq" > "$DIR/shards.fastq" 2>/dev/null
+if ! cmp -s "$DIR/full.fastq" "$DIR/shards.fastq"; then
+    echo "testShard: the shards concatenated differ from the full run"; failures=$((failures + 1))
+fi
+
+# the default output name; shard 2 of 2 is the second half of the records
+if ! ./QUESS -i "$DIR/reads.fastq" --load-index "$DIR/reads.qidx" --shard 2/2 > "$DIR/named.log" 2>&1; then
+    echo "testShard: --shard 2/2 failed"; cat "$DIR/named.log"; failures=$((failures + 1))
+elif ! tail -n +$(( $(wc -l < "$DIR/full.fastq") / 8 * 4 + 1 )) "$DIR/full.fastq" | cmp -s - "$DIR/reads_QUESS_corrected_shard2of2.fastq"; then
+    echo "testShard: --shard 2/2 is not the second half of the full run"; failures=$((failures + 1))
+fi
+if ls "$DIR" | grep -q _temp; then echo "testShard: working files left"; failures=$((failures + 1)); fi
+if [ $failures -eq 0 ]; then echo "testShard: passed"; else echo "testShard: FAILED"; exit 1; fi
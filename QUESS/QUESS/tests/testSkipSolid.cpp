@@ -0,0 +1,123 @@
+/**
+  * File:     testSkipSolid.cpp
+  *
+  * Author1:  Lucian Ilie (ilie@uwo.ca)
+  * Author2:  Stephen Lu (slu93@uwo.ca)
+  *
+  *   Check (make test) --skip-solid: the later seeds skip reads (logged),
+  *   the corrected reads are the same with 1 and 4 threads, and they are
+  *   about as close to the genome as the reads corrected by all seeds:
+  *   a solid read is correct with (almost) every seed.
+  *
+  */
+
+#include "../libquess.h"
+#include <omp.h>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#define GENOME_LENGTH 20000
+#define READ_LENGTH 100
+#define NUMBER_OF_READS 12000       // coverage 60
+
+static uint64_t state = 0x2545F4914F6CDD1DULL;
+
+static uint64_t nextRandom()
+{
+    state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+    return state;
+}
+
+// reads of a random genome, both strands, with 1% substitutions; truth = the reads without them
+static void simulateReads(vector<string>& reads, vector<string>& truth)
+{
+    const char bases[] = "ACGT";
+    string genome(GENOME_LENGTH, 'A');
+    for (int i = 0; i < GENOME_LENGTH; ++i)
+        genome[i] = bases[nextRandom() % 4];
+    for (int r = 0; r < NUMBER_OF_READS; ++r)
+    {
+        string read = genome.substr(nextRandom() % (GENOME_LENGTH - READ_LENGTH + 1), READ_LENGTH);
+        if (nextRandom() % 2)
+        {
+            string reverse(read.rbegin(), read.rend());
+            for (char& c : reverse)
+                c = (c == 'A') ? 'T' : (c == 'C') ? 'G' : (c == 'G') ? 'C' : 'A';
+            read = reverse;
+        }
+        truth.push_back(read);
+        for (char& c : read)
+            if (nextRandom() % 100 == 0)
+                c = bases[(string(bases).find(c) + 1 + nextRandom() % 3) % 4];
+        reads.push_back(read);
+    }
+}
+
+static uint64_t skippedReads = 0;       // "Solid reads skipped" of all seeds
+
+static void logger(const char* line, void*)
+{
+    if (strncmp(line, "Solid reads skipped: ", 21) == 0)
+        skippedReads += strtoull(line + 21, NULL, 10);
+}
+
+static vector<string> correct(const vector<string>& reads, bool skipSolid, int numberOfThreads)
+{
+    omp_set_num_threads(numberOfThreads);
+    QuessCorrector corrector(GENOME_LENGTH);
+    corrector.setSkipSolid(skipSolid);
+    corrector.addReads(reads);
+    corrector.runSeeds();
+    vector<string> corrected;
+    corrector.getCorrectedReads(corrected);
+    return corrected;
+}
+
+// bases differing from the genome
+static uint64_t errors(const vector<string>& reads, const vector<string>& truth)
+{
+    uint64_t e = 0;
+    for (uint64_t r = 0; r < reads.size(); ++r)
+        for (uint64_t i = 0; i < reads[r].size(); ++i)
+            e += (reads[r][i] != truth[r][i]);
+    return e;
+}
+
+int main()
+{
+    vector<string> reads, truth;
+    simulateReads(reads, truth);
+    setLogger(logger, NULL);
+
+    int failures = 0;
+    vector<string> usual = correct(reads, false, 1);
+    if (skippedReads != 0)
+    {
+        cerr << "testSkipSolid: reads skipped without --skip-solid" << endl;
+        ++failures;
+    }
+    vector<string> skipped = correct(reads, true, 1);
+    if (skippedReads == 0)
+    {
+        cerr << "testSkipSolid: no read skipped" << endl;
+        ++failures;
+    }
+    if (correct(reads, true, 4) != skipped)
+    {
+        cerr << "testSkipSolid: 1 and 4 threads differ" << endl;
+        ++failures;
+    }
+    uint64_t before = errors(reads, truth), afterUsual = errors(usual, truth), afterSkipped = errors(skipped, truth);
+    if ((afterSkipped > afterUsual + before / 1000) || (afterSkipped * 100 > before))
+    {
+        cerr << "testSkipSolid: " << afterSkipped << " errors left of " << before << ", " << afterUsual << " without --skip-solid" << endl;
+        ++failures;
+    }
+    cout << "testSkipSolid: " << (failures == 0 ? "passed" : "FAILED") << endl;
+    return (failures == 0) ? 0 : 1;
+}